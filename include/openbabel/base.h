@@ -22,8 +22,10 @@ GNU General Public License for more details.
 
 #include <openbabel/babelconfig.h>
 
+#include <atomic>
 #include <vector>
 #include <map>
+#include <memory>
 #include <string>
 #include <iostream>
 #include <openbabel/tokenst.h>
@@ -44,15 +46,15 @@ namespace OpenBabel
   //Declaration later in this file.
 class OBBase;
 class OBConversion; //used only as pointer
+class OBDataIndex;  //lookup tables kept by OBBase, defined in base.cpp
 
 //! \return the version of the Open Babel library for feature-detection (e.g. "2.3.1")
   OBAPI std::string OBReleaseVersion();
 
   //! \brief Classification of data stored via OBGenericData class and subclasses.
   //!
-  //! OBGenericDataType can be used as a faster, direct access to a particular category
-  //! instead of the slower access via GetData(std::string), which must loop
-  //! through all data to find a match with the supplied key. It is implemented
+  //! OBGenericDataType can be used as a direct access to a particular category
+  //! instead of access via GetData(std::string) by attribute. It is implemented
   //! as a set of unsigned integer constants for maximum flexibility and future
   //! expansion.
   //!
@@ -191,6 +193,8 @@ class OBConversion; //used only as pointer
     std::string  _attr;  //!< attribute tag (e.g., "UnitCell", "Comment" or "Author")
     unsigned int _type;  //!< attribute type -- declared for each subclass
     DataOrigin   _source;//!< source of data for accounting
+    std::shared_ptr<unsigned long> _indexRenames;//!< rename count of the OBBase lookup index holding this item
+    friend class OBDataIndex;
   public:
     OBGenericData(const std::string attr = "undefined",
                   const unsigned int type =  OBGenericDataType::UndefinedData,
@@ -213,8 +217,7 @@ class OBConversion; //used only as pointer
     //OBGenericData& operator=(const OBGenericData &src);
 
     //! Set the attribute (key), which can be used to retrieve this data
-    void                      SetAttribute(const std::string &v)
-    {        _attr = v;        }
+    void                      SetAttribute(const std::string &v);
     //! Set the origin of this data, which can be used to filter the data
     void SetOrigin(const DataOrigin s) { _source = s; }
     //! \return The attribute (key), which can be used to retrieve this data
@@ -239,16 +242,12 @@ class OBConversion; //used only as pointer
   class OBAPI OBBase
     {
     public:
-      virtual ~OBBase()
-        {
-          if (!_vdata.empty())
-            {
-              std::vector<OBGenericData*>::iterator m;
-              for (m = _vdata.begin();m != _vdata.end();m++)
-                delete *m;
-              _vdata.clear();
-            }
-        }
+      OBBase() : _dataGeneration(0), _dataIndex(NULL) {}
+      //! Copies the data pointers (not the data), as the implicit copy did
+      OBBase(const OBBase &src) : _vdata(src._vdata), _dataGeneration(0), _dataIndex(NULL)
+        { UpdateDataIndex(); }
+      OBBase &operator=(const OBBase &src);
+      virtual ~OBBase();
 
       //! \brief Clear any and all data associated with this object
       virtual bool Clear();
@@ -303,10 +302,7 @@ class OBConversion; //used only as pointer
       //! Deletes the generic data with the specified attribute, returning false if not found
       bool                              DeleteData(const std::string& s);
       //! Adds a data object; does nothing if d==NULL
-      void                              SetData(OBGenericData *d)
-        {
-          if(d) _vdata.push_back(d);
-        }
+      void                              SetData(OBGenericData *d);
       //! Adds a copy of a data object; does nothing if d == NULL
       //! \since version 2.2
       void                              CloneData(OBGenericData *d);
@@ -324,20 +320,29 @@ class OBConversion; //used only as pointer
       //!    or an empty vector if nothing matches
       //! \since version 2.2
       std::vector<OBGenericData*>       GetAllData(const unsigned int type);
-      //! \return all data, suitable for iterating
-      std::vector<OBGenericData*>      &GetData() { return(_vdata); }
+      //! \return all data, suitable for iterating. As the data may be changed
+      //! through it, lookups search the data until the next change through OBBase.
+      std::vector<OBGenericData*>      &GetData() { ++_dataGeneration; return(_vdata); }
+      //! \return all data, for reading only
+      //! \since version 3.1
+      const std::vector<OBGenericData*> &GetData() const { return(_vdata); }
       //! \return all data with a specific origin, suitable for iterating
       std::vector<OBGenericData*>      GetData(DataOrigin source);
       //! \return An iterator pointing to the beginning of the data
       OBDataIterator  BeginData()
-        { return(_vdata.begin());        }
+        { ++_dataGeneration; return(_vdata.begin()); }
       //! \return An iterator pointing to the end of the data
       OBDataIterator  EndData()
-        { return(_vdata.end());          }
+        { ++_dataGeneration; return(_vdata.end()); }
       //@}
     protected:
       std::vector<OBGenericData*> _vdata; //!< Custom data
 
+    private:
+      const OBDataIndex *DataIndex() const;
+      void UpdateDataIndex();
+      std::atomic<unsigned long> _dataGeneration; //!< bumped by each change to _vdata through OBBase, or access that allows one
+      OBDataIndex *_dataIndex; //!< lookup tables over _vdata, kept up to date by the changes
     };
 
 } //namespace OpenBabel
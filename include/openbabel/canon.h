@@ -50,6 +50,19 @@ namespace OpenBabel {
       std::vector<unsigned int> &canonical_labels, const OBBitVec &mask = OBBitVec(),
       int maxSeconds = 5, bool onlyOne = false);
 
+  /**
+   * Calculate the canonical labels for the molecule as above, and set
+   * @p timedOut to true if the search for the labels of a fragment was
+   * stopped after @p maxSeconds (e.g. for highly symmetric molecules). The
+   * labels are then the best found so far: a valid numbering, but not
+   * necessarily the canonical one.
+   *
+   * @since version 3.1
+   */
+  void OBAPI CanonicalLabels(OBMol *mol, const std::vector<unsigned int> &symmetry_classes,
+      std::vector<unsigned int> &canonical_labels, const OBBitVec &mask,
+      int maxSeconds, bool onlyOne, bool &timedOut);
+
 } // namespace OpenBabel
 
 //! \file canon.h
@@ -26,6 +26,7 @@ GNU General Public License for more details.
 
 #include <openbabel/babelconfig.h>
 #include <vector>
+#include <map>
 
 namespace OpenBabel
 {
@@ -89,11 +90,13 @@ namespace OpenBabel
       bool DetermineConnectedChains(OBMol &);
       /**
        * Perform the actual work for DetermineConnectedChains(). Set chains[i]
-       * to @p c for all atoms of the recursed chain.
+       * to @p c for all atoms of the connected chain, and list them in
+       * chainAtoms. Uses an explicit stack, so long chains cannot overflow
+       * the call stack.
        * @param mol The molecule.
-       * @param i Index for the current atom. (RecurseChain() will be called for all neighbours)
-       * @param c The chain which we are recusring. ('A' + count)
-       * @return The number of heavy atoms in the recursed chain.
+       * @param i Index for the first atom.
+       * @param c The chain which we are labelling. ('A' + count)
+       * @return The number of heavy atoms in the chain.
        */
       unsigned int RecurseChain(OBMol &mol, unsigned int i, int c);
       //@}
@@ -113,7 +116,8 @@ namespace OpenBabel
        * on Template::element and Template::count.
        *
        * Next, the bitmasks[i] are iteratively resolved by matching the
-       * constraints in OpenBabel::Peptide or OpenBabel::Nucleotide.
+       * constraints in OpenBabel::Peptide or OpenBabel::Nucleotide. Only the
+       * neighbours of atoms whose bitmasks changed are checked again.
        * @param mol The molecule.
        * @param templ OpenBabel::Peptide or OpenBabel::Nucleotide
        * @param tmax Number of entries in @p templ
@@ -172,7 +176,12 @@ namespace OpenBabel
        */
       int IdentifyResidue(void *tree, OBMol &mol, unsigned int seed, int resno); // ByteCode *
       /**
-       * Set resids[i] for all atoms where resids[i] = @p r and chains[i] = @p c.
+       * Index the atoms by chains[i] and resnos[i] for AssignResidue().
+       * IdentifyResidue() adds the atoms it renumbers.
+       */
+      void  IndexResidues(OBMol &mol);
+      /**
+       * Set resids[i] for all atoms where resnos[i] = @p r and chains[i] = @p c.
        * @param mol The molecule.
        * @param r The residue number.
        * @param c The chain number.
@@ -280,6 +289,9 @@ namespace OpenBabel
       std::vector<short>          sernos;   //!< array of residue serial numbers
       std::vector<char>           hcounts;
       std::vector<char>           chains;
+      std::vector<unsigned int>   chainAtoms; //!< atoms found by RecurseChain()
+      //! atoms by chain and residue number, see IndexResidues()
+      std::map<std::pair<char, short>, std::vector<unsigned int> > residueAtoms;
     };
 
     //! Global OBChainsParser for detecting macromolecular chains and residues
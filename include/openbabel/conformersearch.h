@@ -62,6 +62,13 @@ namespace OpenBabel {
        * @return True if the conformer passes the filter.
        */
       virtual bool IsGood(const OBMol &mol, const RotorKey &key, double *coords) = 0;
+      /**
+       * @return True if IsGood() can be called for several conformers at the same
+       * time from different threads. OBConformerSearch only filters conformers
+       * in parallel for thread-safe filters.
+       * @since 3.1
+       */
+      virtual bool IsThreadSafe() const { return false; }
       virtual ~OBConformerFilter() = 0;
   };
 
@@ -97,6 +104,17 @@ namespace OpenBabel {
             return false;
         return true;
       }
+      /**
+       * IsThreadSafe reimplementation.
+       * @return True if all filters are thread-safe.
+       */
+      bool IsThreadSafe() const
+      {
+        for (unsigned int i = 0; i < m_filters.size(); ++i)
+          if (!m_filters[i]->IsThreadSafe())
+            return false;
+        return true;
+      }
     protected:
       std::vector<OBConformerFilter*> m_filters;
   };
@@ -116,6 +134,7 @@ namespace OpenBabel {
       OBStericConformerFilter ();
       OBStericConformerFilter (double cutoff, double vdw_factor = 0.5, bool check_hydrogens = true);
       bool IsGood(const OBMol &mol, const RotorKey &key, double *coords);
+      bool IsThreadSafe() const { return true; }
     private:
       double m_cutoff; //!< Internal cutoff (used as a squared distance)
       double m_vdw_factor;		//!< Factor applied to Van der Waals distance check
@@ -165,6 +184,13 @@ namespace OpenBabel {
        */
       virtual double Score(OBMol &mol, unsigned int index, const RotorKeys &keys,
           const std::vector<double*> &conformers) = 0;
+      /**
+       * @return True if Score() can be called for several conformers at the same
+       * time from different threads. Scores that modify the molecule or keep a
+       * cache (e.g. the energy scores) are not thread-safe.
+       * @since 3.1
+       */
+      virtual bool IsThreadSafe() const { return false; }
       virtual ~OBConformerScore() = 0;
   };
 
@@ -183,6 +209,7 @@ namespace OpenBabel {
       Convergence GetConvergence() { return Average; }
       double Score(OBMol &mol, unsigned int index, const RotorKeys &keys,
           const std::vector<double*> &conformers);
+      bool IsThreadSafe() const { return true; }
   };
 
   /**
@@ -302,6 +329,14 @@ namespace OpenBabel {
        * before considering the iteration converged).
        */
       void SetConvergence(int convergence) { m_convergence = convergence; }
+      /**
+       * Set the seed of the random number generator. By default the generator
+       * is seeded from the current time. Using a fixed seed gives reproducible
+       * results, independent of the number of threads used to evaluate the
+       * population.
+       * @since 3.1
+       */
+      void SetSeed(int seed);
       /**
        * Set the bonds to be fixed.
        */
@@ -413,6 +448,11 @@ namespace OpenBabel {
        * Select the fittest numConformers from the parents and their children.
        */
       double MakeSelection();
+      /**
+       * Score all @p conformers of the current population. The conformers are
+       * scored in parallel if the score is thread-safe.
+       */
+      void ScoreConformers(const std::vector<double*> &conformers, std::vector<double> &scores);
       /**
        * Check if a conformer key is unique.
        */
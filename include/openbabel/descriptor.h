@@ -22,6 +22,8 @@ GNU General Public License for more details.
 #include <string>
 #include <sstream>
 #include <limits>
+#include <vector>
+#include <utility>
 
 #include <openbabel/babelconfig.h>
 #include <openbabel/plugin.h>
@@ -56,6 +58,11 @@ public:
   /// e.g. babel -L descriptors HBA1
   virtual bool Display(std::string& txt, const char* param, const char* ID=NULL);
 
+  /// \return true if Predict() and GetStringValue() may be called from several
+  /// threads at once, each with a different object. The default is false.
+  /// \since version 3.1
+  virtual bool IsThreadSafe() { return false; }
+
   /// Comparison of the values of the descriptor. Used in sorting.
   /// Descriptors may use more complicated ordering than this default (e.g.InChIFilter)
   virtual bool Order(double p1, double p2){ return p1<p2; }
@@ -67,6 +74,32 @@ public:
   ///Reads list of descriptor IDs and calls PredictAndSave() for each.
   static void AddProperties(OBBase* pOb, const std::string& DescrList);
 
+  ///Reads a list of descriptor IDs, as used by AddProperties(), into descriptors
+  ///and their parameters.
+  /// \return false if any of them is not a descriptor
+  /// \since version 3.1
+  static bool FindDescriptors(const std::string& DescrList,
+                              std::vector<std::pair<OBDescriptor*, std::string> >& descrs);
+
+  /// Evaluates descriptors for many objects, e.g. to make a feature matrix,
+  /// without going through OBPairData strings.
+  /// values[i*descrs.size()+j] is the value of descriptor j for objects[i].
+  /// String-valued descriptors, e.g. cansmi, have isString[j] set and their
+  /// value in svalues at the same position instead; they are NaN in values.
+  /// If isString is empty it is filled in from all the objects: a column is
+  /// of strings if any object gives text rather than a number, and numbers in
+  /// it are kept as their text. If isString is given, e.g. from an earlier
+  /// call, text in a numeric column is NaN.
+  /// Each object has all its descriptors evaluated in turn by one thread, so
+  /// the rings, aromaticity etc. perceived for the first are reused by the
+  /// rest. When built with OpenMP, and if all the descriptors IsThreadSafe(),
+  /// the objects are evaluated in parallel.
+  /// \since version 3.1
+  static void PredictValues(const std::vector<OBBase*>& objects,
+                            const std::vector<std::pair<OBDescriptor*, std::string> >& descrs,
+                            std::vector<bool>& isString,
+                            std::vector<double>& values, std::vector<std::string>& svalues);
+
   ///Deletes all the OBPairDatas whose attribute names are in the list (if they exist).
   static void DeleteProperties(OBBase* pOb, const std::string& DescrList);
 
@@ -77,6 +110,12 @@ public:
   ///Read an identifier and its parameter from the filter string.
   static std::pair<std::string, std::string> GetIdentifier(std::istream& optionText);
 
+  /// \return true if every identifier in the --filter string is an existing
+  /// OBPairData of \p pOb without a parameter, so that FilterCompare() can be
+  /// evaluated without a chemical structure.
+  /// \since version 3.1
+  static bool FilterUsesOnlyPairData(OBBase* pOb, std::istream& optionText);
+
 protected:
 
   static double ParsePredicate(std::istream& optionText, char& ch1, char& ch2, std::string& svalue);
@@ -38,6 +38,7 @@ namespace OpenBabel {
 
   class DistanceGeometryPrivate;
   class OBCisTransStereo;
+  class OBRandom;
 
   class TetrahedralInfo {
     int c;
@@ -82,6 +83,12 @@ namespace OpenBabel {
 
     void Generate();
     void AddConformer();
+    /**
+     * Embed @p nconfs independent conformers and add them to the internal
+     * molecule. When built with OpenMP the embeddings run in parallel.
+     * \since version 3.1
+     */
+    void AddConformers(unsigned int nconfs);
     void GetConformers(OBMol &mol);
 
     /**
@@ -106,14 +113,17 @@ namespace OpenBabel {
     OBMol                     _mol;
     std::vector<OBGenericData*> _vdata;
     DistanceGeometryPrivate  *_d;    //!< Internal private data, including bounds matrix
-    Eigen::VectorXd _coord;          // one-dimensional vector containing coordinates of atoms
     std::string input_smiles;
 
     unsigned int dim;
 
-    bool generateInitialCoords();
-    bool firstMinimization();
-    bool minimizeFourthDimension();
+    // coord is a one-dimensional vector containing coordinates of atoms
+    bool generateInitialCoords(Eigen::VectorXd &coord, OBRandom &generator);
+    bool firstMinimization(Eigen::VectorXd &coord);
+    bool minimizeFourthDimension(Eigen::VectorXd &coord);
+    //! \brief Run embedding trials until the geometry of @p mol satisfies the constraints
+    //! \return True on success
+    bool Embed(OBMol &mol, OBRandom &generator);
     
     //! \brief Set the default upper bounds for the constraint matrix
     //! Upper bounds = maximum length of the molecule, or 1/2 the body diagonal in a unit cell
@@ -144,10 +154,10 @@ namespace OpenBabel {
     void CorrectStereoConstraints(double scale = 1.0);
     //! \brief Check that the double bond and atom stereo constraints are met
     //! \return True if all constraints are valid
-    bool CheckStereoConstraints();
+    bool CheckStereoConstraints(OBMol &mol);
 
     //! \return True if the bounds are met
-    bool CheckBounds();
+    bool CheckBounds(OBMol &mol);
   };
   class DistGeomFunc {
     OBDistanceGeometry* const owner;
@@ -34,6 +34,7 @@ GNU General Public License for more details.
 namespace OpenBabel
 {
   class OBBase; //Forward declaration; used only as pointer.
+  class OBConversion;
 
 /// \brief The base class for fingerprints
 class OBFPRT OBFingerprint : public OBPlugin
@@ -64,12 +65,49 @@ public:
   /// \return fingerprint in vector, which may be resized, folded to nbits (if nbits!=0)
   virtual bool GetFingerprint(OBBase* pOb, std::vector<unsigned int>& fp, int nbits=0)=0;
 
+  /// Unfolded, count-based fingerprint: the number of occurrences of each
+  /// feature identifier. Only some fingerprint types (e.g. ECFP) support this.
+  /// \return false if not available for this fingerprint type
+  /// \since version 3.1
+  virtual bool GetFeatureCounts(OBBase* /* pOb */, std::map<unsigned int, unsigned int>& /* counts */)
+  {
+    return false;
+  }
+
   /// Optional flags
   enum FptFlag{FPT_UNIQUEBITS=1, FPT_NOINFO=2};
   virtual unsigned int Flags() { return 0;};
   //// \since version 2.3
   virtual void SetFlags(unsigned int){}
 
+  /// \return true if GetFingerprint() may be called from several threads at once
+  /// with the current flags. The default is false.
+  /// \since version 3.1
+  virtual bool IsThreadSafe() { return false; }
+
+  /// Calculates the fingerprints of all the objects read by @p conv, which
+  /// must have its input stream and format set, e.g.
+  /// \code
+  /// OBConversion conv(&ifs);
+  /// conv.SetInFormat("smi");
+  /// pFP->GetFingerprints(conv, fps);
+  /// \endcode
+  /// The objects are read in chunks and, when built with OpenMP and
+  /// IsThreadSafe() is true with FPT_NOINFO set, fingerprinted in parallel.
+  /// fps[i] is the fingerprint of the ith object, folded to nbits (if nbits!=0).
+  /// \return the number of objects read
+  /// \since version 3.1
+  unsigned int GetFingerprints(OBConversion& conv,
+                               std::vector<std::vector<unsigned int> >& fps, int nbits=0);
+
+  /// Calculates the fingerprints of @p objs, in parallel under the same
+  /// conditions as GetFingerprints(OBConversion&, ...). fps[i] is the
+  /// fingerprint of objs[i], folded to nbits (if nbits!=0).
+  /// \return false if any of the fingerprints could not be calculated
+  /// \since version 3.1
+  bool GetFingerprints(const std::vector<OBBase*>& objs,
+                       std::vector<std::vector<unsigned int> >& fps, int nbits=0);
+
   /// \return a description of each bit that is set (or unset, if bSet=false)
   /// \since version 2.2
   virtual std::string DescribeBits(const std::vector<unsigned int> /* fp */,
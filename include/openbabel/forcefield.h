@@ -523,6 +523,14 @@ const double GAS_CONSTANT = 8.31446261815324e-3 / KCAL_TO_KJ;  //!< kcal mol^-1
      */
     bool IsInSameRing(OBAtom* a, OBAtom* b);
 
+    /*! Create a new instance of this force field, set up for the current molecule
+     *  with the same cut-off settings. This is used to evaluate conformers in
+     *  parallel, each thread working on its own copy. Only molecules without
+     *  constraints can be copied, since the constraints are shared.
+     *  \return The copy (should be deleted after use) or NULL if it could not be set up.
+     */
+    OBForceField* MakeSetupCopy();
+
     // general variables
     OBMol 	_mol; //!< Molecule to be evaluated or minimized
     bool 	_init; //!< Used to make sure we only parse the parameter file once, when needed
@@ -960,6 +968,28 @@ const double GAS_CONSTANT = 8.31446261815324e-3 / KCAL_TO_KJ;  //!< kcal mol^-1
      *	  see Energy()
      */
     virtual double E_Electrostatic(bool UNUSED(gradients) = true) { return 0.0f; }
+    /*! Calculate the Van der Waals and electrostatic energy for a subset of the
+     *  non-bonded pairs. This is used to update the energy incrementally when
+     *  only part of the molecule moves (e.g. after a rotor move). If cut-offs
+     *  are enabled, only the selected pairs within the cut-off are included.
+     *  The force field's terms must record which pair they belong to, as those
+     *  in Open Babel do. The 1-3 Van der Waals terms that UFF adds for atoms
+     *  with more than seven neighbours are not among the pairs and are
+     *  included in every subset.
+     *  \param pairs The pairs to include, indexed in the order of FOR_PAIRS_OF_MOL.
+     *  \return Non-bonded energy of the selected pairs.
+     *  \since version 3.1
+     */
+    double E_NonBonded(const OBBitVec &pairs);
+    /*! Split the non-bonded pairs into the pairs between a moved and a static
+     *  atom, and all other pairs. The energy of the latter does not change when
+     *  the moved atoms are rotated or translated as a rigid body.
+     *  \param moved The atoms that move (indexed by atom index).
+     *  \param cross Set to the pairs between a moved and a static atom.
+     *  \param rest Set to all other pairs.
+     *  \since version 3.1
+     */
+    void GetMovedPairs(const OBBitVec &moved, OBBitVec &cross, OBBitVec &rest);
     //@}
 
     /////////////////////////////////////////////////////////////////////////
@@ -1191,6 +1221,28 @@ const double GAS_CONSTANT = 8.31446261815324e-3 / KCAL_TO_KJ;  //!< kcal mol^-1
 #ifdef HAVE_EIGEN
     //! \since version 2.4
     int DiverseConfGen(double rmsd, unsigned int nconfs = 0, double energy_gap = 50, bool verbose = false);
+    /**
+     * @brief Generate a diverse set of low energy conformers by depth-first torsion driving
+     *
+     * Like DiverseConfGen(), but instead of testing (a random sample of) all rotor
+     * keys, the rotors are assigned one at a time in a depth-first search. After
+     * each assignment only the non-bonded interactions between atoms whose distance
+     * has just become fixed are evaluated, and their energy is kept for all the
+     * keys below that branch. Every rotor key is evaluated, with the same energy
+     * as in DiverseConfGen(); when @p nconfs stops the search early, the keys
+     * tested are the first ones in depth-first order rather than a sample.
+     * The RMSD filter is the same as in DiverseConfGen().
+     *
+     * Molecules with constraints or interaction groups are handled by
+     * DiverseConfGen().
+     *
+     * @param rmsd The RMSD cutoff used to select diverse conformers.
+     * @param nconfs The maximum number of complete rotor keys to evaluate (0 = no limit).
+     * @param energy_gap The energy window above the lowest energy conformer.
+     * @param verbose Print progress information.
+     * @since version 3.1
+     */
+    int DiverseConfGenTree(double rmsd, unsigned int nconfs = 0, double energy_gap = 50, bool verbose = false);
 #endif
 
     /////////////////////////////////////////////////////////////////////////
@@ -250,12 +250,45 @@ namespace OpenBabel
     int GetStereo() {      return(_stereo); }
   };
 
+  //! \struct OBRingMembership generic.h <openbabel/generic.h>
+  //! \brief The rings of an OBRingData set containing one atom or bond
+  //! \since version 3.1
+  struct OBRingMembership
+  {
+    unsigned int count;       //!< Number of rings containing the atom or bond
+    unsigned int firstSize;   //!< Size of the first ring containing it, or 0
+    int smallest;             //!< Index of the first smallest ring containing it, or -1
+    unsigned long long sizes; //!< Bit n is set if it is in a ring of size n (n < 64)
+
+    OBRingMembership() : count(0), firstSize(0), smallest(-1), sizes(0) {}
+    //! \return Whether the atom or bond is in a ring of size @p size.
+    //! Always false for sizes of 64 or more, which are not indexed.
+    bool HasSize(int size) const
+    {
+      return size >= 0 && size < 64 && ((sizes >> size) & 1ULL);
+    }
+  };
+
   //! \class OBRingData generic.h <openbabel/generic.h>
   //! \brief Used to store the SSSR set (filled in by OBMol::GetSSSR())
+  //!
+  //! Also keeps an index of which rings each atom and bond is a member of,
+  //! so that per-atom ring queries (e.g. OBAtom::IsInRingSize()) do not
+  //! need to scan every ring. The index is built by BuildIndex() when the
+  //! rings are perceived, and never by the queries, so these only read the
+  //! object. A query that finds the index out of date scans the rings.
  class OBAPI OBRingData : public OBGenericData
   {
   protected:
     std::vector<OBRing*> _vr;
+    std::vector<OBRingMembership> _atomRings; //!< indexed by atom Idx
+    std::vector<OBRingMembership> _bondRings; //!< indexed by bond Idx
+    std::vector<OBRing*> _indexedRings; //!< the rings when the index was built
+    bool _indexed;
+    //! \return Whether the index describes the rings of @p mol: it was
+    //! built from the current rings, and @p mol has not been modified in a
+    //! way that unsets its ring perception since
+    bool IndexIsCurrent(OBMol &mol) const;
   public:
     OBRingData();
     OBRingData(const OBRingData &);
@@ -272,10 +305,12 @@ namespace OpenBabel
     void SetData(std::vector<OBRing*> &vr)
     {
       _vr = vr;
+      _indexed = false;
     }
     void PushBack(OBRing *r)
     {
       _vr.push_back(r);
+      _indexed = false;
     }
     std::vector<OBRing*> &GetData()
       {
@@ -288,6 +323,19 @@ namespace OpenBabel
       { return(_vr.end()); }
     OBRing *BeginRing(std::vector<OBRing*>::iterator &i);
     OBRing *NextRing(std::vector<OBRing*>::iterator &i);
+
+    //! Build the atom and bond ring membership index of the rings in @p mol.
+    //! A bond is taken to be in a ring if both of its atoms are, as in
+    //! OBRing::IsMember(OBBond*). Call it again after changing the rings
+    //! through GetData().
+    //! \since version 3.1
+    void BuildIndex(OBMol &mol);
+    //! \return The rings containing @p atom, from the index if it is current
+    //! \since version 3.1
+    OBRingMembership GetMembership(OBAtom *atom) const;
+    //! \return The rings containing @p bond, from the index if it is current
+    //! \since version 3.1
+    OBRingMembership GetMembership(OBBond *bond) const;
   };
 
   //! \class OBUnitCell generic.h <openbabel/generic.h>
@@ -377,6 +425,14 @@ namespace OpenBabel
     //! Duplicate symmetry-unique atoms to fill out the unit cell
     //! of the molecule, based on the known space group
     void FillUnitCell(OBMol *);
+    //! Replicate the atoms and bonds of \p mol \p na, \p nb and \p nc times
+    //! along the cell vectors and enlarge the cell to match. Bonds through
+    //! the cell faces join the matching copies, so the supercell is bonded
+    //! periodically as the cell was. The cell must already be filled (see
+    //! FillUnitCell()); afterwards it is treated as P1.
+    //! \return false if a count is zero
+    //! \since version 3.1
+    bool MakeSupercell(OBMol *mol, unsigned int na, unsigned int nb, unsigned int nc);
 
     //! @todo Remove nonconst overloads in OBUnitCell on next version bump
 
@@ -487,6 +543,21 @@ namespace OpenBabel
     //! \todo Make OBUnitCell::WrapFractionalCoordinate static in the next ABI break
     vector3 WrapFractionalCoordinate(vector3 frac);
     vector3 WrapFractionalCoordinate(vector3 frac) const;
+    //! Shortest equivalent of a displacement under the lattice translations.
+    //! Rounds each component, then tries the neighboring images, which is
+    //! exact unless the cell is very oblique.
+    //! \param frac Displacement in fractional coordinates
+    //! \return \p frac less the lattice vector that makes it shortest in
+    //! Cartesian space
+    //! \since version 3.1
+    vector3 MinimumImageFractional(vector3 frac) const;
+    //! \param cart Displacement in Cartesian coordinates
+    //! \return The shortest Cartesian displacement equivalent to \p cart
+    //! \since version 3.1
+    vector3 MinimumImageCartesian(vector3 cart) const;
+    //! \return The distance from \p cart1 to the nearest periodic image of \p cart2
+    //! \since version 3.1
+    double MinimumImageDistance(const vector3 &cart1, const vector3 &cart2) const;
 
     //! \return The numeric value of the given spacegroup
     int GetSpaceGroupNumber( std::string name = "" );
@@ -40,6 +40,11 @@ namespace OpenBabel
 
       This is the base class for calculations that use the JOELib2 contribution
       algorithm.
+
+      The SMARTS of all the data files are kept together, each pattern once,
+      and every atom is typed against them in a single pass that the
+      instances share. Asking for logP, MR and TPSA of a molecule prepares
+      it once and tries each pattern at most once per atom.
     */
 class OBDESC OBGroupContrib : public OBDescriptor
 {
@@ -64,13 +69,20 @@ public:
 
   virtual double Predict(OBBase* pOb, std::string* param=NULL);
 
+  //! Thread-safe unless the data file asks for debugging output
+  virtual bool IsThreadSafe() { return !_debug; }
+
  private:
   bool ParseFile();
 
   const char* _filename;
   const char* _descr;
-  std::vector<std::pair<OBSmartsPattern*, double> > _contribsHeavy; //! heavy atom contributions
-  std::vector<std::pair<OBSmartsPattern*, double> > _contribsHydrogen; //!  hydrogen contributions
+  //! heavy atom contributions, as the index of the shared pattern and the value
+  std::vector<std::pair<unsigned int, double> > _contribsHeavy;
+  //! hydrogen contributions, likewise
+  std::vector<std::pair<unsigned int, double> > _contribsHydrogen;
+  //! the contributions whose first atom could match each atomic number
+  std::vector<std::vector<unsigned int> > _heavyIndex, _hydrogenIndex;
   bool _debug;
 };
 
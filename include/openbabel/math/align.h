@@ -170,6 +170,24 @@ namespace OpenBabel
     bool UpdateCoords(OBMol* target);
     //@}
 
+    ///@name Conformer ensembles
+    //@{
+    /**
+     * Compute the RMSD between every pair of conformers of @p mol using
+     * the current @p includeH and @p symmetry settings. The automorphisms
+     * are found once for the whole ensemble and the pairs are evaluated
+     * with the QCP method (in parallel when built with OpenMP).
+     *
+     * The result is the condensed upper triangle of the matrix, suitable
+     * for clustering: the RMSD of conformers i < j (0-based) is stored at
+     * index n*i - i*(i+1)/2 + (j-i-1), where n is the number of conformers.
+     * An empty vector is returned if there are fewer than two conformers.
+     * The reference and target of this instance are left unchanged.
+     * @since version 3.1
+     */
+    std::vector<double> GetRMSDMatrix(const OBMol &mol) const;
+    //@}
+
   private:
     bool _ready;
     bool _fail;
@@ -0,0 +1,89 @@
+/**********************************************************************
+periodicgrid.h - Neighbor search over points in a periodic cell
+
+This file is part of the Open Babel project.
+For more information, see <http://openbabel.org/>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+***********************************************************************/
+
+#ifndef OB_PERIODICGRID_H
+#define OB_PERIODICGRID_H
+
+#include <openbabel/babelconfig.h>
+#include <openbabel/math/vector3.h>
+#include <openbabel/math/matrix3x3.h>
+
+#include <vector>
+#include <unordered_map>
+
+namespace OpenBabel
+{
+
+  /** \class OBPeriodicGrid periodicgrid.h <openbabel/math/periodicgrid.h>
+      \brief Find points within a cutoff distance in a periodic cell
+
+      Points are given in fractional coordinates and binned on a grid that
+      wraps around the cell, so a search also finds periodic images of the
+      stored points. Only occupied bins are stored, so the cutoff may be
+      much smaller than the cell (e.g. a tolerance for duplicate atoms).
+
+      Distances are measured with the matrix passed to the constructor, which
+      takes fractional to Cartesian coordinates (the transpose of
+      OBUnitCell::GetCellMatrix()). The identity matrix measures distances in
+      fractional coordinates.
+
+      \since version 3.1
+      \sa OBUnitCell
+  */
+  class OBAPI OBPeriodicGrid
+  {
+  public:
+    //! A stored point found by GetNeighbors()
+    struct Neighbor
+    {
+      unsigned int index; //!< the value returned by Add() for the point
+      vector3 delta;      //!< vector from the query to the image of the point found
+    };
+
+    OBPeriodicGrid(const matrix3x3 &fracToCart, double cutoff);
+
+    //! Store a point, which need not be inside the cell
+    //! \return its index, counting from zero in the order added
+    unsigned int Add(const vector3 &frac);
+    //! \return the number of points stored
+    unsigned int Size() const { return static_cast<unsigned int>(_next.size()); }
+    //! Remove all points, keeping the cell and cutoff
+    void Clear();
+
+    //! Replace the contents of \p result by the stored points with an image
+    //! no further than the cutoff from \p frac. A point can be listed once
+    //! for each such image when the cutoff is larger than half the cell.
+    void GetNeighbors(const vector3 &frac, std::vector<Neighbor> &result) const;
+
+  private:
+    unsigned long long BinKey(const int bin[3]) const;
+    void Locate(const vector3 &frac, vector3 &wrapped, int bin[3]) const;
+
+    matrix3x3 _fracToCart;
+    double _cutoffSq;
+    int _bins[3];  //!< bins along each cell vector
+    int _reach[3]; //!< bins on each side to search
+    std::vector<vector3> _points;      //!< wrapped into [0,1)
+    std::vector<unsigned int> _next;   //!< next point in the same bin
+    std::unordered_map<unsigned long long, unsigned int> _heads; //!< first point in each bin
+  };
+
+} // namespace OpenBabel
+
+#endif // OB_PERIODICGRID_H
+
+//! \file periodicgrid.h
+//! \brief Neighbor search over points in a periodic cell
@@ -23,6 +23,7 @@ GNU General Public License for more details.
 #include <openbabel/math/transform3d.h>
 #include <string>
 #include <list>
+#include <vector>
 
 namespace OpenBabel
 {
@@ -54,6 +55,12 @@ namespace OpenBabel
         unsigned int GetOriginAlternative() const
             { return m_OriginAlternative; }
       std::list<vector3> Transform(const vector3 &v) const;
+        //! Apply every transformation to each of \p coords, without wrapping
+        //! or removing duplicates. The image of coords[i] by the k-th
+        //! transformation is result[k * coords.size() + i].
+        //! \since version 3.1
+        void Transform(const std::vector<vector3> &coords,
+                       std::vector<vector3> &result) const;
 
         transform3d const * BeginTransform(transform3dIterator &i) const;
         transform3d const * NextTransform(transform3dIterator &i) const;
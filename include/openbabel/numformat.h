@@ -0,0 +1,51 @@
+/**********************************************************************
+numformat.h - Locale-independent fixed-width number formatting
+
+This file is part of the Open Babel project.
+For more information, see <http://openbabel.org/>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+***********************************************************************/
+
+#ifndef OB_NUMFORMAT_H
+#define OB_NUMFORMAT_H
+
+#include <openbabel/babelconfig.h>
+
+#include <string>
+
+namespace OpenBabel
+{
+  // Helpers for the column-based text writers (MDL, PDB, mol2, ...). Each
+  // appends exactly what the corresponding printf conversion would write in
+  // the "C" locale, without parsing a format string, so a record can be built
+  // in one std::string and written to the stream in a single call.
+
+  //! Append \p value as printf("%*.*f", width, precision) would, or as
+  //! printf("%+*.*f", width, precision) if \p showSign is true
+  //! \since version 3.1
+  OBAPI void AppendFixed(std::string& s, double value, int width, int precision,
+                         bool showSign = false);
+
+  //! Append \p value as printf("%*d", width) would
+  //! \since version 3.1
+  OBAPI void AppendInt(std::string& s, long value, int width = 0);
+
+  //! Append \p text as printf("%*s", width) would, or printf("%-*s", width)
+  //! if \p left is true
+  //! \since version 3.1
+  OBAPI void AppendPadded(std::string& s, const char* text, int width, bool left = false);
+
+} // namespace OpenBabel
+
+#endif // OB_NUMFORMAT_H
+
+//! \file numformat.h
+//! \brief Locale-independent fixed-width number formatting
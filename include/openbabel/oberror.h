@@ -133,7 +133,7 @@ namespace OpenBabel
       unsigned int GetMaxLogEntries() { return _maxEntries; }
 
       //! Clear the current message log entirely
-      void ClearLog() { _messageList.clear(); }
+      void ClearLog();
 
       //! \brief Set the level of messages to output
       //! (i.e., messages with at least this priority will be output)
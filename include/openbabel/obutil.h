@@ -31,6 +31,7 @@ GNU General Public License for more details.
 #else
 #if HAVE_SYS_TIME_H
 #include <sys/time.h>
+#include <time.h>
 #else
 #include <time.h>
 #endif
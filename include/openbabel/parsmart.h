@@ -285,6 +285,18 @@ namespace OpenBabel
     //! \return Whether there exists any match
     bool HasMatch(OBMol &mol) const;
 
+    //! Thread safe check for a match whose first pattern atom is @p atom.
+    //! Only the neighbourhood of @p atom is searched, which is much faster
+    //! than Match() when a pattern is tested against a single atom.
+    //! \since version 3.1
+    bool MatchesAt(OBAtom *atom) const;
+
+    //! Set @p elements[n] (resized to 119 entries) for each atomic number n
+    //! that the first pattern atom could match. Anything other than element
+    //! primitives and their logical combinations is taken to match all.
+    //! \since version 3.1
+    void GetFirstAtomElements(std::vector<bool> &elements) const;
+
     bool RestrictedMatch(OBMol &mol, std::vector<std::pair<int,int> > &pairs, bool single=false);
 
     bool RestrictedMatch(OBMol &mol, OBBitVec &bv, bool single=false);
@@ -342,6 +354,8 @@ namespace OpenBabel
 	  std::vector<std::pair<const Pattern*,std::vector<bool> > > RSCACHE;
 	  // list of fragment patterns (e.g., (*).(*)
 	  std::vector<const Pattern*> Fragments;
+	  // evaluate recursive SMARTS only at the atom in question (see matchAt())
+	  bool Rooted;
     /*
       bool EvalAtomExpr(AtomExpr *expr,OBAtom *atom);
       bool EvalBondExpr(BondExpr *expr,OBBond *bond);
@@ -354,13 +368,17 @@ namespace OpenBabel
 	                           const Pattern *pat, OBMol &mol);
     void FastSingleMatch(OBMol &mol,const Pattern *pat,
                          std::vector<std::vector<int> > &mlist);
+    bool RootedMatch(OBMol &mol,const Pattern *pat,OBAtom *root);
 
     friend class OBSSMatch;
   public:
-    OBSmartsMatcher() {}
+    OBSmartsMatcher() : Rooted(false) {}
     virtual ~OBSmartsMatcher() {}
 
     bool match(OBMol &mol, const Pattern *pat,std::vector<std::vector<int> > &mlist,bool single=false);
+    //! \return whether there is a match of @p pat with its first atom at @p root.
+    //! The pattern must be connected and without chirality.
+    bool matchAt(OBMol &mol, const Pattern *pat, OBAtom *root);
 
   };
 
@@ -0,0 +1,127 @@
+/**********************************************************************
+propertyview.h - Structure-of-arrays snapshot of atom properties
+
+This file is part of the Open Babel project.
+For more information, see <http://openbabel.org/>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+***********************************************************************/
+
+#ifndef OB_PROPERTYVIEW_H
+#define OB_PROPERTYVIEW_H
+
+#include <openbabel/babelconfig.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace OpenBabel
+{
+  class OBMol;
+
+  /**
+   * @class OBMolPropertyView propertyview.h <openbabel/propertyview.h>
+   * @brief Per-atom properties of a molecule as contiguous arrays
+   *
+   * Getters such as OBAtom::IsAromatic() and OBAtom::IsInRing() check the
+   * molecule's perception flags on every call, and degree, valence and
+   * hydrogen counts are recomputed from the bond list each time. Code that
+   * looks at the same properties of every atom (fingerprints, invariants)
+   * can instead fill a view once and index the arrays by
+   * OBAtom::GetIdx() - 1:
+   * \code
+   * OBMolPropertyView view(mol);
+   * for (unsigned int i = 0; i < view.NumAtoms(); ++i)
+   *   if (view.GetAtomicNums()[i] == 6 && view.IsAromatic(i))
+   *     ...
+   * \endcode
+   * Filling the view triggers ring perception (and hybridization if
+   * requested). Aromaticity is only perceived on the first call to
+   * IsAromatic() or GetFlags(), as OBAtom::IsAromatic() does, so code that
+   * does not look at it does not pay for it. The view is a snapshot; call
+   * Update() after modifying the molecule.
+   *
+   * Only the ECFP fingerprints use a view, for their initial atom
+   * invariants. SMARTS matching, FP2/FP3 and canonical labelling still query
+   * OBAtom: the SMARTS matcher takes only a molecule through the public
+   * OBSmartsPattern::Match() API, FP2 walks bond paths and needs only
+   * atomic numbers, FP3 is a set of SMARTS matches, and OBGraphSym
+   * already fills its own invariant arrays once per molecule. Using a view
+   * there is left for later.
+   * @since version 3.1
+   */
+  class OBAPI OBMolPropertyView
+  {
+  public:
+    //! Bits of GetFlags()
+    enum Flag {
+      Aromatic = 1,
+      InRing   = 2
+    };
+
+    OBMolPropertyView() : _mol(NULL), _hasAromatic(false) {}
+    //! Fill the view from @p mol, see Update()
+    explicit OBMolPropertyView(OBMol &mol, bool hybridization = false)
+      : _mol(NULL), _hasAromatic(false)
+    { Update(mol, hybridization); }
+
+    //! Refill the arrays from @p mol. GetHybs() is only filled if
+    //! @p hybridization is true since perceiving it runs the atom typer.
+    void Update(OBMol &mol, bool hybridization = false);
+
+    unsigned int NumAtoms() const { return static_cast<unsigned int>(_atomicNum.size()); }
+
+    const std::vector<unsigned char>&  GetAtomicNums() const      { return _atomicNum; }
+    const std::vector<unsigned short>& GetIsotopes() const        { return _isotope; }
+    const std::vector<signed char>&    GetFormalCharges() const   { return _charge; }
+    //! OBAtom::GetImplicitHCount()
+    const std::vector<unsigned char>&  GetImplicitHCounts() const { return _implicitH; }
+    //! OBAtom::ExplicitHydrogenCount()
+    const std::vector<unsigned char>&  GetExplicitHCounts() const { return _explicitH; }
+    //! OBAtom::GetExplicitDegree()
+    const std::vector<unsigned char>&  GetDegrees() const         { return _degree; }
+    //! OBAtom::GetHvyDegree()
+    const std::vector<unsigned char>&  GetHeavyDegrees() const    { return _heavyDegree; }
+    //! OBAtom::GetExplicitValence()
+    const std::vector<unsigned char>&  GetValences() const        { return _valence; }
+    //! OBAtom::GetHyb(), empty unless requested in Update()
+    const std::vector<unsigned char>&  GetHybs() const            { return _hyb; }
+    //! Flag bits for each atom, perceiving aromaticity if needed
+    const std::vector<unsigned char>&  GetFlags() const
+    { if (!_hasAromatic) FillAromatic(); return _flags; }
+
+    bool IsAromatic(unsigned int i) const
+    { if (!_hasAromatic) FillAromatic(); return (_flags[i] & Aromatic) != 0; }
+    bool IsInRing(unsigned int i) const   { return (_flags[i] & InRing) != 0; }
+
+  private:
+    //! Set the Aromatic bits, perceiving aromaticity of the molecule first
+    void FillAromatic() const;
+
+    OBMol                      *_mol;
+    mutable bool                _hasAromatic;
+    std::vector<unsigned char>  _atomicNum;
+    std::vector<unsigned short> _isotope;
+    std::vector<signed char>    _charge;
+    std::vector<unsigned char>  _implicitH;
+    std::vector<unsigned char>  _explicitH;
+    std::vector<unsigned char>  _degree;
+    std::vector<unsigned char>  _heavyDegree;
+    std::vector<unsigned char>  _valence;
+    std::vector<unsigned char>  _hyb;
+    mutable std::vector<unsigned char> _flags;
+  };
+
+} // namespace OpenBabel
+
+#endif // OB_PROPERTYVIEW_H
+
+//! \file propertyview.h
+//! \brief Structure-of-arrays snapshot of atom properties
@@ -21,6 +21,8 @@ GNU General Public License for more details.
 #define OB_RING_H
 
 #include <deque>
+#include <set>
+#include <vector>
 #include <algorithm>
 
 // TODO: Make this work as a free-standing header
@@ -119,6 +121,18 @@ namespace OpenBabel
   {
     std::vector<OBBond*> _bonds; //!< the internal list of closure bonds (deprecated)
     std::vector<OBRing*> _rlist; //!< the internal list of rings
+
+    //! \name Workspace reused by every AddRingFromClosure() call of a search
+    //@{
+    std::vector<int> _tree1, _tree2; //!< BFS parent of each atom: 0 for the root, -1 if not reached
+    std::vector<int> _curr, _next;   //!< current and next BFS level
+    std::vector<int> _path1, _path2; //!< paths from an atom to the roots
+    std::vector<int> _p1, _p2;       //!< the two halves of a candidate ring
+    std::set<std::vector<int> > _seen; //!< sorted atoms of each ring in _rlist
+    //@}
+
+    void BuildTree(OBMol &mol, OBAtom *root, int excluded, std::vector<int> &tree);
+    bool SaveRing(const std::vector<int> &p1, const std::vector<int> &p2);
   public:
     OBRingSearch()    {}
     ~OBRingSearch();
@@ -133,7 +147,9 @@ namespace OpenBabel
         (*j)->ring_id = ring_id;
       std::sort(_rlist.begin(),_rlist.end(),CompareRingSize);
     }
-    //! Starting with a full ring set - reduce to SSSR set
+    //! Starting with a full ring set sorted by SortRings() - reduce to the
+    //! SSSR set, using Gaussian elimination of the ring bonds over GF(2),
+    //! or to the LSSR set if the argument is negative
     void    RemoveRedundant(int);
     //! Add a new ring from a "closure" bond: See OBBond::IsClosure()
     void    AddRingFromClosure(OBMol &,OBBond *);
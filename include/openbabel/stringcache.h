@@ -0,0 +1,194 @@
+/**********************************************************************
+stringcache.h - Memoisation of strings computed from molecular graphs
+
+This file is part of the Open Babel project.
+For more information, see <http://openbabel.org/>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+***********************************************************************/
+
+#ifndef OB_STRINGCACHE_H
+#define OB_STRINGCACHE_H
+
+#include <openbabel/babelconfig.h>
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace OpenBabel
+{
+  class OBMol;
+
+  /**
+   * @class OBMolStringCache stringcache.h <openbabel/stringcache.h>
+   * @brief Size-bounded LRU cache of strings computed from molecules
+   *
+   * Canonical SMILES and InChI(Key)s are expensive to generate but streams
+   * often contain the same structure many times. The cansmi, cansmiNS, InChI
+   * and InChIKey descriptors (and hence --unique) look up their result in
+   * Default() before regenerating it.
+   *
+   * Entries are looked up by a Key built with GraphKey(). Its hash does not
+   * depend on the atom order or the coordinates: it combines atom invariants
+   * (element, charge, isotope, hydrogen count, spin, aromaticity) refined
+   * over the bond orders and adjacency, and the stereo descriptors. As
+   * different graphs can have the same hash, a hit also requires a mapping
+   * of the atoms onto those of the cached graph that keeps every atom, bond
+   * and stereo descriptor. A hash collision is counted and treated as a miss
+   * rather than returning the wrong string.
+   *
+   * The cache is disabled (maximum size 0) unless SetMaxSize() is called or
+   * the environment variable BABEL_STRINGCACHE is set to the number of
+   * entries when Default() is first used. All methods are thread-safe.
+   * @since version 3.1
+   */
+  class OBAPI OBMolStringCache
+  {
+  public:
+    //! Hit and miss counts since construction or the last ResetStatistics()
+    struct Statistics
+    {
+      unsigned long hits;
+      unsigned long misses;
+      unsigned long collisions; //!< misses caused by a hash collision
+      unsigned long evictions;
+      std::size_t size;         //!< number of entries currently held
+      //! \return the fraction of lookups that were hits, or 0 if there were none
+      double HitRate() const
+      { return hits + misses ? double(hits) / (hits + misses) : 0.0; }
+    };
+
+    /**
+     * @brief The lookup key for a molecule, see GraphKey()
+     *
+     * Holds the hash and a compact copy of the graph, which is compared
+     * with that of a cached entry with the same hash.
+     */
+    class OBAPI Key
+    {
+    public:
+      Key() : _hash(0), _dim(0) {}
+      unsigned long long GetHash() const { return _hash; }
+      //! \return whether @p other is the same molecule for the same kind of string
+      bool Matches(const Key& other) const;
+
+    private:
+      friend class OBMolStringCache;
+      struct Tetrahedral
+      {
+        int center;
+        bool specified;
+        int ligands[4]; //!< looking from the first, the others clockwise; -1 is an implicit H
+      };
+      struct CisTrans
+      {
+        int begin, end;
+        bool specified;
+        int refs[4];    //!< in the U shape; -1 is an implicit H
+      };
+      typedef std::vector<std::pair<unsigned int, unsigned int> > Neighbors; //!< atom, bond code
+
+      //! Map the atoms onto those of @p other; on success @p tetrahedral and
+      //! @p cistrans are the indices of the corresponding stereo in @p other
+      bool Map(const Key& other, std::vector<int>& tetrahedral, std::vector<int>& cistrans) const;
+      //! Whether @p map of the atoms onto those of @p other keeps the stereo
+      bool StereoMatches(const Key& other, const std::vector<int>& map,
+                         const std::vector<int>& otherTetrahedral,
+                         std::vector<int>& tetrahedral, std::vector<int>& cistrans) const;
+
+      std::string _kind;
+      unsigned long long _hash;
+      int _dim;
+      std::vector<unsigned long long> _labels;  //!< per atom: element, charge, ...
+      std::vector<unsigned long long> _classes; //!< per atom: refined invariant
+      std::vector<Neighbors> _nbrs;
+      std::vector<Tetrahedral> _tetrahedral;
+      std::vector<CisTrans> _cistrans;
+    };
+
+    explicit OBMolStringCache(std::size_t maxSize = 0);
+
+    //! \return the cache used by the canonical SMILES and InChI descriptors
+    static OBMolStringCache& Default();
+
+    //! Set the maximum number of entries; 0 disables and empties the cache
+    void SetMaxSize(std::size_t maxSize);
+    std::size_t GetMaxSize() const;
+    bool IsEnabled() const { return GetMaxSize() != 0; }
+
+    /**
+     * Build the lookup key for @p mol. @p kind distinguishes the strings
+     * computed for the same molecule (e.g. the descriptor ID). Stereo is
+     * perceived first, as the writers do, so that the key needs neither
+     * coordinates nor wedges.
+     * @return false for reactions, for molecules carrying data that the
+     * writers use instead of the graph (a stored InChI, a SMILES fragment
+     * selection or external bonds) and for square planar stereo, in which
+     * case the result should not be cached.
+     */
+    static bool GraphKey(OBMol& mol, const std::string& kind, Key& key);
+
+    //! Look up @p key; on a hit copies the value and marks it most recently used
+    bool Find(const Key& key, std::string& value);
+    /**
+     * Look up @p key, built from @p mol. On a hit, also marks as unspecified
+     * the stereo of @p mol that was marked so while computing the cached
+     * value (see Insert()), so that @p mol is changed as on a miss.
+     */
+    bool Find(OBMol& mol, const Key& key, std::string& value);
+    //! Store @p value for @p key, evicting the least recently used entry if full
+    void Insert(const Key& key, const std::string& value);
+    /**
+     * Store @p value for @p key, built from @p mol before computing the
+     * value. Writers such as canonical SMILES mark stereo that turns out not
+     * to be stereogenic as unspecified; this is recorded so that Find()
+     * can repeat it on a hit.
+     */
+    void Insert(OBMol& mol, const Key& key, const std::string& value);
+
+    //! Remove all entries (the statistics are kept)
+    void Clear();
+    Statistics GetStatistics() const;
+    void ResetStatistics();
+
+  private:
+    struct Entry
+    {
+      Key key;
+      std::string value;
+      //! tetrahedral and cis/trans stereo of the key marked as unspecified
+      std::pair<std::vector<bool>, std::vector<bool> > unspecified;
+    };
+    typedef std::list<Entry> EntryList;
+
+    bool Find(const Key& key, std::string& value,
+              std::vector<int>& tetrahedral, std::vector<int>& cistrans);
+    void Insert(const Entry& entry);
+
+    void Trim(); //!< evict down to _maxSize; caller holds _mutex
+
+    mutable std::mutex _mutex;
+    std::size_t _maxSize;
+    EntryList _entries; //!< most recently used first
+    std::map<unsigned long long, EntryList::iterator> _index;
+    Statistics _stats;
+  };
+
+} // namespace OpenBabel
+
+#endif // OB_STRINGCACHE_H
+
+//! \file stringcache.h
+//! \brief Memoisation of canonical strings computed from molecules
@@ -40,6 +40,9 @@ class OBAPI OBAtomTyper : public OBGlobalDataBase
 {
   std::vector<std::pair<OBSmartsPattern*,int> >            _vinthyb; //!< internal hybridization rules
   std::vector<std::pair<OBSmartsPattern*,std::string> >    _vexttyp; //!< external atom type rules
+  //! for each atomic number, the indices of the rules that could match it
+  std::vector<std::vector<unsigned int> >  _inthybIndex;
+  std::vector<std::vector<unsigned int> >  _exttypIndex;
 
 public:
     OBAtomTyper();
@@ -87,6 +90,7 @@ THREAD_LOCAL EXTERN OBAromaticTyper  aromtyper;
 class OBAPI OBRingTyper : public OBGlobalDataBase
 {
   std::vector<std::pair<OBSmartsPattern*,std::string> >    _ringtyp; //!< ring type rules
+  std::vector<std::vector<bool> >  _ringElements; //!< possible first atoms of each rule
 
 public:
     OBRingTyper();
@@ -25,6 +25,7 @@ GNU General Public License for more details.
 #include <openbabel/obiter.h>
 #include <openbabel/molchrg.h>
 #include <openbabel/ring.h>
+#include <openbabel/generic.h>
 #include <openbabel/phmodel.h>
 #include <openbabel/builder.h>
 #include <openbabel/elements.h>
@@ -189,8 +190,9 @@ namespace OpenBabel
 
     _vdata.clear();
     //Copy all the OBGenericData, providing the new atom
-    vector<OBGenericData*>::iterator itr;
-    for(itr=src->BeginData();itr!=src->EndData();++itr)
+    const vector<OBGenericData*> &vdata = static_cast<const OBAtom*>(src)->GetData();
+    vector<OBGenericData*>::const_iterator itr;
+    for(itr=vdata.begin();itr!=vdata.end();++itr)
       {
         OBGenericData* pCopiedData = (*itr)->Clone(this);
         SetData(pCopiedData);
@@ -802,11 +804,15 @@ namespace OpenBabel
     return stereoFacade.HasTetrahedralStereo(_id);
   }
 
-  bool OBAtom::IsInRingSize(int size) const
+  //! \return The SSSR ring data of @p mol, perceiving the rings if needed
+  static OBRingData *GetSSSRData(OBMol *mol)
   {
-    vector<OBRing*> rlist;
-    vector<OBRing*>::iterator i;
+    mol->GetSSSR();
+    return static_cast<OBRingData*>(mol->GetData("SSSR"));
+  }
 
+  bool OBAtom::IsInRingSize(int size) const
+  {
     OBMol *mol = (OBMol*)((OBAtom*)this)->GetParent();
     if (!mol->HasSSSRPerceived())
       mol->FindSSSR();
@@ -814,8 +820,13 @@ namespace OpenBabel
     if (!((OBAtom*)this)->HasFlag(OB_RING_ATOM))
       return(false);
 
-    rlist = mol->GetSSSR();
-    for (i = rlist.begin();i != rlist.end();++i)
+    OBRingData *rd = GetSSSRData(mol);
+    if (size < 64)
+      return rd->GetMembership((OBAtom*)this).HasSize(size);
+
+    // Ring sizes of 64 and above are not in the index
+    vector<OBRing*>::iterator i;
+    for (i = rd->BeginRings();i != rd->EndRings();++i)
       if ((*i)->IsInRing(GetIdx()) && static_cast<int>((*i)->PathSize()) == size)
         return(true);
 
@@ -824,10 +835,6 @@ namespace OpenBabel
 
   unsigned int OBAtom::MemberOfRingCount() const
   {
-    vector<OBRing*> rlist;
-    vector<OBRing*>::iterator i;
-    unsigned int count=0;
-
     OBMol *mol = (OBMol*)((OBAtom*)this)->GetParent();
 
     if (!mol->HasSSSRPerceived())
@@ -836,20 +843,11 @@ namespace OpenBabel
     if (!((OBAtom*)this)->IsInRing())
       return(0);
 
-    rlist = mol->GetSSSR();
-
-    for (i = rlist.begin();i != rlist.end();++i)
-      if ((*i)->IsInRing(GetIdx()))
-        count++;
-
-    return((unsigned int)count);
+    return GetSSSRData(mol)->GetMembership((OBAtom*)this).count;
   }
 
   unsigned int OBAtom::MemberOfRingSize() const
   {
-    vector<OBRing*> rlist;
-    vector<OBRing*>::iterator i;
-
     OBMol *mol = (OBMol*)((OBAtom*)this)->GetParent();
 
     if (!mol->HasSSSRPerceived())
@@ -858,13 +856,7 @@ namespace OpenBabel
     if (!((OBAtom*)this)->IsInRing())
       return(0);
 
-    rlist = mol->GetSSSR();
-
-    for (i = rlist.begin();i != rlist.end();++i)
-      if ((*i)->IsInRing(GetIdx()))
-        return((*i)->Size());
-
-    return(0);
+    return GetSSSRData(mol)->GetMembership((OBAtom*)this).firstSize;
   }
 
   unsigned int OBAtom::CountRingBonds() const
@@ -22,6 +22,9 @@ GNU General Public License for more details.
 #include <openbabel/babelconfig.h>
 #include <openbabel/base.h>
 
+#include <memory>
+#include <unordered_map>
+
 using namespace std;
 
 //! Global namespace for all Open Babel code
@@ -68,6 +71,156 @@ namespace OpenBabel
   an appropriate derived class from OBBase.
   */
 
+  void OBGenericData::SetAttribute(const std::string &v)
+  {
+    if (_indexRenames && v != _attr)
+      ++*_indexRenames; // the index of the object holding this is stale
+    _attr = v;
+  }
+
+  // Objects with at most this many data items are searched linearly
+  static const size_t DataIndexThreshold = 8;
+  static const unsigned int NoDataItem = ~0u;
+
+  /* Lookup tables over OBBase::_vdata: the first item for each attribute, and
+     for each data type its first and last items, chained in order.
+
+     The index is built and updated only by the OBBase methods that change
+     _vdata, which also bump OBBase::_dataGeneration, so lookups only read it
+     and several threads can look up data in the same object. It is used while
+     it was built at the current generation, covers every item and none of its
+     items has been renamed since; otherwise lookups are linear until the next
+     change through OBBase rebuilds it. The accessors that allow _vdata to be
+     changed directly bump the generation as well, and each item found through
+     the index is checked to still be at its position, for changes made
+     through a reference kept from before the last rebuild.
+  */
+  class OBDataIndex
+  {
+  public:
+    struct TypeItems
+    {
+      unsigned int type, first, last;
+    };
+
+    unsigned long generation;
+    std::shared_ptr<unsigned long> renames; // bumped by renaming an item
+    unsigned long renamesAtBuild;
+    std::unordered_map<std::string, unsigned int> byAttribute;
+    std::vector<TypeItems> byType; // only a few types per object
+    std::vector<unsigned int> nextOfType;
+    std::vector<OBGenericData*> items; // as they were indexed
+
+    OBDataIndex() : generation(0), renames(std::make_shared<unsigned long>(0)),
+                    renamesAtBuild(0) {}
+
+    bool Matches(const std::vector<OBGenericData*> &vdata, unsigned long gen) const
+    {
+      return generation == gen && items.size() == vdata.size() &&
+        *renames == renamesAtBuild;
+    }
+
+    //! \return whether item @p idx is still where it was indexed
+    bool Holds(const std::vector<OBGenericData*> &vdata, unsigned int idx) const
+    {
+      return vdata[idx] == items[idx];
+    }
+
+    void Build(const std::vector<OBGenericData*> &vdata, unsigned long gen)
+    {
+      generation = gen;
+      renamesAtBuild = *renames;
+      byAttribute.clear();
+      byType.clear();
+      nextOfType.clear();
+      items.clear();
+      for (size_t i = 0; i < vdata.size(); ++i)
+        Add(vdata[i]);
+    }
+
+    void Add(OBGenericData *d)
+    {
+      unsigned int idx = static_cast<unsigned int>(items.size());
+      items.push_back(d);
+      nextOfType.push_back(NoDataItem);
+      d->_indexRenames = renames;
+      byAttribute.insert(std::make_pair(d->GetAttribute(), idx)); // keeps the first
+      TypeItems *t = FindType(d->GetDataType());
+      if (t) {
+        nextOfType[t->last] = idx;
+        t->last = idx;
+      }
+      else {
+        TypeItems added = { d->GetDataType(), idx, idx };
+        byType.push_back(added);
+      }
+    }
+
+    const TypeItems *FindType(unsigned int type) const
+    {
+      for (size_t i = 0; i < byType.size(); ++i)
+        if (byType[i].type == type)
+          return &byType[i];
+      return NULL;
+    }
+
+    TypeItems *FindType(unsigned int type)
+    {
+      return const_cast<TypeItems*>(static_cast<const OBDataIndex*>(this)->FindType(type));
+    }
+
+    unsigned int FindAttribute(const std::string &s) const
+    {
+      std::unordered_map<std::string, unsigned int>::const_iterator i = byAttribute.find(s);
+      return i == byAttribute.end() ? NoDataItem : i->second;
+    }
+  };
+
+  OBBase &OBBase::operator=(const OBBase &src)
+  {
+    if (this != &src) {
+      _vdata = src._vdata;
+      ++_dataGeneration;
+      UpdateDataIndex();
+    }
+    return *this;
+  }
+
+  OBBase::~OBBase()
+  {
+    if (!_vdata.empty())
+      {
+        std::vector<OBGenericData*>::iterator m;
+        for (m = _vdata.begin();m != _vdata.end();m++)
+          delete *m;
+        _vdata.clear();
+      }
+    delete _dataIndex;
+  }
+
+  //! \return the index over _vdata, or NULL if there is none or it is out of
+  //! date. Does not change the object.
+  const OBDataIndex *OBBase::DataIndex() const
+  {
+    if (_dataIndex && _dataIndex->Matches(_vdata, _dataGeneration))
+      return _dataIndex;
+    return NULL;
+  }
+
+  //! Bring the index up to date after _vdata was changed, or remove it if
+  //! there are too few items to need one
+  void OBBase::UpdateDataIndex()
+  {
+    if (_vdata.size() <= DataIndexThreshold) {
+      delete _dataIndex;
+      _dataIndex = NULL;
+      return;
+    }
+    if (!_dataIndex)
+      _dataIndex = new OBDataIndex;
+    _dataIndex->Build(_vdata, _dataGeneration);
+  }
+
   //!
   //! This method can be called by OBConversion::Read() before reading data.
   //! Derived classes should be sure to call OBBase::Clear() to remove
@@ -84,6 +237,8 @@ namespace OpenBabel
           delete *m;
         _vdata.clear();
       }
+    ++_dataGeneration;
+    UpdateDataIndex();
 
     return(true);
   }
@@ -94,6 +249,12 @@ namespace OpenBabel
     if (_vdata.empty())
       return(false);
 
+    if (const OBDataIndex *index = DataIndex()) {
+      unsigned int idx = index->FindAttribute(s);
+      if (idx == NoDataItem || index->Holds(_vdata, idx))
+        return idx != NoDataItem;
+    }
+
     OBDataIterator i;
 
     for (i = _vdata.begin();i != _vdata.end();++i)
@@ -116,6 +277,12 @@ namespace OpenBabel
     if (_vdata.empty())
       return(false);
 
+    if (const OBDataIndex *index = DataIndex()) {
+      const OBDataIndex::TypeItems *t = index->FindType(dt);
+      if (!t || index->Holds(_vdata, t->first))
+        return t != NULL;
+    }
+
     OBDataIterator i;
 
     for (i = _vdata.begin();i != _vdata.end();++i)
@@ -128,6 +295,14 @@ namespace OpenBabel
   //! \return the value given an attribute name
   OBGenericData *OBBase::GetData(const string &s)
   {
+    if (const OBDataIndex *index = DataIndex()) {
+      unsigned int idx = index->FindAttribute(s);
+      if (idx == NoDataItem)
+        return NULL;
+      if (index->Holds(_vdata, idx))
+        return _vdata[idx];
+    }
+
     OBDataIterator i;
 
     for (i = _vdata.begin();i != _vdata.end();++i)
@@ -140,6 +315,9 @@ namespace OpenBabel
   //! \return the value given an attribute name
   OBGenericData *OBBase::GetData(const char *s)
   {
+    if (DataIndex())
+      return GetData(string(s));
+
     OBDataIterator i;
 
     for (i = _vdata.begin(); i != _vdata.end(); ++i)
@@ -151,6 +329,14 @@ namespace OpenBabel
 
   OBGenericData *OBBase::GetData(const unsigned int dt)
   {
+    if (const OBDataIndex *index = DataIndex()) {
+      const OBDataIndex::TypeItems *t = index->FindType(dt);
+      if (!t)
+        return NULL;
+      if (index->Holds(_vdata, t->first))
+        return _vdata[t->first];
+    }
+
     OBDataIterator i;
     for (i = _vdata.begin();i != _vdata.end();++i)
       if ((*i)->GetDataType() == dt)
@@ -162,6 +348,20 @@ namespace OpenBabel
   {
     std::vector<OBGenericData *> matches;
 
+    if (const OBDataIndex *index = DataIndex()) {
+      const OBDataIndex::TypeItems *t = index->FindType(dt);
+      unsigned int idx;
+      for (idx = t ? t->first : NoDataItem; idx != NoDataItem;
+           idx = index->nextOfType[idx]) {
+        if (!index->Holds(_vdata, idx))
+          break;
+        matches.push_back(_vdata[idx]);
+      }
+      if (idx == NoDataItem)
+        return matches;
+      matches.clear();
+    }
+
     // return all values matching this type
     OBDataIterator i;
     for (i = _vdata.begin();i != _vdata.end();++i)
@@ -192,11 +392,26 @@ namespace OpenBabel
     // This creates a new copy -- useable by scripting languages
     OBGenericData *clone = d->Clone(this);
     if (clone)
-      _vdata.push_back(clone);
+      SetData(clone);
 
     return;
   }
 
+  void OBBase::SetData(OBGenericData *d)
+  {
+    if (!d)
+      return;
+    bool current = DataIndex() != NULL;
+    _vdata.push_back(d);
+    ++_dataGeneration;
+    if (current) {
+      _dataIndex->Add(d);
+      _dataIndex->generation = _dataGeneration;
+    }
+    else
+      UpdateDataIndex();
+  }
+
   void OBBase::DeleteData(unsigned int dt)
   {
     vector<OBGenericData*> vdata;
@@ -207,6 +422,8 @@ namespace OpenBabel
       else
         vdata.push_back(*i);
     _vdata = vdata;
+    ++_dataGeneration;
+    UpdateDataIndex();
   }
 
   void OBBase::DeleteData(vector<OBGenericData*> &vg)
@@ -230,6 +447,8 @@ namespace OpenBabel
           vdata.push_back(*i);
       }
     _vdata = vdata;
+    ++_dataGeneration;
+    UpdateDataIndex();
   }
 
   void OBBase::DeleteData(OBGenericData *gd)
@@ -240,6 +459,8 @@ namespace OpenBabel
         {
           delete *i;
           _vdata.erase(i);
+          ++_dataGeneration;
+          UpdateDataIndex();
           return; //Must stop since iterators invalidated by erase
         }
   }
@@ -253,6 +474,8 @@ namespace OpenBabel
       {
         delete *i;
           _vdata.erase(i);
+          ++_dataGeneration;
+          UpdateDataIndex();
           return true;
       }
     }
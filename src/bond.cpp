@@ -22,6 +22,7 @@ GNU General Public License for more details.
 #include <openbabel/oberror.h>
 #include <openbabel/obutil.h>
 #include <openbabel/ring.h>
+#include <openbabel/generic.h>
 #include <openbabel/bond.h>
 #include <openbabel/mol.h>
 #include <climits>
@@ -522,24 +523,14 @@ namespace OpenBabel
     return false;
   }
 
-  // Adapted from OBAtom::IsInRingSize()
   OBRing* OBBond::FindSmallestRing() const
   {
-    vector<OBRing*> rlist;
-    vector<OBRing*>::iterator i;
-
     OBMol *mol = (OBMol*)((OBBond*)this)->GetParent();
 
-    rlist = mol->GetSSSR();
-    OBRing* result = (OBRing*) NULL;
-    size_t min_size = UINT_MAX;
-    for (i = rlist.begin();i != rlist.end();++i) {
-      if ((*i)->IsMember((OBBond*)this) && (*i)->Size() < min_size) {
-        min_size = (*i)->Size();
-        result = *i;
-      }
-    }
-    return result;
+    vector<OBRing*> &rlist = mol->GetSSSR();
+    OBRingData *rd = static_cast<OBRingData*>(mol->GetData("SSSR"));
+    int smallest = rd->GetMembership((OBBond*)this).smallest;
+    return smallest < 0 ? (OBRing*) NULL : rlist[smallest];
   }
 
   bool OBBond::IsClosure()
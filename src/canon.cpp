@@ -1467,17 +1467,19 @@ namespace OpenBabel {
      * and computes labels for the molecule as a whole.
      *
      * This is the CanonicalLabelsImpl entry point.
+     *
+     * @return False if the labeling of a fragment was stopped by the timeout.
      */
-    static void CalcCanonicalLabels(OBMol *mol, const std::vector<unsigned int> &symmetry_classes,
+    static bool CalcCanonicalLabels(OBMol *mol, const std::vector<unsigned int> &symmetry_classes,
         std::vector<unsigned int> &canonical_labels, const OBStereoUnitSet &stereoUnits, const OBBitVec &mask,
         OBStereoFacade *stereoFacade, int maxSeconds, bool onlyOne = false)
     {
       // Handle some special cases.
       if (!mol->NumAtoms())
-        return;
+        return true;
       if (mol->NumAtoms() == 1) {
         canonical_labels.resize(1, 1);
-        return;
+        return true;
       }
 
       // Set all labels to 0.
@@ -1563,6 +1565,7 @@ namespace OpenBabel {
       }
 
       // Find the canonical code for each fragment.
+      bool complete = true;
       std::vector<CanonicalLabelsImpl::FullCode> fcodes;
       for (std::size_t f = 0; f < fragments.size(); ++f) {
         const OBBitVec &fragment = fragments[f];
@@ -1592,6 +1595,7 @@ namespace OpenBabel {
         // Throw an error if the timeout is exceeded.
         if (time(NULL) - timeout.startTime > timeout.maxTime) {
           obErrorLog.ThrowError(__FUNCTION__, "maximum time exceeded...", obError);
+          complete = false;
         }
 
         // Store the canonical code for the fragment.
@@ -1619,6 +1623,7 @@ namespace OpenBabel {
         offset = max_label;
       }
 
+      return complete;
     }
 
   }; // CanonicalLabelsImpl
@@ -1633,6 +1638,15 @@ namespace OpenBabel {
       std::vector<unsigned int> &canonical_labels, const OBBitVec &mask,
       int maxSeconds, bool onlyOne)
   {
+    bool timedOut;
+    CanonicalLabels(mol, symmetry_classes, canonical_labels, mask, maxSeconds, onlyOne, timedOut);
+  }
+
+  void CanonicalLabels(OBMol *mol, const std::vector<unsigned int> &symmetry_classes,
+      std::vector<unsigned int> &canonical_labels, const OBBitVec &mask,
+      int maxSeconds, bool onlyOne, bool &timedOut)
+  {
+    bool complete;
     // make sure the mask is valid: no mask = all atoms
     OBBitVec maskCopy(mask);
     if (!maskCopy.CountBits())
@@ -1642,7 +1656,7 @@ namespace OpenBabel {
     if (onlyOne) {
       // Only one labeling requested. This results in canonical labels that do not
       // consider stereochemistry. Used for finding stereo centers with automorphisms.
-      CanonicalLabelsImpl::CalcCanonicalLabels(mol, symmetry_classes, canonical_labels, OBStereoUnitSet(), maskCopy, 0, maxSeconds, true);
+      complete = CanonicalLabelsImpl::CalcCanonicalLabels(mol, symmetry_classes, canonical_labels, OBStereoUnitSet(), maskCopy, 0, maxSeconds, true);
     } else {
       std::vector<OBBond*> metalloceneBonds;
       findMetalloceneBonds(metalloceneBonds, mol, symmetry_classes);
@@ -1671,7 +1685,7 @@ namespace OpenBabel {
       }
       if (!hasAtLeastOneDefined) {
         // If there are no specified stereo centers, we don't need to find stereogenic units.
-        CanonicalLabelsImpl::CalcCanonicalLabels(mol, symmetry_classes, canonical_labels, OBStereoUnitSet(), maskCopy, 0, maxSeconds);
+        timedOut = !CanonicalLabelsImpl::CalcCanonicalLabels(mol, symmetry_classes, canonical_labels, OBStereoUnitSet(), maskCopy, 0, maxSeconds);
         return;
       }
 
@@ -1750,13 +1764,15 @@ namespace OpenBabel {
       OBStereoFacade newsf(mol, false);
 
       // Start the labeling process
-      CanonicalLabelsImpl::CalcCanonicalLabels(mol, symmetry_classes, canonical_labels, stereoUnits, maskCopy, &newsf, maxSeconds);
+      complete = CanonicalLabelsImpl::CalcCanonicalLabels(mol, symmetry_classes, canonical_labels, stereoUnits, maskCopy, &newsf, maxSeconds);
     }
 
     // if the labeling failed, just return the identity labels to avoid craches
     if (canonical_labels.empty())
       for (std::size_t i = 0; i < symmetry_classes.size(); ++i)
         canonical_labels.push_back(i+1);
+
+    timedOut = !complete;
   }
 
 
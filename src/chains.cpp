@@ -29,6 +29,9 @@ GNU General Public License for more details.
 #include <stdio.h>
 #include <ctype.h>
 #include <map>
+#include <set>
+#include <queue>
+#include <functional>
 
 #include <openbabel/mol.h>
 #include <openbabel/atom.h>
@@ -833,6 +836,8 @@ namespace OpenBabel
     sernos.clear();
     hcounts.clear();
     chains.clear();
+    chainAtoms.clear();
+    residueAtoms.clear();
   }
 
   //! Clear all residue information for a supplied molecule
@@ -848,8 +853,9 @@ namespace OpenBabel
     for (residue = mol.BeginResidue(r) ; residue ; residue = mol.NextResidue(r))
       residues.push_back(residue);
 
-    for ( unsigned int i = 0 ; i < residues.size() ; i++ )
-      mol.DeleteResidue(residues[i]);
+    // from the back, so no remaining residues need renumbering
+    for ( unsigned int i = residues.size() ; i > 0 ; i-- )
+      mol.DeleteResidue(residues[i - 1]);
 
     residues.clear();
   }
@@ -972,47 +978,85 @@ namespace OpenBabel
 
     // Partially identified residues
     // example: CSD in 1LWF (CYS with two Os on the S)
+    //
+    // Unknown atoms take the residue of a known neighbour, in repeated sweeps
+    // over the atoms in order. Only atoms next to a newly assigned atom can
+    // change, so each sweep visits just those, in the same order: later
+    // atoms in this sweep, earlier ones in the next.
+    unsigned int numAtoms = mol.NumAtoms();
+    set<pair<char,short> > invalidResidues;
+    priority_queue<unsigned int, vector<unsigned int>, greater<unsigned int> > sweep;
+    vector<unsigned int> nextSweep;
+    vector<bool> inSweep(numAtoms, false), inNextSweep(numAtoms, false);
+    FOR_ATOMS_OF_MOL (atom, mol) {
+      idx = atom->GetIdx() - 1;
+      if (resids[idx] == 0) // UNK
+        FOR_NBORS_OF_ATOM (nbr, &*atom)
+          if (resids[nbr->GetIdx() - 1] != 0) {
+            sweep.push(idx);
+            inSweep[idx] = true;
+            break;
+          }
+    }
     bool changed;
-    vector<pair<char,short> > invalidResidues;
     do {
       changed = false;
 
-      FOR_ATOMS_OF_MOL (atom, mol) {
-        idx = atom->GetIdx() - 1;
+      while (!sweep.empty()) {
+        idx = sweep.top();
+        sweep.pop();
+        inSweep[idx] = false;
+        if (resids[idx] != 0) // !UNK
+          continue;
 
-        if (resids[idx] == 0) { // UNK
-          FOR_NBORS_OF_ATOM (nbr, &*atom) {
-            unsigned int idx2 = nbr->GetIdx() - 1;
-            if (resids[idx2] != 0) { // !UNK
-	      if (atomids[idx2] == AI_N || atomids[idx2] == AI_C) {
-		// bound to backbone-N/C
-		hetflags[idx] = true;
-		resids[idx] = 3; // ACE
-		atomids[idx] = -1;
-	      } else {
-		resnos[idx] = resnos[idx2];
-		resids[idx] = resids[idx2];
-		changed = true;
-
-		bool addResidue = true;
-		for (unsigned int i = 0; i < invalidResidues.size(); ++i)
-		  if ( (invalidResidues[i].first == chains[idx2]) &&
-		       (invalidResidues[i].second == resnos[idx2]) )
-		    addResidue = false;
-		if (addResidue)
-		  invalidResidues.push_back(pair<char,short>(chains[idx2], resnos[idx2]));
-	      }
+        OBAtom *atom = mol.GetAtom(idx + 1);
+        FOR_NBORS_OF_ATOM (nbr, atom) {
+          unsigned int idx2 = nbr->GetIdx() - 1;
+          if (resids[idx2] != 0) { // !UNK
+            if (atomids[idx2] == AI_N || atomids[idx2] == AI_C) {
+              // bound to backbone-N/C
+              hetflags[idx] = true;
+              resids[idx] = 3; // ACE
+              atomids[idx] = -1;
+            } else {
+              resnos[idx] = resnos[idx2];
+              resids[idx] = resids[idx2];
+              changed = true;
+
+              invalidResidues.insert(pair<char,short>(chains[idx2], resnos[idx2]));
             }
           }
         }
 
+        if (resids[idx] != 0)
+          FOR_NBORS_OF_ATOM (nbr, atom) {
+            unsigned int idx2 = nbr->GetIdx() - 1;
+            if (resids[idx2] != 0)
+              continue;
+            if (idx2 > idx) {
+              if (!inSweep[idx2]) {
+                sweep.push(idx2);
+                inSweep[idx2] = true;
+              }
+            } else if (!inNextSweep[idx2]) {
+              nextSweep.push_back(idx2);
+              inNextSweep[idx2] = true;
+            }
+          }
       }
+
+      for (unsigned int i = 0; i < nextSweep.size(); ++i) {
+        inNextSweep[nextSweep[i]] = false;
+        if (!inSweep[nextSweep[i]]) {
+          sweep.push(nextSweep[i]);
+          inSweep[nextSweep[i]] = true;
+        }
+      }
+      nextSweep.clear();
     } while (changed);
-    for (unsigned int i = 0; i < invalidResidues.size(); ++i) {
-      FOR_ATOMS_OF_MOL (atom, mol) {
-        idx = atom->GetIdx() - 1;
-        if ( (invalidResidues[i].first == chains[idx]) &&
-             (invalidResidues[i].second == resnos[idx]) ) {
+    if (!invalidResidues.empty()) {
+      for (idx = 0; idx < numAtoms; ++idx) {
+        if (invalidResidues.count(pair<char,short>(chains[idx], resnos[idx]))) {
           hetflags[idx] = true;
           resids[idx] = 0; // UNK
           atomids[idx] = -1;
@@ -1100,7 +1144,6 @@ namespace OpenBabel
 
     int resno = 1;
     int count = 0;
-    unsigned int numAtoms = mol.NumAtoms();
 
     OBAtom *atom;
     vector<OBAtom *>::iterator a;
@@ -1116,13 +1159,12 @@ namespace OpenBabel
           else
             resid = 2; /* Unknown ligand */
 
-          for (i = 0 ; i < numAtoms ; ++i) {
-            if (chains[i] == ('A' + count)) {
-              hetflags[i] = true;
-              resids[i]   = resid;
-              resnos[i]   = resno;
-              chains[i]   = ' ';
-            }
+          for (i = 0 ; i < chainAtoms.size() ; ++i) {
+            unsigned int member = chainAtoms[i];
+            hetflags[member] = true;
+            resids[member]   = resid;
+            resnos[member]   = resno;
+            chains[member]   = ' ';
           }
           resno++;
         } else {
@@ -1147,26 +1189,31 @@ namespace OpenBabel
   {
     OBAtom *atom, *nbr;
     vector<OBBond *>::iterator b;
-    unsigned int result, index;
+    unsigned int index;
 
-    atom = mol.GetAtom(i + 1);
+    chainAtoms.clear();
 
     // ignore hydrogens
-    if (atom->GetAtomicNum() == OBElements::Hydrogen )
+    if (mol.GetAtom(i + 1)->GetAtomicNum() == OBElements::Hydrogen )
       return 0;
 
-    result    = 1;
+    // visit till we have all atoms for this chain; chainAtoms doubles as
+    // the stack of atoms whose neighbours are still to be visited
     chains[i] = c;
-
-    // recurse till we have all atoms for this chain
-    for (nbr = atom->BeginNbrAtom(b); nbr; nbr = atom->NextNbrAtom(b)) {
-      index = nbr->GetIdx() - 1;
-      if (chains[index] == ' ')
-        result += RecurseChain(mol, index, c);
+    chainAtoms.push_back(i);
+    for (unsigned int next = 0; next < chainAtoms.size(); ++next) {
+      atom = mol.GetAtom(chainAtoms[next] + 1);
+      for (nbr = atom->BeginNbrAtom(b); nbr; nbr = atom->NextNbrAtom(b)) {
+        index = nbr->GetIdx() - 1;
+        if (chains[index] == ' ' && nbr->GetAtomicNum() != OBElements::Hydrogen) {
+          chains[index] = c;
+          chainAtoms.push_back(index);
+        }
+      }
     }
 
     // and return how many we found
-    return result;
+    return chainAtoms.size();
   }
 
   //////////////////////////////////////////////////////////////////////////////
@@ -1252,53 +1299,76 @@ namespace OpenBabel
 
     /* Second Pass */
 
-    do
+    // Constraints only fail as neighbouring bitmasks lose bits, so after
+    // checking every atom once only the neighbours of changed atoms need
+    // checking again
+    unsigned int numAtoms = mol.NumAtoms();
+    vector<unsigned int> pending;
+    vector<bool> isPending(numAtoms, false);
+    for ( idx = numAtoms ; idx > 0 ; idx-- )
+      if (bitmasks[idx - 1])
+        {
+          pending.push_back(idx - 1);
+          isPending[idx - 1] = true;
+        }
+
+    while (!pending.empty())
       {
+        idx = pending.back();
+        pending.pop_back();
+        isPending[idx] = false;
+        if (!bitmasks[idx])
+          continue;
+
+        atom = mol.GetAtom(idx + 1);
+        count = 0;
+        for (nbr = atom->BeginNbrAtom(b) ; nbr ; nbr = atom->NextNbrAtom(b))
+          if (nbr->GetAtomicNum() != OBElements::Hydrogen && count < 6)
+            neighbour[count++] = nbr;
+
+        if (count >= 1)
+          na = neighbour[0];
+        if (count >= 2)
+          nb = neighbour[1];
+        if (count >= 3)
+          nc = neighbour[2];
+        if (count >= 4)
+          nd = neighbour[3];
+
         change = false;
-        for (atom = mol.BeginAtom(a) ; atom ; atom = mol.NextAtom(a))
-          {
-            idx = atom->GetIdx() - 1;
-            if (bitmasks[idx]) // Determine Neighbours
-              {
-                count = 0;
-                for (nbr = atom->BeginNbrAtom(b) ; nbr ; nbr = atom->NextNbrAtom(b))
-                  if (nbr->GetAtomicNum() != OBElements::Hydrogen)
-                    neighbour[count++] = nbr;
-
-                if (count >= 1)
-                  na = neighbour[0];
-                if (count >= 2)
-                  nb = neighbour[1];
-                if (count >= 3)
-                  nc = neighbour[2];
-                if (count >= 4)
-                  nd = neighbour[3];
-
-                for ( i = 0 ; i < tmax ; i++ )
-                  if ( templ[i].flag & bitmasks[idx] )
-                    {
-                      pep    = &templ[i];
-                      result = true;
-
-                      if (count == 4)
-                        result = Match4Constraints(pep,na,nb,nc,nd);
-                      else if (count == 3)
-                        result = Match3Constraints(pep,na,nb,nc);
-                      else if (count == 2)
-                        result = Match2Constraints(pep,na,nb);
-                      else if (count == 1)
-                        result = MatchConstraint(na,pep->n1);
-
-                      if(result == false)
-                        {
-                          bitmasks[idx] &= ~pep->flag;
-                          change = true;
-                        }
-                    }
-              }
-          }
+        for ( i = 0 ; i < tmax ; i++ )
+          if ( templ[i].flag & bitmasks[idx] )
+            {
+              pep    = &templ[i];
+              result = true;
+
+              if (count == 4)
+                result = Match4Constraints(pep,na,nb,nc,nd);
+              else if (count == 3)
+                result = Match3Constraints(pep,na,nb,nc);
+              else if (count == 2)
+                result = Match2Constraints(pep,na,nb);
+              else if (count == 1)
+                result = MatchConstraint(na,pep->n1);
+
+              if(result == false)
+                {
+                  bitmasks[idx] &= ~pep->flag;
+                  change = true;
+                }
+            }
+
+        if (change)
+          for ( i = 0 ; i < count ; i++ )
+            {
+              unsigned int n = neighbour[i]->GetIdx() - 1;
+              if (bitmasks[n] && !isPending[n])
+                {
+                  pending.push_back(n);
+                  isPending[n] = true;
+                }
+            }
       }
-    while( change );
   }
 
   bool OBChainsParser::MatchConstraint(OBAtom *atom, int mask)
@@ -1494,6 +1564,8 @@ namespace OpenBabel
     int resid;
     int max = mol.NumAtoms();
 
+    IndexResidues(mol);
+
     for (int i = 0 ; i < max ; ++i)
       if (atomids[i] == AI_CA)
         {
@@ -1504,13 +1576,27 @@ namespace OpenBabel
     return true;
   }
 
-  void OBChainsParser::AssignResidue(OBMol &mol, int r, int c, int i)
+  void OBChainsParser::IndexResidues(OBMol &mol)
   {
-    int max = mol.NumAtoms();
+    residueAtoms.clear();
+    unsigned int max = mol.NumAtoms();
+    for (unsigned int j = 0 ; j < max ; ++j)
+      residueAtoms[pair<char, short>(chains[j], resnos[j])].push_back(j);
+  }
 
-    for (int j = 0 ; j < max ; ++j)
+  void OBChainsParser::AssignResidue(OBMol &, int r, int c, int i)
+  {
+    map<pair<char, short>, vector<unsigned int> >::iterator atoms =
+      residueAtoms.find(pair<char, short>(c, r));
+    if (atoms == residueAtoms.end())
+      return;
+
+    // The index can hold atoms since renumbered, so check them again
+    for (unsigned int k = 0 ; k < atoms->second.size() ; ++k) {
+      unsigned int j = atoms->second[k];
       if ((resnos[j] == r) && (chains[j] == c) && !hetflags[j])
         resids[j] = i;
+    }
   }
 
   int OBChainsParser::IdentifyResidue(void *tree, OBMol &mol, unsigned int seed,
@@ -1570,7 +1656,10 @@ namespace OpenBabel
               bond = Stack[StackPtr-1].bond;
               ResMonoAtom[AtomCount++] = curr;
               ResMonoBond[BondCount++] = bond;
-              resnos[curr] = resno;
+              if (resnos[curr] != static_cast<short>(resno)) {
+                resnos[curr] = resno;
+                residueAtoms[pair<char, short>(chains[curr], resnos[curr])].push_back(curr);
+              }
               ptr = ptr->elem.tcond;
               StackPtr--;
             }
@@ -1802,6 +1891,8 @@ namespace OpenBabel
 
   bool OBChainsParser::DetermineNucleicSidechains(OBMol &mol)
   {
+    IndexResidues(mol);
+
     for( unsigned int i = 0 ; i < mol.NumAtoms() ; i++ )
       if( atomids[i] == 49 )
         {
@@ -329,6 +329,11 @@ namespace OpenBabel {
   }
 
 
+  void OBConformerSearch::SetSeed(int seed)
+  {
+    ((OBRandom*)d)->Seed(seed);
+  }
+
   bool OBConformerSearch::Setup(const OBMol &mol, int numConformers, int numChildren, int mutability, int convergence)
   {
     int nb_rotors = 0;
@@ -391,8 +396,7 @@ namespace OpenBabel {
     }
 
     // create initial population
-    OBRandom generator;
-    generator.TimeSeed();
+    OBRandom &generator = *(OBRandom*)d;
 
     RotorKey rotorKey(m_rotorList.Size() + 1, 0); // indexed from 1
     if (IsGood(rotorKey))
@@ -457,39 +461,58 @@ namespace OpenBabel {
   void OBConformerSearch::NextGeneration()
   {
     // create next generation population
-    OBRandom generator;
-    generator.TimeSeed();
+    OBRandom &generator = *(OBRandom*)d;
 
-    // generate the children
+    // one slot for each child that still has to be generated
+    std::vector<int> parents, tries;
     int numConformers = m_rotorKeys.size();
-    for (int c = 0; c < numConformers; ++c) {
-      for (int child = 0; child < m_numChildren; ++child) {
-        bool foundKey = false;
-        int tries = 0;
-        while (!foundKey) {
-          tries++;
-          if (tries > 1000)
-            foundKey = true;
-          RotorKey rotorKey = m_rotorKeys[c]; // copy parent gene
-          // perform random mutation(s)
-          OBRotorIterator ri;
-          OBRotor *rotor = m_rotorList.BeginRotor(ri);
-          for (unsigned int i = 1; i < m_rotorList.Size() + 1; ++i, rotor = m_rotorList.NextRotor(ri)) {
-            if (generator.NextInt() % m_mutability == 0)
-              rotorKey[i] = generator.NextInt() % rotor->GetResolution().size(); // permutate gene
-          }
-          // duplicates are always rejected
-          if (!IsUniqueKey(m_rotorKeys, rotorKey))
-            continue;
-          // execute the filter(s)
-          if (!IsGood(rotorKey))
-            continue;
-          // add the key
-          m_rotorKeys.push_back(rotorKey); // append child to population
-          // set foundKey to generate the next child
-          foundKey = true;
+    for (int c = 0; c < numConformers; ++c)
+      for (int child = 0; child < m_numChildren; ++child)
+        parents.push_back(c);
+    tries.resize(parents.size(), 0);
+
+    // The candidate keys are drawn serially so the population only depends on
+    // the random seed. The (expensive) filtering is done in parallel.
+    RotorKeys candidates;
+    std::vector<char> good;
+    while (!parents.empty()) {
+      int numCandidates = parents.size();
+      candidates.resize(numCandidates);
+      for (int n = 0; n < numCandidates; ++n) {
+        RotorKey &rotorKey = candidates[n];
+        rotorKey = m_rotorKeys[parents[n]]; // copy parent gene
+        // perform random mutation(s)
+        OBRotorIterator ri;
+        OBRotor *rotor = m_rotorList.BeginRotor(ri);
+        for (unsigned int i = 1; i < m_rotorList.Size() + 1; ++i, rotor = m_rotorList.NextRotor(ri)) {
+          if (generator.NextInt() % m_mutability == 0)
+            rotorKey[i] = generator.NextInt() % rotor->GetResolution().size(); // permutate gene
+        }
+      }
+
+      // duplicates are always rejected, then execute the filter(s)
+      good.assign(numCandidates, 0);
+#ifdef _OPENMP
+      #pragma omp parallel for schedule(dynamic) if(m_filter->IsThreadSafe())
+#endif
+      for (int n = 0; n < numCandidates; ++n)
+        good[n] = IsUniqueKey(m_rotorKeys, candidates[n]) && IsGood(candidates[n]);
+
+      // add the keys, children in the same round may still be duplicates
+      std::vector<int> nextParents, nextTries;
+      for (int n = 0; n < numCandidates; ++n) {
+        if (good[n] && IsUniqueKey(m_rotorKeys, candidates[n])) {
+          m_rotorKeys.push_back(candidates[n]); // append child to population
+          continue;
+        }
+        // give up on this child after 1000 tries
+        if (++tries[n] < 1000) {
+          nextParents.push_back(parents[n]);
+          nextTries.push_back(tries[n]);
         }
       }
+      parents.swap(nextParents);
+      tries.swap(nextTries);
     }
   }
 
@@ -525,10 +548,11 @@ namespace OpenBabel {
     rotamers.ExpandConformerList(m_mol, conformers);
 
     // Score each conformer
+    std::vector<double> scores;
+    ScoreConformers(conformers, scores);
     std::vector<ConformerScore> conformer_scores;
     for (unsigned int i = 0; i < conformers.size(); ++i) {
-      double score = m_score->Score(m_mol, i, m_rotorKeys, conformers);
-      conformer_scores.push_back(ConformerScore(m_rotorKeys[i], score));
+      conformer_scores.push_back(ConformerScore(m_rotorKeys[i], scores[i]));
     }
 
     // delete the conformers
@@ -584,6 +608,17 @@ namespace OpenBabel {
 
 
 
+  void OBConformerSearch::ScoreConformers(const std::vector<double*> &conformers, std::vector<double> &scores)
+  {
+    int numConformers = conformers.size();
+    scores.resize(numConformers);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) if(m_score->IsThreadSafe())
+#endif
+    for (int i = 0; i < numConformers; ++i)
+      scores[i] = m_score->Score(m_mol, i, m_rotorKeys, conformers);
+  }
+
   void OBConformerSearch::Search()
   {
     int identicalGenerations = 0;
@@ -919,7 +954,6 @@ namespace OpenBabel {
   {
     bool max_flag = (m_score->GetPreferred() == OBConformerScore::HighScore);
     unsigned int i = 0, pop_size = 0;
-    double score = 0.0;
     std::vector<double*> conformers;
     std::vector<double>::iterator dit;
     OBRotamerList rotamers;
@@ -936,11 +970,10 @@ namespace OpenBabel {
     rotamers.ExpandConformerList(m_mol, conformers);
 
     // Score each conformer
+    std::vector<double> scores;
+    ScoreConformers(conformers, scores);
     for (i = 0; i < conformers.size(); ++i)
-      {
-        score = m_score->Score(m_mol, i, m_rotorKeys, conformers);
-        conformer_scores.push_back(ConformerScore(m_rotorKeys[i], score));
-      }
+      conformer_scores.push_back(ConformerScore(m_rotorKeys[i], scores[i]));
 
     // delete the conformers
     for (i = 0; i < conformers.size(); ++i)
@@ -29,6 +29,7 @@ GNU General Public License for more details.
 #include <openbabel/tree/tree_util.hh>
 #include <openbabel/math/vector3.h>
 #include <openbabel/elements.h>
+#include <openbabel/obiter.h>
 
 #include <float.h> // For DBL_MAX
 #include <algorithm> // For min
@@ -449,6 +450,146 @@ int OBForceField::DiverseConfGen(double rmsd, unsigned int nconfs, double energy
     return 0;
  }
 
+int OBForceField::DiverseConfGenTree(double rmsd, unsigned int nconfs, double energy_gap, bool verbose)
+  {
+    // The pair indices used below are only valid if every pair is evaluated
+    if (_constraints.Size() || HasGroups())
+      return DiverseConfGen(rmsd, nconfs, energy_gap, verbose);
+
+    _energies.clear(); // Wipe any energies from previous conformer generators
+
+    // Remove all conformers (e.g. from previous conformer generators) even the current conformer
+    double *initialCoord = new double [_mol.NumAtoms() * 3]; // initial state
+    double *store_initial = new double [_mol.NumAtoms() * 3]; // store the initial state
+    memcpy((char*)initialCoord,(char*)_mol.GetCoordinates(),sizeof(double)*3*_mol.NumAtoms());
+    memcpy((char*)store_initial,(char*)_mol.GetCoordinates(),sizeof(double)*3*_mol.NumAtoms());
+    std::vector<double *> newConfs(1, initialCoord);
+    _mol.SetConformers(newConfs);
+
+    if (_mol.NumRotors() == 0) {
+      SetupPointers();
+      _energies.push_back(Energy(false));
+      delete [] store_initial;
+      return 0;
+    }
+
+    // Get estimate of lowest energy conf using FastRotorSearch
+    FastRotorSearch(true);
+    double lowest_energy = Energy(false);
+
+    OBRotorList rl;
+    if (_loglvl == 0)
+      rl.SetQuiet(); // Don't print info on symmetry removal
+    rl.Setup(_mol);
+
+    OBRotorIterator ri;
+    OBRotamerList rotamerlist;
+    rotamerlist.SetBaseCoordinateSets(_mol);
+    rotamerlist.Setup(_mol, rl);
+
+    // Can take shortcut later, as 4 components of the energy will be constant
+    SetupPointers();
+    double energy_offset = E_Bond(false) + E_Angle(false) + E_StrBnd(false) + E_OOP(false);
+    lowest_energy -= energy_offset;
+    _energies.push_back(lowest_energy);
+
+    // Find the atoms moved by each rotor
+    std::vector<size_t> rotor_sizes;
+    std::vector<OBBitVec> moved;
+    std::vector<int> children;
+    int ref[4];
+    OBRotor* rotor = rl.BeginRotor(ri);
+    for (unsigned int i = 1; i < rl.Size() + 1; ++i, rotor = rl.NextRotor(ri)) { // foreach rotor
+      rotor_sizes.push_back(rotor->GetResolution().size());
+      rotor->GetDihedralAtoms(ref);
+      _mol.FindChildren(children, ref[1], ref[2]);
+      OBBitVec bv(_mol.NumAtoms() + 1);
+      for (std::vector<int>::iterator c = children.begin(); c != children.end(); ++c)
+        bv.SetBitOn(*c);
+      moved.push_back(bv);
+      if(verbose) {
+        std::cout << "....rotor " << i << " from " << rotor->GetBond()->GetBeginAtomIdx() << " to "
+             << rotor->GetBond()->GetEndAtomIdx() << " has " << rotor_sizes.back() << " values" << std::endl;
+      }
+    }
+    unsigned int nrotors = rotor_sizes.size();
+
+    // The distance between the atoms of a non-bonded pair is fixed once all
+    // rotors that move one atom but not the other are assigned. Assign each
+    // pair to the level of the last of these rotors (0 = rigid).
+    const unsigned int numPairs = _mol.NumAtoms() * (_mol.NumAtoms() - 1) / 2;
+    std::vector<OBBitVec> levelPairs(nrotors + 1, OBBitVec(numPairs));
+    unsigned int pairIndex = 0;
+    FOR_PAIRS_OF_MOL(p, _mol) {
+      unsigned int level = 0;
+      for (unsigned int r = 0; r < nrotors; ++r)
+        if (moved[r].BitIsSet((*p)[0]) != moved[r].BitIsSet((*p)[1]))
+          level = r + 1;
+      levelPairs[level].SetBitOn(pairIndex);
+      ++pairIndex;
+    }
+
+    double rigid_energy = E_NonBonded(levelPairs[0]);
+
+    if (nconfs == 0)
+      nconfs = UINT_MAX;
+
+    OBDiversePoses divposes(_mol, rmsd, false);
+    std::vector<int> key(nrotors + 1, -1);
+    std::vector<double> partial(nrotors + 1, rigid_energy); // energy of the levels <= depth
+    unsigned int counter = 0, N_low_energy = 0;
+    unsigned int depth = 1;
+
+    // Main loop, depth-first over the rotor keys
+    while (depth > 0) {
+      // next position for the rotor at this depth
+      if (++key[depth] >= static_cast<int>(rotor_sizes[depth - 1])) {
+        key[depth] = -1;
+        --depth;
+        continue;
+      }
+
+      _mol.SetCoordinates(store_initial);
+      rotamerlist.SetCurrentCoordinates(_mol, key); // unassigned rotors are skipped
+      SetupPointers();
+      partial[depth] = partial[depth - 1] + E_NonBonded(levelPairs[depth]);
+
+      if (depth < nrotors) {
+        ++depth;
+        continue;
+      }
+
+      // All rotors assigned
+      double currentE = partial[depth] + E_Torsion(false);
+      if (currentE < lowest_energy + energy_gap) { // Don't retain high energy poses
+        divposes.AddPose(_mol.GetCoordinates(), currentE);
+        N_low_energy++;
+        if (currentE < lowest_energy)
+          lowest_energy = currentE;
+      }
+      counter++;
+      if (counter >= nconfs)
+        break;
+    }
+    std::cout << "..tot confs tested = " << counter << "\n..below energy threshold = " << N_low_energy << "\n";
+
+    // Reset the coordinates to those of the initial structure
+    _mol.SetCoordinates(store_initial);
+    SetupPointers();
+
+    // Get results from the tree
+    UpdateConformersFromTree(&_mol, _energies, &divposes, verbose);
+
+    // Add back the energy offset
+    transform(_energies.begin(), _energies.end(), _energies.begin(),
+              [energy_offset](double e) { return e + energy_offset; });
+
+    // Clean up
+    delete [] store_initial;
+
+    return 0;
+  }
+
 } // end of namespace OpenBabel
 
 //! \file confsearch.cpp
@@ -238,6 +238,35 @@ pair<string,string> OBDescriptor::GetIdentifier(istream& optionText)
   return make_pair(descID, param);
 }
 
+//////////////////////////////////////////////////////////////
+bool OBDescriptor::FilterUsesOnlyPairData(OBBase* pOb, istream& optionText)
+{
+  //Walks the filter string in the same way as FilterCompare() but only
+  //checks the identifiers. Anything unusual is left to FilterCompare().
+  bool found = false;
+  char ch;
+  while(optionText >> ch)
+  {
+    if(ch=='!' || ch=='(' || ch==')' || ch=='&' || ch=='|' || ch==',' || ch==';')
+      continue;
+    if(ispunctU(ch))
+      return false;
+    optionText.unget();
+
+    pair<string,string> spair = GetIdentifier(optionText);
+    if(spair.first.empty() || !spair.second.empty() || !MatchPairData(pOb, spair.first))
+      return false;
+    found = true;
+
+    char ch1, ch2;
+    string svalue;
+    ParsePredicate(optionText, ch1, ch2, svalue);
+    if(optionText.bad())
+      return false;
+  }
+  return found;
+}
+
 
 ///Reads comparison operator and the following string. Return its value if possible else NaN
 //The comparison operator characters in ch1 and ch2 if found, 0 otherwise.
@@ -427,6 +456,107 @@ void OBDescriptor::AddProperties(OBBase* pOb, const string& DescrList)
   }
 }
 
+bool OBDescriptor::FindDescriptors(const string& DescrList,
+                                   vector<pair<OBDescriptor*, string> >& descrs)
+{
+  descrs.clear();
+  stringstream ss(DescrList);
+  OBDescriptor* pDescr;
+  bool ret = true;
+  while(ss)
+  {
+    pair<string,string> spair = GetIdentifier(ss);
+    if(spair.first.empty())
+    {
+      ss.ignore(); //past a separator that GetIdentifier() leaves in place
+      continue;
+    }
+    if( (pDescr = OBDescriptor::FindType(spair.first.c_str())) ) // extra parentheses to indicate assignment as truth value
+      descrs.push_back(make_pair(pDescr, spair.second));
+    else
+    {
+      obErrorLog.ThrowError(__FUNCTION__, spair.first + " not recognized as a descriptor", obError, onceOnly);
+      ret = false;
+    }
+  }
+  return ret;
+}
+
+//Evaluates all the descriptors of one object; first is its index in values and svalues.
+//While the column types are not known (isString is empty) every value is also
+//kept as text.
+static void PredictRow(OBBase* pOb, const vector<pair<OBDescriptor*, string> >& descrs,
+                       const vector<bool>& isString, size_t first,
+                       vector<double>& values, vector<string>& svalues)
+{
+  for(unsigned int j=0; j<descrs.size(); ++j)
+  {
+    string param(descrs[j].second); //a copy, since descriptors may modify it
+    if(isString.empty() || isString[j])
+      values[first + j] = descrs[j].first->GetStringValue(pOb, svalues[first + j], &param);
+    else
+      values[first + j] = descrs[j].first->Predict(pOb, &param);
+  }
+}
+
+//Whether GetStringValue() gave text rather than a number: NaN, with text that
+//is not empty (e.g. a failure) and not the default text for NaN
+static bool IsStringValue(double val, const string& svalue)
+{
+  if(!IsNan(val) || svalue.empty())
+    return false;
+  stringstream ss;
+  ss << val;
+  return svalue != ss.str();
+}
+
+void OBDescriptor::PredictValues(const vector<OBBase*>& objects,
+                                 const vector<pair<OBDescriptor*, string> >& descrs,
+                                 vector<bool>& isString,
+                                 vector<double>& values, vector<string>& svalues)
+{
+  size_t ncols = descrs.size();
+  values.assign(objects.size() * ncols, numeric_limits<double>::quiet_NaN());
+  svalues.assign(objects.size() * ncols, string());
+  if(objects.empty() || ncols == 0)
+    return;
+  bool decide = isString.size() != ncols;
+  if(decide)
+    isString.clear();
+
+  //The first object is done on its own so that any lazily loaded data,
+  //e.g. SMARTS pattern files, is set up before the threads start
+  PredictRow(objects[0], descrs, isString, 0, values, svalues);
+
+  bool threadSafe = true;
+  for(unsigned int j=0; j<ncols; ++j)
+    threadSafe = threadSafe && descrs[j].first->IsThreadSafe();
+
+  int n = objects.size();
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic, 16) if(threadSafe)
+#endif
+  for(int i=1; i<n; ++i)
+    PredictRow(objects[i], descrs, isString, i * ncols, values, svalues);
+
+  if(!decide)
+    return;
+  //A column is of strings if any object gives text, so neither a failure
+  //nor a value that looks like a number decides it on its own. Numbers in a
+  //string column are kept as their text.
+  isString.assign(ncols, false);
+  for(unsigned int j=0; j<ncols; ++j)
+  {
+    for(size_t k=j; k<values.size() && !isString[j]; k+=ncols)
+      isString[j] = IsStringValue(values[k], svalues[k]);
+    for(size_t k=j; k<values.size(); k+=ncols)
+      if(isString[j])
+        values[k] = numeric_limits<double>::quiet_NaN();
+      else
+        svalues[k].clear();
+  }
+}
+
 void OBDescriptor::DeleteProperties(OBBase* pOb, const string& DescrList)
 {
   vector<string> vs;
@@ -21,6 +21,13 @@ GNU General Public License for more details.
 #include <openbabel/tokenst.h>
 #include <openbabel/obconversion.h>
 #include <openbabel/descriptor.h>
+#include <openbabel/mol.h>
+#include <openbabel/bond.h>
+#include <openbabel/obiter.h>
+#include <openbabel/generic.h>
+#include <openbabel/stringcache.h>
+
+#include <algorithm>
 
 using namespace std;
 namespace OpenBabel
@@ -46,8 +53,76 @@ bool CanSmiles::Compare(OBBase* pOb, istream& optionText, bool noEval, string* p
   return CompareStringWithFilter(optionText, can, noEval);
 }
 
+namespace
+{
+//The perception that the canonical SMILES writer leaves in the molecule: the
+//flags and the data it adds (ring sets, symmetry classes)
+struct WriterState
+{
+  WriterState() : flags(0), hadClasses(false) {}
+  void Save(OBMol& mol)
+  {
+    flags = mol.GetFlags();
+    data = mol.GetData();
+    hadClasses = mol.HasData("OpenBabel Symmetry Classes");
+    if(hadClasses)
+      classes = mol.GetData("OpenBabel Symmetry Classes")->GetValue();
+  }
+  void Restore(OBMol& mol) const
+  {
+    //The writer replaces the symmetry classes, which may reuse the address
+    std::vector<OBGenericData*> added;
+    std::vector<OBGenericData*>& current = mol.GetData();
+    for(std::vector<OBGenericData*>::iterator i = current.begin(); i != current.end(); ++i)
+      if(std::find(data.begin(), data.end(), *i) == data.end()
+         || (*i)->GetAttribute() == "OpenBabel Symmetry Classes")
+        added.push_back(*i);
+    if(!added.empty())
+      mol.DeleteData(added);
+    if(hadClasses)
+    {
+      OBPairData* dp = new OBPairData;
+      dp->SetAttribute("OpenBabel Symmetry Classes");
+      dp->SetOrigin(local);
+      dp->SetValue(classes);
+      mol.SetData(dp);
+    }
+    mol.SetFlags(flags);
+  }
+  int flags;
+  std::vector<OBGenericData*> data;
+  bool hadClasses;
+  std::string classes;
+};
+}
+
 double CanSmiles::GetStringValue(OBBase* pOb, std::string& svalue, std::string*)
 {
+  //The key is computed from the molecule itself, after the same stereo
+  //perception as the writer does. The stereo that the writer marks as
+  //unspecified is recorded with the entry and marked again on a hit, while
+  //the rest of the writer's perception is undone on a miss, so that the
+  //molecule is left in the same state either way.
+  OBMolStringCache& cache = OBMolStringCache::Default();
+  OBMol* pmol = dynamic_cast<OBMol*>(pOb);
+  OBMolStringCache::Key key;
+  bool cacheable = pmol && cache.IsEnabled();
+  if(cacheable && _noStereo)
+  {
+    //The writer clears these before perceiving stereo without the 'i' option
+    FOR_BONDS_OF_MOL(bond, pmol)
+    {
+      bond->SetHash(false);
+      bond->SetWedge(false);
+    }
+  }
+  cacheable = cacheable && OBMolStringCache::GraphKey(*pmol, GetID(), key);
+  if(cacheable && cache.Find(*pmol, key, svalue))
+    return std::numeric_limits<double>::quiet_NaN();
+  WriterState state;
+  if(cacheable)
+    state.Save(*pmol);
+
   OBConversion conv;
   conv.AddOption("n"); //no name
   if(_noStereo)
@@ -57,6 +132,11 @@ double CanSmiles::GetStringValue(OBBase* pOb, std::string& svalue, std::string*)
   else
     obErrorLog.ThrowError(__FUNCTION__, "SmilesFormat is not loaded" , obError);
   Trim(svalue);
+  if(cacheable)
+  {
+    state.Restore(*pmol);
+    cache.Insert(*pmol, key, svalue);
+  }
 
   return std::numeric_limits<double>::quiet_NaN();
 }
@@ -38,6 +38,7 @@ public:
       return 0;
     return pmol->GetMolWt();
   }
+  virtual bool IsThreadSafe() { return true; }
 };
 // Make a global instance
 MWFilter theMWFilter("MW");
@@ -52,6 +53,7 @@ public:
       return 0;
     return pmol->NumRotors();
   }
+  virtual bool IsThreadSafe() { return true; }
 };
 // Make a global instance
 RotatableBondsFilter theRBFilter("rotors");
@@ -113,6 +115,7 @@ public:
   virtual double GetStringValue(OBBase *pOb, std::string &svalue,
                                 std::string *param = NULL);
   virtual bool LessThan(OBBase *pOb1, OBBase *pOb2);
+  virtual bool IsThreadSafe() { return true; }
 };
 
 bool TitleFilter::Compare(OBBase *pOb, istream &optionText, bool noEval,
@@ -165,6 +168,8 @@ public:
     GetStringValue(pOb, svalue);
     return CompareStringWithFilter(optionText, svalue, noEval);
   }
+
+  virtual bool IsThreadSafe() { return true; }
 };
 
 FormulaDescriptor TheFormulaDescriptor("formula");
@@ -23,13 +23,15 @@ GNU General Public License for more details.
 
 #include <openbabel/babelconfig.h>
 #include <vector>
+#include <map>
 #include <utility>
 #include <cstdlib>
 #include <openbabel/mol.h>
 #include <openbabel/atom.h>
 #include <openbabel/oberror.h>
 #include <openbabel/parsmart.h>
-#include <openbabel/bitvec.h>
+#include <openbabel/bond.h>
+#include <openbabel/obiter.h>
 #include <openbabel/groupcontrib.h>
 #include <openbabel/locale.h>
 #include <openbabel/elements.h>
@@ -39,6 +41,142 @@ using namespace std;
 namespace OpenBabel
 {
 
+  // The patterns of all the data files, each SMARTS parsed once. Like the
+  // descriptors which refer to them, they last as long as the program.
+  struct SharedPatterns
+  {
+    vector<OBSmartsPattern*> patterns;
+    map<string, unsigned int> index; // SMARTS -> position in patterns
+  };
+
+  static SharedPatterns& GetSharedPatterns()
+  {
+    static SharedPatterns shared;
+    return shared;
+  }
+
+  // \return the index of the shared pattern for smarts, or -1 if it cannot be parsed
+  static int AddSharedPattern(const string& smarts)
+  {
+    SharedPatterns& shared = GetSharedPatterns();
+    map<string, unsigned int>::iterator it = shared.index.find(smarts);
+    if (it != shared.index.end())
+      return it->second;
+    OBSmartsPattern* sp = new OBSmartsPattern;
+    if (!sp->Init(smarts)) {
+      delete sp;
+      return -1;
+    }
+    shared.patterns.push_back(sp);
+    shared.index[smarts] = shared.patterns.size() - 1;
+    return shared.patterns.size() - 1;
+  }
+
+  // Index contribution idx under each atomic number its first atom could match
+  static void IndexRule(unsigned int pattern, unsigned int idx,
+                        vector<vector<unsigned int> >& index)
+  {
+    vector<bool> elements;
+    GetSharedPatterns().patterns[pattern]->GetFirstAtomElements(elements);
+    if (index.empty())
+      index.resize(elements.size());
+    for (unsigned int n = 0; n < elements.size(); ++n)
+      if (elements[n])
+        index[n].push_back(idx);
+  }
+
+  // The molecule last seen by any of the descriptors, ready for matching,
+  // and which of the shared patterns have been tried at each of its atoms
+  struct GroupContribWorkspace
+  {
+    vector<int> key;              // connection table of the original molecule
+    vector<int> nextKey;          // ...and of the one asked for, to compare
+    OBMol mol;                    // with hydrogens added and dative bonds converted
+    vector<unsigned char> tried;  // by atom and pattern: 0 untried, 1 matched, 2 not
+    unsigned int npatterns;       // shared patterns when tried was sized
+    GroupContribWorkspace() : npatterns(0) {}
+  };
+
+  static THREAD_LOCAL GroupContribWorkspace groupContribWorkspace;
+
+  // Everything about the molecule that the copy with hydrogens, and so the
+  // SMARTS matches, depend on. Aromaticity is included only when it has
+  // already been perceived, since it would otherwise be perceived the same
+  // way on the copy.
+  static void GetConnectionTable(OBMol& mol, vector<int>& key)
+  {
+    bool aromatic = mol.HasAromaticPerceived();
+    key.clear();
+    key.push_back(mol.NumAtoms());
+    key.push_back(mol.NumBonds());
+    key.push_back(aromatic);
+    FOR_ATOMS_OF_MOL(a, mol) {
+      key.push_back(a->GetAtomicNum());
+      key.push_back(a->GetFormalCharge());
+      key.push_back(a->GetImplicitHCount());
+      key.push_back(a->GetIsotope());
+      key.push_back(aromatic && a->IsAromatic());
+    }
+    FOR_BONDS_OF_MOL(b, mol) {
+      key.push_back(b->GetBeginAtomIdx());
+      key.push_back(b->GetEndAtomIdx());
+      key.push_back(b->GetBondOrder());
+      key.push_back(aromatic && b->IsAromatic());
+    }
+  }
+
+  // \return the copy of mol to match against, reusing the previous one if
+  // it is of the same molecule
+  static OBMol& PrepareMolecule(OBMol& mol, GroupContribWorkspace& ws)
+  {
+    GetConnectionTable(mol, ws.nextKey);
+    if (ws.nextKey != ws.key) {
+      ws.key.swap(ws.nextKey);
+      ws.mol = mol;
+      ws.mol.AddHydrogens(false, false);
+      ws.mol.ConvertDativeBonds();
+      ws.tried.clear();
+    }
+    unsigned int npatterns = GetSharedPatterns().patterns.size();
+    if (npatterns != ws.npatterns) { // another data file has been read
+      ws.tried.clear();
+      ws.npatterns = npatterns;
+    }
+    if (ws.tried.empty())
+      ws.tried.resize(ws.mol.NumAtoms() * npatterns, 0);
+    return ws.mol;
+  }
+
+  // \return true if the shared pattern matches at atom, trying it only once
+  static bool MatchesAt(unsigned int pattern, OBAtom* atom, GroupContribWorkspace& ws)
+  {
+    unsigned char& tried = ws.tried[(atom->GetIdx() - 1) * ws.npatterns + pattern];
+    if (!tried)
+      tried = GetSharedPatterns().patterns[pattern]->MatchesAt(atom) ? 1 : 2;
+    return tried == 1;
+  }
+
+  // \return the last of the contributions that matches at atom, or -1. Later
+  // contributions override earlier ones, so this one gives the atom's value.
+  static int LastMatchingRule(OBAtom* atom, const vector<pair<unsigned int, double> >& rules,
+                              const vector<vector<unsigned int> >& index,
+                              GroupContribWorkspace& ws)
+  {
+    unsigned int n = atom->GetAtomicNum();
+    if (n < index.size()) {
+      const vector<unsigned int>& candidates = index[n];
+      for (vector<unsigned int>::const_reverse_iterator i = candidates.rbegin();
+           i != candidates.rend(); ++i)
+        if (MatchesAt(rules[*i].first, atom, ws))
+          return *i;
+      return -1;
+    }
+    for (int i = rules.size() - 1; i >= 0; --i)
+      if (MatchesAt(rules[i].first, atom, ws))
+        return i;
+    return -1;
+  }
+
   const char* OBGroupContrib::Description()
   {
    //Adds name of datafile containing SMARTS strings to the description
@@ -52,8 +190,6 @@ namespace OpenBabel
 
   bool OBGroupContrib::ParseFile()
   {
-    OBSmartsPattern *sp;
-
     // open data file
     ifstream ifs;
 
@@ -80,19 +216,24 @@ namespace OpenBabel
       if (vs.size() < 2)
         continue;
 
-      sp = new OBSmartsPattern;//causes non-serious memory leak.
-      // Could be cured by copying OBSmartsPattern rather than a pointer in vectors
-      if (sp->Init(vs[0]))
+      // SMARTS already read for another descriptor are shared, not parsed again
+      int pattern = AddSharedPattern(vs[0]);
+      if (pattern >= 0)
       {
+        pair<unsigned int, double> contrib(pattern, atof(vs[1].c_str()));
         if (heavy)
-          _contribsHeavy.push_back(pair<OBSmartsPattern*, double> (sp, atof(vs[1].c_str())));
+        {
+          IndexRule(pattern, _contribsHeavy.size(), _heavyIndex);
+          _contribsHeavy.push_back(contrib);
+        }
         else
-          _contribsHydrogen.push_back(pair<OBSmartsPattern*, double> (sp, atof(vs[1].c_str())));
+        {
+          IndexRule(pattern, _contribsHydrogen.size(), _hydrogenIndex);
+          _contribsHydrogen.push_back(contrib);
+        }
       }
       else
       {
-        delete sp;
-        sp = NULL;
         obErrorLog.ThrowError(__FUNCTION__, " Could not parse SMARTS from contribution data file", obInfo);
 
         // return the locale to the original one
@@ -114,78 +255,48 @@ namespace OpenBabel
     if(!pmol)
       return 0.0;
 
-    //Need to add hydrogens, so do this to a copy to leave original unchanged
-    OBMol mol(*pmol);
-    mol.AddHydrogens(false, false);
-
     //Read in data, unless it has already been done.
     if(_contribsHeavy.empty() && _contribsHydrogen.empty())
       ParseFile();
 
-    vector<vector<int> > _mlist; // match list for atom typing
-    vector<vector<int> >::iterator j;
-    vector<pair<OBSmartsPattern*, double> >::iterator i;
+    //Need to add hydrogens, so do this to a copy to leave original unchanged.
+    //The copy and the patterns tried on it are kept, so that the next group
+    //contribution descriptor of the same molecule need not repeat them.
+    GroupContribWorkspace& ws = groupContribWorkspace;
+    OBMol& tmpmol = PrepareMolecule(*pmol, ws);
+    const vector<OBSmartsPattern*>& patterns = GetSharedPatterns().patterns;
 
     stringstream debugMessage;
-    OBBitVec seenHeavy(mol.NumAtoms() + 1);
-    OBBitVec seenHydrogen(mol.NumAtoms() + 1);
-    vector<double> atomValues(mol.NumAtoms(), 0.0);
-
-    OBMol tmpmol;
-    tmpmol = mol;
-    tmpmol.ConvertDativeBonds();
-
-    // atom contributions
-    if (_debug) debugMessage << "Heavy atom contributions:" << endl;
-    for (i = _contribsHeavy.begin();i != _contribsHeavy.end();++i) {
-      if (i->first->Match(tmpmol)) {
-        _mlist = i->first->GetMapList();
-        for (j = _mlist.begin();j != _mlist.end();++j) {
-          atomValues[(*j)[0] - 1] = i->second;
-          seenHeavy.SetBitOn((*j)[0]);
-	        if (_debug)
-            debugMessage << (*j)[0] << " = " << i->first->GetSMARTS() << " : " << i->second << endl;
-        }
-      }
-    }
-
-    vector<double> hydrogenValues(tmpmol.NumAtoms(), 0.0);
-
-    // Hydrogen contributions - note that matches to hydrogens themselves are ignored
-    if (_debug) debugMessage << "  Hydrogen contributions:" << endl;
-    for (i = _contribsHydrogen.begin();i != _contribsHydrogen.end();++i) {
-      if (i->first->Match(tmpmol)) {
-        _mlist = i->first->GetMapList();
-        for (j = _mlist.begin();j != _mlist.end();++j) {
-          if (tmpmol.GetAtom((*j)[0])->GetAtomicNum() == OBElements::Hydrogen)
-            continue;
-          int Hcount = tmpmol.GetAtom((*j)[0])->GetExplicitDegree() - tmpmol.GetAtom((*j)[0])->GetHvyDegree();
-          hydrogenValues[(*j)[0] - 1] = i->second * Hcount;
-          seenHydrogen.SetBitOn((*j)[0]);
-          if (_debug)
-            debugMessage << (*j)[0] << " = " << i->first->GetSMARTS() << " : " << i->second << " Hcount " << Hcount << endl;
-        }
-      }
-    }
+    if (_debug)
+      debugMessage << "Contributions:\n";
 
-    // total atomic and hydrogen contribution
+    // total atomic and hydrogen contribution. As the data files are applied
+    // in order, the last contribution which matches an atom is the one used.
+    // Matches to hydrogens themselves are ignored.
     double total = 0.0;
-
-    if (_debug)
-      debugMessage << "  Final contributions:\n";
-    for (unsigned int index = 0; index < tmpmol.NumAtoms(); index++) {
-      if (tmpmol.GetAtom(index + 1)->GetAtomicNum() == OBElements::Hydrogen)
+    FOR_ATOMS_OF_MOL(atom, tmpmol) {
+      if (atom->GetAtomicNum() == OBElements::Hydrogen)
         continue;
-      total += atomValues[index];
-      total += hydrogenValues[index];
+      int heavy = LastMatchingRule(&*atom, _contribsHeavy, _heavyIndex, ws);
+      int hydrogen = LastMatchingRule(&*atom, _contribsHydrogen, _hydrogenIndex, ws);
+      int Hcount = atom->GetExplicitDegree() - atom->GetHvyDegree();
+      double atomValue = heavy >= 0 ? _contribsHeavy[heavy].second : 0.0;
+      double hydrogenValue = hydrogen >= 0 ? _contribsHydrogen[hydrogen].second * Hcount : 0.0;
+      total += atomValue;
+      total += hydrogenValue;
+
       if (_debug) {
-        debugMessage << index+1 << " = " << atomValues[index] << " ";
-        if (!seenHeavy.BitIsSet(index + 1)) debugMessage << "un";
-        debugMessage << "matched...";
-        int Hcount = tmpmol.GetAtom(index + 1)->GetExplicitDegree() - tmpmol.GetAtom(index + 1)->GetHvyDegree();
-        debugMessage << "   " << Hcount << " hydrogens = " << hydrogenValues[index] << " ";
-        if (!seenHydrogen.BitIsSet(index + 1)) debugMessage << "un";
-        debugMessage << "matched\n";
+        debugMessage << atom->GetIdx() << " = " << atomValue << " ";
+        if (heavy >= 0)
+          debugMessage << "matched " << patterns[_contribsHeavy[heavy].first]->GetSMARTS();
+        else
+          debugMessage << "unmatched";
+        debugMessage << "...   " << Hcount << " hydrogens = " << hydrogenValue << " ";
+        if (hydrogen >= 0)
+          debugMessage << "matched " << patterns[_contribsHydrogen[hydrogen].first]->GetSMARTS();
+        else
+          debugMessage << "unmatched";
+        debugMessage << "\n";
       }
     }
 
@@ -22,6 +22,7 @@ GNU General Public License for more details.
 #include <openbabel/obconversion.h>
 #include <openbabel/descriptor.h>
 #include <openbabel/inchiformat.h>
+#include <openbabel/stringcache.h>
 
 using namespace std;
 namespace OpenBabel
@@ -48,6 +49,16 @@ private:
 
 double InChIFilter::GetStringValue(OBBase* pOb, std::string& svalue, std::string*)
 {
+  //The key is computed from the molecule itself, after the same stereo
+  //perception as the writer does, so that it is left in the same state on a
+  //hit or a miss
+  OBMolStringCache& cache = OBMolStringCache::Default();
+  OBMol* pmol = dynamic_cast<OBMol*>(pOb);
+  OBMolStringCache::Key key;
+  bool cacheable = pmol && cache.IsEnabled() && OBMolStringCache::GraphKey(*pmol, GetID(), key);
+  if(cacheable && cache.Find(*pmol, key, svalue))
+    return std::numeric_limits<double>::quiet_NaN();
+
   OBConversion conv;
   conv.AddOption("w");//suppress trivial warnings
   if(bKey)
@@ -57,6 +68,8 @@ double InChIFilter::GetStringValue(OBBase* pOb, std::string& svalue, std::string
   else
     obErrorLog.ThrowError(__FUNCTION__, "InChIFormat is not loaded" , obError);
   Trim(svalue);
+  if(cacheable)
+    cache.Insert(*pmol, key, svalue);
 
   return std::numeric_limits<double>::quiet_NaN();
 }
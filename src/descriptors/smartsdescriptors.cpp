@@ -58,6 +58,8 @@ namespace OpenBabel
         return 0.0;
     }
 
+    virtual bool IsThreadSafe() { return true; }
+
     virtual SmartsDescriptor* MakeInstance(const std::vector<std::string>& textlines)
     {
       return new SmartsDescriptor(textlines[1].c_str(),textlines[2].c_str(),textlines[3].c_str());
@@ -36,6 +36,7 @@ GNU General Public License for more details.
 #include <openbabel/stereo/tetrahedral.h>
 #include <openbabel/obconversion.h>
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -819,64 +820,58 @@ namespace OpenBabel {
   //! https://doi.org/10.1016/0166-218X(88)90009-1
   void OBDistanceGeometry::TriangleSmooth()
   {
-    int a, b, c;
-
-    _d->maxBoxSize = 0.0; // size of surrounding space
-
-    float u_ab, u_bc, u_ac; // upper limits
-    float l_ab, l_bc, l_ac; // lower limits
-    FOR_ATOMS_OF_MOL (_a, _mol) {
-      a = _a->GetIdx() - 1;
-      FOR_ATOMS_OF_MOL (_b, _mol) {
-        if (&*_b == &*_a)
+    const int N = _mol.NumAtoms();
+    const int block = 64; // columns per tile (fits comfortably in L1)
+
+    // Work on dense, symmetric row-major copies of the upper and lower
+    // bounds so the inner loop runs over contiguous memory and can be
+    // vectorised by the compiler
+    vector<float> upper(N * N), lower(N * N);
+    for (int i = 0; i < N; ++i) {
+      for (int j = 0; j < N; ++j) {
+        if (i == j) {
+          upper[i * N + j] = lower[i * N + j] = 0.0f;
           continue;
-        b = _b->GetIdx() - 1;
+        }
+        upper[i * N + j] = _d->GetUpperBounds(i, j);
+        lower[i * N + j] = _d->GetLowerBounds(i, j);
+      }
+    }
 
-        // Get upper and lower bounds for ab
-        u_ab = _d->GetUpperBounds(a, b);
-        l_ab = _d->GetLowerBounds(a, b);
-        FOR_ATOMS_OF_MOL (_c, _mol) {
-          if (_c->GetIdx() <= _b->GetIdx())
+    // Each atom k in turn acts as the vertex of the triangle (i, k, j)
+    for (int k = 0; k < N; ++k) {
+      const float *u_k = &upper[k * N];
+      const float *l_k = &lower[k * N];
+      for (int j0 = 0; j0 < N; j0 += block) {
+        const int j1 = std::min(N, j0 + block);
+        for (int i = 0; i < N; ++i) {
+          if (i == k)
             continue;
-          if (&*_c == &*_a)
-            continue;
-
-          c = _c->GetIdx() - 1;
-
-          // get the upper and lower limits for bc and ac
-          u_bc = _d->GetUpperBounds(b, c);
-          l_bc = _d->GetLowerBounds(b, c);
-          u_ac = _d->GetUpperBounds(a, c);
-          l_ac = _d->GetLowerBounds(a, c);
-
-          // Triangle rule: length can't be longer than the sum of the two other legs
-          //   here "a" is the vertex
-          if (u_bc > (u_ab + u_ac)) { // u_bc <= u_ab + u_bc
-            u_bc = u_ab + u_ac;
-            _d->SetUpperBounds(b, c, u_bc);
-          }
-
-          // Triangle rule: length can't be shorter than the difference between the legs
-          if (l_bc < (l_ab - l_ac)) {
-            l_bc = l_ab - l_ac;
-            _d->SetLowerBounds(b, c, l_bc);
-          } else if (l_bc < (l_ac - l_ab)) {
-            l_bc = l_ac - l_ab;
-            _d->SetLowerBounds(b, c, l_bc);
+          float *u_i = &upper[i * N];
+          float *l_i = &lower[i * N];
+          const float u_ik = u_i[k];
+          const float l_ik = l_i[k];
+          for (int j = j0; j < j1; ++j) {
+            // Triangle rule: length can't be longer than the sum of the two other legs
+            const float u = std::min(u_i[j], u_ik + u_k[j]);
+            // Triangle rule: length can't be shorter than the difference between the legs
+            const float l = std::max(l_i[j], std::max(l_ik - l_k[j], l_k[j] - l_ik));
+            u_i[j] = std::max(u, l);
+            l_i[j] = l;
           }
+        }
+      }
+    }
 
-          if (u_bc < l_bc) {
-            _d->SetUpperBounds(b, c, l_bc);
-            //obErrorLog.ThrowError(__FUNCTION__, "Triagle Smoothing: Erroneous Bounds.", obWarning);
-          }
-
-        } // loop(c)
-
-        // Update boxSize after all "c" updates for this pair
-        if (_d->GetUpperBounds(a, b) > _d->maxBoxSize)
-          _d->maxBoxSize = _d->GetUpperBounds(a, b);
-      } // loop(b)
-    } // loop(a)
+    _d->maxBoxSize = 0.0; // size of surrounding space
+    for (int i = 0; i < N; ++i) {
+      for (int j = i + 1; j < N; ++j) {
+        _d->SetUpperBounds(i, j, upper[i * N + j]);
+        _d->SetLowerBounds(i, j, lower[i * N + j]);
+        if (upper[i * N + j] > _d->maxBoxSize)
+          _d->maxBoxSize = upper[i * N + j];
+      }
+    }
   }
 
   void OBDistanceGeometry::SetLowerBounds()
@@ -909,13 +904,13 @@ namespace OpenBabel {
     }
   }
 
-  bool OBDistanceGeometry::CheckStereoConstraints()
+  bool OBDistanceGeometry::CheckStereoConstraints(OBMol &mol)
   {
     // Check stereo by canonical SMILES
-    StereoFrom3D(&_mol, true);
+    StereoFrom3D(&mol, true);
     OBConversion conv;
     conv.SetOutFormat("can");
-    std::string predicted_smiles = conv.WriteString(&_mol, true);
+    std::string predicted_smiles = conv.WriteString(&mol, true);
     return input_smiles == predicted_smiles;
 
     // Check all stereo constraints
@@ -993,13 +988,11 @@ namespace OpenBabel {
       return false;
   }
 
-  bool OBDistanceGeometry::generateInitialCoords(void) {
+  bool OBDistanceGeometry::generateInitialCoords(Eigen::VectorXd &coord, OBRandom &generator) {
     // place atoms randomly
     unsigned int N = _mol.NumAtoms();
     // random distance matrix
     Eigen::MatrixXd distMat = Eigen::MatrixXd::Zero(N, N);
-    OBRandom generator;
-    generator.TimeSeed();
     for (size_t i=0; i<N; ++i) {
       for(size_t j=0; j<i; ++j) {
         double lb = _d->GetLowerBounds(i, j);
@@ -1049,41 +1042,17 @@ namespace OpenBabel {
       else eigVals(i) *= -1;
     }
 
-    _coord.resize(N * dim);
+    coord.resize(N * dim);
     for (size_t i = 0; i < N; i++) {
       for (size_t j = 0; j < dim; j++) {
-        if(N-1-j >= 0) _coord(i*dim + j) = eigVals(N-1-j) * eigVecs(i, N-1-j);
-        else _coord(i*dim + j) = 0;
-      }
-    }
-    Eigen::MatrixXd distMat2(N, N);
-    for (size_t i = 0; i < N; i++) {
-      for (size_t j = 0; j < N; j++) {
-        for(size_t k = 0; k < dim; k++)
-          distMat2(i, j) += pow(_coord(i*dim + k)-_coord(j*dim + k), 2.0);
-        distMat2(i, j) = sqrt(distMat2(i, j));
-      }
-    }
-
-    for(size_t i=0; i<N; i++) {
-      for (size_t j=0; j<N; j++) {
-        double lb = _d->GetLowerBounds(i, j);
-        double ub = _d->GetUpperBounds(i, j);
-        //cout << "(" << i << ", " << j << ")" << lb << " < " << distMat2(i, j) << " (" << distMat(i, j) << ")" << " < " << ub << endl;
+        if(j < N) coord(i*dim + j) = eigVals(N-1-j) * eigVecs(i, N-1-j);
+        else coord(i*dim + j) = 0;
       }
     }
     return true;
   }
 
-  bool OBDistanceGeometry::firstMinimization(void) {
-    unsigned int N = _mol.NumAtoms();
-    for(size_t i=0; i<N; ++i) {
-      vector3 v(_coord(i*dim), _coord(i*dim+1), _coord(i*dim+2));
-      OBAtom* a = _mol.GetAtom(i+1);
-      a->SetVector(v);
-    }
-    DistGeomFunc f(this);
-
+  bool OBDistanceGeometry::firstMinimization(Eigen::VectorXd &coord) {
     LBFGSpp::LBFGSParam<double> param;
     param.epsilon = 1e-6;
     param.max_iterations = 1000;
@@ -1093,43 +1062,11 @@ namespace OpenBabel {
     DistGeomFunc fun(this);
 
     double fx;
-    int niter = solver.minimize(fun, _coord, fx);
-    //std::cout << niter << " iterations" << std::endl;
-    //std::cout << "f(x) = " << fx << std::endl;
-
-    for(size_t i=0; i<N; ++i) {
-      vector3 v(_coord(i*dim), _coord(i*dim+1), _coord(i*dim+2));
-      OBAtom* a = _mol.GetAtom(i+1);
-      a->SetVector(v);
-    }
-
-    Eigen::MatrixXd distMat2(N, N);
-    for (size_t i = 0; i < N; i++) {
-      for (size_t j = 0; j < N; j++) {
-        for(size_t k = 0; k < dim; k++)
-          distMat2(i, j) += pow(_coord(i*dim + k)-_coord(j*dim + k), 2.0);
-        distMat2(i, j) = sqrt(distMat2(i, j));
-      }
-    }
-
-    for(size_t i=0; i<N; i++) {
-      for (size_t j=0; j<N; j++) {
-        double lb = _d->GetLowerBounds(i, j);
-        double ub = _d->GetUpperBounds(i, j);
-        //cout << "(" << i << ", " << j << ")" << lb << " < " << distMat2(i, j) << " < " << ub << endl;
-      }
-    }
+    solver.minimize(fun, coord, fx);
     return true;
   }
 
-  bool OBDistanceGeometry::minimizeFourthDimension(void) {
-    unsigned int N = _mol.NumAtoms();
-    for(size_t i=0; i<N; ++i) {
-      vector3 v(_coord(i*dim), _coord(i*dim+1), _coord(i*dim+2));
-      OBAtom* a = _mol.GetAtom(i+1);
-      a->SetVector(v);
-    }
-
+  bool OBDistanceGeometry::minimizeFourthDimension(Eigen::VectorXd &coord) {
     LBFGSpp::LBFGSParam<double> param;
     param.epsilon = 1e-6;
     param.max_iterations = 2000;
@@ -1138,16 +1075,31 @@ namespace OpenBabel {
     DistGeomFunc4D fun(this);
 
     double fx;
-    int niter = solver.minimize(fun, _coord, fx);
-    //std::cout << niter << " iterations" << std::endl;
-    //std::cout << "f(x) = " << fx << std::endl;
+    solver.minimize(fun, coord, fx);
+    return true;
+  }
 
-    for(size_t i=0; i<N; ++i) {
-      vector3 v(_coord(i*dim), _coord(i*dim+1), _coord(i*dim+2));
-      OBAtom* a = _mol.GetAtom(i+1);
-      a->SetVector(v);
+  bool OBDistanceGeometry::Embed(OBMol &mol, OBRandom &generator)
+  {
+    unsigned int N = mol.NumAtoms();
+    Eigen::VectorXd coord;
+
+    unsigned int maxIter = 1 * N;
+    for (unsigned int trial = 0; trial < maxIter; trial++) {
+      generateInitialCoords(coord, generator);
+      firstMinimization(coord);
+      if (dim == 4) minimizeFourthDimension(coord);
+
+      for(size_t i=0; i<N; ++i) {
+        vector3 v(coord(i*dim), coord(i*dim+1), coord(i*dim+2));
+        mol.GetAtom(i+1)->SetVector(v);
+      }
+      if (CheckStereoConstraints(mol) && CheckBounds(mol))
+        return true;
+      if (_d->debug)
+        cerr << "Stereo unsatisfied, trying again" << endl;
     }
-    return true;
+    return false;
   }
 
   void OBDistanceGeometry::AddConformer()
@@ -1157,42 +1109,66 @@ namespace OpenBabel {
     _mol.AddConformer(confCoord);
     _mol.SetConformer(_mol.NumConformers());
 
-    OBRandom generator(true); // Use system rand() functions
+    OBRandom generator; // private to this call, as is the seed
     generator.TimeSeed();
 
     if (_d->debug) {
       cerr << " max box size: " << _d->maxBoxSize << endl;
     }
 
-    bool success = false;
-    unsigned int maxIter = 1 * _mol.NumAtoms();
-    for (unsigned int trial = 0; trial < maxIter; trial++) {
-      generateInitialCoords();
-      firstMinimization();
-      if (dim == 4) minimizeFourthDimension();
-      if (CheckStereoConstraints() && CheckBounds()) {
-        success = true;
-        break;
-      }
-      if (_d->debug && !success)
-        cerr << "Stereo unsatisfied, trying again" << endl;
-    }
-    if(!success) {
+    if(!Embed(_mol, generator)) {
       obErrorLog.ThrowError(__FUNCTION__, "Distance Geometry failed.", obWarning);
     }
   }
 
-  bool OBDistanceGeometry::CheckBounds()
+  void OBDistanceGeometry::AddConformers(unsigned int nconfs)
+  {
+    if (nconfs == 0)
+      return;
+
+    const unsigned int N = _mol.NumAtoms();
+    // Draw the seeds up front so each embedding has its own random stream
+    OBRandom seeder;
+    seeder.TimeSeed();
+    vector<int> seeds(nconfs);
+    for (unsigned int c = 0; c < nconfs; ++c)
+      seeds[c] = seeder.NextInt();
+
+    vector<double*> coords(nconfs);
+    vector<char> success(nconfs);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int c = 0; c < static_cast<int>(nconfs); ++c) {
+      OBMol mol(_mol); // private copy for the stereo and bounds checks
+      OBRandom generator;
+      generator.Seed(seeds[c]);
+      success[c] = Embed(mol, generator);
+
+      coords[c] = new double [N * 3];
+      for (unsigned int i = 0; i < N * 3; ++i)
+        coords[c][i] = mol.GetCoordinates()[i];
+    }
+
+    for (unsigned int c = 0; c < nconfs; ++c) {
+      _mol.AddConformer(coords[c]);
+      if (!success[c])
+        obErrorLog.ThrowError(__FUNCTION__, "Distance Geometry failed.", obWarning);
+    }
+    _mol.SetConformer(_mol.NumConformers() - 1);
+  }
+
+  bool OBDistanceGeometry::CheckBounds(OBMol &mol)
   {
     // remember atom indexes from 1
     OBAtom *a, *b;
     double dist, aRad, bRad, minDist, uBounds;
 
-    for (unsigned int i = 1; i <= _mol.NumAtoms(); ++i) {
-      a = _mol.GetAtom(i);
+    for (unsigned int i = 1; i <= mol.NumAtoms(); ++i) {
+      a = mol.GetAtom(i);
       aRad = OBElements::GetVdwRad(a->GetAtomicNum());
-      for (unsigned int j = i + 1; j <= _mol.NumAtoms(); ++j) {
-          b = _mol.GetAtom(j);
+      for (unsigned int j = i + 1; j <= mol.NumAtoms(); ++j) {
+          b = mol.GetAtom(j);
 
           // Compare the current distance to the lower and upper bounds
           dist = a->GetDistance(b);
@@ -1205,7 +1181,7 @@ namespace OpenBabel {
             return false;
           }
           // now lower.. if the two atoms aren't bonded
-          if (_mol.GetBond(a, b))
+          if (mol.GetBond(a, b))
             continue;
 
           bRad = OBElements::GetVdwRad(b->GetAtomicNum());
@@ -1267,152 +1243,49 @@ namespace OpenBabel {
 
   double DistGeomFunc::operator() (const Eigen::VectorXd& x, Eigen::VectorXd& grad) {
     unsigned int dim = owner->GetDimension();
-    const size_t size = x.size()/dim;
+    const size_t N = x.size()/dim;
     double ret = 0.0;
-    // calculate distance error
-    for(size_t i=0; i<size; ++i) {
-        for(size_t j=0; j<size; ++j) {
-            double v = 0.0;
-            double d2 = 0;
-            for(size_t k=0; k<dim; k++)
-              d2 += pow(x[i*dim+k]-x[j*dim+k], 2.0);
-            double d = sqrt(d2);
-            double ub = owner->GetUpperBounds(i, j);
-            double lb = owner->GetLowerBounds(i, j);
-            double u2 = ub * ub;
-            double l2 = lb * lb;
-            if (d > ub) v = d2/u2-1.0; 
-            else if (d < lb) v = (2.0*l2 / (l2+d2))-1.0;
-            if(v > 0.0) ret += v*v;
-        }
-    }
-    // calculate distance error
-    for(size_t i = 0; i < owner->_stereo.size(); i++) {
-      TetrahedralInfo tetra = owner->_stereo[i];
-      vector<unsigned long> nbrs = tetra.GetNeighbors();
-      Eigen::Vector3d v1(x(nbrs[0] * dim), x(nbrs[0]*dim+1), x(nbrs[0]*dim+2));
-      Eigen::Vector3d v2(x(nbrs[1] * dim), x(nbrs[1]*dim+1), x(nbrs[1]*dim+2));
-      Eigen::Vector3d v3(x(nbrs[2] * dim), x(nbrs[2]*dim+1), x(nbrs[2]*dim+2));
-      Eigen::Vector3d v4(x(nbrs[3] * dim), x(nbrs[3]*dim+1), x(nbrs[3]*dim+2));
-      double vol = (v1-v4).dot((v2-v4).cross(v3-v4));
-      double lb = tetra.GetLowerBound();
-      double ub = tetra.GetUpperBound();
-      if(vol < lb) ret += (vol - lb) * (vol - lb);
-      else if(vol > ub) ret += (vol - ub) * (vol - ub);
-    }
     // clear gradient
-    for (size_t i=0; i<grad.rows(); i++) {
-      grad[i] = 0;
-    }
-    // gradient for distance error
-    unsigned int N = x.size() / dim;
+    grad.setZero();
+    // distance error and its gradient, in one pass over the unique pairs
+    // (each pair contributes twice, once as (i, j) and once as (j, i))
     for(size_t i=0; i<N; ++i) {
-      for(size_t j=0; j<N; ++j) {
-        double preFactor = 0.0;
+      const double *xi = x.data() + i*dim;
+      for(size_t j=i+1; j<N; ++j) {
+        const double *xj = x.data() + j*dim;
+        double d2 = 0.0;
+        for(size_t k=0; k<dim; k++) {
+          double diff = xi[k] - xj[k];
+          d2 += diff * diff;
+        }
         double ub = owner->GetUpperBounds(i, j);
         double lb = owner->GetLowerBounds(i, j);
-        double d2 = 0;
-        for(size_t k=0; k<dim; k++)
-          d2 += pow(x[i*dim+k]-x[j*dim+k], 2.0);
+        double u2 = ub * ub;
+        double l2 = lb * lb;
+        // most pairs are already inside their bounds and contribute nothing
+        if (d2 <= u2 && d2 >= l2)
+          continue;
+
         double d = sqrt(d2);
-        if (d > ub) {
-          double u2 = ub * ub;
-          preFactor = 4.0 * (((d2)/u2) - 1.0) * (d/u2);
-        } else if(d < lb) {
-          double l2 = lb * lb;
+        double v, preFactor;
+        if (d2 > u2) {
+          v = d2/u2 - 1.0;
+          preFactor = 4.0 * v * (d/u2);
+        } else {
           double l2d2 = d2 + l2;
+          v = (2.0*l2 / l2d2) - 1.0;
           preFactor = 8.0 * l2 * d * (1.0 - 2.0 * l2 / l2d2) / (l2d2 * l2d2);
         }
+        ret += 2.0 * v * v;
+        if (d <= 0)
+          continue;
         for (size_t k=0; k<dim; ++k) {
-          double g = 0;
-          if(d > 0) g = preFactor * (x[i*dim+k] - x[j*dim+k]) / d;
+          double g = 2.0 * preFactor * (xi[k] - xj[k]) / d;
           grad[i * dim + k] += g;
-          grad[j * dim + k] += -g;
+          grad[j * dim + k] -= g;
         }
       }
     }
-    // gradient for chiral error
-    for(size_t i = 0; i < owner->_stereo.size(); i++) {
-      TetrahedralInfo tetra = owner->_stereo[i];
-      vector<unsigned long> nbrs = tetra.GetNeighbors();
-      unsigned long idx1, idx2, idx3, idx4;
-      idx1 = nbrs[0];
-      idx2 = nbrs[1];
-      idx3 = nbrs[2];
-      idx4 = nbrs[3];
-
-      Eigen::Vector3d v1(x(idx1 * dim), x(idx1 * dim+1), x(idx1 * dim+2));
-      Eigen::Vector3d v2(x(idx2 * dim), x(idx2 * dim+1), x(idx2 * dim+2));
-      Eigen::Vector3d v3(x(idx3 * dim), x(idx3 * dim+1), x(idx3 * dim+2));
-      Eigen::Vector3d v4(x(idx4 * dim), x(idx4 * dim+1), x(idx4 * dim+2));
-      v1 -= v4;
-      v2 -= v4;
-      v3 -= v4;
-
-      double vol = v1.dot(v2.cross(v3));
-      double lb = tetra.GetLowerBound();
-      double ub = tetra.GetUpperBound();
-
-      double preFactor;
-      if (vol < lb) preFactor = vol - lb;
-      else if (vol > ub) preFactor = vol - ub;
-      else continue;
-
-      // RDKit: Code/DistGeom/ChiralViolationContrib.cpp
-      grad[dim * idx1] += preFactor * (v2.y() * v3.z() - v3.y() * v2.z());
-      grad[dim * idx1 + 1] += preFactor * (v3.x() * v2.z() - v2.x() * v3.z());
-      grad[dim * idx1 + 2] += preFactor * (v2.x() * v3.y() - v3.x() * v2.y());
-
-      grad[dim * idx2] += preFactor * (v3.y() * v1.z() - v3.z() * v1.y());
-      grad[dim * idx2 + 1] += preFactor * (v3.z() * v1.x() - v3.z() * v1.z());
-      grad[dim * idx2 + 2] += preFactor * (v3.x() * v1.y() - v3.y() * v1.x());
-
-      grad[dim * idx3] += preFactor * (v2.z() * v1.y() - v2.y() * v1.z());
-      grad[dim * idx3 + 1] += preFactor * (v2.x() * v1.z() - v2.z() * v1.x());
-      grad[dim * idx3 + 2] += preFactor * (v2.y() * v1.x() - v2.x() * v1.y());
-
-      grad[dim * idx4] += 
-        preFactor *
-        (x[idx1 * dim + 2] * (x[idx2 * dim + 1] - x[idx3 * dim + 1]) + 
-         x[idx2 * dim + 2] * (x[idx3 * dim + 1] - x[idx1 * dim + 1]) + 
-         x[idx3 * dim + 2] * (x[idx1 * dim + 1] - x[idx2 * dim + 1]));
-
-      grad[dim * idx4 + 1] += 
-        preFactor *
-        (x[idx1 * dim] * (x[idx2 * dim + 2] - x[idx3 * dim + 2]) + 
-         x[idx2 * dim] * (x[idx3 * dim + 2] - x[idx1 * dim + 2]) + 
-         x[idx3 * dim] * (x[idx1 * dim + 2] - x[idx2 * dim + 2]));
-
-      grad[dim * idx4 + 2] += 
-        preFactor *
-        (x[idx1 * dim + 1] * (x[idx2 * dim] - x[idx3 * dim]) + 
-         x[idx2 * dim + 1] * (x[idx3 * dim] - x[idx1 * dim]) + 
-         x[idx3 * dim + 1] * (x[idx1 * dim] - x[idx2 * dim]));
-    }
-    return ret;
-  }
-
-  double DistGeomFunc4D::operator() (const Eigen::VectorXd& x, Eigen::VectorXd& grad) {
-    unsigned int dim = owner->GetDimension();
-    const size_t size = x.size()/dim;
-    double ret = 0.0;
-    // calculate distance error
-    for(size_t i=0; i<size; ++i) {
-        for(size_t j=0; j<size; ++j) {
-            double v = 0.0;
-            double d2 = 0;
-            for(size_t k=0; k<dim; k++)
-              d2 += pow(x[i*dim+k]-x[j*dim+k], 2.0);
-            double d = sqrt(d2);
-            double ub = owner->GetUpperBounds(i, j);
-            double lb = owner->GetLowerBounds(i, j);
-            double u2 = ub * ub;
-            double l2 = lb * lb;
-            if (d > ub) v = d2/u2-1.0; 
-            else if (d < lb) v = (2.0*l2 / (l2+d2))-1.0;
-            if(v > 0.0) ret += v*v;
-        }
-    }
     // calculate distance error
     for(size_t i = 0; i < owner->_stereo.size(); i++) {
       TetrahedralInfo tetra = owner->_stereo[i];
@@ -1427,37 +1300,6 @@ namespace OpenBabel {
       if(vol < lb) ret += (vol - lb) * (vol - lb);
       else if(vol > ub) ret += (vol - ub) * (vol - ub);
     }
-    // clear gradient
-    for (size_t i=0; i<grad.rows(); i++) {
-      grad[i] = 0;
-    }
-    // gradient for distance error
-    unsigned int N = x.size() / dim;
-    for(size_t i=0; i<N; ++i) {
-      for(size_t j=0; j<N; ++j) {
-        double preFactor = 0.0;
-        double ub = owner->GetUpperBounds(i, j);
-        double lb = owner->GetLowerBounds(i, j);
-        double d2 = 0;
-        for(size_t k=0; k<dim; k++)
-          d2 += pow(x[i*dim+k]-x[j*dim+k], 2.0);
-        double d = sqrt(d2);
-        if (d > ub) {
-          double u2 = ub * ub;
-          preFactor = 4.0 * (((d2)/u2) - 1.0) * (d/u2);
-        } else if(d < lb) {
-          double l2 = lb * lb;
-          double l2d2 = d2 + l2;
-          preFactor = 8.0 * l2 * d * (1.0 - 2.0 * l2 / l2d2) / (l2d2 * l2d2);
-        }
-        for (size_t k=0; k<dim; ++k) {
-          double g = 0;
-          if(d > 0) g = preFactor * (x[i*dim+k] - x[j*dim+k]) / d;
-          grad[i * dim + k] += g;
-          grad[j * dim + k] += -g;
-        }
-      }
-    }
     // gradient for chiral error
     for(size_t i = 0; i < owner->_stereo.size(); i++) {
       TetrahedralInfo tetra = owner->_stereo[i];
@@ -1516,12 +1358,19 @@ namespace OpenBabel {
          x[idx2 * dim + 1] * (x[idx3 * dim] - x[idx1 * dim]) + 
          x[idx3 * dim + 1] * (x[idx1 * dim] - x[idx2 * dim]));
     }
+    return ret;
+  }
 
-    for(size_t i=0; i<size; ++i) {
-      ret += pow(x[i*dim+3], 2.0);
-    }
+  double DistGeomFunc4D::operator() (const Eigen::VectorXd& x, Eigen::VectorXd& grad) {
+    unsigned int dim = owner->GetDimension();
+    const size_t N = x.size()/dim;
+    // same distance and chiral errors as in the first minimization...
+    DistGeomFunc f(owner);
+    double ret = f(x, grad);
 
+    // ...plus a penalty to squeeze out the fourth dimension
     for(size_t i=0; i<N; ++i) {
+      ret += x[i*dim+3] * x[i*dim+3];
       grad[i * dim + 3] += 2.0 * x[i * dim + 3];
     }
     return ret;
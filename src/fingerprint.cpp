@@ -26,6 +26,8 @@ GNU General Public License for more details.
 
 #include <openbabel/fingerprint.h>
 #include <openbabel/oberror.h>
+#include <openbabel/mol.h>
+#include <openbabel/obconversion.h>
 
 using namespace std;
 namespace OpenBabel
@@ -70,6 +72,66 @@ namespace OpenBabel
     }
   }
 
+  ////////////////////////////////////////
+  unsigned int OBFingerprint::GetFingerprints(OBConversion& conv,
+                                              vector<vector<unsigned int> >& fps, int nbits)
+  {
+    const unsigned int chunksize = 1024;
+    fps.clear();
+    vector<OBMol> mols;
+    mols.reserve(chunksize);
+    vector<OBBase*> objs;
+    vector<vector<unsigned int> > chunkfps;
+    bool more = true;
+    while(more)
+    {
+      //Reading is serial; the molecules of a chunk are then independent
+      mols.clear();
+      while(mols.size() < chunksize)
+      {
+        mols.push_back(OBMol());
+        if(!conv.Read(&mols.back()))
+        {
+          mols.pop_back();
+          more = false;
+          break;
+        }
+      }
+      if(mols.empty())
+        break;
+
+      objs.clear();
+      for(unsigned int i = 0; i < mols.size(); ++i)
+        objs.push_back(&mols[i]);
+      GetFingerprints(objs, chunkfps, nbits);
+      fps.insert(fps.end(), chunkfps.begin(), chunkfps.end());
+    }
+
+    return fps.size();
+  }
+
+  bool OBFingerprint::GetFingerprints(const vector<OBBase*>& objs,
+                                      vector<vector<unsigned int> >& fps, int nbits)
+  {
+    unsigned int oldflags = Flags();
+    SetFlags(oldflags | FPT_NOINFO);
+
+    fps.assign(objs.size(), vector<unsigned int>());
+    //The typers used in perception are thread_local, and each object is
+    //perceived on its own, so the objects are independent
+    int n = objs.size();
+    int failed = 0;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 16) reduction(+:failed) if(IsThreadSafe())
+#endif
+    for(int i = 0; i < n; ++i)
+      if(!GetFingerprint(objs[i], fps[i], nbits))
+        ++failed;
+
+    SetFlags(oldflags);
+    return failed == 0;
+  }
+
   ////////////////////////////////////////
 /*  bool OBFingerprint::GetNextFPrt(std::string& id, OBFingerprint*& pFPrt)
   {
@@ -69,22 +69,51 @@ virtual std::string DescribeBits(const std::  vector<unsigned int> fp, bool bSet
   { return _ss.str(); }
 
   virtual unsigned int Flags() { return _flags;};
-  virtual void SetFlags(unsigned int f){ _flags=f; }
+  /// Without fragment info _ss is never written, so it is cleared here rather
+  /// than by GetFingerprint(), which may then be running on several threads
+  virtual void SetFlags(unsigned int f)
+  {
+    _flags=f;
+    if(_flags & FPT_NOINFO)
+      _ss.str("");
+  }
+
+  /// Only the fragment descriptions are shared between calls
+  virtual bool IsThreadSafe() { return (_flags & FPT_NOINFO) != 0; }
 
 private:
 	typedef std::set<std::vector<int> > Fset;
 	typedef std::set<std::vector<int> >::iterator SetItr;
 
-	void getFragments(std::vector<int> levels, std::vector<int> curfrag,
-			int level, OBAtom* patom, OBBond* pbond);
-	void DoReverses();
-	void DoRings();
+	enum { Max_Fragment_Size = 7, Max_Fragment_Length = 2 * Max_Fragment_Size };
 
-	unsigned int CalcHash(const std::vector<int>& frag);
+	/// One step of the path enumeration: the atom at this depth, the bond used
+	/// to reach it and the next bond to try. hash/revhash are the rolling
+	/// CalcHash() values of the path so far and of its reverse.
+	struct PathStep
+	{
+		OBAtom* atom;
+		OBBond* bond;
+		OBBondIterator next;
+		unsigned int hash, revhash, power;
+	};
+
+	/// Per-call state of the path enumeration
+	struct Workspace
+	{
+		std::vector<int> levels;
+		std::vector<PathStep> path;
+		int curfrag[Max_Fragment_Length];
+		Fset fragset; //only filled when describing the bits
+	};
+
+	void getFragments(Workspace& ws, OBAtom* pstart, std::vector<unsigned int>& fp);
+	void AddFragment(Workspace& ws, const int* frag, int len, std::vector<unsigned int>& fp);
+	void AddRing(Workspace& ws, int len, std::vector<unsigned int>& fp);
+
+	unsigned int CalcHash(const int* frag, int len);
 	void PrintFpt(const std::vector<int>& f, int hash=0);
 
-	Fset fragset;
-	Fset ringset;
   stringstream _ss;
   unsigned int _flags;
 
@@ -105,163 +134,175 @@ bool fingerprint2::GetFingerprint(OBBase* pOb, vector<unsigned int>&fp, int nbit
 	OBMol* pmol = dynamic_cast<OBMol*>(pOb);
 	if(!pmol) return false;
 	fp.resize(1024/Getbitsperint());
-	fragset.clear();//needed because now only one instance of fp class
-	ringset.clear();
- 
+	Workspace ws;
+	ws.levels.assign(pmol->NumAtoms(), 0);
+	ws.path.reserve(Max_Fragment_Size);
+
 	//identify fragments starting at every atom
 	OBAtom *patom;
 	vector<OBNodeBase*>::iterator i;
 	for (patom = pmol->BeginAtom(i);patom;patom = pmol->NextAtom(i))
 	{
 		if(patom->GetAtomicNum() == OBElements::Hydrogen) continue;
-		vector<int> curfrag;
-		vector<int> levels(pmol->NumAtoms());
-		getFragments(levels, curfrag, 1, patom, NULL);
+		getFragments(ws, patom, fp);
 	}
 
-//	TRACE("%s %d frags before; ",pmol->GetTitle(),fragset.size());
-
-	//Ensure that each chemically identical fragment is present only in a single
-	DoRings();
-	DoReverses();
-
+	//The bits were set as the fragments were found; the sorted set of
+	//fragments is only kept to describe them. With FPT_NOINFO, _ss was
+	//cleared by SetFlags() and stays empty.
 	SetItr itr;
-  _ss.str("");
-	for(itr=fragset.begin();itr!=fragset.end();++itr)
-	{
-		//Use hash of fragment to set a bit in the fingerprint
-		int hash = CalcHash(*itr);
-		SetBit(fp,hash);
-		if(!(Flags() & FPT_NOINFO))
-      PrintFpt(*itr,hash);
-	}
+	if(!(Flags() & FPT_NOINFO))
+	  _ss.str("");
+	for(itr=ws.fragset.begin();itr!=ws.fragset.end();++itr)
+		PrintFpt(*itr, CalcHash(&(*itr)[0], itr->size()));
 	if(nbits)
 		Fold(fp, nbits);
 
-//	TRACE("%d after\n",fragset.size());
 	return true;
 }
 
 //////////////////////////////////////////////////////////
-void fingerprint2::getFragments(vector<int> levels, vector<int> curfrag,
-					int level, OBAtom* patom, OBBond* pbond)
+static inline int BondCode(OBBond* pbond)
 {
-	//Recursive routine to analyse schemical structure and populate fragset and ringset
-	//Hydrogens,charges(except dative bonds), spinMultiplicity ignored
-	const int Max_Fragment_Size = 7;
-	int bo=0;
-	if(pbond)
-	{
-		bo = pbond->IsAromatic() ? 5 : pbond->GetBondOrder();
+	return pbond->IsAromatic() ? 5 : pbond->GetBondOrder();
+}
 
-//		OBAtom* pprevat = pbond->GetNbrAtom(patom);
-//		if(patom->GetFormalCharge() && (patom->GetFormalCharge() == -pprevat->GetFormalCharge()))
-//			++bo; //coordinate (dative) bond eg C[N+]([O-])=O is seen as CN(=O)=O
-	}
-	curfrag.push_back(bo);
-	curfrag.push_back(patom->GetAtomicNum());
-	levels[patom->GetIdx()-1] = level;
-
-	vector<OBBond*>::iterator itr;
-	OBBond *pnewbond;
-//	PrintFpt(curfrag,(int)patom);
-	for (pnewbond = patom->BeginBond(itr);pnewbond;pnewbond = patom->NextBond(itr))
+void fingerprint2::getFragments(Workspace& ws, OBAtom* pstart, vector<unsigned int>& fp)
+{
+	//Depth-first enumeration of the linear paths starting at pstart, using
+	//a single explicit stack and fragment buffer.
+	//Hydrogens,charges(except dative bonds), spinMultiplicity ignored
+	const unsigned int MODINT = 108; //2^32 % 1021
+	vector<int>& levels = ws.levels;
+	vector<PathStep>& path = ws.path;
+	int* curfrag = ws.curfrag;
+	PathStep step;
+	step.atom = pstart;
+	step.bond = NULL;
+	step.next = pstart->BeginBonds();
+	step.hash = pstart->GetAtomicNum() % 1021;
+	step.revhash = step.hash;
+	step.power = MODINT;
+	path.clear();
+	path.push_back(step);
+	curfrag[0] = 0;
+	curfrag[1] = pstart->GetAtomicNum();
+	levels[pstart->GetIdx()-1] = 1;
+
+	while(!path.empty())
 	{
-		if(pnewbond==pbond) continue; //don't retrace steps
-		OBAtom* pnxtat = pnewbond->GetNbrAtom(patom);
-		if(pnxtat->GetAtomicNum() == OBElements::Hydrogen) continue;
-
-		int atlevel = levels[pnxtat->GetIdx()-1];
-		if(atlevel) //ring
+		const int level = path.size();
+		PathStep& cur = path.back();
+		OBAtom* patom = cur.atom;
+		bool descended = false;
+		while(cur.next != patom->EndBonds())
 		{
-			if(atlevel==1)
+			OBBond* pnewbond = *cur.next++;
+			if(pnewbond==cur.bond) continue; //don't retrace steps
+			OBAtom* pnxtat = pnewbond->GetNbrAtom(patom);
+			if(pnxtat->GetAtomicNum() == OBElements::Hydrogen) continue;
+
+			int atlevel = levels[pnxtat->GetIdx()-1];
+			if(atlevel) //ring
 			{
 				//If complete ring (last bond is back to starting atom) add bond at front
-				//and save in ringset
-				curfrag[0] = pnewbond->IsAromatic() ? 5 : pnewbond->GetBondOrder();
-				ringset.insert(curfrag);
- 				curfrag[0] = 0;
+				if(atlevel==1)
+				{
+					curfrag[0] = BondCode(pnewbond);
+					AddRing(ws, 2 * level, fp);
+					curfrag[0] = 0;
+				}
 			}
-		}
-		else //no ring
-		{
-			if(level<Max_Fragment_Size)
+			else if(level<Max_Fragment_Size)
 			{
-//				TRACE("level=%d size=%d %p frag[0]=%p\n",level, curfrag.size(),&curfrag, &(curfrag[0]));
-				//Do the next atom; levels, curfrag are passed by value and hence copied
-				getFragments(levels, curfrag, level+1, pnxtat, pnewbond);
+				//Extend the path by one atom and update both rolling hashes
+				int bo = BondCode(pnewbond);
+				int atno = pnxtat->GetAtomicNum();
+				curfrag[2 * level] = bo;
+				curfrag[2 * level + 1] = atno;
+				step.atom = pnxtat;
+				step.bond = pnewbond;
+				step.next = pnxtat->BeginBonds();
+				step.hash = ((cur.hash * MODINT + bo % 1021) * MODINT + atno % 1021) % 1021;
+				step.revhash = (cur.revhash + (bo % 1021) * cur.power
+				                + (atno % 1021) * ((cur.power * MODINT) % 1021)) % 1021;
+				step.power = (cur.power * MODINT * MODINT) % 1021;
+				levels[pnxtat->GetIdx()-1] = level + 1;
+				path.push_back(step); // cur is invalid from here
+				descended = true;
+				break;
 			}
 		}
-	}
+		if(descended)
+			continue;
 
-	//do not save C,N,O single atom fragments
-	if(curfrag[0]==0 &&
-		(level>1 || patom->GetAtomicNum()>8  || patom->GetAtomicNum()<6))
-	{
-		fragset.insert(curfrag); //curfrag ignored if an identical fragment already present
-//		PrintFpt(curfrag,level);
-	}
-}
-
-///////////////////////////////////////////////////
-void fingerprint2::DoReverses()
-{
-	SetItr itr;
-	for(itr=fragset.begin();itr!=fragset.end();)
-	{
-		//Reverse the order of the atoms, add the smallest fragment and remove the larger
-		SetItr titr = itr++; //Ensure have valid next iterator in case current one is erased
-		vector<int> t1(*titr); //temporary copy
-		reverse(t1.begin()+1, t1.end()); //(leave 0 at front alone)
-		if(t1!=*titr)
+		//All bonds tried: do not save C,N,O single atom fragments
+		if(level>1 || patom->GetAtomicNum()>8  || patom->GetAtomicNum()<6)
 		{
-			//Add the larger fragment and delete the smaller
-			if(t1>*titr)
+			//Only the larger of the fragment and its reverse (leaving 0 at
+			//front alone) is retained
+			const int len = 2 * level;
+			int i = 1;
+			while(i < len && curfrag[i] == curfrag[len - i])
+				++i;
+			bool reversed = i < len && curfrag[len - i] > curfrag[i];
+			if(!(Flags() & FPT_NOINFO))
 			{
-				fragset.erase(titr);
-				fragset.insert(t1);
+				int frag[Max_Fragment_Length];
+				frag[0] = 0;
+				for(int j = 1; j < len; ++j)
+					frag[j] = reversed ? curfrag[len - j] : curfrag[j];
+				AddFragment(ws, frag, len, fp);
 			}
 			else
-				fragset.erase(t1);
+				SetBit(fp, reversed ? path.back().revhash : path.back().hash);
 		}
+		levels[patom->GetIdx()-1] = 0;
+		path.pop_back();
 	}
 }
+
 ///////////////////////////////////////////////////
-void fingerprint2::DoRings()
+void fingerprint2::AddFragment(Workspace& ws, const int* frag, int len, vector<unsigned int>& fp)
 {
-	//For each complete ring fragment, find its largest chemically identical representation
-	//by rotating and reversing, and insert into the main set of fragments
-	SetItr itr;
-	for(itr=ringset.begin();itr!=ringset.end();++itr)
+	//Use hash of fragment to set a bit in the fingerprint
+	SetBit(fp, CalcHash(frag, len));
+	if(!(Flags() & FPT_NOINFO))
+		ws.fragset.insert(vector<int>(frag, frag + len)); //ignored if an identical fragment already present
+}
+
+///////////////////////////////////////////////////
+void fingerprint2::AddRing(Workspace& ws, int len, vector<unsigned int>& fp)
+{
+	//For a complete ring fragment, find its largest chemically identical representation
+	//by rotating and reversing
+	int maxring[Max_Fragment_Length], t1[Max_Fragment_Length], t2[Max_Fragment_Length];
+	const int* curfrag = ws.curfrag;
+	std::copy(curfrag, curfrag + len, maxring);
+	for(int r = 2; r <= len; r += 2)
 	{
-		vector<int> t1(*itr); //temporary copy
-		vector<int> maxring(*itr); //the current largest vector
-		unsigned int i;
-		for(i=0;i<t1.size()/2;++i)
-		{
-			//rotate atoms in ring
-			rotate(t1.begin(),t1.begin()+2,t1.end());
-			if(t1>maxring)
-				maxring=t1;
-
-			//reverse the direction around ring
-			vector<int> t2(t1);
-			reverse(t2.begin()+1, t2.end());
-			if(t2>maxring)
-				maxring=t2;
-		}
-		fragset.insert(maxring);
-		//PrintFpt(maxring,0);
+		//rotate atoms in ring
+		for(int j = 0; j < len; ++j)
+			t1[j] = curfrag[(j + r) % len];
+		if(std::lexicographical_compare(maxring, maxring + len, t1, t1 + len))
+			std::copy(t1, t1 + len, maxring);
+
+		//reverse the direction around ring
+		t2[0] = t1[0];
+		std::reverse_copy(t1 + 1, t1 + len, t2 + 1);
+		if(std::lexicographical_compare(maxring, maxring + len, t2, t2 + len))
+			std::copy(t2, t2 + len, maxring);
 	}
+	AddFragment(ws, maxring, len, fp);
 }
 
 //////////////////////////////////////////////////////////
-unsigned int fingerprint2::CalcHash(const vector<int>& frag)
+unsigned int fingerprint2::CalcHash(const int* frag, int len)
 {
 	//Something like... whole of fragment treated as a binary number modulus 1021
 	const int MODINT = 108; //2^32 % 1021
 	unsigned int hash=0;
-	for(unsigned i=0;i<frag.size();++i)
+	for(int i=0;i<len;++i)
 		hash= (hash*MODINT + (frag[i] % 1021)) % 1021;
 	return hash;
 }
@@ -18,9 +18,13 @@ GNU General Public License for more details.
 #include <openbabel/bond.h>
 #include <openbabel/obiter.h>
 #include <openbabel/fingerprint.h>
-#include <openbabel/obiter.h>
 #include <openbabel/elements.h>
+#include <openbabel/propertyview.h>
+
+#include <openbabel/bitvec.h>
 
+#include <cstdlib>
+#include <map>
 #include <vector>
 #include <algorithm>
 
@@ -43,12 +47,29 @@ public:
 	  // to determine the default size
 	  return "Extended-Connectivity Fingerprints (ECFPs)\n"
                  "4096 bits.\n"
-                 "Circular topological fingerprints of specified radius\n";
+                 "Circular topological fingerprints of specified radius\n"
+                 "fingerprintECFP is definable";
 	}
 
+  /// Instances of any radius can be made in plugindefines.txt, e.g.
+  /// \code
+  /// fingerprintECFP
+  /// ECFP12      # ID
+  /// 6           # radius (number of passes)
+  /// nodups      # optional: remove features with duplicate environments
+  /// \endcode
+  virtual fingerprintECFP* MakeInstance(const std::vector<std::string>& textlines)
+  {
+    unsigned int radius = textlines.size() > 2 ? atoi(textlines[2].c_str()) : 2;
+    bool keepdups = !(textlines.size() > 3 && textlines[3] == "nodups");
+    return new fingerprintECFP(textlines[1].c_str(), false, radius, keepdups);
+  }
+
 	//Calculates the fingerprint
 	virtual bool GetFingerprint(OBBase* pOb, vector<unsigned int>&fp, int nbits=0);
 
+  virtual bool GetFeatureCounts(OBBase* pOb, std::map<unsigned int, unsigned int>& counts);
+
   /// \returns fragment info unless SetFlags(OBFingerprint::FPT_NOINFO) has been called before GetFingerprint() called.
   virtual std::string DescribeBits(const std::  vector<unsigned int> fp, bool bSet=true)
   { return _ss.str(); }
@@ -56,8 +77,12 @@ public:
   virtual unsigned int Flags() { return _flags;};
   virtual void SetFlags(unsigned int f){ _flags=f; }
 
+  /// No state is kept between calls
+  virtual bool IsThreadSafe() { return true; }
+
 private:
-  std::vector<unsigned int> v;
+  /// The identifiers of all passes, for every heavy atom
+  void GetIdentifiers(OBMol& mol, std::vector<unsigned int>& ids);
 
   stringstream _ss;
   unsigned int _radius;
@@ -154,9 +179,13 @@ static unsigned int ECFPHash(std::vector<unsigned int> &v)
 }
 
 
-struct AtomInfo {
-  unsigned int e[5]; // hashcodes for ecfp0, 2, 4... This will segfault at ECFP12
-  std::vector<unsigned int> b[4]; // for duplicate removal as described in paper?
+/// Heavy-atom neighbour lists in compressed form: the neighbours of
+/// atom i are nbr[start[i]] .. nbr[start[i+1]-1]
+struct NborArrays {
+  std::vector<unsigned int> start;
+  std::vector<unsigned int> nbr;
+  std::vector<unsigned int> order;
+  std::vector<unsigned int> bond;
 };
 
 struct NborInfo {
@@ -172,19 +201,48 @@ struct NborInfo {
   }
 };
 
-static void ECFPPass(OpenBabel::OBMol &mol,
-                     AtomInfo *ainfo, unsigned int pass)
+static unsigned int ECFPInitialHash(const OBMolPropertyView &view, unsigned int i)
+{
+  unsigned char buffer[8];
+  buffer[0] = view.GetHeavyDegrees()[i]; // degree of heavy atom connections
+  buffer[1] = view.GetValences()[i] - view.GetExplicitHCounts()[i]; // valence of heavy atom connections
+  buffer[2] = view.GetAtomicNums()[i];
+  buffer[3] = (unsigned char)view.GetIsotopes()[i];
+  buffer[4] = (unsigned char)view.GetFormalCharges()[i];
+  buffer[5] = (unsigned char)(view.GetExplicitHCounts()[i] + view.GetImplicitHCounts()[i]);
+  buffer[6] = view.IsInRing(i) ? 1 : 0;
+  buffer[7] = 0;  // view.IsAromatic(i) ? 1 : 0;
+  return ECFPHash(buffer,8);
+}
+
+/// Hash of the bonds (set bits) in an environment
+static unsigned int EnvironmentHash(const OBBitVec &env)
 {
+  std::vector<unsigned int> bits;
+  for (int i = env.FirstBit(); i != env.EndBit(); i = env.NextBit(i))
+    bits.push_back(i);
+  return ECFPHash(bits);
+}
+
+void fingerprintECFP::GetIdentifiers(OBMol &mol, std::vector<unsigned int> &ids)
+{
+  // Compact numbering of the heavy atoms and their neighbour arrays
+  std::vector<OBAtom*> atoms;
+  std::vector<int> pos(mol.NumAtoms() + 1, -1);
   FOR_ATOMS_OF_MOL(atom, mol) {
     if (atom->GetAtomicNum() == OBElements::Hydrogen)
       continue;
-    OpenBabel::OBAtom* aptr = &(*atom);
-    unsigned int idx = aptr->GetIdx();
-    AtomInfo *ptr = &ainfo[idx];
-
-    std::vector<NborInfo> nbrs;
-    FOR_BONDS_OF_ATOM(bptr, aptr) {
-      OpenBabel::OBAtom* nptr = bptr->GetNbrAtom(aptr);
+    pos[atom->GetIdx()] = atoms.size();
+    atoms.push_back(&*atom);
+  }
+  const unsigned int n = atoms.size();
+
+  NborArrays nb;
+  nb.start.reserve(n + 1);
+  for (unsigned int i = 0; i < n; ++i) {
+    nb.start.push_back(nb.nbr.size());
+    FOR_BONDS_OF_ATOM(bptr, atoms[i]) {
+      OBAtom* nptr = bptr->GetNbrAtom(atoms[i]);
       if (nptr->GetAtomicNum() == OBElements::Hydrogen)
         continue;
       unsigned int order;
@@ -195,48 +253,90 @@ static void ECFPPass(OpenBabel::OBMol &mol,
         default: order = 1;
         }
       } else order = 4;
-
-      unsigned int nidx = nptr->GetIdx();
-
-      nbrs.push_back(NborInfo(order,ainfo[nidx].e[pass-1]));
-      // for duplicate removal as described in paper (?)
-      if (pass == 1)
-        ptr->b[pass-1].push_back(bptr->GetIdx());
+      nb.nbr.push_back(pos[nptr->GetIdx()]);
+      nb.order.push_back(order);
+      nb.bond.push_back(bptr->GetIdx());
     }
-    std::sort(nbrs.begin(),nbrs.end());
-
-    std::vector<unsigned int> vint;
-    vint.push_back(pass);
-    vint.push_back(ptr->e[pass-1]);
-    std::vector<NborInfo>::const_iterator ni;
-    for (ni=nbrs.begin(); ni!=nbrs.end(); ++ni) {
-      vint.push_back(ni->order);
-      vint.push_back(ni->idx);
+  }
+  nb.start.push_back(nb.nbr.size());
+
+  /* First Pass: ECFP_0 */
+  OBMolPropertyView view(mol);
+  std::vector<unsigned int> cur(n), next(n);
+  for (unsigned int i = 0; i < n; ++i)
+    cur[i] = ECFPInitialHash(view, atoms[i]->GetIdx() - 1);
+  ids.assign(cur.begin(), cur.end());
+
+  // For duplicate removal: the bonds covered by each atom's current
+  // environment, and those already seen, bucketed by hash. The pass 0
+  // environment of an atom is the atom alone, marked by a bit after those
+  // of the bonds. Larger environments keep that bit, which does not change
+  // whether two of them are equal as their bonds determine their atoms.
+  std::vector<OBBitVec> env, nextenv;
+  std::multimap<unsigned int, OBBitVec> seen;
+  if (!_keepdups) {
+    env.resize(n);
+    for (unsigned int i = 0; i < n; ++i) {
+      env[i].SetBitOn(mol.NumBonds() + i);
+      seen.insert(std::make_pair(EnvironmentHash(env[i]), env[i]));
     }
-    ptr->e[pass] = ECFPHash(vint);
   }
-}
 
-static void ECFPFirstPass(OpenBabel::OBMol &mol,
-                          AtomInfo *ainfo)
-{
-  unsigned char buffer[8];
+  std::vector<NborInfo> nbrs;
+  std::vector<unsigned int> vint;
+  for (unsigned int pass = 1; pass <= _radius; ++pass) {
+    for (unsigned int i = 0; i < n; ++i) {
+      nbrs.clear();
+      for (unsigned int k = nb.start[i]; k < nb.start[i+1]; ++k)
+        nbrs.push_back(NborInfo(nb.order[k], cur[nb.nbr[k]]));
+      std::sort(nbrs.begin(), nbrs.end());
+
+      vint.clear();
+      vint.push_back(pass);
+      vint.push_back(cur[i]);
+      std::vector<NborInfo>::const_iterator ni;
+      for (ni=nbrs.begin(); ni!=nbrs.end(); ++ni) {
+        vint.push_back(ni->order);
+        vint.push_back(ni->idx);
+      }
+      next[i] = ECFPHash(vint);
+    }
+    cur.swap(next);
 
-  /* First Pass: ECFP_0 */
-  FOR_ATOMS_OF_MOL(atom, mol) {
-    if (atom->GetAtomicNum() == OBElements::Hydrogen)
+    if (_keepdups) {
+      ids.insert(ids.end(), cur.begin(), cur.end());
       continue;
-    OpenBabel::OBAtom* aptr = &(*atom);
-    unsigned int idx = aptr->GetIdx();
-    buffer[0] = aptr->GetHvyDegree(); // degree of heavy atom connections
-    buffer[1] = aptr->GetExplicitValence() - aptr->ExplicitHydrogenCount(); // valence of heavy atom connections
-    buffer[2] = aptr->GetAtomicNum();
-    buffer[3] = (unsigned char)aptr->GetIsotope();
-    buffer[4] = (unsigned char)aptr->GetFormalCharge();
-    buffer[5] = (unsigned char)(aptr->ExplicitHydrogenCount() + aptr->GetImplicitHCount());
-    buffer[6] = aptr->IsInRing() ? 1 : 0;
-    buffer[7] = 0;  // aptr->IsAromatic() ? 1 : 0;
-    ainfo[idx].e[0] = ECFPHash(buffer,8);
+    }
+
+    // Drop features whose environment was already covered by an earlier
+    // feature; within a pass the smaller identifier is kept
+    nextenv = env;
+    for (unsigned int i = 0; i < n; ++i)
+      for (unsigned int k = nb.start[i]; k < nb.start[i+1]; ++k) {
+        nextenv[i] |= env[nb.nbr[k]];
+        nextenv[i].SetBitOn(nb.bond[k]);
+      }
+    env.swap(nextenv);
+
+    std::vector<std::pair<unsigned int, unsigned int> > order(n);
+    for (unsigned int i = 0; i < n; ++i)
+      order[i] = std::make_pair(cur[i], i);
+    std::sort(order.begin(), order.end());
+    for (unsigned int j = 0; j < n; ++j) {
+      const OBBitVec &e = env[order[j].second];
+      unsigned int h = EnvironmentHash(e);
+      bool duplicate = false;
+      std::multimap<unsigned int, OBBitVec>::const_iterator it, end;
+      for (it = seen.lower_bound(h), end = seen.upper_bound(h); it != end; ++it)
+        if (it->second == e) {
+          duplicate = true;
+          break;
+        }
+      if (duplicate)
+        continue;
+      seen.insert(std::make_pair(h, e));
+      ids.push_back(order[j].first);
+    }
   }
 }
 
@@ -251,34 +351,29 @@ bool fingerprintECFP::GetFingerprint(OBBase* pOb, vector<unsigned int>&fp, int n
 
   fp.resize(0); // clear without deallocating memory
   fp.resize(nbits/Getbitsperint());
-	
-  _ss.str("");
-
-  unsigned int pass;
-
-  unsigned int count = pmol->NumAtoms();
-  if (count == 0) return true;
-
-  // Access this using the Atom::Idx()
-  AtomInfo *ainfo = new AtomInfo[count+1];
-
-  ECFPFirstPass(*pmol,ainfo);
-  for (pass=1; pass<= _radius; pass++)
-    ECFPPass(*pmol,ainfo,pass);
 
-  // Duplicate removal - this is a simplified version of what's in the paper
-  FOR_ATOMS_OF_MOL(atom, pmol) {
-    if (atom->GetAtomicNum() == OBElements::Hydrogen)
-      continue;    
-    unsigned int idx = atom->GetIdx();
-    for (pass=0; pass <= _radius; pass++) {
-      unsigned int bit = (ainfo[idx].e[pass] % nbits) & 0x7fffffff; 
-      SetBit(fp, bit);
-    }
+  std::vector<unsigned int> ids;
+  GetIdentifiers(*pmol, ids);
+  std::vector<unsigned int>::const_iterator it;
+  for (it = ids.begin(); it != ids.end(); ++it) {
+    unsigned int bit = (*it % nbits) & 0x7fffffff; 
+    SetBit(fp, bit);
   }
 
-  delete[] ainfo;
+  return true;
+}
 
+bool fingerprintECFP::GetFeatureCounts(OBBase* pOb, std::map<unsigned int, unsigned int>& counts)
+{
+  OBMol* pmol = dynamic_cast<OBMol*>(pOb);
+  if(!pmol) return false;
+
+  counts.clear();
+  std::vector<unsigned int> ids;
+  GetIdentifiers(*pmol, ids);
+  std::vector<unsigned int>::const_iterator it;
+  for (it = ids.begin(); it != ids.end(); ++it)
+    ++counts[*it];
   return true;
 }
 
@@ -36,6 +36,10 @@ GNU General Public License for more details.
 #include <openbabel/elements.h>
 #include "rand.h"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 using namespace std;
 
 namespace OpenBabel
@@ -1357,6 +1361,28 @@ namespace OpenBabel
     for (int i=0; i<vrotors.size(); ++i)
       reordered_rotors[i] = i;
 
+#ifdef _OPENMP
+    // The positions of each rotor are scored in parallel, each thread using
+    // its own copy of the force field and coordinates.
+    std::vector<OBForceField*> threadFF;
+    std::vector<OBRotamerList*> threadRotamers;
+    int numThreads = omp_get_max_threads();
+    if (numThreads > 1) {
+      for (int t = 0; t < numThreads; ++t) {
+        OBForceField *ff = MakeSetupCopy();
+        if (!ff)
+          break;
+        threadFF.push_back(ff);
+        OBRotamerList *r = new OBRotamerList;
+        r->SetBaseCoordinateSets(ff->_mol);
+        r->Setup(ff->_mol, rl);
+        threadRotamers.push_back(r);
+      }
+    }
+    std::vector<double> positionEnergies;
+#endif
+
+    OBBitVec moved, crossPairs, restPairs;
     std::set<unsigned int> seen;
     best_minE = DBL_MAX;
     for (int N=0; N<num_permutations; ++N) {
@@ -1373,6 +1399,48 @@ namespace OpenBabel
 
         minE = DBL_MAX;
 
+        // A move of this rotor only changes the non-bonded pairs between the
+        // atoms it rotates and the rest of the molecule (and its torsions),
+        // the energy of the other pairs is evaluated once.
+        const std::vector<int> &rotatoms = static_cast<const OBRotor*>(rotor)->GetRotAtoms();
+        moved.Clear();
+        moved.Resize(_mol.NumAtoms() + 1);
+        for (std::vector<int>::const_iterator a = rotatoms.begin(); a != rotatoms.end(); ++a)
+          moved.SetBitOn(*a / 3 + 1); // coordinate index to atom index
+        GetMovedPairs(moved, crossPairs, restPairs);
+        _mol.SetCoordinates(bestconf);
+        SetupPointers();
+        double restE = E_NonBonded(restPairs);
+
+#ifdef _OPENMP
+        if (threadFF.size() > 1) {
+          int numPositions = rotor->GetResolution().size();
+          positionEnergies.resize(numPositions);
+          #pragma omp parallel for num_threads(threadFF.size())
+          for (int p = 0; p < numPositions; ++p) {
+            int t = omp_get_thread_num();
+            OBForceField *ff = threadFF[t];
+            std::vector<int> key(rotorKey);
+            key[idx + 1] = p;
+            ff->_mol.SetCoordinates(bestconf);
+            threadRotamers[t]->SetCurrentCoordinates(ff->_mol, key);
+            ff->SetupPointers();
+            positionEnergies[p] = restE + ff->E_NonBonded(crossPairs) + ff->E_Torsion(false);
+          }
+
+          for (j = 0; j < rotor->GetResolution().size(); j++) {
+            if (positionEnergies[j] < minE) {
+              minE = positionEnergies[j];
+              minj = j;
+            }
+          }
+          // regenerate the best position
+          _mol.SetCoordinates(bestconf);
+          rotorKey[idx + 1] = minj;
+          rotamerlist.SetCurrentCoordinates(_mol, rotorKey);
+          memcpy((char*)minconf,(char*)_mol.GetCoordinates(),sizeof(double)*3*_mol.NumAtoms());
+        } else
+#endif
         for (j = 0; j < rotor->GetResolution().size(); j++) { // For each rotor position
           // Note: we could do slightly better by skipping the rotor position we already
           //       tested in the last loop (position 0 at the moment). Note that this
@@ -1382,7 +1450,7 @@ namespace OpenBabel
           rotamerlist.SetCurrentCoordinates(_mol, rotorKey);
           SetupPointers();
 
-          currentE = E_VDW(false) + E_Torsion(false) + E_Electrostatic(false);
+          currentE = restE + E_NonBonded(crossPairs) + E_Torsion(false);
 
           if (currentE < minE) {
             minE = currentE;
@@ -1415,6 +1483,13 @@ namespace OpenBabel
 
     } // end of final permutation
 
+#ifdef _OPENMP
+    for (unsigned int t = 0; t < threadFF.size(); ++t) {
+      delete threadFF[t];
+      delete threadRotamers[t];
+    }
+#endif
+
     _mol.SetCoordinates(verybestconf);
     SetupPointers();
 
@@ -1596,6 +1671,25 @@ namespace OpenBabel
   }
 
 
+  OBForceField* OBForceField::MakeSetupCopy()
+  {
+    if (!_validSetup || _constraints.Size())
+      return NULL;
+
+    OBForceField *ff = MakeNewInstance();
+    ff->SetLogLevel(OBFF_LOGLVL_NONE);
+    ff->EnableCutOff(_cutoff);
+    ff->SetVDWCutOff(_rvdw);
+    ff->SetElectrostaticCutOff(_rele);
+    ff->SetDielectricConstant(_epsilon);
+    ff->SetUpdateFrequency(_pairfreq);
+    if (!ff->Setup(_mol)) {
+      delete ff;
+      return NULL;
+    }
+    return ff;
+  }
+
   void OBForceField::WeightedRotorSearch(unsigned int conformers, unsigned int geomSteps,
                                          bool sampleRingBonds)
   {
@@ -1681,6 +1775,61 @@ namespace OpenBabel
       rotorKey[i] = -1; // no rotation (new in 2.2)
     }
 
+#ifdef _OPENMP
+    // Each rotor position is minimized in isolation, so all positions can be
+    // evaluated in parallel, each thread using its own copy of the force field
+    // and coordinates.
+    std::vector<std::vector<double> > positionEnergies;
+    std::vector<OBForceField*> threadFF;
+    int numThreads = omp_get_max_threads();
+    if (numThreads > 1) {
+      for (int t = 0; t < numThreads; ++t) {
+        OBForceField *ff = MakeSetupCopy();
+        if (!ff)
+          break;
+        threadFF.push_back(ff);
+      }
+    }
+    if (threadFF.size() > 1) {
+      std::vector<std::pair<unsigned int, unsigned int> > positions; // rotor, position
+      positionEnergies.resize(rl.Size() + 1);
+      rotor = rl.BeginRotor(ri);
+      for (unsigned int i = 1; i < rl.Size() + 1; ++i, rotor = rl.NextRotor(ri)) {
+        positionEnergies[i].resize(rotor->GetResolution().size());
+        for (unsigned int j = 0; j < rotor->GetResolution().size(); j++)
+          positions.push_back(std::make_pair(i, j));
+      }
+
+      std::vector<double> startCoord(initialCoord, initialCoord + 3 * _mol.NumAtoms());
+      std::vector<OBRotamerList*> threadRotamers;
+      for (unsigned int t = 0; t < threadFF.size(); ++t) {
+        OBRotamerList *r = new OBRotamerList;
+        r->SetBaseCoordinateSets(threadFF[t]->_mol);
+        r->Setup(threadFF[t]->_mol, rl);
+        threadRotamers.push_back(r);
+      }
+
+      int numPositions = positions.size();
+      #pragma omp parallel for schedule(dynamic) num_threads(threadFF.size())
+      for (int p = 0; p < numPositions; ++p) {
+        int t = omp_get_thread_num();
+        OBForceField *ff = threadFF[t];
+        std::vector<int> key(rl.Size() + 1, -1);
+        key[positions[p].first] = positions[p].second;
+        ff->_mol.SetCoordinates(&startCoord[0]);
+        threadRotamers[t]->SetCurrentCoordinates(ff->_mol, key);
+        ff->SetupPointers();
+        ff->ConjugateGradients(geomSteps);
+        positionEnergies[positions[p].first][positions[p].second] = ff->Energy(false);
+      }
+
+      for (unsigned int t = 0; t < threadRotamers.size(); ++t)
+        delete threadRotamers[t];
+    }
+    for (unsigned int t = 0; t < threadFF.size(); ++t)
+      delete threadFF[t];
+#endif
+
     rotor = rl.BeginRotor(ri);
 
     for (unsigned int i = 1; i < rl.Size() + 1; ++i, rotor = rl.NextRotor(ri)) {
@@ -1688,15 +1837,22 @@ namespace OpenBabel
       energies.clear();
       for (unsigned int j = 0; j < rotor->GetResolution().size(); j++) {
         // foreach rotor position
-        _mol.SetCoordinates(initialCoord);
-        rotorKey[i] = j;
-        rotamers.SetCurrentCoordinates(_mol, rotorKey);
-        SetupPointers(); // update pointers to atom positions in the OBFFCalculation objects
-
-        _loglvl = OBFF_LOGLVL_NONE;
-        ConjugateGradients(geomSteps); // energy minimization for conformer
-        _loglvl = origLogLevel;
-        currentE = Energy(false);
+#ifdef _OPENMP
+        if (!positionEnergies.empty())
+          currentE = positionEnergies[i][j];
+        else
+#endif
+        {
+          _mol.SetCoordinates(initialCoord);
+          rotorKey[i] = j;
+          rotamers.SetCurrentCoordinates(_mol, rotorKey);
+          SetupPointers(); // update pointers to atom positions in the OBFFCalculation objects
+
+          _loglvl = OBFF_LOGLVL_NONE;
+          ConjugateGradients(geomSteps); // energy minimization for conformer
+          _loglvl = origLogLevel;
+          currentE = Energy(false);
+        }
 
         if (j == 0)
           bestE = worstE = currentE;
@@ -2158,6 +2314,47 @@ namespace OpenBabel
   //
   //////////////////////////////////////////////////////////////////////////////////
 
+  double OBForceField::E_NonBonded(const OBBitVec &pairs)
+  {
+    // Evaluate only the selected pairs by restricting the cut-off pair masks
+    bool store_cutoff = _cutoff;
+    OBBitVec store_vdwpairs = _vdwpairs, store_elepairs = _elepairs;
+    if (_cutoff) {
+      _vdwpairs &= pairs;
+      _elepairs &= pairs;
+    } else {
+      _vdwpairs = pairs;
+      _elepairs = pairs;
+      _cutoff = true;
+    }
+
+    double energy = E_VDW(false) + E_Electrostatic(false);
+
+    _cutoff = store_cutoff;
+    _vdwpairs = store_vdwpairs;
+    _elepairs = store_elepairs;
+    return energy;
+  }
+
+  void OBForceField::GetMovedPairs(const OBBitVec &moved, OBBitVec &cross, OBBitVec &rest)
+  {
+    const unsigned int numAtoms = _mol.NumAtoms();
+    const unsigned int numPairs = numAtoms * (numAtoms - 1) / 2;
+    cross.Clear();
+    cross.Resize(numPairs);
+    rest.Clear();
+    rest.Resize(numPairs);
+
+    unsigned int pairIndex = 0;
+    FOR_PAIRS_OF_MOL(p, _mol) {
+      if (moved.BitIsSet((*p)[0]) != moved.BitIsSet((*p)[1]))
+        cross.SetBitOn(pairIndex);
+      else
+        rest.SetBitOn(pairIndex);
+      ++pairIndex;
+    }
+  }
+
   void OBForceField::UpdatePairsSimple()
   {
     _vdwpairs.Clear();
@@ -390,11 +390,10 @@ namespace OpenBabel
       //          XX   XX     -000.000  -000.000  -000.000  -000.000
     }
 
-    unsigned int j = 0;
-    for (i = _vdwcalculations.begin(); i != _vdwcalculations.end(); ++i, ++j) {
+    for (i = _vdwcalculations.begin(); i != _vdwcalculations.end(); ++i) {
       // Cut-off check
       if (_cutoff)
-        if (!_vdwpairs.BitIsSet(j))
+        if (!_vdwpairs.BitIsSet(i->pairIndex))
           continue;
 
       i->template Compute<gradients>();
@@ -458,11 +457,10 @@ namespace OpenBabel
       //            XX   XX     -000.000  -000.000  -000.000
     }
 
-    unsigned int j = 0;
-    for (i = _electrostaticcalculations.begin(); i != _electrostaticcalculations.end(); ++i, ++j) {
+    for (i = _electrostaticcalculations.begin(); i != _electrostaticcalculations.end(); ++i) {
       // Cut-off check
       if (_cutoff)
-        if (!_elepairs.BitIsSet(j))
+        if (!_elepairs.BitIsSet(i->pairIndex))
           continue;
 
       i->template Compute<gradients>();
@@ -911,7 +909,9 @@ namespace OpenBabel
 
     _vdwcalculations.clear();
 
+    int pairIndex = -1;
     FOR_PAIRS_OF_MOL(p, _mol) {
+      ++pairIndex;
       a = _mol.GetAtom((*p)[0]);
       b = _mol.GetAtom((*p)[1]);
 
@@ -998,6 +998,7 @@ namespace OpenBabel
       */
 
       vdwcalc.RVDWab = (Ra + Rb);
+      vdwcalc.pairIndex = pairIndex;
       vdwcalc.SetupPointers();
 
       _vdwcalculations.push_back(vdwcalc);
@@ -1013,7 +1014,9 @@ namespace OpenBabel
 
     _electrostaticcalculations.clear();
 
+    pairIndex = -1;
     FOR_PAIRS_OF_MOL(p, _mol) {
+      ++pairIndex;
       a = _mol.GetAtom((*p)[0]);
       b = _mol.GetAtom((*p)[1]);
 
@@ -1050,6 +1053,7 @@ namespace OpenBabel
         if (a->IsOneFour(b))
           elecalc.qq *= 0.5;
 
+        elecalc.pairIndex = pairIndex;
         elecalc.SetupPointers();
         _electrostaticcalculations.push_back(elecalc);
       }
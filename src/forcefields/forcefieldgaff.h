@@ -65,6 +65,7 @@ namespace OpenBabel
     public:
       bool is14, samering;
       double Eab, RVDWab, rab;
+      int pairIndex; // index into iteration using FOR_PAIRS_OF_MOL(..., _mol)
 
       template<bool> void Compute();
   };
@@ -73,6 +74,7 @@ namespace OpenBabel
   {
     public:
       double qq, rab;
+      int pairIndex; // index into iteration using FOR_PAIRS_OF_MOL(..., _mol)
 
       template<bool> void Compute();
   };
@@ -293,11 +293,10 @@ namespace OpenBabel
       //          XX   XX     -000.000  -000.000  -000.000  -000.000
     }
 
-    unsigned int j = 0;
-    for (i = _vdwcalculations.begin(); i != _vdwcalculations.end(); ++i, ++j) {
+    for (i = _vdwcalculations.begin(); i != _vdwcalculations.end(); ++i) {
       // Cut-off check
       if (_cutoff)
-        if (!_vdwpairs.BitIsSet(j))
+        if (!_vdwpairs.BitIsSet(i->pairIndex))
           continue;
 
       i->template Compute<gradients>();
@@ -361,11 +360,10 @@ namespace OpenBabel
       //            XX   XX     -000.000  -000.000  -000.000
     }
 
-    unsigned int j = 0;
-    for (i = _electrostaticcalculations.begin(); i != _electrostaticcalculations.end(); ++i, ++j) {
+    for (i = _electrostaticcalculations.begin(); i != _electrostaticcalculations.end(); ++i) {
       // Cut-off check
       if (_cutoff)
-        if (!_elepairs.BitIsSet(j))
+        if (!_elepairs.BitIsSet(i->pairIndex))
           continue;
 
       i->template Compute<gradients>();
@@ -685,7 +683,9 @@ namespace OpenBabel
 
     _vdwcalculations.clear();
 
+    int pairIndex = -1;
     FOR_PAIRS_OF_MOL(p, _mol) {
+      ++pairIndex;
       a = _mol.GetAtom((*p)[0]);
       b = _mol.GetAtom((*p)[1]);
 
@@ -773,6 +773,7 @@ namespace OpenBabel
 
       vdwcalc.sigma12 = (vdwcalc.Ra + vdwcalc.Rb) * pow(1.0 * vdwcalc.kab , 1.0 / 12.0);
       vdwcalc.sigma6 = (vdwcalc.Ra + vdwcalc.Rb) * pow(2.0 * vdwcalc.kab , 1.0 / 6.0);
+      vdwcalc.pairIndex = pairIndex;
       vdwcalc.SetupPointers();
 
       _vdwcalculations.push_back(vdwcalc);
@@ -788,7 +789,9 @@ namespace OpenBabel
 
     _electrostaticcalculations.clear();
 
+    pairIndex = -1;
     FOR_PAIRS_OF_MOL(p, _mol) {
+      ++pairIndex;
       a = _mol.GetAtom((*p)[0]);
       b = _mol.GetAtom((*p)[1]);
 
@@ -825,6 +828,7 @@ namespace OpenBabel
         if (a->IsOneFour(b))
           elecalc.qq *= 0.5;
 
+        elecalc.pairIndex = pairIndex;
         elecalc.SetupPointers();
         _electrostaticcalculations.push_back(elecalc);
       }
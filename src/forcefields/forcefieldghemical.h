@@ -64,6 +64,7 @@ namespace OpenBabel
       union {
         double kb, sigma6;
       };
+      int pairIndex; // index into iteration using FOR_PAIRS_OF_MOL(..., _mol)
 
       template<bool> void Compute();
   };
@@ -72,6 +73,7 @@ namespace OpenBabel
   {
     public:
       double qq, rab;
+      int pairIndex; // index into iteration using FOR_PAIRS_OF_MOL(..., _mol)
 
       template<bool> void Compute();
   };
@@ -468,11 +468,10 @@ namespace OpenBabel {
       //          XX   XX     -000.000  -000.000  -000.000  -000.000
     }
 
-    unsigned int j = 0;
-    for (i = _vdwcalculations.begin(); i != _vdwcalculations.end(); ++i, ++j) {
+    for (i = _vdwcalculations.begin(); i != _vdwcalculations.end(); ++i) {
       // Cut-off check
-      if (_cutoff)
-        if (!_vdwpairs.BitIsSet(j))
+      if (_cutoff && i->pairIndex >= 0)
+        if (!_vdwpairs.BitIsSet(i->pairIndex))
           continue;
 
       i->template Compute<gradients>();
@@ -545,11 +544,10 @@ namespace OpenBabel {
       //            XX   XX     -000.000  -000.000  -000.000
     }
 
-    unsigned int j = 0;
-    for (i = _electrostaticcalculations.begin(); i != _electrostaticcalculations.end(); ++i, ++j) {
+    for (i = _electrostaticcalculations.begin(); i != _electrostaticcalculations.end(); ++i) {
       // Cut-off check
       if (_cutoff)
-        if (!_elepairs.BitIsSet(j))
+        if (!_elepairs.BitIsSet(i->pairIndex))
           continue;
 
       i->template Compute<gradients>();
@@ -1035,6 +1033,7 @@ namespace OpenBabel {
         // just resort to using VDW 1-3 interactions to push atoms into place
         // there's not much else we can do without real parameters
         if (SetupVDWCalculation(a, c, vdwcalc)) {
+          vdwcalc.pairIndex = -1; // 1-3, so not subject to the cut-off
           _vdwcalculations.push_back(vdwcalc);
         }
         // We're not installing an angle term for this set
@@ -1475,7 +1474,9 @@ namespace OpenBabel {
     IF_OBFF_LOGLVL_LOW
       OBFFLog("SETTING UP VAN DER WAALS CALCULATIONS...\n");
 
+    int pairIndex = -1;
     FOR_PAIRS_OF_MOL(p, _mol) {
+      ++pairIndex;
       a = _mol.GetAtom((*p)[0]);
       b = _mol.GetAtom((*p)[1]);
 
@@ -1510,6 +1511,7 @@ namespace OpenBabel {
       }
 
       if (SetupVDWCalculation(a, b, vdwcalc)) {
+        vdwcalc.pairIndex = pairIndex;
         _vdwcalculations.push_back(vdwcalc);
       }
     }
@@ -1539,7 +1541,9 @@ namespace OpenBabel {
     // it does not actually use it. Both Towhee and the UFF FAQ
     // discourage the use of electrostatics with UFF.
 
+    int pairIndex = -1;
     FOR_PAIRS_OF_MOL(p, _mol) {
+      ++pairIndex;
       a = _mol.GetAtom((*p)[0]);
       b = _mol.GetAtom((*p)[1]);
 
@@ -1581,6 +1585,7 @@ namespace OpenBabel {
         elecalc.a = &*a;
         elecalc.b = &*b;
 
+        elecalc.pairIndex = pairIndex;
         elecalc.SetupPointers();
         _electrostaticcalculations.push_back(elecalc);
       }
@@ -75,6 +75,7 @@ namespace OpenBabel
     public:
       bool is14, samering;
       double ka, kaSquared, Ra, kb, Rb, kab, rab;
+      int pairIndex; // index into iteration using FOR_PAIRS_OF_MOL(..., _mol), or -1
 
       template<bool> void Compute();
   };
@@ -83,6 +84,7 @@ namespace OpenBabel
   {
     public:
       double qq, rab;
+      int pairIndex; // index into iteration using FOR_PAIRS_OF_MOL(..., _mol)
 
       template<bool> void Compute();
   };
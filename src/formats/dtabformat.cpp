@@ -0,0 +1,334 @@
+/**********************************************************************
+dtabformat.cpp - Descriptor tables as binary columns or CSV
+
+This file is part of the Open Babel project.
+For more information, see <http://openbabel.org/>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+***********************************************************************/
+#include <openbabel/babelconfig.h>
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdio>
+
+#include <openbabel/obmolecformat.h>
+#include <openbabel/mol.h>
+#include <openbabel/descriptor.h>
+#include <openbabel/locale.h>
+#include <openbabel/obutil.h>
+
+using namespace std;
+namespace OpenBabel
+{
+
+  /// \brief Writes a table of descriptor values, one row per molecule
+  class DescTableFormat : public OBMoleculeFormat
+  {
+  public:
+    //Register this format type ID
+    DescTableFormat(const char* ID, bool csv) : _csv(csv)
+    {
+      OBConversion::RegisterFormat(ID, this);
+      OBConversion::RegisterOptionParam("d", this, 1, OBConversion::OUTOPTIONS);
+    }
+
+    virtual const char* Description() //required
+    {
+      if(_csv)
+        return
+    "Descriptor table as comma-separated values\n"
+    "One row of descriptor values per molecule, for spreadsheets etc.\n\n"
+
+    "The first line has the descriptor names. Strings are quoted where\n"
+    "needed and values which could not be calculated are left empty.\n"
+    "The descriptors are calculated as for the dtab format, which has the\n"
+    "details.\n\n"
+
+    "Write Options e.g. -xd \"title MW logP\"\n"
+    " d <list> Descriptors, as for --append; see ``obabel -L descriptors``\n\n";
+
+      return
+    "Binary descriptor table format\n"
+    "Typed columns of descriptor values, for machine learning\n\n"
+
+    "Writes the descriptors given by the -xd option for each molecule,\n"
+    "without making OBPairData strings, so that large libraries can be\n"
+    "turned into feature matrices quickly. The molecules are handled in\n"
+    "blocks of 1024, each evaluated in parallel when Open Babel is built\n"
+    "with OpenMP and the descriptors allow it. All the descriptors of a\n"
+    "molecule use the same perceived rings, aromaticity etc.\n\n"
+
+    "All numbers are little endian and every part starts on an 8 byte\n"
+    "boundary. The file has:\n\n"
+
+    "- a header: the magic string ``OBDTAB01`` (8 bytes) and the number of\n"
+    "  columns (unsigned 32-bit, then 4 zero bytes), and for each column\n"
+    "  its type, ``d`` for 64-bit floating point or ``s`` for UTF-8 strings\n"
+    "  (1 byte, then 3 zero bytes), the length of its name (unsigned\n"
+    "  32-bit) and the name, padded with zeros\n"
+    "- blocks of rows, each the number of rows (unsigned 32-bit, then 4\n"
+    "  zero bytes) followed by each column in turn. A ``d`` column is one\n"
+    "  double per row, NaN if it could not be calculated. An ``s`` column\n"
+    "  is rows+1 unsigned 32-bit offsets into the text that follows them,\n"
+    "  padded with zeros; row i is the text from offset i to offset i+1.\n\n"
+
+    "The type of a column is decided from the first block: it is ``s`` if\n"
+    "any of its molecules gives text, as title, formula, cansmi or InChI\n"
+    "do. In later blocks text in a ``d`` column is written as NaN.\n\n"
+
+    "Write Options e.g. -xd \"title MW logP\"\n"
+    " d <list> Descriptors, as for --append; see ``obabel -L descriptors``\n"
+    "          The default is \"title MW logP TPSA MR HBD HBA1 HBA2 rotors\"\n\n";
+    }
+
+    virtual unsigned int Flags()
+    { return _csv ? NOTREADABLE : NOTREADABLE | WRITEBINARY; }
+
+    virtual bool WriteChemObject(OBConversion* pConv);
+    virtual bool WriteMolecule(OBBase* pOb, OBConversion* pConv);
+
+  private:
+    bool Start(OBConversion* pConv);
+    bool WriteRows(const vector<OBBase*>& objects, OBConversion* pConv);
+    void WriteHeader(ostream& ofs);
+    void ClearPending();
+
+    bool _csv;
+    vector<pair<OBDescriptor*, string> > _descrs;
+    vector<string> _names;
+    vector<bool> _isString;
+    vector<OBBase*> _pending; //molecules waiting for a full block
+    vector<double> _values;
+    vector<string> _svalues;
+  };
+
+  ////////////////////////////////////////////////////
+  //Make instances of the format class
+  DescTableFormat theDescTableFormat("dtab", false);
+  DescTableFormat theDescCSVFormat("csv", true);
+
+  static const unsigned int RowsPerBlock = 1024;
+  static const char* DefaultDescriptors = "title MW logP TPSA MR HBD HBA1 HBA2 rotors";
+
+//*******************************************************************
+static void AppendLE32(string& s, unsigned int x)
+{
+  for(int i=0; i<4; ++i)
+    s.push_back(static_cast<char>((x >> (8*i)) & 0xff));
+}
+
+static void AppendDouble(string& s, double x)
+{
+  unsigned long long bits;
+  memcpy(&bits, &x, 8);
+  for(int i=0; i<8; ++i)
+    s.push_back(static_cast<char>((bits >> (8*i)) & 0xff));
+}
+
+static void PadTo8(string& s)
+{
+  s.append((8 - s.size() % 8) % 8, '\0');
+}
+
+static void AppendCSVString(string& s, const string& text)
+{
+  if(text.find_first_of(",\"\r\n") == string::npos)
+  {
+    s += text;
+    return;
+  }
+  s.push_back('"');
+  for(string::size_type i=0; i<text.size(); ++i)
+  {
+    if(text[i] == '"')
+      s.push_back('"');
+    s.push_back(text[i]);
+  }
+  s.push_back('"');
+}
+
+/////////////////////////////////////////////////////////////////////
+bool DescTableFormat::WriteChemObject(OBConversion* pConv)
+{
+  //Joined or deferred output is written a molecule at a time
+  if(pConv->IsOption("C",OBConversion::GENOPTIONS)
+      || pConv->IsOption("j",OBConversion::GENOPTIONS)
+      || pConv->IsOption("join",OBConversion::GENOPTIONS))
+    return WriteChemObjectImpl(pConv, this);
+
+  OBBase* pOb = pConv->GetChemObject();
+  if(pConv->GetOutputIndex()==1)
+  {
+    ClearPending();
+    if(!Start(pConv))
+    {
+      delete pOb;
+      return false;
+    }
+  }
+
+  if(!dynamic_cast<OBMol*>(pOb) || !DoOutputOptions(pOb, pConv))
+  {
+    delete pOb;
+    return false;
+  }
+
+  //The molecules are kept until a block is full, and evaluated together
+  _pending.push_back(pOb);
+  bool ret = true;
+  if(_pending.size() >= RowsPerBlock || pConv->IsLast())
+  {
+    ret = WriteRows(_pending, pConv);
+    ClearPending();
+  }
+  return ret;
+}
+
+/////////////////////////////////////////////////////////////////////
+bool DescTableFormat::WriteMolecule(OBBase* pOb, OBConversion* pConv)
+{
+  if(pConv->GetOutputIndex()<=1 && !Start(pConv))
+    return false;
+  return WriteRows(vector<OBBase*>(1, pOb), pConv);
+}
+
+/////////////////////////////////////////////////////////////////////
+bool DescTableFormat::Start(OBConversion* pConv)
+{
+  const char* p = pConv->IsOption("d");
+  string list(p ? p : DefaultDescriptors);
+  if(!OBDescriptor::FindDescriptors(list, _descrs) || _descrs.empty())
+  {
+    obErrorLog.ThrowError(__FUNCTION__,
+      "No descriptors to write, or some not recognized, in \"" + list + "\"", obError);
+    return false;
+  }
+
+  _names.clear();
+  for(unsigned int j=0; j<_descrs.size(); ++j)
+  {
+    string name(_descrs[j].first->GetID());
+    if(!_descrs[j].second.empty())
+      name += '(' + _descrs[j].second + ')';
+    _names.push_back(name);
+  }
+  _isString.clear(); //until the first block is evaluated
+
+  if(_csv)
+  {
+    string line;
+    for(unsigned int j=0; j<_names.size(); ++j)
+    {
+      if(j)
+        line.push_back(',');
+      AppendCSVString(line, _names[j]);
+    }
+    line.push_back('\n');
+    ostream& ofs = *pConv->GetOutStream();
+    ofs.write(line.data(), line.size());
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////
+void DescTableFormat::WriteHeader(ostream& ofs)
+{
+  string s("OBDTAB01", 8);
+  AppendLE32(s, _names.size());
+  AppendLE32(s, 0);
+  for(unsigned int j=0; j<_names.size(); ++j)
+  {
+    s.push_back(_isString[j] ? 's' : 'd');
+    s.append(3, '\0');
+    AppendLE32(s, _names[j].size());
+    s += _names[j];
+    PadTo8(s);
+  }
+  ofs.write(s.data(), s.size());
+}
+
+/////////////////////////////////////////////////////////////////////
+bool DescTableFormat::WriteRows(const vector<OBBase*>& objects, OBConversion* pConv)
+{
+  if(objects.empty())
+    return true;
+
+  ostream& ofs = *pConv->GetOutStream();
+  bool first = _isString.empty();
+  OBDescriptor::PredictValues(objects, _descrs, _isString, _values, _svalues);
+
+  const unsigned int nrows = objects.size();
+  const unsigned int ncols = _descrs.size();
+  string s;
+  if(_csv)
+  {
+    obLocale.SetLocale();
+    char buf[32];
+    for(unsigned int i=0; i<nrows; ++i)
+    {
+      for(unsigned int j=0; j<ncols; ++j)
+      {
+        if(j)
+          s.push_back(',');
+        if(_isString[j])
+          AppendCSVString(s, _svalues[i*ncols + j]);
+        else if(!IsNan(_values[i*ncols + j]))
+        {
+          snprintf(buf, sizeof(buf), "%.15g", _values[i*ncols + j]);
+          s += buf;
+        }
+      }
+      s.push_back('\n');
+    }
+    obLocale.RestoreLocale();
+  }
+  else
+  {
+    if(first)
+      WriteHeader(ofs);
+
+    //Column by column, so each can be read as one array
+    AppendLE32(s, nrows);
+    AppendLE32(s, 0);
+    for(unsigned int j=0; j<ncols; ++j)
+    {
+      if(_isString[j])
+      {
+        unsigned int offset = 0;
+        AppendLE32(s, offset);
+        for(unsigned int i=0; i<nrows; ++i)
+        {
+          offset += _svalues[i*ncols + j].size();
+          AppendLE32(s, offset);
+        }
+        for(unsigned int i=0; i<nrows; ++i)
+          s += _svalues[i*ncols + j];
+        PadTo8(s);
+      }
+      else
+        for(unsigned int i=0; i<nrows; ++i)
+          AppendDouble(s, _values[i*ncols + j]);
+    }
+  }
+  ofs.write(s.data(), s.size());
+  return ofs.good();
+}
+
+/////////////////////////////////////////////////////////////////////
+void DescTableFormat::ClearPending()
+{
+  for(unsigned int i=0; i<_pending.size(); ++i)
+    delete _pending[i];
+  _pending.clear();
+}
+
+}//namespace
@@ -12,6 +12,7 @@ GNU General Public License for more details.
 ***********************************************************************/
 #include <openbabel/babelconfig.h>
 
+#include <map>
 #include <vector>
 #include <string>
 #include <iomanip>
@@ -101,6 +102,7 @@ namespace OpenBabel
       "Write Options e.g. -xfFP3 -xN128\n"
       " f<id> fingerprint type\n"
       " N# fold to specified number of bits, 32, 64, 128, etc.\n"
+      " c  unfolded feature counts (identifier:count), where supported\n"
       " h  hex output when multiple molecules\n"
       " o  hex output only\n"
       " s  describe each set bit\n"
@@ -156,6 +158,23 @@ namespace OpenBabel
       obErrorLog.ThrowError(__FUNCTION__,
       "The number of bits to fold to, in the-xN option, should be >=0", obWarning);
 
+    if(pConv->IsOption("c"))
+    {
+      map<unsigned int, unsigned int> counts;
+      if(!pFP->GetFeatureCounts(pOb, counts))
+      {
+        obErrorLog.ThrowError(__FUNCTION__,
+        "Feature counts are not available for this fingerprint type", obError, onceOnly);
+        return false;
+      }
+      ofs << ">" << pOb->GetTitle() << '\n';
+      map<unsigned int, unsigned int>::const_iterator it;
+      for(it=counts.begin(); it!=counts.end(); ++it)
+        ofs << (it==counts.begin() ? "" : " ") << it->first << ':' << it->second;
+      ofs << endl;
+      return true;
+    }
+
     vector<unsigned int> fptvec;
     if(!pFP->GetFingerprint(pOb, fptvec, nbits))
       return false;
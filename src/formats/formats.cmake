@@ -104,12 +104,14 @@ set(formats_misc
       crkformat
       cssrformat
       dlpolyformat
+      dtabformat
       exyzformat      
       fastsearchformat
       fastaformat
       featformat
       fhformat
       fingerprintformat
+      fpmformat
       fpsformat
       freefracformat
       ghemicalformat
@@ -125,6 +127,7 @@ set(formats_misc
       mpqcformat
       msiformat
       msmsformat
+      obbinformat
       opendxformat
       outformat
       pcmodelformat
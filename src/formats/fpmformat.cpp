@@ -0,0 +1,209 @@
+/**********************************************************************
+fpmformat.cpp - Binary fingerprint matrix output
+
+This file is part of the Open Babel project.
+For more information, see <http://openbabel.org/>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+***********************************************************************/
+#include <openbabel/babelconfig.h>
+
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+
+#include <openbabel/obmolecformat.h>
+#include <openbabel/mol.h>
+#include <openbabel/fingerprint.h>
+
+using namespace std;
+namespace OpenBabel
+{
+
+  /// \brief Writes fingerprints as a binary matrix with one 64-bit aligned row per molecule
+  class FPMFormat : public OBMoleculeFormat
+  {
+  public:
+    //Register this format type ID
+    FPMFormat() {OBConversion::RegisterFormat("fpm",this);}
+
+    virtual const char* Description() //required
+    { return
+    "Binary fingerprint matrix format\n"
+    "Fingerprints as a dense, memory-mappable bit matrix\n\n"
+
+    "Each molecule is written as one row of the matrix, in input order, so\n"
+    "that the file can be mapped into memory and used directly (e.g. with\n"
+    "numpy) without parsing any text. The layout is:\n\n"
+
+    "- a 32 byte header: the magic string ``OBFPMAT1`` (8 bytes), the number\n"
+    "  of bits and the number of 64-bit words per row (unsigned 32-bit little\n"
+    "  endian integers each) and the fingerprint type, NUL-padded to 16 bytes\n"
+    "- the rows, each a whole number of 64-bit little endian words. Bit n of\n"
+    "  the fingerprint is bit n%64 of word n/64.\n\n"
+
+    "The number of rows is (file size - 32) / (8 * words per row). The bits\n"
+    "of the last word beyond the number of bits are zero. Folding halves the\n"
+    "fingerprint down to the smallest size of at least N bits; when N is not\n"
+    "a power of two, bit n of that is then set as bit n%N of the row.\n\n"
+
+    "The molecules are fingerprinted in batches, in parallel when Open Babel\n"
+    "is built with OpenMP and the fingerprint type allows it.\n\n"
+
+"A list of available fingerprint types can be obtained by::\n\n"
+
+"  obabel -L fingerprints\n\n"
+
+      "Write Options e.g. -xf FP3 -xN 128\n"
+      " f<id> Fingerprint type\n"
+      " N # Fold to specified number of bits, 32, 64, 128, etc.\n\n";
+    }
+
+    virtual unsigned int Flags(){return NOTREADABLE | WRITEBINARY;};
+    virtual bool WriteMolecule(OBBase* pOb, OBConversion* pConv);
+  private:
+    bool WriteRows(ostream& ofs);
+
+    unsigned int _nbits;
+    unsigned int _nwords;
+    OBFingerprint* _pFP;
+    std::vector<OBMol> _mols; //the molecules of the current batch
+  };
+
+  ////////////////////////////////////////////////////
+  //Make an instance of the format class
+  FPMFormat theFPMFormat;
+
+//*******************************************************************
+static void WriteLE32(ostream& ofs, unsigned int x)
+{
+  char buf[4];
+  for(int i=0; i<4; ++i)
+    buf[i] = static_cast<char>((x >> (8*i)) & 0xff);
+  ofs.write(buf, 4);
+}
+
+/////////////////////////////////////////////////////////////////////
+bool FPMFormat::WriteMolecule(OBBase* pOb, OBConversion* pConv)
+{
+  ostream &ofs = *pConv->GetOutStream();
+  OBMol* pmol = dynamic_cast<OBMol*>(pOb);
+  if(!pmol)
+    return false;
+
+  if(pConv->GetOutputIndex()==1)
+  {
+    _mols.clear();
+
+    string fpid;
+    const char* p=pConv->IsOption("f");
+    if(p)
+    {
+      fpid=p;
+      fpid = fpid.substr(0,fpid.find('"'));
+    }
+
+    _pFP = OBFingerprint::FindFingerprint(fpid.c_str());
+    if(!_pFP)
+    {
+      stringstream errorMsg;
+      errorMsg << "Fingerprint type '" << fpid << "' not available" << endl;
+      obErrorLog.ThrowError(__FUNCTION__, errorMsg.str(), obError);
+      return false;
+    }
+
+    int nbits = 0;
+    p=pConv->IsOption("N");
+    if(p)
+      nbits = atoi(p);
+    if(nbits<0)
+    {
+      obErrorLog.ThrowError(__FUNCTION__,
+      "The number of bits to fold to, in the-xN option, should be >=0", obWarning);
+      nbits = 0;
+    }
+
+    if(nbits==0) //if not folded, use the size of the first fingerprint
+    {
+      vector<unsigned int> fptvec;
+      if(!_pFP->GetFingerprint(pOb, fptvec, 0))
+        return false;
+      nbits = fptvec.size() * OBFingerprint::Getbitsperint();
+    }
+    if(nbits==0)
+    {
+      obErrorLog.ThrowError(__FUNCTION__, "The fingerprint is empty", obError);
+      return false;
+    }
+    _nbits = nbits;
+    _nwords = (_nbits + 63) / 64;
+
+    //Write the header
+    char header[8 + 16];
+    memset(header, 0, sizeof(header));
+    memcpy(header, "OBFPMAT1", 8);
+    strncpy(header + 8, _pFP->GetID(), 15);
+    ofs.write(header, 8);
+    WriteLE32(ofs, _nbits);
+    WriteLE32(ofs, _nwords);
+    ofs.write(header + 8, 16);
+  }
+
+  //The molecules are kept until the batch is full or the input ends
+  const unsigned int batchsize = 1024;
+  _mols.push_back(*pmol);
+  if(_mols.size() < batchsize && !pConv->IsLast())
+    return true;
+  return WriteRows(ofs);
+}
+
+/////////////////////////////////////////////////////////////////////
+bool FPMFormat::WriteRows(ostream& ofs)
+{
+  vector<OBBase*> objs;
+  for(unsigned int i=0; i<_mols.size(); ++i)
+    objs.push_back(&_mols[i]);
+  vector<vector<unsigned int> > fps;
+  bool ok = _pFP->GetFingerprints(objs, fps, _nbits);
+  _mols.clear();
+  if(!ok)
+    return false;
+
+  //Pack into 64-bit words; missing high words are zero. Folding only
+  //halves the size, so a fingerprint folded to a number of bits that is not
+  //a multiple of 64 can have bits beyond it: these are folded onto bit
+  //n % _nbits, as a fold to exactly that size would.
+  const unsigned int perint = OBFingerprint::Getbitsperint();
+  vector<unsigned char> row(8 * _nwords);
+  for(unsigned int m=0; m<fps.size(); ++m)
+  {
+    const vector<unsigned int>& fptvec = fps[m];
+    std::fill(row.begin(), row.end(), 0);
+    for(unsigned int i=0; i<fptvec.size(); ++i)
+    {
+      if(!fptvec[i])
+        continue;
+      for(unsigned int b=0; b<perint; ++b)
+        if(fptvec[i] & (1u << b))
+        {
+          unsigned int n = (i*perint + b) % _nbits;
+          row[n/8] |= static_cast<unsigned char>(1u << (n%8));
+        }
+    }
+    ofs.write(reinterpret_cast<const char*>(&row[0]), row.size());
+  }
+
+  return ofs.good();
+}
+
+}//namespace
@@ -39,6 +39,9 @@ GNU General Public License for more details.
 #include <openbabel/alias.h>
 #include <openbabel/tokenst.h>
 #include <openbabel/kekulize.h>
+#include <openbabel/descriptor.h>
+#include <openbabel/op.h>
+#include <openbabel/numformat.h>
 
 #include "mdlvalence.h"
 
@@ -84,7 +87,11 @@ namespace OpenBabel
                "       When filtering an sdf file on title or properties\n"
                "       only, avoid lengthy chemical interpretation by\n"
                "       using the ``T`` or ``P`` option together with the\n"
-               "       :ref:`copy format <Copy_raw_text>`.\n\n"
+               "       :ref:`copy format <Copy_raw_text>`.\n"
+               "       With the ``--filter`` option alone, an sdf record is\n"
+               "       first checked against its data fields when the filter\n"
+               "       only refers to these, and the chemical interpretation\n"
+               "       is skipped for records that fail.\n\n"
 
                "Write Options, e.g. -x3\n"
                " 3  output V3000 not V2000 (used for >999 atoms/bonds) \n"
@@ -120,9 +127,14 @@ namespace OpenBabel
 
       virtual int SkipObjects(int n, OBConversion* pConv)
       {
+        istream& ifs = *pConv->GetInStream();
+        if (n == 0 && recordBuffered) {
+          //The failed record has already been read in full
+          recordBuffered = false;
+          return ifs.good() ? 1 : -1;
+        }
         if (n == 0)
           n++;
-        istream& ifs = *pConv->GetInStream();
         do {
          ignore(ifs, "$$$$\n");
         } while(ifs && --n);
@@ -134,6 +146,9 @@ namespace OpenBabel
       virtual bool ReadMolecule(OBBase* pOb, OBConversion* pConv);
       virtual bool WriteMolecule(OBBase* pOb, OBConversion* pConv);
 
+    protected:
+      MDLFormat() : recordBuffered(false) {}
+
       ////////////////////////////////////////////////////
       //V3000 routines
     private:
@@ -145,6 +160,8 @@ namespace OpenBabel
       bool ReadUnimplementedBlock(istream& ifs,OBMol& mol, OBConversion* pConv, string& blockname);
       bool WriteV3000(ostream& ofs,OBMol& mol, OBConversion* pConv);
       bool ReadPropertyLines(istream& ifs, OBMol& mol);
+      bool CanFilterOnProperties(OBConversion* pConv);
+      bool ReadRecord(istream& ifs, string& record, string::size_type& propStart);
       bool TestForAlias(const string& symbol, OBAtom* at, vector<pair<AliasData*,OBAtom*> >& aliases);
 
     private:
@@ -164,6 +181,7 @@ namespace OpenBabel
       bool IsMetal(OBAtom *atom);// Temporary for 2.3.1 (because of binary compatibility)
       map<int,int> indexmap; //relates index in file to index in OBMol
       vector<string> vs;
+      bool recordBuffered; //the current record was read into a string before parsing
   };
 
   //**************************************
@@ -243,8 +261,36 @@ namespace OpenBabel
   {
     OBMol* pmol = pOb->CastAndClear<OBMol>();
 
+    // When the filter only refers to data fields, read the record as text and
+    // test them first; the connection table is parsed only for records that pass
+    istringstream recordStream;
+    recordBuffered = false;
+    if (CanFilterOnProperties(pConv)) {
+      istream &in = *pConv->GetInStream();
+      if ( !in.good() || in.peek() == EOF )
+        return false;
+      string record;
+      string::size_type propStart;
+      ReadRecord(in, record, propStart);
+      if (propStart != string::npos) {
+        OBMol props;
+        istringstream propStream(record.substr(propStart));
+        ReadPropertyLines(propStream, props);
+        const char* filter = pConv->IsOption("filter", OBConversion::GENOPTIONS);
+        istringstream filterText(filter);
+        if (OBDescriptor::FilterUsesOnlyPairData(&props, filterText)) {
+          filterText.clear();
+          filterText.str(filter);
+          if (!OBDescriptor::FilterCompare(&props, filterText, false))
+            return true; // an empty molecule, which is counted but not output
+        }
+      }
+      recordStream.str(record);
+      recordBuffered = true;
+    }
+
     //Define some references so we can use the old parameter names
-    istream &ifs = *pConv->GetInStream();
+    istream &ifs = recordBuffered ? recordStream : *pConv->GetInStream();
     OBMol &mol = *pmol;
     bool setDimension = false; // did we extract the 'dimensional code' from line 2?
     stringstream errorMsg;
@@ -1072,10 +1118,10 @@ namespace OpenBabel
       AliasData::RevertToAliasForm(mol);
 
     // line 1: molecule name
-    ofs << mol.GetTitle() <<  endl;
+    ofs << mol.GetTitle() << '\n';
 
     // line 2: Program name, date/time, dimensions code
-    ofs << " OpenBabel" << GetTimeDate() <<  dimension << endl; //line2
+    ofs << " OpenBabel" << GetTimeDate() <<  dimension << '\n'; //line2
 
     // line 3: comment
     if (mol.HasData(OBGenericDataType::CommentData)) {
@@ -1085,7 +1131,7 @@ namespace OpenBabel
         comment.erase(80); //truncate to 80 chars
       ofs << comment;
     }
-    ofs << endl;
+    ofs << '\n';
 
     //
     // Atom Block
@@ -1096,8 +1142,6 @@ namespace OpenBabel
         return false;
     } else {
       //The rest of the function is the same as the original
-      char buff[BUFF_SIZE];
-
       if (mol.NumAtoms() > 999 || mol.NumBonds() > 999) { // Three digits!
         stringstream errorMsg;
         errorMsg << "MDL Molfile conversion failed: Molecule is too large to convert." << endl;
@@ -1139,10 +1183,15 @@ namespace OpenBabel
       // mmm = no longer supported (default=999)
       //                         aaabbblllfffcccsssxxxrrrpppiiimmmvvvvvv
       bool chiralFlag = GetChiralFlagFromGenericData(mol);
- 
-      snprintf(buff, BUFF_SIZE, "%3d%3d  0  0%3d  0  0  0  0  0999 V2000\n",
-               mol.NumAtoms(), mol.NumBonds(), chiralFlag);
-      ofs << buff;
+
+      // The counts line, atom block and bond block are built in one string
+      string block;
+      block.reserve(40 + 70 * mol.NumAtoms() + 22 * mol.NumBonds());
+      AppendInt(block, mol.NumAtoms(), 3);
+      AppendInt(block, mol.NumBonds(), 3);
+      block += "  0  0";
+      AppendInt(block, chiralFlag, 3);
+      block += "  0  0  0  0  0999 V2000\n";
 
       OBAtom *atom;
       vector<OBAtom*>::iterator i;
@@ -1188,11 +1237,20 @@ namespace OpenBabel
           }
         }
 
-        snprintf(buff, BUFF_SIZE, "%10.4f%10.4f%10.4f %-3s%2d%3d%3d%3d%3d%3d%3d%3d%3d%3d%3d%3d",
-          atom->GetX(), atom->GetY(), atom->GetZ(),
-          AtomSymbol(pmol, atom),
-          0,charge,stereo,0,0,valence,0,0,0,aclass,0,0);
-        ofs << buff << endl;
+        // "%10.4f%10.4f%10.4f %-3s%2d%3d%3d%3d%3d%3d%3d%3d%3d%3d%3d%3d"
+        AppendFixed(block, atom->GetX(), 10, 4);
+        AppendFixed(block, atom->GetY(), 10, 4);
+        AppendFixed(block, atom->GetZ(), 10, 4);
+        block += ' ';
+        AppendPadded(block, AtomSymbol(pmol, atom), 3, true);
+        block += " 0";
+        AppendInt(block, charge, 3);
+        AppendInt(block, stereo, 3);
+        block += "  0  0";
+        AppendInt(block, valence, 3);
+        block += "  0  0  0";
+        AppendInt(block, aclass, 3);
+        block += "  0  0\n";
       }
 
       OBAtom *nbr;
@@ -1227,11 +1285,11 @@ namespace OpenBabel
             if (updown.find(bond) != updown.end())
               stereo = updown[bond];
 
-            ofs << setw(3) << atom->GetIdx(); // begin atom number
-            ofs << setw(3) << nbr->GetIdx(); // end atom number
-            ofs << setw(3) << bond->GetBondOrder(); // bond type
-            ofs << setw(3) << stereo; // bond stereo
-            ofs << "  0  0  0" << endl;
+            AppendInt(block, atom->GetIdx(), 3); // begin atom number
+            AppendInt(block, nbr->GetIdx(), 3); // end atom number
+            AppendInt(block, bond->GetBondOrder(), 3); // bond type
+            AppendInt(block, stereo, 3); // bond stereo
+            block += "  0  0  0\n";
 
             // Add position in bond list to zbos for zero-order bonds
             bondline++;
@@ -1245,6 +1303,8 @@ namespace OpenBabel
         }
       }
 
+      ofs << block;
+
       vector<OBAtom*> rads, isos, chgs;
       vector<OBAtom*>::iterator itr;
       vector<pair<int,int> > zchs, hyds;
@@ -1278,7 +1338,7 @@ namespace OpenBabel
           if (atom->HasData(AliasDataType)) {
             AliasData* ad = static_cast<AliasData*>(atom->GetData(AliasDataType));
             if(!ad->IsExpanded()) //do nothing with an expanded alias
-              ofs << "A  " << setw(3) << right << atom->GetIdx() << '\n' << ad->GetAlias() << endl;
+              ofs << "A  " << setw(3) << right << atom->GetIdx() << '\n' << ad->GetAlias() << '\n';
           }
         }
         else {
@@ -1290,81 +1350,81 @@ namespace OpenBabel
         int counter = 0;
         for(itr=rads.begin();itr!=rads.end();++itr, counter++) {
           if (counter % 8 == 0) {
-            if (counter > 0) ofs << endl;
+            if (counter > 0) ofs << '\n';
             ofs << "M  RAD" << setw(3) << min(static_cast<unsigned long int>(rads.size() - counter), static_cast<unsigned long int>(8));
           }
           ofs << setw(4) << (*itr)->GetIdx() << setw(4) << (*itr)->GetSpinMultiplicity();
         }
-        ofs << endl;
+        ofs << '\n';
       }
       if(isos.size()) {
         int counter = 0;
         for(itr=isos.begin();itr!=isos.end();++itr, counter++) {
           if (counter % 8 == 0) {
-            if (counter > 0) ofs << endl;
+            if (counter > 0) ofs << '\n';
             ofs << "M  ISO" << setw(3) << min(static_cast<unsigned long int>(isos.size() - counter), static_cast<unsigned long int>(8));
           }
           ofs << setw(4) << (*itr)->GetIdx() << setw(4) << (*itr)->GetIsotope();
         }
-        ofs << endl;
+        ofs << '\n';
       }
       if(chgs.size()) {
         int counter = 0;
         for (itr=chgs.begin(); itr != chgs.end(); ++itr, counter++) {
           if (counter % 8 == 0) {
-            if (counter > 0) ofs << endl;
+            if (counter > 0) ofs << '\n';
             ofs << "M  CHG" << setw(3) << min(static_cast<unsigned long int>(chgs.size() - counter), static_cast<unsigned long int>(8));
           }
           ofs << setw(4) << (*itr)->GetIdx() << setw(4) << (*itr)->GetFormalCharge();
         }
-        ofs << endl;
+        ofs << '\n';
       }
       if(zchs.size()) {
         int counter = 0;
         for (zitr=zchs.begin(); zitr != zchs.end(); ++zitr, counter++) {
           if (counter % 8 == 0) {
-            if (counter > 0) ofs << endl;
+            if (counter > 0) ofs << '\n';
             ofs << "M  ZCH" << setw(3) << min(static_cast<unsigned long int>(zchs.size() - counter), static_cast<unsigned long int>(8));
           }
           ofs << setw(4) << zitr->first << setw(4) << zitr->second;
         }
-        ofs << endl;
+        ofs << '\n';
       }
       if(hyds.size()) {
         int counter = 0;
         for (zitr=hyds.begin(); zitr != hyds.end(); ++zitr, counter++) {
           if (counter % 8 == 0) {
-            if (counter > 0) ofs << endl;
+            if (counter > 0) ofs << '\n';
             ofs << "M  HYD" << setw(3) << min(static_cast<unsigned long int>(hyds.size() - counter), static_cast<unsigned long int>(8));
           }
           ofs << setw(4) << zitr->first << setw(4) << zitr->second;
         }
-        ofs << endl;
+        ofs << '\n';
       }
       if(zbos.size()) {
         int counter = 0;
         for(vector<int>::iterator it = zbos.begin(); it != zbos.end(); ++it, counter++) {
           if (counter % 8 == 0) {
-            if (counter > 0) ofs << endl;
+            if (counter > 0) ofs << '\n';
             ofs << "M  ZBO" << setw(3) << min(static_cast<unsigned long int>(zbos.size() - counter), static_cast<unsigned long int>(8));
           }
           ofs << setw(4) << *it << setw(4) << 0;
         }
-        ofs << endl;
+        ofs << '\n';
       }
       if(numberedRGroups.size()) {
         int counter = 0;
         for (zitr=numberedRGroups.begin(); zitr != numberedRGroups.end(); ++zitr, counter++) {
           if (counter % 8 == 0) {
-            if (counter > 0) ofs << endl;
+            if (counter > 0) ofs << '\n';
             ofs << "M  RGP" << setw(3) << min(static_cast<unsigned long int>(numberedRGroups.size() - counter), static_cast<unsigned long int>(8));
           }
           ofs << setw(4) << zitr->first << setw(4) << zitr->second;
         }
-        ofs << endl;
+        ofs << '\n';
       }
     }
-    ofs << "M  END" << endl;
+    ofs << "M  END\n";
 
     //For SD files only, write properties unless option m
     if(pConv->IsOption("sd") && !pConv->IsOption("m"))
@@ -1384,8 +1444,8 @@ namespace OpenBabel
           //in this format, don't need the annotation
           if((*k)->GetAttribute()!="PartialCharges")
           {
-            ofs << ">  <" << (*k)->GetAttribute() << ">" << endl;
-            ofs << ((OBPairData*)(*k))->GetValue() << endl << endl;
+            ofs << ">  <" << (*k)->GetAttribute() << ">\n";
+            ofs << ((OBPairData*)(*k))->GetValue() << "\n\n";
           }
         }
       }
@@ -1623,12 +1683,12 @@ namespace OpenBabel
   {
     bool chiralFlag = GetChiralFlagFromGenericData(mol);
 
-    ofs << "  0  0  0     0  0            999 V3000" << endl; //line 4
-    ofs << "M  V30 BEGIN CTAB" <<endl;
+    ofs << "  0  0  0     0  0            999 V3000" << '\n'; //line 4
+    ofs << "M  V30 BEGIN CTAB" << '\n';
     ofs << "M  V30 COUNTS " << mol.NumAtoms() << " " << mol.NumBonds()
-        << " 0 0 " << chiralFlag << endl;
+        << " 0 0 " << chiralFlag << '\n';
 
-    ofs << "M  V30 BEGIN ATOM" <<endl;
+    ofs << "M  V30 BEGIN ATOM" << '\n';
     OBAtom *atom;
     int index=1;
     vector<OBAtom*>::iterator i;
@@ -1647,11 +1707,11 @@ namespace OpenBabel
           ofs << " RAD=" << atom->GetSpinMultiplicity();
         if(atom->GetIsotope()!=0)
           ofs << " MASS=" << atom->GetIsotope();
-        ofs << endl;
+        ofs << '\n';
       }
-    ofs << "M  V30 END ATOM" <<endl;
+    ofs << "M  V30 END ATOM" << '\n';
 
-    ofs << "M  V30 BEGIN BOND" <<endl;
+    ofs << "M  V30 BEGIN BOND" << '\n';
     //so the bonds come out sorted
     index=1;
     OBAtom *nbr;
@@ -1675,12 +1735,12 @@ namespace OpenBabel
                 if(bond->IsHash()) cfg=6;
                 if(bond->IsWedgeOrHash()) cfg=4;
                 if(cfg) ofs << " CFG=" << cfg;
-                ofs << endl;
+                ofs << '\n';
               }
           }
       }
-    ofs << "M  V30 END BOND" <<endl;
-    ofs << "M  V30 END CTAB" <<endl;
+    ofs << "M  V30 END BOND" << '\n';
+    ofs << "M  V30 END CTAB" << '\n';
     return true;
   }
 
@@ -1888,6 +1948,66 @@ namespace OpenBabel
     return n;
   }
 
+  bool MDLFormat::CanFilterOnProperties(OBConversion* pConv)
+  {
+    // Not for molfiles embedded in other formats, and not when another option
+    // could change the data fields, or whether the molecule is output, before
+    // the filter is applied
+    if (pConv->GetInFormat() != this
+        || !pConv->IsOption("filter", OBConversion::GENOPTIONS)
+        || pConv->IsOption("T", OBConversion::INOPTIONS)
+        || pConv->IsOption("P", OBConversion::INOPTIONS))
+      return false;
+    static const char* const unsafe[] = { "C", "separate", "j", "join", "property", "add", "delete" };
+    for (unsigned int i = 0; i < sizeof(unsafe) / sizeof(unsafe[0]); ++i)
+      if (pConv->IsOption(unsafe[i], OBConversion::GENOPTIONS))
+        return false;
+    OBOp::OpMap* opts = pConv->GetOptions(OBConversion::GENOPTIONS);
+    for (OBOp::OpMap::const_iterator itr = opts->begin(); itr != opts->end(); ++itr)
+      if (OBOp::FindType(itr->first.c_str()))
+        return false;
+    return true;
+  }
+
+  bool MDLFormat::ReadRecord(istream& ifs, string& record, string::size_type& propStart)
+  {
+    // Reads the same lines as ReadMolecule() would: the header, the connection
+    // table up to M  END and then the data items (whose values may contain
+    // anything up to a blank line) up to $$$$. propStart is set to the offset
+    // of the line after M  END, or npos if there is none.
+    string line;
+    record.clear();
+    propStart = string::npos;
+    unsigned int header = 3;
+    while (std::getline(ifs, line)) {
+      record += line;
+      record += '\n';
+      if (header) {
+        --header;
+        continue;
+      }
+      if (line.substr(0, 4) == "$$$$")
+        break;
+      if (propStart == string::npos) {
+        if (line.substr(0, 6) == "M  END")
+          propStart = record.size();
+        continue;
+      }
+      if (line.substr(0, 4) == "$RXN" || line.substr(0, 4) == "$MOL")
+        break;
+      if (line.find("<") != string::npos) {
+        while (std::getline(ifs, line)) {
+          record += line;
+          record += '\n';
+          Trim(line);
+          if (line.empty())
+            break;
+        }
+      }
+    }
+    return !record.empty();
+  }
+
   bool MDLFormat::ReadPropertyLines(istream& ifs, OBMol& mol)
   {
     string line;
@@ -24,6 +24,7 @@ GNU General Public License for more details.
 #include <openbabel/kekulize.h>
 #include <openbabel/obfunctions.h>
 #include <openbabel/data.h>
+#include <openbabel/numformat.h>
 #include <cstdlib>
 
 using namespace std;
@@ -615,34 +616,34 @@ namespace OpenBabel
     //The old code follows....
     string str,str1;
     char buffer[BUFF_SIZE],label[BUFF_SIZE];
-    char rnum[BUFF_SIZE],rlabel[BUFF_SIZE];
+    string atomLabel, resLabel, resNum;
 
     //Check if UCSF Dock style coments are on
     if(pConv->IsOption("c", OBConversion::OUTOPTIONS)!=NULL) {
         vector<OBGenericData*>::iterator k;
         vector<OBGenericData*> vdata = mol.GetData();
-        ofs << endl;
+        ofs << '\n';
         for (k = vdata.begin();k != vdata.end();++k) {
             if ((*k)->GetDataType() == OBGenericDataType::PairData
             && (*k)->GetOrigin()!=local //internal OBPairData is not written
             && (*k)->GetAttribute()!="PartialCharges")
             {
-                ofs << "##########\t" << (*k)->GetAttribute() << ":\t" << ((OBPairData*)(*k))->GetValue() << endl;
+                ofs << "##########\t" << (*k)->GetAttribute() << ":\t" << ((OBPairData*)(*k))->GetValue() << '\n';
             }
         }
-        ofs << endl;
+        ofs << '\n';
     }
 
-    ofs << "@<TRIPOS>MOLECULE" << endl;
+    ofs << "@<TRIPOS>MOLECULE" << '\n';
     str = mol.GetTitle();
     if (str.empty())
-      ofs << "*****" << endl;
+      ofs << "*****" << '\n';
     else
-      ofs << str << endl;
+      ofs << str << '\n';
 
     snprintf(buffer, BUFF_SIZE," %d %d 0 0 0", mol.NumAtoms(),mol.NumBonds());
-    ofs << buffer << endl;
-    ofs << "SMALL" << endl; // TODO: detect if we have protein, biopolymer, etc.
+    ofs << buffer << '\n';
+    ofs << "SMALL" << '\n'; // TODO: detect if we have protein, biopolymer, etc.
 
     OBPairData *dp = (OBPairData*)mol.GetData("PartialCharges");
     if (dp != NULL) {
@@ -651,21 +652,21 @@ namespace OpenBabel
         // GAUSS80_CHARGES, AMPAC_CHARGES, MULLIKEN_CHARGES, DICT_ CHARGES,
         // MMFF94_CHARGES, USER_CHARGES
       if (strcasecmp(dp->GetValue().c_str(),"Mulliken") == 0)
-        ofs << "MULLIKEN_CHARGES" << endl;
+        ofs << "MULLIKEN_CHARGES" << '\n';
       else if (strcasecmp(dp->GetValue().c_str(),"MMFF94") == 0)
-        ofs << "MMFF94_CHARGES" << endl;
+        ofs << "MMFF94_CHARGES" << '\n';
       else if (strcasecmp(dp->GetValue().c_str(),"ESP") == 0)
-        ofs << "USER_CHARGES" << endl;
+        ofs << "USER_CHARGES" << '\n';
       else if (strcasecmp(dp->GetValue().c_str(),"Gasteiger") == 0)
-        ofs << "GASTEIGER" << endl;
+        ofs << "GASTEIGER" << '\n';
       else // ideally, code should pick from the Tripos types
-        ofs << "USER_CHARGES" << endl;
+        ofs << "USER_CHARGES" << '\n';
     }
     else { // No idea what these charges are... all our code sets "PartialCharges"
-        ofs << "GASTEIGER" << endl;
+        ofs << "GASTEIGER" << '\n';
     }
 
-    //    ofs << "Energy = " << mol.GetEnergy() << endl;
+    //    ofs << "Energy = " << mol.GetEnergy() << '\n';
 
     if (mol.HasData(OBGenericDataType::CommentData))
       {
@@ -674,8 +675,8 @@ namespace OpenBabel
         ofs << cd->GetData();
       }
 
-    ofs << endl;
-    ofs << "@<TRIPOS>ATOM" << endl;
+    ofs << '\n';
+    ofs << "@<TRIPOS>ATOM" << '\n';
 
     OBAtom *atom;
     OBResidue *res;
@@ -686,6 +687,10 @@ namespace OpenBabel
     ttab.SetFromType("INT");
     ttab.SetToType("SYB");
 
+    // The atom and bond records are built in one string
+    string block;
+    block.reserve(80 * mol.NumAtoms() + 32 * mol.NumBonds());
+
     bool hasFormalCharges = false;
     for (atom = mol.BeginAtom(i);atom;atom = mol.NextAtom(i))
       {
@@ -694,11 +699,10 @@ namespace OpenBabel
         //  Use sequentially numbered atom names if no residues
         //
 
-        snprintf(label,BUFF_SIZE, "%s%d",
-                 OBElements::GetSymbol(atom->GetAtomicNum()),
-                 ++labelcount[atom->GetAtomicNum()]);
-        strcpy(rlabel,"<1>");
-        strcpy(rnum,"1");
+        atomLabel = OBElements::GetSymbol(atom->GetAtomicNum());
+        AppendInt(atomLabel, ++labelcount[atom->GetAtomicNum()]);
+        resLabel = "<1>";
+        resNum = "1";
 
         str = atom->GetType();
         ttab.Translate(str1,str);
@@ -711,38 +715,55 @@ namespace OpenBabel
         if (!ligandsOnly && (res = atom->GetResidue()) )
           {
             // use original atom names defined by residue
-            snprintf(label,BUFF_SIZE,"%s",(char*)res->GetAtomID(atom).c_str());
+            atomLabel = res->GetAtomID(atom).c_str();
             // make sure that residue name includes its number
-            snprintf(rlabel,BUFF_SIZE,"%s%d",res->GetName().c_str(), res->GetNum());
-            snprintf(rnum,BUFF_SIZE,"%d",res->GetNum());
+            resLabel = res->GetName().c_str();
+            AppendInt(resLabel, res->GetNum());
+            resNum.clear();
+            AppendInt(resNum, res->GetNum());
           }
 
-        snprintf(buffer,BUFF_SIZE,"%7d %-6s   %9.4f %9.4f %9.4f %-5s %3s  %-8s %9.4f",
-                 atom->GetIdx(),label,
-                 atom->GetX(),atom->GetY(),atom->GetZ(),
-                 str1.c_str(),
-                 rnum,rlabel,
-                 atom->GetPartialCharge());
-        ofs << buffer << endl;
+        // "%7d %-6s   %9.4f %9.4f %9.4f %-5s %3s  %-8s %9.4f"
+        AppendInt(block, atom->GetIdx(), 7);
+        block += ' ';
+        AppendPadded(block, atomLabel.c_str(), 6, true);
+        block += "   ";
+        AppendFixed(block, atom->GetX(), 9, 4);
+        block += ' ';
+        AppendFixed(block, atom->GetY(), 9, 4);
+        block += ' ';
+        AppendFixed(block, atom->GetZ(), 9, 4);
+        block += ' ';
+        AppendPadded(block, str1.c_str(), 5, true);
+        block += ' ';
+        AppendPadded(block, resNum.c_str(), 3);
+        block += "  ";
+        AppendPadded(block, resLabel.c_str(), 8, true);
+        block += ' ';
+        AppendFixed(block, atom->GetPartialCharge(), 9, 4);
+        block += '\n';
       }
 
     //store formal charge info; put before bonds so we don't have
     //to read past the end of the molecule to realize it is there
     if(hasFormalCharges && !skipFormalCharge) {
       //dkoes - to enable roundtriping of charges
-      ofs << "@<TRIPOS>UNITY_ATOM_ATTR\n";
+      block += "@<TRIPOS>UNITY_ATOM_ATTR\n";
       for (atom = mol.BeginAtom(i);atom;atom = mol.NextAtom(i))
       {
         int charge = atom->GetFormalCharge();
         if (charge != 0) 
         {
-          ofs << atom->GetIdx() << " 1\n"; //one attribute
-          ofs << "charge " << charge << "\n"; //namely charge
+          AppendInt(block, atom->GetIdx());
+          block += " 1\n"; //one attribute
+          block += "charge ";
+          AppendInt(block, charge);
+          block += "\n"; //namely charge
         }
       }
     }
 
-    ofs << "@<TRIPOS>BOND" << endl;
+    block += "@<TRIPOS>BOND\n";
     OBBond *bond;
     vector<OBBond*>::iterator j;
     string s1, s2;
@@ -757,13 +778,19 @@ namespace OpenBabel
         else
           snprintf(label,BUFF_SIZE,"%d",bond->GetBondOrder());
 
-        snprintf(buffer, BUFF_SIZE,"%6d %5d %5d   %2s",
-                 bond->GetIdx()+1,bond->GetBeginAtomIdx(),bond->GetEndAtomIdx(),
-                 label);
-        ofs << buffer << endl;
+        // "%6d %5d %5d   %2s"
+        AppendInt(block, bond->GetIdx()+1, 6);
+        block += ' ';
+        AppendInt(block, bond->GetBeginAtomIdx(), 5);
+        block += ' ';
+        AppendInt(block, bond->GetEndAtomIdx(), 5);
+        block += "   ";
+        AppendPadded(block, label, 2);
+        block += '\n';
       }
+    ofs << block;
     // NO trailing blank line (PR#1868929).
-    //    ofs << endl;
+    //    ofs << '\n';
 
     return(true);
   }
@@ -0,0 +1,710 @@
+/**********************************************************************
+obbinformat.cpp - Compact binary serialization of OBMol
+
+This file is part of the Open Babel project.
+For more information, see <http://openbabel.org/>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+***********************************************************************/
+#include <openbabel/babelconfig.h>
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cstring>
+
+#include <openbabel/obmolecformat.h>
+#include <openbabel/mol.h>
+#include <openbabel/atom.h>
+#include <openbabel/bond.h>
+#include <openbabel/ring.h>
+#include <openbabel/residue.h>
+#include <openbabel/generic.h>
+#include <openbabel/obiter.h>
+#include <openbabel/stereo/tetrahedral.h>
+#include <openbabel/stereo/cistrans.h>
+#include <openbabel/stereo/squareplanar.h>
+
+using namespace std;
+namespace OpenBabel
+{
+
+  /// \brief Binary OBMol records that are read back without re-perception
+  class OBBinaryFormat : public OBMoleculeFormat
+  {
+  public:
+    //Register this format type ID
+    OBBinaryFormat() {OBConversion::RegisterFormat("obbin",this);}
+
+    virtual const char* Description() //required
+    { return
+    "Open Babel binary format\n"
+    "Molecules with their perceived properties, for passing between programs\n\n"
+
+    "Each molecule is stored as a self-contained binary record holding the\n"
+    "atoms, bonds, all conformers, residues, stereochemistry, ring sets,\n"
+    "key/value properties, the unit cell and the flags recording what has\n"
+    "been perceived.\n"
+    "Reading a record restores the molecule without parsing text or\n"
+    "perceiving rings, aromaticity, atom types or stereo again. This makes it\n"
+    "suitable for handing molecules from one stage of a pipeline to the next,\n"
+    "but it is not an archival format: the record layout is tied to the\n"
+    "version of Open Babel. Apart from the unit cell, other kinds of data\n"
+    "attached to a molecule (e.g. vibrations or orbitals) are not stored.\n\n"
+
+    "A record is a 16 byte header - the magic string ``OBBN``, the record\n"
+    "version and the payload length (unsigned 32 and 64-bit little endian\n"
+    "integers) - followed by the payload, so records can be skipped or\n"
+    "indexed without decoding them.\n\n"
+
+    "Write Options e.g. -xp\n"
+    " p Perceive rings, aromaticity, hybridization and atom types first\n\n";
+    }
+
+    virtual unsigned int Flags(){return READBINARY | WRITEBINARY;};
+    virtual int SkipObjects(int n, OBConversion* pConv);
+    virtual bool ReadMolecule(OBBase* pOb, OBConversion* pConv);
+    virtual bool WriteMolecule(OBBase* pOb, OBConversion* pConv);
+  };
+
+  ////////////////////////////////////////////////////
+  //Make an instance of the format class
+  OBBinaryFormat theOBBinaryFormat;
+
+  static const char OBBinMagic[4] = { 'O', 'B', 'B', 'N' };
+  static const unsigned int OBBinVersion = 2;
+  static const unsigned int OBBinHeaderSize = 16;
+  static const unsigned long long OBBinMaxRecord = 1ULL << 30; // 1 GiB
+
+  enum { AtomAromatic = 1, AtomInRing = 2 };
+
+//*******************************************************************
+// Little endian encoding of the payload
+
+static void Put(string& buf, unsigned long long x, unsigned int nbytes)
+{
+  for (unsigned int i = 0; i < nbytes; ++i)
+    buf += static_cast<char>((x >> (8*i)) & 0xff);
+}
+static void Put8(string& buf, unsigned int x)  { Put(buf, x, 1); }
+static void Put32(string& buf, unsigned int x) { Put(buf, x, 4); }
+static void Put64(string& buf, unsigned long long x) { Put(buf, x, 8); }
+static void PutDouble(string& buf, double x)
+{
+  unsigned long long bits;
+  memcpy(&bits, &x, sizeof(bits));
+  Put64(buf, bits);
+}
+static void PutString(string& buf, const string& s)
+{
+  Put32(buf, static_cast<unsigned int>(s.size()));
+  buf += s;
+}
+
+/// Bounds-checked cursor over a record payload. Reading past the end
+/// returns zeros and clears ok, which is checked once at the end.
+class OBBinReader
+{
+public:
+  OBBinReader(const string& buf) : _p(buf.data()), _end(buf.data() + buf.size()), ok(true) {}
+  unsigned long long Get(unsigned int nbytes)
+  {
+    if (_end - _p < static_cast<ptrdiff_t>(nbytes)) {
+      ok = false;
+      _p = _end;
+      return 0;
+    }
+    unsigned long long x = 0;
+    for (unsigned int i = 0; i < nbytes; ++i)
+      x |= static_cast<unsigned long long>(static_cast<unsigned char>(*_p++)) << (8*i);
+    return x;
+  }
+  unsigned int U8()  { return static_cast<unsigned int>(Get(1)); }
+  unsigned int U32() { return static_cast<unsigned int>(Get(4)); }
+  int I32()          { return static_cast<int>(static_cast<unsigned int>(Get(4))); }
+  unsigned long long U64() { return Get(8); }
+  double Double()
+  {
+    unsigned long long bits = Get(8);
+    double x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+  }
+  string String()
+  {
+    unsigned int len = U32();
+    if (_end - _p < static_cast<ptrdiff_t>(len)) {
+      ok = false;
+      _p = _end;
+      return string();
+    }
+    string s(_p, len);
+    _p += len;
+    return s;
+  }
+  //! \return whether @p count items of at least @p size bytes can remain
+  bool Fits(unsigned int count, unsigned int size)
+  {
+    if (static_cast<unsigned long long>(count) * size > static_cast<unsigned long long>(_end - _p))
+      ok = false;
+    return ok;
+  }
+
+private:
+  const char* _p;
+  const char* _end;
+public:
+  bool ok;
+};
+
+static void PutRefs(string& buf, const OBStereo::Refs& refs)
+{
+  Put32(buf, static_cast<unsigned int>(refs.size()));
+  for (OBStereo::ConstRefIter i = refs.begin(); i != refs.end(); ++i)
+    Put64(buf, *i);
+}
+
+static OBStereo::Refs GetRefs(OBBinReader& in)
+{
+  OBStereo::Refs refs;
+  unsigned int n = in.U32();
+  if (in.Fits(n, 8))
+    for (unsigned int i = 0; i < n; ++i)
+      refs.push_back(static_cast<OBStereo::Ref>(in.U64()));
+  return refs;
+}
+
+/////////////////////////////////////////////////////////////////////
+bool OBBinaryFormat::WriteMolecule(OBBase* pOb, OBConversion* pConv)
+{
+  OBMol* pmol = dynamic_cast<OBMol*>(pOb);
+  if(pmol==NULL)
+    return false;
+  OBMol &mol = *pmol;
+  ostream &ofs = *pConv->GetOutStream();
+
+  if (pConv->IsOption("p") && mol.NumAtoms()) {
+    // Do the perception once here rather than in every reader
+    mol.GetSSSR();
+    mol.GetLSSR();
+    OBAtom *atom = mol.GetFirstAtom();
+    atom->IsInRing();
+    atom->IsAromatic();
+    atom->GetHyb();
+    atom->GetType();
+  }
+
+  // Only claim what is actually stored; anything else is perceived again
+  unsigned int flags = mol.GetFlags();
+  if (mol.HasSSSRPerceived() && !mol.HasData("SSSR"))
+    flags &= ~OB_SSSR_MOL;
+  if (mol.HasLSSRPerceived() && !mol.HasData("LSSR"))
+    flags &= ~OB_LSSR_MOL;
+  const bool aromatic = mol.HasAromaticPerceived();
+  const bool rings = mol.HasRingAtomsAndBondsPerceived();
+  const bool hyb = mol.HasHybridizationPerceived();
+  const bool types = mol.HasAtomTypesPerceived();
+  const bool pcharges = mol.HasPartialChargesPerceived();
+
+  string buf;
+  buf.reserve(64 + 64 * mol.NumAtoms() + 16 * mol.NumBonds());
+  Put32(buf, flags);
+  Put32(buf, mol.GetDimension());
+  PutString(buf, mol.GetTitle());
+  PutDouble(buf, mol.GetEnergy());
+  Put32(buf, mol.HasFlag(OB_TCHARGE_MOL) ? mol.GetTotalCharge() : 0);
+  Put32(buf, mol.HasFlag(OB_TSPIN_MOL) ? mol.GetTotalSpinMultiplicity() : 0);
+
+  Put32(buf, mol.NumAtoms());
+  FOR_ATOMS_OF_MOL(atom, mol) {
+    Put64(buf, atom->GetId());
+    Put8(buf, atom->GetAtomicNum());
+    Put32(buf, atom->GetIsotope());
+    Put32(buf, atom->GetFormalCharge());
+    Put32(buf, atom->GetSpinMultiplicity());
+    Put8(buf, atom->GetImplicitHCount());
+    Put8(buf, hyb ? atom->GetHyb() : 0);
+    Put8(buf, (aromatic && atom->IsAromatic() ? AtomAromatic : 0)
+            | (rings && atom->IsInRing() ? AtomInRing : 0));
+    PutDouble(buf, pcharges ? atom->GetPartialCharge() : 0.0);
+    PutString(buf, types ? atom->GetType() : "");
+  }
+
+  Put32(buf, mol.NumBonds());
+  FOR_BONDS_OF_MOL(bond, mol) {
+    Put64(buf, bond->GetId());
+    Put32(buf, bond->GetBeginAtomIdx());
+    Put32(buf, bond->GetEndAtomIdx());
+    Put8(buf, bond->GetBondOrder());
+    Put32(buf, bond->GetFlags());
+  }
+
+  // All conformers; the first one is current when there is just one
+  vector<double*> &confs = mol.GetConformers();
+  const unsigned int ncoords = 3 * mol.NumAtoms();
+  unsigned int current = 0;
+  for (unsigned int i = 0; i < confs.size(); ++i)
+    if (confs[i] == mol.GetCoordinates())
+      current = i;
+  if (confs.empty() && mol.NumAtoms()) {
+    Put32(buf, 1);
+    Put32(buf, 0);
+    FOR_ATOMS_OF_MOL(atom, mol) {
+      PutDouble(buf, atom->x());
+      PutDouble(buf, atom->y());
+      PutDouble(buf, atom->z());
+    }
+  }
+  else {
+    Put32(buf, static_cast<unsigned int>(confs.size()));
+    Put32(buf, current);
+    for (unsigned int i = 0; i < confs.size(); ++i)
+      for (unsigned int j = 0; j < ncoords; ++j)
+        PutDouble(buf, confs[i][j]);
+  }
+  vector<double> energies;
+  if (mol.HasData(OBGenericDataType::ConformerData))
+    energies = static_cast<OBConformerData*>(mol.GetData(OBGenericDataType::ConformerData))->GetEnergies();
+  Put32(buf, static_cast<unsigned int>(energies.size()));
+  for (unsigned int i = 0; i < energies.size(); ++i)
+    PutDouble(buf, energies[i]);
+
+  Put32(buf, mol.NumResidues());
+  FOR_RESIDUES_OF_MOL(res, mol) {
+    PutString(buf, res->GetName());
+    PutString(buf, res->GetNumString());
+    Put8(buf, static_cast<unsigned char>(res->GetChain()));
+    Put8(buf, static_cast<unsigned char>(res->GetInsertionCode()));
+    Put32(buf, res->GetChainNum());
+    vector<OBAtom*> atoms = res->GetAtoms();
+    Put32(buf, static_cast<unsigned int>(atoms.size()));
+    for (vector<OBAtom*>::iterator a = atoms.begin(); a != atoms.end(); ++a) {
+      Put32(buf, (*a)->GetIdx());
+      PutString(buf, res->GetAtomID(*a));
+      Put8(buf, res->IsHetAtom(*a));
+      Put32(buf, res->GetSerialNum(*a));
+    }
+  }
+
+  // Ring sets, only if they have been perceived
+  const char* ringsets[2] = { "SSSR", "LSSR" };
+  const int ringflags[2] = { OB_SSSR_MOL, OB_LSSR_MOL };
+  for (int k = 0; k < 2; ++k) {
+    OBRingData *rd = (flags & ringflags[k]) ?
+      static_cast<OBRingData*>(mol.GetData(ringsets[k])) : NULL;
+    if (!rd) {
+      Put32(buf, 0);
+      continue;
+    }
+    vector<OBRing*> &vr = rd->GetData();
+    Put32(buf, static_cast<unsigned int>(vr.size()));
+    for (vector<OBRing*>::iterator r = vr.begin(); r != vr.end(); ++r) {
+      PutString(buf, mol.HasRingTypesPerceived() ? (*r)->GetType() : "");
+      Put32(buf, static_cast<unsigned int>((*r)->_path.size()));
+      for (vector<int>::iterator j = (*r)->_path.begin(); j != (*r)->_path.end(); ++j)
+        Put32(buf, *j);
+    }
+  }
+
+  // Stereo that has been read or perceived, without triggering perception
+  vector<OBGenericData*> stereo = mol.GetAllData(OBGenericDataType::StereoData);
+  string sbuf;
+  unsigned int nstereo = 0;
+  for (vector<OBGenericData*>::iterator i = stereo.begin(); i != stereo.end(); ++i) {
+    OBStereo::Type type = static_cast<OBStereoBase*>(*i)->GetType();
+    if (type == OBStereo::Tetrahedral) {
+      OBTetrahedralStereo::Config cfg = static_cast<OBTetrahedralStereo*>(*i)->GetConfig();
+      Put32(sbuf, type);
+      Put64(sbuf, cfg.center);
+      Put64(sbuf, cfg.from);
+      PutRefs(sbuf, cfg.refs);
+      Put8(sbuf, cfg.specified);
+    }
+    else if (type == OBStereo::CisTrans) {
+      OBCisTransStereo::Config cfg = static_cast<OBCisTransStereo*>(*i)->GetConfig();
+      Put32(sbuf, type);
+      Put64(sbuf, cfg.begin);
+      Put64(sbuf, cfg.end);
+      PutRefs(sbuf, cfg.refs);
+      Put8(sbuf, cfg.specified);
+    }
+    else if (type == OBStereo::SquarePlanar) {
+      OBSquarePlanarStereo::Config cfg = static_cast<OBSquarePlanarStereo*>(*i)->GetConfig();
+      Put32(sbuf, type);
+      Put64(sbuf, cfg.center);
+      PutRefs(sbuf, cfg.refs);
+      Put8(sbuf, cfg.specified);
+    }
+    else
+      continue;
+    ++nstereo;
+  }
+  Put32(buf, nstereo);
+  buf += sbuf;
+
+  vector<OBGenericData*> pairs = mol.GetAllData(OBGenericDataType::PairData);
+  sbuf.clear();
+  unsigned int npairs = 0;
+  for (vector<OBGenericData*>::iterator i = pairs.begin(); i != pairs.end(); ++i) {
+    OBPairData *pd = dynamic_cast<OBPairData*>(*i);
+    if (!pd)
+      continue;
+    PutString(sbuf, pd->GetAttribute());
+    PutString(sbuf, pd->GetValue());
+    Put8(sbuf, pd->GetOrigin());
+    ++npairs;
+  }
+  Put32(buf, npairs);
+  buf += sbuf;
+
+  OBUnitCell *cell = static_cast<OBUnitCell*>(mol.GetData(OBGenericDataType::UnitCell));
+  Put8(buf, cell != NULL);
+  if (cell) {
+    matrix3x3 m = cell->GetCellMatrix();
+    for (int i = 0; i < 3; ++i)
+      for (int j = 0; j < 3; ++j)
+        PutDouble(buf, m.Get(i, j));
+    vector3 offset = cell->GetOffset();
+    PutDouble(buf, offset.x());
+    PutDouble(buf, offset.y());
+    PutDouble(buf, offset.z());
+    string sg = cell->GetSpaceGroupName();
+    if (sg.empty() && cell->GetSpaceGroup())
+      sg = cell->GetSpaceGroup()->GetHMName();
+    PutString(buf, sg);
+  }
+
+  string header(OBBinMagic, 4);
+  Put32(header, OBBinVersion);
+  Put64(header, buf.size());
+  ofs.write(header.data(), header.size());
+  ofs.write(buf.data(), buf.size());
+  return ofs.good();
+}
+
+//*******************************************************************
+//! Read a record header. \return false at the end of the input or if it is not a record
+static bool ReadHeader(istream& ifs, unsigned long long& length)
+{
+  char header[OBBinHeaderSize];
+  if (!ifs.read(header, OBBinHeaderSize))
+    return false;
+  if (memcmp(header, OBBinMagic, 4) != 0) {
+    obErrorLog.ThrowError(__FUNCTION__, "Not an Open Babel binary record", obError);
+    return false;
+  }
+  string h(header + 4, OBBinHeaderSize - 4);
+  OBBinReader in(h);
+  unsigned int version = in.U32();
+  length = in.U64();
+  if (version != OBBinVersion) {
+    stringstream errorMsg;
+    errorMsg << "Open Babel binary record version " << version
+             << " is not supported (expected " << OBBinVersion << ")" << endl;
+    obErrorLog.ThrowError(__FUNCTION__, errorMsg.str(), obError);
+    return false;
+  }
+  return true;
+}
+
+//! \return false if the stream is known to end before @p length more bytes
+static bool HasBytes(istream& ifs, unsigned long long length)
+{
+  streampos pos = ifs.tellg();
+  if (pos < 0) // not seekable, e.g. compressed
+    return true;
+  ifs.seekg(0, ios_base::end);
+  streampos end = ifs.tellg();
+  ifs.seekg(pos);
+  if (end < 0 || !ifs) {
+    ifs.clear();
+    ifs.seekg(pos);
+    return true;
+  }
+  return static_cast<unsigned long long>(end - pos) >= length;
+}
+
+int OBBinaryFormat::SkipObjects(int n, OBConversion* pConv)
+{
+  if (n == 0)
+    n++;
+  istream& ifs = *pConv->GetInStream();
+  unsigned long long length;
+  while (n-- && ReadHeader(ifs, length))
+    ifs.ignore(length);
+  return ifs.good() ? 1 : -1;
+}
+
+/////////////////////////////////////////////////////////////////////
+bool OBBinaryFormat::ReadMolecule(OBBase* pOb, OBConversion* pConv)
+{
+  OBMol* pmol = pOb->CastAndClear<OBMol>();
+  if(pmol==NULL)
+    return false;
+  OBMol &mol = *pmol;
+  istream &ifs = *pConv->GetInStream();
+
+  unsigned long long length;
+  if (!ReadHeader(ifs, length))
+    return false;
+  // Check the length before allocating for it
+  if (length > OBBinMaxRecord) {
+    obErrorLog.ThrowError(__FUNCTION__, "Open Babel binary record is too long", obError);
+    return false;
+  }
+  if (!HasBytes(ifs, length)) {
+    obErrorLog.ThrowError(__FUNCTION__, "Truncated Open Babel binary record", obError);
+    return false;
+  }
+  string buf(length, '\0');
+  if (length && !ifs.read(&buf[0], length)) {
+    obErrorLog.ThrowError(__FUNCTION__, "Truncated Open Babel binary record", obError);
+    return false;
+  }
+  OBBinReader in(buf);
+
+  unsigned int flags = in.U32();
+  int dim = in.I32();
+  string title = in.String();
+  double energy = in.Double();
+  int totalCharge = in.I32();
+  unsigned int totalSpin = in.U32();
+
+  mol.BeginModify();
+  unsigned int natoms = in.U32();
+  if (!in.Fits(natoms, 33)) // the fixed-size part of an atom
+    natoms = 0;
+  for (unsigned int i = 0; i < natoms && in.ok; ++i) {
+    OBAtom *atom = mol.NewAtom(static_cast<unsigned long>(in.U64()));
+    if (!atom) { // duplicate id
+      in.ok = false;
+      break;
+    }
+    atom->SetAtomicNum(in.U8());
+    atom->SetIsotope(in.U32());
+    atom->SetFormalCharge(in.I32());
+    atom->SetSpinMultiplicity(static_cast<short>(in.I32()));
+    atom->SetImplicitHCount(in.U8());
+    atom->SetHyb(in.U8());
+    unsigned int aflags = in.U8();
+    atom->SetAromatic((aflags & AtomAromatic) != 0);
+    atom->SetInRing((aflags & AtomInRing) != 0);
+    atom->SetPartialCharge(in.Double());
+    string type = in.String();
+    if (!type.empty())
+      atom->SetType(type);
+  }
+
+  unsigned int nbonds = in.U32();
+  if (!in.Fits(nbonds, 21))
+    nbonds = 0;
+  for (unsigned int i = 0; i < nbonds && in.ok; ++i) {
+    unsigned long id = static_cast<unsigned long>(in.U64());
+    unsigned int bgn = in.U32();
+    unsigned int end = in.U32();
+    unsigned int order = in.U8();
+    unsigned int bflags = in.U32();
+    OBAtom *bgnAtom = mol.GetAtom(bgn);
+    OBAtom *endAtom = mol.GetAtom(end);
+    if (!bgnAtom || !endAtom || bgn == end || mol.GetBond(bgnAtom, endAtom)) {
+      in.ok = false;
+      break;
+    }
+    // Keep the id, so that GetBondById() finds the same bond as before
+    OBBond *bond = mol.NewBond(id);
+    if (!bond) { // duplicate id
+      in.ok = false;
+      break;
+    }
+    bond->Set(bond->GetIdx(), bgnAtom, endAtom, order, bflags);
+    bgnAtom->AddBond(bond);
+    endAtom->AddBond(bond);
+  }
+
+  unsigned int nconfs = in.U32();
+  unsigned int current = in.U32();
+  vector<double*> confs;
+  const unsigned int ncoords = 3 * mol.NumAtoms();
+  if (in.ok && in.Fits(nconfs, 8 * ncoords))
+    for (unsigned int i = 0; i < nconfs; ++i) {
+      double *c = new double[ncoords];
+      for (unsigned int j = 0; j < ncoords; ++j)
+        c[j] = in.Double();
+      confs.push_back(c);
+    }
+  if (!confs.empty() && current >= confs.size()) {
+    for (unsigned int i = 0; i < confs.size(); ++i)
+      delete [] confs[i];
+    obErrorLog.ThrowError(__FUNCTION__, "Corrupt Open Babel binary record", obError);
+    mol.EndModify();
+    mol.Clear();
+    return false;
+  }
+  if (!confs.empty())
+    FOR_ATOMS_OF_MOL(atom, mol) {
+      const double *c = confs[current] + 3 * (atom->GetIdx() - 1);
+      atom->SetVector(c[0], c[1], c[2]);
+    }
+  mol.EndModify();
+  if (!confs.empty()) {
+    mol.SetConformers(confs);
+    mol.SetConformer(current);
+  }
+
+  unsigned int nenergies = in.U32();
+  if (in.Fits(nenergies, 8) && nenergies) {
+    vector<double> energies(nenergies);
+    for (unsigned int i = 0; i < nenergies; ++i)
+      energies[i] = in.Double();
+    mol.SetEnergies(energies);
+  }
+
+  unsigned int nresidues = in.U32();
+  if (!in.Fits(nresidues, 18))
+    nresidues = 0;
+  for (unsigned int i = 0; i < nresidues && in.ok; ++i) {
+    OBResidue *res = mol.NewResidue();
+    res->SetName(in.String());
+    res->SetNum(in.String());
+    res->SetChain(static_cast<char>(in.U8()));
+    res->SetInsertionCode(static_cast<char>(in.U8()));
+    res->SetChainNum(in.U32());
+    unsigned int nresatoms = in.U32();
+    if (!in.Fits(nresatoms, 13))
+      break;
+    for (unsigned int j = 0; j < nresatoms; ++j) {
+      OBAtom *atom = mol.GetAtom(in.U32());
+      string id = in.String();
+      bool het = in.U8() != 0;
+      unsigned int serial = in.U32();
+      if (!atom) {
+        in.ok = false;
+        break;
+      }
+      res->AddAtom(atom);
+      res->SetAtomID(atom, id);
+      res->SetHetAtom(atom, het);
+      res->SetSerialNum(atom, serial);
+    }
+  }
+
+  const char* ringsets[2] = { "SSSR", "LSSR" };
+  for (int k = 0; k < 2 && in.ok; ++k) {
+    unsigned int nrings = in.U32();
+    if (!nrings || !in.Fits(nrings, 8))
+      continue;
+    vector<OBRing*> vr;
+    for (unsigned int i = 0; i < nrings && in.ok; ++i) {
+      string type = in.String();
+      unsigned int size = in.U32();
+      if (!in.Fits(size, 4))
+        break;
+      vector<int> path(size);
+      for (unsigned int j = 0; j < size; ++j) {
+        path[j] = in.U32();
+        if (path[j] < 1 || path[j] > static_cast<int>(mol.NumAtoms()))
+          in.ok = false;
+      }
+      OBRing *ring = new OBRing(path, mol.NumAtoms() + 1);
+      ring->SetParent(&mol);
+      ring->SetType(type);
+      vr.push_back(ring);
+    }
+    OBRingData *rd = new OBRingData();
+    rd->SetOrigin(perceived);
+    rd->SetAttribute(ringsets[k]);
+    rd->SetData(vr);
+    if (in.ok)
+      rd->BuildIndex(mol);
+    mol.SetData(rd);
+  }
+
+  unsigned int nstereo = in.U32();
+  if (!in.Fits(nstereo, 17))
+    nstereo = 0;
+  for (unsigned int i = 0; i < nstereo && in.ok; ++i) {
+    unsigned int type = in.U32();
+    if (type == OBStereo::Tetrahedral) {
+      OBTetrahedralStereo::Config cfg;
+      cfg.center = static_cast<OBStereo::Ref>(in.U64());
+      cfg.from = static_cast<OBStereo::Ref>(in.U64());
+      cfg.refs = GetRefs(in);
+      cfg.specified = in.U8() != 0;
+      OBTetrahedralStereo *ts = new OBTetrahedralStereo(&mol);
+      ts->SetConfig(cfg);
+      mol.SetData(ts);
+    }
+    else if (type == OBStereo::CisTrans) {
+      OBCisTransStereo::Config cfg;
+      cfg.begin = static_cast<OBStereo::Ref>(in.U64());
+      cfg.end = static_cast<OBStereo::Ref>(in.U64());
+      cfg.refs = GetRefs(in);
+      cfg.specified = in.U8() != 0;
+      OBCisTransStereo *ct = new OBCisTransStereo(&mol);
+      ct->SetConfig(cfg);
+      mol.SetData(ct);
+    }
+    else if (type == OBStereo::SquarePlanar) {
+      OBSquarePlanarStereo::Config cfg;
+      cfg.center = static_cast<OBStereo::Ref>(in.U64());
+      cfg.refs = GetRefs(in);
+      cfg.specified = in.U8() != 0;
+      OBSquarePlanarStereo *sp = new OBSquarePlanarStereo(&mol);
+      sp->SetConfig(cfg);
+      mol.SetData(sp);
+    }
+    else
+      in.ok = false;
+  }
+
+  unsigned int npairs = in.U32();
+  if (!in.Fits(npairs, 9))
+    npairs = 0;
+  for (unsigned int i = 0; i < npairs && in.ok; ++i) {
+    OBPairData *dp = new OBPairData;
+    dp->SetAttribute(in.String());
+    dp->SetValue(in.String());
+    dp->SetOrigin(static_cast<DataOrigin>(in.U8()));
+    mol.SetData(dp);
+  }
+
+  if (in.U8() && in.ok) {
+    matrix3x3 m;
+    for (int i = 0; i < 3; ++i)
+      for (int j = 0; j < 3; ++j)
+        m.Set(i, j, in.Double());
+    double x = in.Double(), y = in.Double(), z = in.Double();
+    string sg = in.String();
+    OBUnitCell *cell = new OBUnitCell;
+    cell->SetData(m);
+    cell->SetOffset(vector3(x, y, z));
+    if (!sg.empty())
+      cell->SetSpaceGroup(sg);
+    mol.SetData(cell);
+  }
+
+  if (!in.ok) {
+    obErrorLog.ThrowError(__FUNCTION__, "Corrupt Open Babel binary record", obError);
+    mol.Clear();
+    return false;
+  }
+
+  mol.SetTitle(title);
+  mol.SetDimension(dim);
+  mol.SetEnergy(energy);
+  if (flags & OB_TCHARGE_MOL)
+    mol.SetTotalCharge(totalCharge);
+  if (flags & OB_TSPIN_MOL)
+    mol.SetTotalSpinMultiplicity(totalSpin);
+  mol.SetFlags(flags); // last, as the setters above change flags
+  return true;
+}
+
+}//namespace
@@ -23,6 +23,7 @@ GNU General Public License for more details.
 #include <openbabel/elements.h>
 #include <openbabel/generic.h>
 #include <openbabel/data.h>
+#include <openbabel/numformat.h>
 
 #include <vector>
 #include <map>
@@ -532,7 +533,7 @@ namespace OpenBabel
       { // More than one molecule record
         model_num = pConv->GetOutputIndex(); // MODEL 1-based index
         snprintf(buffer, BUFF_SIZE, "MODEL %8d", model_num);
-        ofs << buffer << endl;
+        ofs << buffer << '\n';
       }
 
     // write back all fields (REMARKS, HELIX, SHEET, SITE, ...)
@@ -579,7 +580,7 @@ namespace OpenBabel
           last = pos + 1;
         pos = lines.find('\n', last);
 
-        ofs << attr << line << endl;
+        ofs << attr << line << '\n';
       }
     }
 
@@ -588,12 +589,12 @@ namespace OpenBabel
         snprintf(buffer, BUFF_SIZE, "COMPND    %s ",mol.GetTitle());
       else
         snprintf(buffer, BUFF_SIZE, "COMPND    UNNAMED");
-      ofs << buffer << endl;
+      ofs << buffer << '\n';
     }
 
     if (!authorWritten) {
       snprintf(buffer, BUFF_SIZE, "AUTHOR    GENERATED BY OPEN BABEL %s",BABEL_VERSION);
-      ofs << buffer << endl;
+      ofs << buffer << '\n';
     }
 
     // Write CRYST1 record, containing unit cell parameters, space group
@@ -637,7 +638,7 @@ namespace OpenBabel
                    pUC->GetAlpha(), pUC->GetBeta(), pUC->GetGamma(),
                    "P1");
 
-        ofs << buffer << endl;
+        ofs << buffer << '\n';
       }
 
     // before we write any records, we should check to see if any coord < -1000
@@ -666,6 +667,10 @@ namespace OpenBabel
     // otherwise, move enough so that smallest coord is > -999.0f
     mol.Translate(transV);
 
+    // The ATOM/HETATM, CONECT and MASTER records are built in one string
+    string block;
+    block.reserve(81 * mol.NumAtoms() + 256);
+
     OBAtom *atom;
     OBResidue *res;
     for (i = 1; i <= mol.NumAtoms(); i++)
@@ -749,21 +754,29 @@ namespace OpenBabel
          occup = occup_fp->GetGenericValue();
         }
 
-        snprintf(buffer, BUFF_SIZE, "%s%5d %-4s %-3s %c%4d%c   %8.3f%8.3f%8.3f%6.2f  0.00          %2s%2s\n",
-                 het?"HETATM":"ATOM  ",
-                 i,
-                 type_name,
-                 the_res,
-                 the_chain,
-                 res_num,
-                 the_insertioncode,
-                 atom->GetX(),
-                 atom->GetY(),
-                 atom->GetZ(),
-                 occup,
-                 element_name,
-                 scharge);
-        ofs << buffer;
+        // "%s%5d %-4s %-3s %c%4d%c   %8.3f%8.3f%8.3f%6.2f  0.00          %2s%2s\n"
+        string::size_type start = block.size();
+        block += het ? "HETATM" : "ATOM  ";
+        AppendInt(block, i, 5);
+        block += ' ';
+        AppendPadded(block, type_name, 4, true);
+        block += ' ';
+        AppendPadded(block, the_res, 3, true);
+        block += ' ';
+        block += the_chain;
+        AppendInt(block, res_num, 4);
+        block += the_insertioncode;
+        block += "   ";
+        AppendFixed(block, atom->GetX(), 8, 3);
+        AppendFixed(block, atom->GetY(), 8, 3);
+        AppendFixed(block, atom->GetZ(), 8, 3);
+        AppendFixed(block, occup, 6, 2);
+        block += "  0.00          ";
+        AppendPadded(block, element_name, 2);
+        AppendPadded(block, scharge, 2);
+        block += '\n';
+        if (the_chain == '\0') // the record used to end at the null chain ID
+          block.resize(block.find('\0', start));
       }
 
     OBAtom *nbr;
@@ -789,33 +802,34 @@ namespace OpenBabel
               if ((currentValence % 4) == 0) {
                 if (currentValence > 0) {
                   // Add the trailing space to finish the previous record
-                  ofs << "                                       \n";
+                  block += "                                       \n";
                 }
                 // write the start of a new CONECT record
-                snprintf(buffer, BUFF_SIZE, "CONECT%5d", i);
-                ofs << buffer;
+                block += "CONECT";
+                AppendInt(block, i, 5);
               }
               currentValence++;
-              snprintf(buffer, BUFF_SIZE, "%5d", nbr->GetIdx());
-              ofs << buffer;
+              AppendInt(block, nbr->GetIdx(), 5);
             }
           }
 
         // Add trailing spaces
         while ((currentValence % 4) != 0) {
-          ofs << "     ";
+          block += "     ";
           currentValence++;
         }
-        ofs << "                                       \n";
+        block += "                                       \n";
       }
 
-    snprintf(buffer, BUFF_SIZE, "MASTER        0    0    0    0    0    0    0    0 ");
-    ofs << buffer;
-    snprintf(buffer, BUFF_SIZE, "%4d    0 %4d    0\n",mol.NumAtoms(),mol.NumAtoms());
-    ofs << buffer;
+    block += "MASTER        0    0    0    0    0    0    0    0 ";
+    AppendInt(block, mol.NumAtoms(), 4);
+    block += "    0 ";
+    AppendInt(block, mol.NumAtoms(), 4);
+    block += "    0\n";
+    ofs << block;
 
     if (model_num) {
-      ofs << "ENDMDL" << endl;
+      ofs << "ENDMDL" << '\n';
 	  if (pConv->IsLast()) {
 	    ofs << "END\n";
 	  }
@@ -30,6 +30,7 @@ GNU General Public License for more details.
 #include <openbabel/data.h>
 #include <openbabel/obiter.h>
 #include <openbabel/typer.h>
+#include <openbabel/numformat.h>
 
 #include <algorithm>
 #include <cstdlib>
@@ -321,7 +322,6 @@ namespace OpenBabel
   /////////////////////////////////////////////////////////////////////////
   void OutputAtom(OBAtom* atom, ostream& ofs, const unsigned int index)
   {
-    char buffer[BUFF_SIZE];
     char type_name[10], padded_name[10];
     char the_res[10];
     char the_chain = ' ';
@@ -398,21 +398,31 @@ namespace OpenBabel
     }
 
     double charge = atom->GetPartialCharge();
-    snprintf(buffer, BUFF_SIZE, "%s%5d %-4s %-3s %c%4d%c   %8.3f%8.3f%8.3f  0.00  0.00    %+5.3f %.2s",
-      het?"HETATM":"ATOM  ",
-      index,
-      type_name,
-      the_res,
-      the_chain,
-      res_num,
-      the_icode,
-      atom->GetX(),
-      atom->GetY(),
-      atom->GetZ(),
-      charge,
-      element_name_final);
-    ofs << buffer;
-    ofs << endl;
+    // "%s%5d %-4s %-3s %c%4d%c   %8.3f%8.3f%8.3f  0.00  0.00    %+5.3f %.2s"
+    string line;
+    line.reserve(80);
+    line += het ? "HETATM" : "ATOM  ";
+    AppendInt(line, index, 5);
+    line += ' ';
+    AppendPadded(line, type_name, 4, true);
+    line += ' ';
+    AppendPadded(line, the_res, 3, true);
+    line += ' ';
+    line += the_chain;
+    AppendInt(line, res_num, 4);
+    line += the_icode;
+    line += "   ";
+    AppendFixed(line, atom->GetX(), 8, 3);
+    AppendFixed(line, atom->GetY(), 8, 3);
+    AppendFixed(line, atom->GetZ(), 8, 3);
+    line += "  0.00  0.00    ";
+    AppendFixed(line, charge, 5, 3, true);
+    line += ' ';
+    line.append(element_name_final, 2);
+    if (the_chain == '\0') // the record used to end at the null chain ID
+      line.resize(line.find('\0'));
+    line += '\n';
+    ofs << line;
   }
 
   void OutputGroup(OBMol& mol, ostream& ofs, const vector <int>& group, map <unsigned int, unsigned int> new_indexes, bool use_new_indexes)
@@ -550,14 +560,14 @@ namespace OpenBabel
     }
 
     if (!(pConv->IsOption("r",OBConversion::OUTOPTIONS)))
-      ofs << "ROOT" << endl;
+      ofs << "ROOT" << '\n';
     for (set <unsigned int>::iterator it= (*tree.find(0)).second.rigid_with.begin() ; it != (*tree.find(0)).second.rigid_with.end(); ++it)
     {
       OutputGroup(mol, ofs, (*tree.find(*it)).second.atoms, new_order, !preserve_original_index);
     }
 
    if (!(pConv->IsOption("r",OBConversion::OUTOPTIONS)))
-     ofs << "ENDROOT" << endl;
+     ofs << "ENDROOT" << '\n';
 
     for (unsigned int i=1; i < tree.size(); i++)
     {
@@ -572,7 +582,7 @@ namespace OpenBabel
         ofs.width(4);
         if (!preserve_original_index) {ofs << (new_order.find(child_atom))-> second;}
         else {ofs << child_atom;}
-        ofs << endl;
+        ofs << '\n';
         for (set <unsigned int>::iterator it= (*tree.find(i)).second.rigid_with.begin() ; it != (*tree.find(i)).second.rigid_with.end(); ++it)
         {
           OutputGroup(mol, ofs, (*tree.find(*it)).second.atoms, new_order, !preserve_original_index);
@@ -598,7 +608,7 @@ namespace OpenBabel
             ofs.width(4);
             if (!preserve_original_index) {ofs << (new_order.find(child_atom))-> second;}
                                     else {ofs << child_atom;}
-            ofs << endl;
+            ofs << '\n';
           }
           (*tree.find(*it_parent)).second.children.erase(*it);
         }
@@ -886,9 +896,9 @@ namespace OpenBabel
         { // More than one molecule record
           model_num = pConv->GetOutputIndex(); // MODEL 1-based index
           snprintf(buffer, BUFF_SIZE, "MODEL %8d", model_num);
-          ofs << buffer << endl;
+          ofs << buffer << '\n';
         }
-        ofs << "REMARK  Name = " << mol.GetTitle(true) << endl;
+        ofs << "REMARK  Name = " << mol.GetTitle(true) << '\n';
 //        ofs << "USER    Name = " << mol.GetTitle(true) << endl;
         if (!(pConv->IsOption("r",OBConversion::OUTOPTIONS)))
         {
@@ -911,8 +921,8 @@ namespace OpenBabel
             }
           }
           qsort(rotBondTable, nRotBond, sizeof(OBAtom **), CompareBonds);
-          ofs << "REMARK  " << nRotBond << " active torsions:" << endl;
-          ofs << "REMARK  status: ('A' for Active; 'I' for Inactive)" << endl;
+          ofs << "REMARK  " << nRotBond << " active torsions:" << '\n';
+          ofs << "REMARK  status: ('A' for Active; 'I' for Inactive)" << '\n';
           for (rotBondId=0; rotBondId < nRotBond; rotBondId++)
           {
             snprintf(buffer, BUFF_SIZE, "REMARK  %3d  A    between atoms: ", rotBondId + 1);
@@ -940,20 +950,20 @@ namespace OpenBabel
                 ofs << "  and  ";
             }
             delete [] rotBondTable[rotBondId];
-            ofs << endl;
+            ofs << '\n';
           }
           delete [] rotBondTable;
         }
-        ofs << "REMARK                            x       y       z     vdW  Elec       q    Type" << endl;
+        ofs << "REMARK                            x       y       z     vdW  Elec       q    Type" << '\n';
 //        ofs << "USER                              x       y       z     vdW  Elec       q    Type" << endl;
-        ofs << "REMARK                         _______ _______ _______ _____ _____    ______ ____" << endl;
+        ofs << "REMARK                         _______ _______ _______ _____ _____    ______ ____" << '\n';
 //        ofs << "USER                           _______ _______ _______ _____ _____    ______ ____" << endl;
       }
       else
       {
         ofs << "BEGIN_RES" << " " << res_name << " " << res_chain << " ";
         ofs.width(3);
-        ofs << right << res_num << endl;
+        ofs << right << res_num << '\n';
       }
 
       // before we write any records, we should check to see if any coord < -1000
@@ -1030,20 +1040,20 @@ namespace OpenBabel
       if (!residue)
       {
         if (!(pConv->IsOption("r",OBConversion::OUTOPTIONS)))
-          ofs << "TORSDOF " << torsdof << endl;
+          ofs << "TORSDOF " << torsdof << '\n';
         else
-          ofs << "TER " << endl;
+          ofs << "TER " << '\n';
 //        ofs << "TER" << endl;
         if (model_num)
         {
-          ofs << "ENDMDL" << endl;
+          ofs << "ENDMDL" << '\n';
         }
       }
       else
       {
         ofs << "END_RES" << " " << res_name << " " << res_chain << " ";
         ofs.width(3);
-        ofs << right << res_num << endl;
+        ofs << right << res_num << '\n';
       }
     }
     return true;
@@ -3877,7 +3877,14 @@ namespace OpenBabel {
         }
       }
 
-      CanonicalLabels(&mol, symmetry_classes, canonical_order, frag_atoms, maxSeconds);
+      bool timedOut;
+      CanonicalLabels(&mol, symmetry_classes, canonical_order, frag_atoms, maxSeconds, false, timedOut);
+      if (timedOut) {
+        std::stringstream errorMsg;
+        errorMsg << "Canonicalization of " << mol.GetTitle() << " timed out after "
+                 << maxSeconds << " seconds; the SMILES may not be canonical" << std::endl;
+        obErrorLog.ThrowError(__FUNCTION__, errorMsg.str(), obWarning);
+      }
     }
     else {
       if (_pconv->IsOption("C")) {      // "C" == "anti-canonical form"
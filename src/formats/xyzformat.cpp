@@ -19,6 +19,7 @@ GNU General Public License for more details.
 #include <openbabel/atom.h>
 #include <openbabel/elements.h>
 #include <openbabel/obiter.h>
+#include <openbabel/numformat.h>
 
 #include <sstream>
 #include <cstdlib>
@@ -305,15 +306,18 @@ namespace OpenBabel
       snprintf(buffer, BUFF_SIZE, "%s\n", mol.GetTitle());
     ofs << buffer;
 
+    string block;
+    block.reserve(48 * mol.NumAtoms());
     FOR_ATOMS_OF_MOL(atom, mol)
       {
-        snprintf(buffer, BUFF_SIZE, "%-3s%15.5f%15.5f%15.5f\n",
-                 OBElements::GetSymbol(atom->GetAtomicNum()),
-                 atom->GetX(),
-                 atom->GetY(),
-                 atom->GetZ());
-        ofs << buffer;
+        // "%-3s%15.5f%15.5f%15.5f\n"
+        AppendPadded(block, OBElements::GetSymbol(atom->GetAtomicNum()), 3, true);
+        AppendFixed(block, atom->GetX(), 15, 5);
+        AppendFixed(block, atom->GetY(), 15, 5);
+        AppendFixed(block, atom->GetZ(), 15, 5);
+        block += '\n';
       }
+    ofs << block;
 
     return(true);
   }
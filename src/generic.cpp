@@ -29,6 +29,7 @@ GNU General Public License for more details.
 #include <openbabel/obiter.h>
 #include <openbabel/generic.h>
 #include <openbabel/math/matrix3x3.h>
+#include <openbabel/math/periodicgrid.h>
 #include <openbabel/elements.h>
 
 // needed for msvc to have at least one reference to AtomClass, AliasData in openbabel library
@@ -406,6 +407,47 @@ namespace OpenBabel
     return vector3(x, y, z);
   }
 
+  // Minimum image of the fractional displacement \p frac, with distances
+  // measured by \p fracToCart. Shared by the public kernels and
+  // MakeSupercell(), which keeps the matrix for many calls.
+  static vector3 MinimumImage(const matrix3x3 &fracToCart, const vector3 &frac)
+  {
+    vector3 rounded(frac.x() - floor(frac.x() + 0.5),
+                    frac.y() - floor(frac.y() + 0.5),
+                    frac.z() - floor(frac.z() + 0.5));
+    vector3 best = rounded;
+    double bestLength = (fracToCart * rounded).length_2();
+    for (int i = -1; i <= 1; ++i)
+      for (int j = -1; j <= 1; ++j)
+        for (int k = -1; k <= 1; ++k) {
+          if (i == 0 && j == 0 && k == 0)
+            continue;
+          vector3 image = rounded + vector3(i, j, k);
+          double length = (fracToCart * image).length_2();
+          if (length < bestLength) {
+            bestLength = length;
+            best = image;
+          }
+        }
+    return best;
+  }
+
+  vector3 OBUnitCell::MinimumImageFractional(vector3 frac) const
+  {
+    return MinimumImage(_mOrient * _mOrtho, frac);
+  }
+
+  vector3 OBUnitCell::MinimumImageCartesian(vector3 cart) const
+  {
+    matrix3x3 fracToCart = _mOrient * _mOrtho;
+    return fracToCart * MinimumImage(fracToCart, fracToCart.inverse() * cart);
+  }
+
+  double OBUnitCell::MinimumImageDistance(const vector3 &cart1, const vector3 &cart2) const
+  {
+    return MinimumImageCartesian(cart2 - cart1).length();
+  }
+
   OBUnitCell::LatticeType OBUnitCell::GetLatticeType( int spacegroup ) const
   {
     //	1-2 	Triclinic
@@ -580,6 +622,21 @@ namespace OpenBabel
     return (dr.length_2() < 1e-6);
   }
 
+  // Adds a site for an atom of element \p elem at \p frac unless the same
+  // element already has one there. Returns whether the site was added.
+  static bool AddUniqueSite(OBPeriodicGrid &sites, vector<unsigned int> &siteElements,
+                            vector<OBPeriodicGrid::Neighbor> &found,
+                            const vector3 &frac, unsigned int elem)
+  {
+    sites.GetNeighbors(frac, found);
+    for (size_t i = 0; i < found.size(); ++i)
+      if (siteElements[found[i].index] == elem)
+        return false;
+    sites.Add(frac);
+    siteElements.push_back(elem);
+    return true;
+  }
+
   void OBUnitCell::FillUnitCell(OBMol *mol)
   {
     const SpaceGroup *sg = GetSpaceGroup(); // the actual space group and transformations for this unit cell
@@ -587,49 +644,43 @@ namespace OpenBabel
     if(sg == NULL)
       return ;
 
-    // For each atom, we loop through: convert the coords back to inverse space, apply the transformations and create new atoms
-    vector3 baseV, uniqueV, updatedCoordinate;
-    list<vector3> transformedVectors; // list of symmetry-defined copies of the atom
-    list<vector3>::iterator transformIter;
-    list<OBAtom*>::iterator deleteIter, atomIter;
-    OBAtom *newAtom;
-    list<OBAtom*> atoms, atomsToDelete;
-    char hash[22];
-    set<string> coordinateSet;
+    // Sites are duplicates when closer than this in fractional coordinates,
+    // across the cell boundaries as in areDuplicateAtoms()
+    OBPeriodicGrid sites(matrix3x3(1.0), 1e-3);
+    vector<unsigned int> siteElements;
+    vector<OBPeriodicGrid::Neighbor> found;
+
+    vector<OBAtom*> atoms, atomsToDelete;
+    vector<vector3> uniqueV;
+    vector<unsigned int> elements;
 
     // Check original mol for duplicates
     FOR_ATOMS_OF_MOL(atom, *mol) {
-      baseV = atom->GetVector();
-      baseV = CartesianToFractional(baseV);
-      baseV = WrapFractionalCoordinate(baseV);
-      snprintf(hash, 22, "%03d,%.3f,%.3f,%.3f", atom->GetAtomicNum(), baseV.x(), baseV.y(), baseV.z());
-      if (coordinateSet.insert(hash).second) { // True if new entry
+      vector3 baseV = WrapFractionalCoordinate(CartesianToFractional(atom->GetVector()));
+      if (AddUniqueSite(sites, siteElements, found, baseV, atom->GetAtomicNum())) {
         atoms.push_back(&(*atom));
+        uniqueV.push_back(baseV);
+        elements.push_back(atom->GetAtomicNum());
       } else {
         atomsToDelete.push_back(&(*atom));
       }
     }
-    for (deleteIter = atomsToDelete.begin(); deleteIter != atomsToDelete.end(); ++deleteIter) {
-      mol->DeleteAtom(*deleteIter);
+    for (size_t i = 0; i < atomsToDelete.size(); ++i) {
+      mol->DeleteAtom(atomsToDelete[i]);
     }
 
-    // Cross-check all transformations for duplicity
-    for (atomIter = atoms.begin(); atomIter != atoms.end(); ++atomIter) {
-      uniqueV = (*atomIter)->GetVector();
-      uniqueV = CartesianToFractional(uniqueV);
-      uniqueV = WrapFractionalCoordinate(uniqueV);
-
-      transformedVectors = sg->Transform(uniqueV);
-      for (transformIter = transformedVectors.begin();
-        transformIter != transformedVectors.end(); ++transformIter) {
-        updatedCoordinate = WrapFractionalCoordinate(*transformIter);
-
-        // Check if the transformed coordinate is a duplicate of an atom
-        snprintf(hash, 22, "%03d,%.3f,%.3f,%.3f", (*atomIter)->GetAtomicNum(), updatedCoordinate.x(),
-                 updatedCoordinate.y(), updatedCoordinate.z());
-        if (coordinateSet.insert(hash).second) {
-          newAtom = mol->NewAtom();
-          newAtom->Duplicate(*atomIter);
+    // Apply every transformation to all the atoms in one pass, then add the
+    // symmetry-defined copies of each atom in turn, skipping occupied sites
+    vector<vector3> transformedVectors;
+    sg->Transform(uniqueV, transformedVectors);
+    const size_t numAtoms = atoms.size();
+    const size_t numTransforms = numAtoms ? transformedVectors.size() / numAtoms : 0;
+    for (size_t i = 0; i < numAtoms; ++i) {
+      for (size_t t = 0; t < numTransforms; ++t) {
+        vector3 updatedCoordinate = WrapFractionalCoordinate(transformedVectors[t * numAtoms + i]);
+        if (AddUniqueSite(sites, siteElements, found, updatedCoordinate, elements[i])) {
+          OBAtom *newAtom = mol->NewAtom();
+          newAtom->Duplicate(atoms[i]);
           newAtom->SetVector(FractionalToCartesian(updatedCoordinate));
         }
       } // end loop of transformed atoms
@@ -637,6 +688,88 @@ namespace OpenBabel
     SetSpaceGroup(1); // We've now applied the symmetry, so we should act like a P1 unit cell
   }
 
+  bool OBUnitCell::MakeSupercell(OBMol *mol, unsigned int na, unsigned int nb, unsigned int nc)
+  {
+    if (mol == NULL || na == 0 || nb == 0 || nc == 0)
+      return false;
+
+    const int counts[3] = { static_cast<int>(na), static_cast<int>(nb), static_cast<int>(nc) };
+    const unsigned int numAtoms = mol->NumAtoms();
+    const unsigned int numCells = na * nb * nc;
+    const matrix3x3 fracToCart = _mOrient * _mOrtho;
+    const matrix3x3 cartToFrac = fracToCart.inverse();
+
+    // Which image of its end atom each bond joins, as the lattice
+    // translation from that image back to the end atom
+    vector<OBBond*> bonds;
+    vector<int> bondShifts;
+    FOR_BONDS_OF_MOL(bond, *mol) {
+      vector3 d = cartToFrac * (bond->GetEndAtom()->GetVector() - bond->GetBeginAtom()->GetVector());
+      vector3 shift = d - MinimumImage(fracToCart, d);
+      bonds.push_back(&(*bond));
+      bondShifts.push_back(static_cast<int>(floor(shift.x() + 0.5)));
+      bondShifts.push_back(static_cast<int>(floor(shift.y() + 0.5)));
+      bondShifts.push_back(static_cast<int>(floor(shift.z() + 0.5)));
+    }
+
+    mol->BeginModify();
+    mol->ReserveAtoms(numAtoms * numCells);
+
+    // Copies of the atoms, one cell at a time; cell 0 is the original
+    for (unsigned int cell = 1; cell < numCells; ++cell) {
+      vector3 translation = fracToCart * vector3(cell / (nb * nc), (cell / nc) % nb, cell % nc);
+      for (unsigned int i = 1; i <= numAtoms; ++i) {
+        OBAtom *atom = mol->GetAtom(i);
+        OBAtom *copy = mol->NewAtom();
+        copy->Duplicate(atom);
+        copy->SetVector(atom->GetVector() + translation);
+      }
+    }
+
+    // Join the begin atom in each cell to the end atom in the cell its bond
+    // leads to, wrapping around the supercell
+    for (size_t b = 0; b < bonds.size(); ++b) {
+      OBBond *bond = bonds[b];
+      const int *shift = &bondShifts[3 * b];
+      unsigned int begin = bond->GetBeginAtomIdx(), end = bond->GetEndAtomIdx();
+      for (unsigned int cell = 0; cell < numCells; ++cell) {
+        int index[3] = { static_cast<int>(cell / (nb * nc)),
+                         static_cast<int>((cell / nc) % nb),
+                         static_cast<int>(cell % nc) };
+        unsigned int target = 0;
+        for (int axis = 0; axis < 3; ++axis) {
+          int t = (index[axis] - shift[axis]) % counts[axis];
+          if (t < 0)
+            t += counts[axis];
+          target = target * counts[axis] + t;
+        }
+        unsigned int copyEnd = end + target * numAtoms;
+        if (cell == 0) {
+          if (target == 0)
+            continue;
+          // The bond left the cell; join it to the right copy instead
+          OBAtom *oldEnd = bond->GetEndAtom();
+          OBAtom *newEnd = mol->GetAtom(copyEnd);
+          oldEnd->DeleteBond(bond);
+          bond->SetEnd(newEnd);
+          newEnd->AddBond(bond);
+        }
+        else
+          mol->AddBond(begin + cell * numAtoms, copyEnd,
+                       bond->GetBondOrder(), bond->GetFlags());
+      }
+    }
+
+    mol->EndModify();
+
+    vector3 v1 = fracToCart.GetColumn(0) * na;
+    vector3 v2 = fracToCart.GetColumn(1) * nb;
+    vector3 v3 = fracToCart.GetColumn(2) * nc;
+    SetData(v1, v2, v3);
+    SetSpaceGroup(1);
+    return true;
+  }
+
   /// @todo Remove nonconst overloads in OBUnitCell on next version bump.
 #define OBUNITCELL_CALL_CONST_OVERLOAD(_type, _name) \
   _type OBUnitCell::_name() \
@@ -769,7 +902,8 @@ namespace OpenBabel
   //
 
   OBRingData::OBRingData() :
-    OBGenericData("RingData", OBGenericDataType::RingData)
+    OBGenericData("RingData", OBGenericDataType::RingData),
+    _indexed(false)
   {
     _vr.clear();
   }
@@ -780,7 +914,8 @@ namespace OpenBabel
   */
   OBRingData::OBRingData(const OBRingData &src)
     :	OBGenericData(src),	//chain to base class
-      _vr(src._vr)				//chain to member classes
+      _vr(src._vr),				//chain to member classes
+      _indexed(false)
   {
     //no other memeber data
     //memory management
@@ -840,6 +975,7 @@ namespace OpenBabel
         (*newring) = (**ring);
         (*ring) = newring;	//redirect pointer
       }
+    _indexed = false;
     return(*this);
   }
 
@@ -855,6 +991,87 @@ namespace OpenBabel
     return((i == _vr.end()) ? (OBRing*)NULL : (OBRing*)*i);
   }
 
+  bool OBRingData::IndexIsCurrent(OBMol &mol) const
+  {
+    // Modifying the molecule unsets its ring perception, and the next
+    // perception replaces this object. Changes made through GetData() show
+    // up as different rings.
+    bool perceived = GetAttribute() == "LSSR" ? mol.HasLSSRPerceived()
+                                              : mol.HasSSSRPerceived();
+    return _indexed && perceived && _indexedRings == _vr;
+  }
+
+  //! Add ring @p r of @p vr to the membership @p m of one of its atoms or bonds
+  static void AddRing(OBRingMembership &m, const vector<OBRing*> &vr, unsigned int r)
+  {
+    unsigned int size = vr[r]->Size();
+    if (m.count == 0)
+      m.firstSize = size;
+    if (m.smallest < 0 || size < vr[m.smallest]->Size())
+      m.smallest = r;
+    if (size < 64)
+      m.sizes |= 1ULL << size;
+    ++m.count;
+  }
+
+  void OBRingData::BuildIndex(OBMol &mol)
+  {
+    _atomRings.assign(mol.NumAtoms() + 1, OBRingMembership());
+    _bondRings.assign(mol.NumBonds(), OBRingMembership());
+
+    for (unsigned int r = 0; r < _vr.size(); ++r) {
+      OBRing *ring = _vr[r];
+      vector<int>::iterator i;
+      for (i = ring->_path.begin(); i != ring->_path.end(); ++i) {
+        if (*i <= 0 || static_cast<unsigned int>(*i) >= _atomRings.size())
+          continue;
+        AddRing(_atomRings[*i], _vr, r);
+
+        // Each bond between two ring atoms is seen from both ends
+        OBAtom *atom = mol.GetAtom(*i);
+        if (!atom)
+          continue;
+        OBBondIterator j;
+        for (OBBond *bond = atom->BeginBond(j); bond; bond = atom->NextBond(j)) {
+          OBAtom *nbr = bond->GetNbrAtom(atom);
+          if (nbr->GetIdx() < atom->GetIdx() || !ring->IsInRing(nbr->GetIdx()))
+            continue;
+          AddRing(_bondRings[bond->GetIdx()], _vr, r);
+        }
+      }
+    }
+
+    _indexedRings = _vr;
+    _indexed = true;
+  }
+
+  OBRingMembership OBRingData::GetMembership(OBAtom *atom) const
+  {
+    OBMol *mol = static_cast<OBMol*>(atom->GetParent());
+    unsigned int idx = atom->GetIdx();
+    if (IndexIsCurrent(*mol) && idx < _atomRings.size())
+      return _atomRings[idx];
+
+    OBRingMembership m;
+    for (unsigned int r = 0; r < _vr.size(); ++r)
+      if (_vr[r]->IsInRing(idx))
+        AddRing(m, _vr, r);
+    return m;
+  }
+
+  OBRingMembership OBRingData::GetMembership(OBBond *bond) const
+  {
+    OBMol *mol = static_cast<OBMol*>(bond->GetParent());
+    if (IndexIsCurrent(*mol) && bond->GetIdx() < _bondRings.size())
+      return _bondRings[bond->GetIdx()];
+
+    OBRingMembership m;
+    for (unsigned int r = 0; r < _vr.size(); ++r)
+      if (_vr[r]->IsMember(bond))
+        AddRing(m, _vr, r);
+    return m;
+  }
+
   //
   //member functions for OBAngle class - stores all angles
   //
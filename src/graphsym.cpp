@@ -79,17 +79,22 @@ namespace OpenBabel {
       std::vector<unsigned int> _canonLabels;
       OBStereoUnitSet _stereoUnits;
 
+      // The fragment as a graph: its atoms in molecule order and, for each,
+      // the positions in _atoms of its neighbors in the fragment (CSR)
+      std::vector<OBAtom*> _atoms;
+      std::vector<unsigned int> _nbrStart, _nbrs;
+      // Scratch space for the refinement rounds
+      std::vector<unsigned int> _nbrClasses, _order;
+
       unsigned int GetHvyDegree(OBAtom *atom);
       unsigned int GetHvyBondSum(OBAtom *atom);
       void FindRingAtoms(OBBitVec &ring_atoms);
-      void CreateNewClassVector(std::vector<std::pair<OBAtom*,unsigned int> > &vp1,
-                                std::vector<std::pair<OBAtom*,unsigned int> > &vp2);
-      static void CreateNewClassVector(OBMol *mol, std::vector<std::pair<OBAtom*,unsigned int> > &vp1,
-                                       std::vector<std::pair<OBAtom*,unsigned int> > &vp2);
+      void BuildFragmentGraph();
+      void ExtendClasses(const std::vector<unsigned int> &classes, std::vector<unsigned int> &extended);
       void GetGIVector(std::vector<unsigned int> &vid);
       bool GetGTDVector(std::vector<int> &gtd);
-      static void CountAndRenumberClasses(std::vector<std::pair<OBAtom*,unsigned int> > &vp, unsigned int &count);
-      int ExtendInvariants(std::vector<std::pair<OBAtom*, unsigned int> > &symmetry_classes);
+      unsigned int RenumberClasses(std::vector<unsigned int> &classes);
+      int ExtendInvariants(std::vector<unsigned int> &symmetry_classes);
       int CalculateSymmetry(std::vector<unsigned int> &symmetry_classes);
       int Iterate(std::vector<unsigned int> &symmetry_classes);
       void CanonicalLabels(const std::vector<unsigned int> &symmetry_classes, std::vector<unsigned int> &canon_labels, int maxSeconds);
@@ -114,25 +119,6 @@ namespace OpenBabel {
 
   const unsigned int OBGraphSym::NoSymmetryClass = 0x7FFFFFFF;
 
-  /**
-   * Functions for use by the sort() method of a vector.
-   */
-  inline bool CompareUnsigned(const unsigned int &a,const unsigned int &b)
-  {
-    return(a<b);
-  }
-
-  inline bool ComparePairFirst(const std::pair<OBAtom*,unsigned int> &a,const std::pair<OBAtom*,unsigned int> &b)
-  {
-    return(a.first->GetIdx() < b.first->GetIdx());
-  }
-
-  inline bool ComparePairSecond(const std::pair<OBAtom*,unsigned int> &a,const std::pair<OBAtom*,unsigned int> &b)
-  {
-    return(a.second < b.second);
-  }
-
-
   /**
    * Like OBAtom::GetHvyDegree(): Counts the number non-hydrogen
    * neighbors, but doesn't count atoms not in the fragment.
@@ -205,48 +191,39 @@ namespace OpenBabel {
     gtd.clear();
     gtd.resize(_pmol->NumAtoms());
 
-    int gtdcount, natom;
-    OBBitVec used, curr, next;
-    OBAtom *atom, *atom1;
-    OBBond *bond;
-    vector<OBNodeBase*>::iterator ai;
-    vector<OBBond*>::iterator j;
-
-    next.Clear();
-
-    for (atom = _pmol->BeginAtom(ai); atom; atom = _pmol->NextAtom(ai)) {
-
-      int idx = atom->GetIdx();
-      if (!_frag_atoms.BitIsSet(idx)) {     // Not in this fragment?
-        gtd[idx-1] = OBGraphSym::NoSymmetryClass;
-        continue;
-      }
-
-      gtdcount = 0;
-      used.Clear();curr.Clear();
-      used.SetBitOn(idx);
-      curr.SetBitOn(idx);
+    // Breadth-first search over the heavy atoms of the fragment, using
+    // the level of each atom (+1) stamped with the search it was seen in
+    const unsigned int n = _atoms.size();
+    vector<unsigned int> seen(n, 0), level(n, 0), queue(n);
+    vector<bool> heavy(n);
+    for (unsigned int p = 0; p < n; ++p)
+      heavy[p] = _atoms[p]->GetAtomicNum() != OBElements::Hydrogen;
 
-      while (!curr.IsEmpty()) {
-        next.Clear();
-        for (natom = curr.NextBit(-1);natom != curr.EndBit();natom = curr.NextBit(natom)) {
-          atom1 = _pmol->GetAtom(natom);
-          if (!_frag_atoms.BitIsSet(atom1->GetIdx()))
+    vector<OBNodeBase*>::iterator ai;
+    for (OBAtom *atom = _pmol->BeginAtom(ai); atom; atom = _pmol->NextAtom(ai))
+      if (!_frag_atoms.BitIsSet(atom->GetIdx()))     // Not in this fragment?
+        gtd[atom->GetIndex()] = OBGraphSym::NoSymmetryClass;
+
+    for (unsigned int p = 0; p < n; ++p) {
+      unsigned int head = 0, tail = 0;
+      queue[tail++] = p;
+      seen[p] = p + 1;
+      level[p] = 0;
+      unsigned int maxlevel = 0;
+      while (head < tail) {
+        unsigned int q = queue[head++];
+        for (unsigned int k = _nbrStart[q]; k < _nbrStart[q+1]; ++k) {
+          unsigned int r = _nbrs[k];
+          if (seen[r] == p + 1 || !heavy[r])
             continue;
-          for (bond = atom1->BeginBond(j);bond;bond = atom1->NextBond(j)) {
-            int nbr_idx = bond->GetNbrAtomIdx(atom1);
-            if (   _frag_atoms.BitIsSet(nbr_idx)
-                && !used.BitIsSet(nbr_idx)
-                && !curr.BitIsSet(nbr_idx)
-                && bond->GetNbrAtom(atom1)->GetAtomicNum() != OBElements::Hydrogen)
-              next.SetBitOn(nbr_idx);
-          }
+          seen[r] = p + 1;
+          level[r] = level[q] + 1;
+          maxlevel = level[r];
+          queue[tail++] = r;
         }
-        used |= next;
-        curr = next;
-        gtdcount++;
       }
-      gtd[idx-1] = gtdcount;
+      // The number of levels, including the start atom
+      gtd[_atoms[p]->GetIndex()] = maxlevel + 1;
     }
 
     return(true);
@@ -262,13 +239,12 @@ namespace OpenBabel {
    */
   void OBGraphSymPrivate::FindRingAtoms(OBBitVec &ring_atoms)
   {
-    vector<OBRing*> sssRings;
     vector<OBRing*>::iterator ri;
 
     ring_atoms.Resize(_pmol->NumAtoms());
     ring_atoms.Clear();
 
-    sssRings = _pmol->GetSSSR();
+    vector<OBRing*> &sssRings = _pmol->GetSSSR();
     for (ri = sssRings.begin(); ri != sssRings.end(); ++ri) {
       OBRing *ring = *ri;
       OBBitVec bvtmp = _frag_atoms & ring->_pathset;      // intersection: fragment and ring
@@ -325,162 +301,106 @@ namespace OpenBabel {
     }
   }
 
+  /**
+   * Builds the fragment graph used by GetGTDVector() and ExtendInvariants():
+   * the fragment atoms in molecule order and, for each, the positions of
+   * its neighbors that are in the fragment.
+   */
+  void OBGraphSymPrivate::BuildFragmentGraph()
+  {
+    _atoms.clear();
+    vector<int> idx2pos(_pmol->NumAtoms() + 1, -1);
+    vector<OBNodeBase*>::iterator ai;
+    for (OBAtom *atom = _pmol->BeginAtom(ai); atom; atom = _pmol->NextAtom(ai))
+      if (_frag_atoms.BitIsSet(atom->GetIdx())) {
+        idx2pos[atom->GetIdx()] = _atoms.size();
+        _atoms.push_back(atom);
+      }
+
+    _nbrStart.assign(1, 0);
+    _nbrs.clear();
+    vector<OBBond*>::iterator bi;
+    for (unsigned int p = 0; p < _atoms.size(); ++p) {
+      for (OBAtom *nbr = _atoms[p]->BeginNbrAtom(bi); nbr; nbr = _atoms[p]->NextNbrAtom(bi))
+        if (idx2pos[nbr->GetIdx()] >= 0)
+          _nbrs.push_back(idx2pos[nbr->GetIdx()]);
+      _nbrStart.push_back(_nbrs.size());
+    }
+  }
+
   /**
    * Creates a new vector of symmetry classes based on an existing
-   * vector.  (Helper routine to GetGIDVector.)  On return, vp2 will
-   * have newly-extended connectivity sums, but the numbers (the class
-   * IDs) are very large.
+   * vector, both indexed by position in the fragment.  On return,
+   * @p extended will have newly-extended connectivity sums, but the
+   * numbers (the class IDs) are very large.
    *
-   * (Comments by CJ) This appears to compute the "extended connectivity
-   * sums" similar to those described by Weininger, Morgan, etc. It uses
-   * vp1 as its starting point (the current connectivity sums), and puts
-   * the new sums in vp2.  Note that vp1 is modified along the way.
+   * This computes "extended connectivity sums" similar to those described
+   * by Weininger, Morgan, etc.: each atom's neighbors' class ID's are
+   * sorted into ascending order, and (c0 + c1*10^2 + c2*10^4 + ...) becomes
+   * the new class ID (where c0 is the current classID).
    *
    * Note that, per Weininger's warning, this assumes the initial class
    * ID's are less than 100, which is a BAD assumption, e.g. OCC...CCN
    * would have more than 100 symmetry classes if the chain is more than
-   * 98 carbons long.  Should change this to use Weininger's product of
-   * corresponding primes.
+   * 98 carbons long.  The sums wrap around at 2^32; as the symmetry classes
+   * and so the canonical labels depend on them they are kept as they are.
    */
-  void OBGraphSymPrivate::CreateNewClassVector(std::vector<std::pair<OBAtom*,unsigned int> > &vp1,
-                                        std::vector<std::pair<OBAtom*,unsigned int> > &vp2)
+  void OBGraphSymPrivate::ExtendClasses(const std::vector<unsigned int> &classes,
+                                        std::vector<unsigned int> &extended)
   {
-    int m,id;
-    OBAtom *atom, *nbr;
-    vector<OBBond*>::iterator nbr_iter;
-    vector<unsigned int>::iterator k;
-    vector<pair<OBAtom*,unsigned int> >::iterator vp_iter;
-
-#if DEBUG2
-    cout << "CreateNewClassVector: START\n";
-    //print_vector_pairs("    ", vp1);
-#endif
-
-    // There may be fewer atoms than in the whole molecule, so we can't
-    // index the vp1 array by atom->GetIdx().  Instead, create a quick
-    // mapping vector of idx-to-index for vp1.
-    vector<int> idx2index(_pmol->NumAtoms() + 1, -1);  // natoms + 1
-    int index = 0;
-    for (vp_iter = vp1.begin(); vp_iter != vp1.end(); ++vp_iter) {
-      int idx = vp_iter->first->GetIdx();
-      idx2index[idx] = index++;
-    }
-
-    // vp2 will hold the newly-extended symmetry classes
-    vp2.resize(vp1.size());
-    vp2.clear();
-
-    // Loop over original atoms.
-    // Create a new extended varient for each atom.  Get its neighbors' class ID's,
-    // sort them into ascending order, and create a sum of (c0 + c1*10^2 + c2*10^4 + ...)
-    // which becomes the new class ID (where c0 is the current classID).
-
-    for (vp_iter = vp1.begin(); vp_iter != vp1.end(); ++vp_iter) {
-      atom = vp_iter->first;
-      id   = vp_iter->second;
-      vector<unsigned int> vtmp;
-      for (nbr = atom->BeginNbrAtom(nbr_iter); nbr; nbr = atom->NextNbrAtom(nbr_iter)) {
-        int idx = nbr->GetIdx();
-        if (_frag_atoms.BitIsSet(idx))
-          vtmp.push_back(vp1[idx2index[idx]].second);
-      }
-
-      sort(vtmp.begin(),vtmp.end(),CompareUnsigned);
-      for (m = 100, k = vtmp.begin(); k != vtmp.end(); ++k, m*=100)
-        id += *k * m;
-      vp2.push_back(pair<OBAtom*,unsigned int> (atom, id));
+    extended.resize(classes.size());
+    for (unsigned int p = 0; p < classes.size(); ++p) {
+      _nbrClasses.clear();
+      for (unsigned int k = _nbrStart[p]; k < _nbrStart[p+1]; ++k)
+        _nbrClasses.push_back(classes[_nbrs[k]]);
+      sort(_nbrClasses.begin(), _nbrClasses.end());
+
+      unsigned int id = classes[p], m = 100;
+      for (unsigned int k = 0; k < _nbrClasses.size(); ++k, m *= 100)
+        id += _nbrClasses[k] * m;
+      extended[p] = id;
     }
-#if DEBUG2
-    cout << "CreateNewClassVector: FINISH\n";
-    //print_vector_pairs("    ", vp2);
-#endif
   }
 
-  void OBGraphSymPrivate::CreateNewClassVector(OBMol *mol, std::vector<std::pair<OBAtom*,unsigned int> > &vp1,
-      std::vector<std::pair<OBAtom*,unsigned int> > &vp2)
+  struct CompareClasses
   {
-    int m,id;
-    OBAtom *atom, *nbr;
-    vector<OBBond*>::iterator nbr_iter;
-    vector<unsigned int>::iterator k;
-    vector<pair<OBAtom*,unsigned int> >::iterator vp_iter;
-
-#if DEBUG2
-    cout << "CreateNewClassVector: START\n";
-    //print_vector_pairs("    ", vp1);
-#endif
-
-    // There may be fewer atoms than in the whole molecule, so we can't
-    // index the vp1 array by atom->GetIdx().  Instead, create a quick
-    // mapping vector of idx-to-index for vp1.
-    vector<int> idx2index(mol->NumAtoms() + 1, -1);  // natoms + 1
-    int index = 0;
-    for (vp_iter = vp1.begin(); vp_iter != vp1.end(); ++vp_iter) {
-      int idx = vp_iter->first->GetIdx();
-      idx2index[idx] = index++;
+    const std::vector<unsigned int> &classes;
+    CompareClasses(const std::vector<unsigned int> &c) : classes(c) {}
+    bool operator()(unsigned int a, unsigned int b) const
+    {
+      return classes[a] < classes[b];
     }
-
-    // vp2 will hold the newly-extended symmetry classes
-    vp2.resize(vp1.size());
-    vp2.clear();
-
-    // Loop over original atoms.
-    // Create a new extended varient for each atom.  Get its neighbors' class ID's,
-    // sort them into ascending order, and create a sum of (c0 + c1*10^2 + c2*10^4 + ...)
-    // which becomes the new class ID (where c0 is the current classID).
-
-    for (vp_iter = vp1.begin(); vp_iter != vp1.end(); ++vp_iter) {
-      atom = vp_iter->first;
-      id   = vp_iter->second;
-      vector<unsigned int> vtmp;
-      for (nbr = atom->BeginNbrAtom(nbr_iter); nbr; nbr = atom->NextNbrAtom(nbr_iter)) {
-        int idx = nbr->GetIdx();
-        vtmp.push_back(vp1[idx2index[idx]].second);
-      }
-
-      sort(vtmp.begin(),vtmp.end(),CompareUnsigned);
-      for (m = 100, k = vtmp.begin(); k != vtmp.end(); ++k, m*=100)
-        id += *k * m;
-      vp2.push_back(pair<OBAtom*,unsigned int> (atom, id));
-    }
-#if DEBUG2
-    cout << "CreateNewClassVector: FINISH\n";
-    //print_vector_pairs("    ", vp2);
-#endif
-
-  }
+  };
 
   /**
-   * Counts the number of unique symmetry classes in a list.
-   *
-   * (NOTE: CJ -- It also appears to MODIFY the list.  It sorts it in order
-   * of class ID, then renumbers the ID's zero through N-1.  See the comments
-   * in CreateNewClassVector() about how it returns very large numbers for the
-   * class IDs it creates.  These are replaced by lower, sequential numbers here.)
+   * Counts the number of unique symmetry classes in a list, and
+   * renumbers them 1 through N in order of class ID (see the comments in
+   * ExtendClasses() about how it returns very large numbers for the class
+   * IDs it creates).  If the smallest class ID is 0, the classes are left
+   * as they are and 1 is returned.
    */
-  void OBGraphSymPrivate::CountAndRenumberClasses(std::vector<std::pair<OBAtom*,unsigned int> > &vp,
-                                           unsigned int &count)
+  unsigned int OBGraphSymPrivate::RenumberClasses(std::vector<unsigned int> &classes)
   {
-    count = 1;
-    vector<pair<OBAtom*,unsigned int> >::iterator k;
-
-    sort(vp.begin(), vp.end(), ComparePairSecond);
-    k = vp.begin();
-    if (k != vp.end()) {
-      unsigned int id = k->second;
-      if (id) {
-      k->second = 1;
-      ++k;
-      for (;k != vp.end(); ++k) {
-        if (k->second != id) {
-          id = k->second;
-          k->second = ++count;
-        } else {
-          k->second = count;
-        }
-      }
+    _order.resize(classes.size());
+    for (unsigned int p = 0; p < _order.size(); ++p)
+      _order[p] = p;
+    sort(_order.begin(), _order.end(), CompareClasses(classes));
+
+    unsigned int count = 1;
+    if (_order.empty() || !classes[_order[0]])
+      return count;
+
+    unsigned int id = classes[_order[0]];
+    classes[_order[0]] = 1;
+    for (unsigned int k = 1; k < _order.size(); ++k) {
+      unsigned int &c = classes[_order[k]];
+      if (c != id) {
+        id = c;
+        ++count;
       }
+      c = count;
     }
+    return count;
   }
 
   /**
@@ -490,44 +410,42 @@ namespace OpenBabel {
    * until a stable solution is found (further spreading doesn't
    * change the answer).
    *
+   * The classes are indexed by position in the fragment (see
+   * BuildFragmentGraph()); each round is a pass over the flattened
+   * neighbor lists and a sort of the atom positions.
+   *
    * @return The number of distinct symmetry classes found.
    */
-  int OBGraphSymPrivate::ExtendInvariants(std::vector<std::pair<OBAtom*, unsigned int> > &symmetry_classes)
+  int OBGraphSymPrivate::ExtendInvariants(std::vector<unsigned int> &symmetry_classes)
   {
     unsigned int nclasses1, nclasses2;
-    vector<pair<OBAtom*,unsigned int> > tmp_classes;
+    vector<unsigned int> tmp_classes;
 
-    // How many classes are we starting with?  (The "renumber" part isn't relevant.)
-    CountAndRenumberClasses(symmetry_classes, nclasses1);
+    // How many classes are we starting with?
+    nclasses1 = RenumberClasses(symmetry_classes);
 
     unsigned int nfragatoms = _frag_atoms.CountBits();
 
     // LOOP: Do extended sum-of-invarients until no further changes are
-    // noted.  (Note: This is inefficient, as it re-computes extended sums
-    // and re-sorts the entire list each time.  You can save a lot of time by
-    // only recomputing and resorting within regions where there is a tie
-    // initially.  But it's a lot more code.)
-
+    // noted.
     if (nclasses1 < nfragatoms) {
       for (int i = 0; i < 100;i++) {  //sanity check - shouldn't ever hit this number
-        CreateNewClassVector(symmetry_classes, tmp_classes);
-        CountAndRenumberClasses(tmp_classes, nclasses2);
-        symmetry_classes = tmp_classes;
+        ExtendClasses(symmetry_classes, tmp_classes);
+        nclasses2 = RenumberClasses(tmp_classes);
+        symmetry_classes.swap(tmp_classes);
         if (nclasses1 == nclasses2) break;
         nclasses1 = nclasses2;
       }
     }
 
-    CreateNewClassVector(symmetry_classes, tmp_classes);
-    CountAndRenumberClasses(tmp_classes, nclasses2);
-
+    ExtendClasses(symmetry_classes, tmp_classes);
+    nclasses2 = RenumberClasses(tmp_classes);
 
     if (nclasses1 != nclasses2) {
-      symmetry_classes = tmp_classes;
+      symmetry_classes.swap(tmp_classes);
       return ExtendInvariants(symmetry_classes);
     }
 
-
     return nclasses1;
   }
 
@@ -548,23 +466,16 @@ namespace OpenBabel {
   int OBGraphSymPrivate::CalculateSymmetry(std::vector<unsigned int> &atom_sym_classes)
   {
     vector<unsigned int> vgi;
-    vector<OBNodeBase*>::iterator j;
-    OBAtom *atom;
+
+    BuildFragmentGraph();
 
     // Get vector of graph invariants.  These are the starting "symmetry classes".
     GetGIVector(vgi);
 
-
-    // Create a vector-of-pairs, associating each atom with its Class ID.
-    std::vector<std::pair<OBAtom*, unsigned int> > symmetry_classes;
-    for (atom = _pmol->BeginAtom(j); atom; atom = _pmol->NextAtom(j)) {
-      int idx = atom->GetIdx();
-      if (_frag_atoms.BitIsSet(idx))
-        symmetry_classes.push_back(pair<OBAtom*, unsigned int> (atom, vgi[idx-1]));
-      //else
-      //  symmetry_classes.push_back(pair<OBAtom*, unsigned int> (atom, OBGraphSym::NoSymmetryClass));
-    }
-
+    // The class ID of each fragment atom, by position in the fragment
+    std::vector<unsigned int> symmetry_classes(_atoms.size());
+    for (unsigned int p = 0; p < _atoms.size(); ++p)
+      symmetry_classes[p] = vgi[_atoms[p]->GetIndex()];
 
     // The heart of the matter: Do extended sum-of-invariants until no further
     // changes are noted.
@@ -574,9 +485,8 @@ namespace OpenBabel {
     // Atoms not in the fragment will have a value of OBGraphSym::NoSymmetryClass
     atom_sym_classes.clear();
     atom_sym_classes.resize(_pmol->NumAtoms(), OBGraphSym::NoSymmetryClass);
-    for (unsigned int i = 0; i < symmetry_classes.size(); ++i) {
-      atom_sym_classes[symmetry_classes.at(i).first->GetIndex()] = symmetry_classes.at(i).second;
-    }
+    for (unsigned int p = 0; p < _atoms.size(); ++p)
+      atom_sym_classes[_atoms[p]->GetIndex()] = symmetry_classes[p];
 
     // Store the symmetry classes in an OBPairData
     stringstream temp;
@@ -623,14 +533,12 @@ namespace OpenBabel {
 
   int OBGraphSymPrivate::Iterate(vector<unsigned int> &symClasses)
   {
-    // Create a vector-of-pairs, associating each atom with its Class ID.
-    vector<OBAtom*>::iterator j;
-    std::vector<std::pair<OBAtom*, unsigned int> > symmetry_classes;
-    for (OBAtom *atom = _pmol->BeginAtom(j); atom; atom = _pmol->NextAtom(j)) {
-      int idx = atom->GetIdx();
-      if (_frag_atoms.BitIsSet(idx))
-        symmetry_classes.push_back(pair<OBAtom*, unsigned int> (atom, symClasses[idx-1]));
-    }
+    BuildFragmentGraph();
+
+    // The class ID of each fragment atom, by position in the fragment
+    std::vector<unsigned int> symmetry_classes(_atoms.size());
+    for (unsigned int p = 0; p < _atoms.size(); ++p)
+      symmetry_classes[p] = symClasses[_atoms[p]->GetIndex()];
 
     // The heart of the matter: Do extended sum-of-invariants until no further
     // changes are noted.
@@ -640,9 +548,8 @@ namespace OpenBabel {
     // Atoms not in the fragment will have a value of OBGraphSym::NoSymmetryClass
     symClasses.clear();
     symClasses.resize(_pmol->NumAtoms(), OBGraphSym::NoSymmetryClass);
-    for (unsigned int i = 0; i < symmetry_classes.size(); ++i) {
-      symClasses[symmetry_classes.at(i).first->GetIndex()] = symmetry_classes.at(i).second;
-    }
+    for (unsigned int p = 0; p < _atoms.size(); ++p)
+      symClasses[_atoms[p]->GetIndex()] = symmetry_classes[p];
 
     return nclasses;
   }
@@ -23,46 +23,48 @@ GNU General Public License for more details.
 #include <openbabel/bond.h>
 #include <openbabel/obiter.h>
 #include <openbabel/kekulize.h>
-#include <cstdlib>
-#include <cstring>
+#include <algorithm>
+#include <vector>
 
 namespace OpenBabel
 {
-  static unsigned int GetMaxAtomIdx(OBMol* mol)
+  // Per-thread storage reused by every call, so that kekulizing a molecule
+  // only allocates when it is larger than any kekulized before
+  struct KekulizeWorkspace
   {
-    return mol->NumAtoms() + 1;
-  }
+    std::vector<char> needs;           // atoms still needing a double bond, by idx
+    std::vector<char> doubleBonds;     // assigned double bonds, by bond idx
+    std::vector<unsigned int> degrees; // unmatched pi neighbours, by atom idx
+    std::vector<unsigned int> start;   // CSR offsets into nbrs/bonds, by atom idx
+    std::vector<unsigned int> nbrs;    // pi-subgraph neighbour atom idx
+    std::vector<unsigned int> bonds;   // ...and the bond idx leading to it
+    std::vector<unsigned int> stack;   // atoms awaiting degree one matching
+    std::vector<unsigned int> visited; // stamp of the search that visited an atom
+    unsigned int stamp;
+    std::vector<unsigned int> path;    // atoms on the current alternating path
+    std::vector<unsigned int> next;    // ...and the next CSR entry to try at each
+    KekulizeWorkspace() : stamp(0) {}
+  };
 
-  static unsigned int GetMaxBondIdx(OBMol* mol)
-  {
-    return mol->NumBonds();
-  }
+  static THREAD_LOCAL KekulizeWorkspace kekulizeWorkspace;
 
   class Kekulizer
   {
   public:
-    Kekulizer(OBMol* mol) : m_mol(mol), needs_dbl_bond((OBBitVec*)0), doubleBonds((OBBitVec*)0), kekule_system((OBBitVec*)0)
-    {
-      atomArraySize = GetMaxAtomIdx(m_mol) + 1;
-      bondArraySize = GetMaxBondIdx(m_mol) + 1;
-    }
-    ~Kekulizer() {
-      delete needs_dbl_bond;
-      delete doubleBonds;
-      delete kekule_system;
-    }
+    Kekulizer(OBMol* mol, KekulizeWorkspace &ws) : m_mol(mol), m_ws(ws),
+      atomArraySize(mol->NumAtoms() + 1), bondArraySize(mol->NumBonds())
+    { }
     bool GreedyMatch();
     bool BackTrack();
     void AssignDoubleBonds();
   private:
-    bool FindPath(unsigned int atomidx, bool isDoubleBond, OBBitVec &visited);
+    void BuildPiGraph();
+    void MatchBond(unsigned int atomIdx, unsigned int nbrIdx, unsigned int bondIdx, bool both);
+    bool FindPath(unsigned int atomidx);
     OBMol* m_mol;
-    OBBitVec *needs_dbl_bond;
-    OBBitVec *doubleBonds;
-    OBBitVec *kekule_system;
+    KekulizeWorkspace &m_ws;
     unsigned int atomArraySize;
     unsigned int bondArraySize;
-    std::vector<unsigned int> m_path;
   };
 
   static bool IsSpecialCase(OBAtom* atom)
@@ -141,167 +143,120 @@ namespace OpenBabel
     return true; // It needs a double bond
   }
 
-  class NodeIterator
+  void Kekulizer::AssignDoubleBonds()
   {
-  public:
-    NodeIterator(unsigned int *&degrees, unsigned int atomArraySize) :
-      m_degrees(degrees), m_atomArraySize(atomArraySize),
-      m_counter(0), finishedDegTwo(false)
-    { }
-    unsigned int next()
-    {
-      m_counter++;
-
-      if (!finishedDegTwo) { // return deg 2 nodes first
-        for (; m_counter < m_atomArraySize; ++m_counter) {
-          if (m_degrees[m_counter] == 2) {
-            return m_counter;
-          }
-        }
-        finishedDegTwo = true;
-        m_counter = 1; // first atom has idx 1
-      }
+    for (unsigned int i = 0; i < bondArraySize; ++i)
+      if (m_ws.doubleBonds[i])
+        m_mol->GetBond(i)->SetBondOrder(2);
+  }
 
-      // return nodes with degree > 2
-      for (; m_counter < m_atomArraySize; ++m_counter) {
-        if (m_degrees[m_counter] > 2) {
-          return m_counter;
-        }
-      }
+  // Flatten the aromatic bonds between atoms that need a double bond into
+  // a neighbour list, in the atoms' own bond order. This is the only part
+  // of the kekule system that GreedyMatch() and BackTrack() traverse.
+  void Kekulizer::BuildPiGraph()
+  {
+    std::vector<char> &needs = m_ws.needs;
+    needs.assign(atomArraySize, 0);
+    FOR_ATOMS_OF_MOL(atom, m_mol) {
+      if (NeedsDoubleBond(&*atom))
+        needs[atom->GetIdx()] = 1;
+    }
 
-      // Finished - return 0 signalling the end of iteration
-      return 0;
+    m_ws.start.assign(atomArraySize + 1, 0);
+    m_ws.degrees.assign(atomArraySize, 0);
+    m_ws.nbrs.clear();
+    m_ws.bonds.clear();
+    m_ws.stack.clear();
+    for (unsigned int idx = 1; idx < atomArraySize; ++idx) {
+      m_ws.start[idx] = m_ws.nbrs.size();
+      if (!needs[idx])
+        continue;
+      OBAtom *atom = m_mol->GetAtom(idx);
+      FOR_BONDS_OF_ATOM(bond, atom) {
+        if (!bond->IsAromatic()) continue;
+        unsigned int nbrIdx = bond->GetNbrAtomIdx(atom);
+        if (!needs[nbrIdx]) continue;
+        m_ws.nbrs.push_back(nbrIdx);
+        m_ws.bonds.push_back(bond->GetIdx());
+      }
+      m_ws.degrees[idx] = m_ws.nbrs.size() - m_ws.start[idx];
+      if (m_ws.degrees[idx] == 1)
+        m_ws.stack.push_back(idx);
     }
-  private:
-    unsigned int *&m_degrees; 
-    unsigned int m_atomArraySize;
-    unsigned int m_counter;
-    bool finishedDegTwo;
-  };
+    m_ws.start[atomArraySize] = m_ws.nbrs.size();
+  }
 
-  void Kekulizer::AssignDoubleBonds()
+  // Make a double bond between atomIdx and nbrIdx and update the degrees
+  // of the neighbours of nbrIdx (and of atomIdx, if both)
+  void Kekulizer::MatchBond(unsigned int atomIdx, unsigned int nbrIdx, unsigned int bondIdx, bool both)
   {
-    int bit;
-    for (bit = doubleBonds->FirstBit(); bit != doubleBonds->EndBit(); bit = doubleBonds->NextBit(bit)) {
-      m_mol->GetBond(bit)->SetBondOrder(2);
+    std::vector<char> &needs = m_ws.needs;
+    m_ws.doubleBonds[bondIdx] = 1;
+    needs[atomIdx] = 0;
+    needs[nbrIdx] = 0;
+    for (int N = both ? 0 : 1; N < 2; N++) {
+      unsigned int ref = N == 0 ? atomIdx : nbrIdx;
+      for (unsigned int j = m_ws.start[ref]; j < m_ws.start[ref + 1]; ++j) {
+        unsigned int nbrnbrIdx = m_ws.nbrs[j];
+        if (m_ws.bonds[j] == bondIdx || !needs[nbrnbrIdx]) continue;
+        if (--m_ws.degrees[nbrnbrIdx] == 1)
+          m_ws.stack.push_back(nbrnbrIdx);
+      }
     }
   }
 
   bool Kekulizer::GreedyMatch()
   {
-
     // What atoms need a double bond? The job of kekulization is
     // to give all of these atoms a single double bond.
-    needs_dbl_bond = new OBBitVec(atomArraySize); // defaults to all False
-    FOR_ATOMS_OF_MOL(atom, m_mol) {
-      if (NeedsDoubleBond(&*atom)) {
-        needs_dbl_bond->SetBitOn(atom->GetIdx());
-      }
-    }
-    // Make a copy of needs_dbl_bond, to restrict the traversal in BackTrack()
-    kekule_system = new OBBitVec(*needs_dbl_bond);
+    BuildPiGraph();
+    std::vector<char> &needs = m_ws.needs;
+    std::vector<unsigned int> &degrees = m_ws.degrees;
 
-    // Create lookup of degrees
-    unsigned int *degrees = (unsigned int*)malloc(sizeof(unsigned int)*atomArraySize);
-    memset(degrees, 0, sizeof(unsigned int)*atomArraySize);
-    std::vector<OBAtom*> degreeOneAtoms;
-    FOR_ATOMS_OF_MOL(atom, m_mol) {
-      unsigned int atom_idx = atom->GetIdx();
-      if (!needs_dbl_bond->BitIsSet(atom_idx)) {
-        degrees[atom_idx] = 0;
-        continue;
-      }
-      unsigned int mdeg = 0;
-      FOR_BONDS_OF_ATOM(bond, &*atom) {
-        if (!bond->IsAromatic()) continue;
-        OBAtom *nbr = bond->GetNbrAtom(&*atom);
-        if (needs_dbl_bond->BitIsSet(nbr->GetIdx()))
-          mdeg++;
-      }
-      degrees[atom_idx] = mdeg;
-      if (mdeg == 1)
-        degreeOneAtoms.push_back(&*atom);
-    }
-    
     // Location of assigned double bonds
-    doubleBonds = new OBBitVec(bondArraySize); // defaults to all False
+    m_ws.doubleBonds.assign(bondArraySize, 0);
 
     bool finished = false;
     while (true) { // Main loop
-      
+
       // Complete all of the degree one nodes
-      while (!degreeOneAtoms.empty()) {
-        OBAtom* atom = degreeOneAtoms.back();
-        degreeOneAtoms.pop_back();
+      while (!m_ws.stack.empty()) {
+        unsigned int atomIdx = m_ws.stack.back();
+        m_ws.stack.pop_back();
         // some nodes may already have been handled
-        if (!needs_dbl_bond->BitIsSet(atom->GetIdx())) continue;
-        FOR_BONDS_OF_ATOM(bond, atom) {
-          if (!bond->IsAromatic()) continue;
-          OBAtom *nbr = bond->GetNbrAtom(&*atom);
-          if (!needs_dbl_bond->BitIsSet(nbr->GetIdx())) continue;
-          // create a double bond from atom -> nbr
-          doubleBonds->SetBitOn(bond->GetIdx());
-          needs_dbl_bond->SetBitOff(atom->GetIdx());
-          needs_dbl_bond->SetBitOff(nbr->GetIdx());
-          // now update degree information for nbr's neighbors
-          FOR_BONDS_OF_ATOM(nbrbond, nbr) {
-            if (&(*nbrbond) == &(*bond) || !nbrbond->IsAromatic()) continue;
-            OBAtom* nbrnbr = nbrbond->GetNbrAtom(nbr);
-            unsigned int nbrnbrIdx = nbrnbr->GetIdx();
-            if (!needs_dbl_bond->BitIsSet(nbrnbrIdx)) continue;
-            degrees[nbrnbrIdx]--;
-            if (degrees[nbrnbrIdx] == 1)
-              degreeOneAtoms.push_back(nbrnbr);
-          }
+        if (!needs[atomIdx]) continue;
+        for (unsigned int j = m_ws.start[atomIdx]; j < m_ws.start[atomIdx + 1]; ++j) {
+          if (!needs[m_ws.nbrs[j]]) continue;
           // only a single double bond can be made to atom so we can break here
+          MatchBond(atomIdx, m_ws.nbrs[j], m_ws.bonds[j], false);
           break;
         }
       }
-      
-      if (needs_dbl_bond->IsEmpty()) {
+
+      if (std::find(needs.begin(), needs.end(), 1) == needs.end()) {
         finished = true;
         break;
       }
 
-      // Now handle any remaining degree 2 or 3 nodes
-      // We handle deg 2 nodes first and then 3, and the iteration over these nodes
-      // is abstracted away. Once a double-bond is added that generates more
-      // degree one nodes, then the iterator is exited
-      NodeIterator iterator(degrees, atomArraySize);
+      // Now handle any remaining degree 2 or 3 nodes, degree 2 first.
+      // Once a double bond is added that generates more degree one
+      // nodes, go back to handling those.
       bool change = false;
-      while (unsigned int atomIdx = iterator.next()) {
-        if (!needs_dbl_bond->BitIsSet(atomIdx)) continue;
-        // The following is almost identical to the code above for deg 1 atoms
-        // except for handling the variable 'change'
-        OBAtom *atom = m_mol->GetAtom(atomIdx);
-        FOR_BONDS_OF_ATOM(bond, atom) {
-          if (!bond->IsAromatic()) continue;
-          OBAtom *nbr = bond->GetNbrAtom(&*atom);
-          if (!needs_dbl_bond->BitIsSet(nbr->GetIdx())) continue;
-          // create a double bond from atom -> nbr
-          doubleBonds->SetBitOn(bond->GetIdx());
-          needs_dbl_bond->SetBitOff(atomIdx);
-          needs_dbl_bond->SetBitOff(nbr->GetIdx());
-          // now update degree information for both atom's and nbr's neighbors
-          for(int N=0; N<2; N++) {
-            OBAtom *ref = N == 0 ? atom : nbr;
-            FOR_BONDS_OF_ATOM(nbrbond, ref) {
-              if (&(*nbrbond) == &(*bond) || !nbrbond->IsAromatic()) continue;
-              OBAtom* nbrnbr = nbrbond->GetNbrAtom(ref);
-              unsigned int nbrnbrIdx = nbrnbr->GetIdx();
-              if (!needs_dbl_bond->BitIsSet(nbrnbrIdx)) continue;
-              degrees[nbrnbrIdx]--;
-              if (degrees[nbrnbrIdx] == 1) {
-                degreeOneAtoms.push_back(nbrnbr);
-                change = true;
-              }
-            }
+      for (int pass = 0; pass < 2 && !change; ++pass) {
+        for (unsigned int atomIdx = 1; atomIdx < atomArraySize; ++atomIdx) {
+          if (pass == 0 ? degrees[atomIdx] != 2 : degrees[atomIdx] <= 2) continue;
+          if (!needs[atomIdx]) continue;
+          std::size_t pending = m_ws.stack.size();
+          for (unsigned int j = m_ws.start[atomIdx]; j < m_ws.start[atomIdx + 1]; ++j) {
+            if (!needs[m_ws.nbrs[j]]) continue;
+            MatchBond(atomIdx, m_ws.nbrs[j], m_ws.bonds[j], true);
+            break;
+          }
+          if (m_ws.stack.size() != pending) {
+            change = true;
+            break; // exit the iteration once we have actually set a double bond
           }
-          // only a single double bond can be made to atom so we can break here
-          break;
         }
-        if (change)
-          break; // exit the iterator once we have actually set a double bond
       }
 
       // We exit if we are finished or if no degree 2/3 nodes can be set
@@ -309,45 +264,67 @@ namespace OpenBabel
         break;
     }
 
-    // Tidy up
-    free(degrees);
-
     return finished;
   }
 
-  // The isDoubleBond alternates between double and single, as we need to find
-  // an alternating path
-  bool Kekulizer::FindPath(unsigned int atomidx, bool isDoubleBond, OBBitVec &visited)
+  // Search depth-first for a path of alternating single and double bonds
+  // from atomidx to an atom that needs a double bond, leaving it in m_ws.path.
+  // Atoms are unmarked again on backtracking, so the search is exhaustive.
+  bool Kekulizer::FindPath(unsigned int atomidx)
   {
-    if (needs_dbl_bond->BitIsSet(atomidx))
-      return true;
-    visited.SetBitOn(atomidx);
-    OBAtom* atom = m_mol->GetAtom(atomidx);
-    FOR_BONDS_OF_ATOM(bond, atom) {
-      if (!bond->IsAromatic()) continue;
-      OBAtom *nbr = bond->GetNbrAtom(atom);
-      if (!kekule_system->BitIsSet(nbr->GetIdx())) continue;
-      if (doubleBonds->BitIsSet(bond->GetIdx()) == isDoubleBond) {
-        if (visited.BitIsSet(nbr->GetIdx())) continue;
-        bool found_path = FindPath(nbr->GetIdx(), !isDoubleBond, visited);
-        if (found_path) {
-          m_path.push_back(nbr->GetIdx());
+    std::vector<unsigned int> &path = m_ws.path;
+    std::vector<unsigned int> &next = m_ws.next;
+    std::vector<unsigned int> &visited = m_ws.visited;
+    if (++m_ws.stamp == 0) { // wrapped around
+      std::fill(visited.begin(), visited.end(), 0);
+      m_ws.stamp = 1;
+    }
+    const unsigned int stamp = m_ws.stamp;
+    path.assign(1, atomidx);
+    next.assign(1, m_ws.start[atomidx]);
+    visited[atomidx] = stamp;
+
+    while (!path.empty()) {
+      unsigned int cur = path.back();
+      // The first bond out of the start atom is single, then they alternate
+      const char isDoubleBond = (path.size() % 2) == 0;
+      unsigned int &j = next.back();
+      bool descended = false;
+      for (; j < m_ws.start[cur + 1]; ++j) {
+        unsigned int nbrIdx = m_ws.nbrs[j];
+        if (m_ws.doubleBonds[m_ws.bonds[j]] != isDoubleBond) continue;
+        if (visited[nbrIdx] == stamp) continue;
+        if (m_ws.needs[nbrIdx]) {
+          path.push_back(nbrIdx);
           return true;
         }
+        visited[nbrIdx] = stamp;
+        ++j;
+        path.push_back(nbrIdx);
+        next.push_back(m_ws.start[nbrIdx]); // j is invalid from here
+        descended = true;
+        break;
       }
+      if (descended)
+        continue;
+      visited[cur] = 0;
+      path.pop_back();
+      next.pop_back();
     }
-    visited.SetBitOff(atomidx);
     return false;
   }
 
   bool Kekulizer::BackTrack()
   {
+    std::vector<char> &needs = m_ws.needs;
     // With an odd number of bits, it's never going to kekulize fully, but let's fill in as many as we can
-    unsigned int count = needs_dbl_bond->CountBits();
+    unsigned int count = std::count(needs.begin(), needs.end(), 1);
+    if (m_ws.visited.size() < atomArraySize)
+      m_ws.visited.resize(atomArraySize, 0);
 
     unsigned int total_handled = 0;
-    int idx;
-    for (idx = needs_dbl_bond->FirstBit(); idx != needs_dbl_bond->EndBit(); idx = needs_dbl_bond->NextBit(idx)) {
+    for (unsigned int idx = 1; idx < atomArraySize; ++idx) {
+      if (!needs[idx]) continue;
       total_handled++;
       // If there is no additional bit available to match this bit, then terminate
       if (total_handled == count)
@@ -355,27 +332,21 @@ namespace OpenBabel
 
       // Our goal is to find an alternating path to another atom
       // that needs a double bond
-      needs_dbl_bond->SetBitOff(idx); // to avoid the trivial null path being found
-      OBBitVec visited(atomArraySize);
-      m_path.clear();
-      bool found_path = FindPath(idx, false, visited);
-      if (!found_path) { // could only happen if not kekulizable
-        needs_dbl_bond->SetBitOn(idx); // reset
+      needs[idx] = 0; // to avoid the trivial null path being found
+      if (!FindPath(idx)) { // could only happen if not kekulizable
+        needs[idx] = 1; // reset
         continue;
       }
       total_handled++;
-      m_path.push_back(idx);
-      needs_dbl_bond->SetBitOff(m_path[0]);
+      const std::vector<unsigned int> &path = m_ws.path;
+      needs[path.back()] = 0;
       // Flip all of the bond orders on the path from double<-->single
-      for (unsigned int i = 0; i < m_path.size()-1; ++i) {
-        OBBond *bond = m_mol->GetBond(m_path[i], m_path[i + 1]);
-        if (i % 2 == 0)
-          doubleBonds->SetBitOn(bond->GetIdx());
-        else
-          doubleBonds->SetBitOff(bond->GetIdx());
+      for (unsigned int i = 0; i + 1 < path.size(); ++i) {
+        OBBond *bond = m_mol->GetBond(path[i], path[i + 1]);
+        m_ws.doubleBonds[bond->GetIdx()] = (i % 2 == 0);
       }
     }
-    return needs_dbl_bond->IsEmpty();
+    return std::find(needs.begin(), needs.end(), 1) == needs.end();
   }
 
 // I'd like to thank John Mayfield for many helpful discussions on the topic of
@@ -396,21 +367,21 @@ namespace OpenBabel
 // the use of Edmond's Blossom algorithm which scales better - this may or may not be
 // faster in practice for typical chemical graphs.
 //
+// Both steps work on a flattened copy of the pi subgraph (the aromatic bonds
+// between atoms that need a double bond) held in a per-thread workspace, so
+// that nothing is allocated once the workspace has grown to the size of the
+// molecule. The backtracking search is iterative rather than recursive.
+//
 // Potential speedups:
-//   * Is OBBitVec performant? I don't know - it seems to do a lot of bounds checking.
-//     You could try replacing all usages theoreof with
-//     std::vector<char>, where the char could possibly handle several flags.
 //   * Before trying the exhaustive search, try a BFS. I have a feeling that this would work
 //     90% of the time.
-//   * There's a lot of switching between atoms and atom indices (and similar for bonds).
-//     Was this completely necessary?
-//   * The iterator over degree 2 and 3 nodes may iterate twice - it would have been
+//   * The iteration over degree 2 and 3 nodes may iterate twice - it would have been
 //     faster if I just took the first degree 2 or 3 node I came across, but would
 //     it have worked as well?
 
   bool OBKekulize(OBMol* mol)
   {
-    Kekulizer kekulizer(mol);
+    Kekulizer kekulizer(mol, kekulizeWorkspace);
     bool success = kekulizer.GreedyMatch();
     if (!success) {
       success = kekulizer.BackTrack();
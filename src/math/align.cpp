@@ -20,6 +20,7 @@ GNU General Public License for more details.
 
 #include <vector>
 #include <climits> // UINT_MAX
+#include <cfloat>  // DBL_MAX
 
 #include <openbabel/math/align.h>
 #include <openbabel/atom.h>
@@ -250,22 +251,47 @@ namespace OpenBabel
     return coeff;
   }
 
+  /* QCP RMSD from the inner product matrix M and the sum of the
+     squared norms of the two centred coordinate sets.
+     Returns false if the root finder did not converge */
+  static bool QCPRMSD(const Eigen::Matrix3d &M, double innerprod, int N, double &rmsd)
+  {
+    vector<double> coeffs = CalcQuarticCoeffs(M);
+    // Maximum value for lambda is (Ga + Gb) / 2
+    double lambdamax = QCProot(coeffs, 0.5 * innerprod, 1e-6);
+    if (lambdamax > (0.5 * innerprod))
+      return false;
+
+    double sqrdev = innerprod - (2.0 * lambdamax);
+    rmsd = sqrdev > 0.0 ? sqrt(sqrdev / N) : 0.0;
+    return true;
+  }
+
+  /* Kabsch RMSD of two centred 3xN coordinate sets, used as a fallback
+     when QCP fails to converge */
+  static double KabschRMSD(const Eigen::Matrix3Xd &ref, const Eigen::Matrix3Xd &target)
+  {
+    Eigen::Matrix3d C = ref * target.transpose();
+#ifdef HAVE_EIGEN3
+    Eigen::JacobiSVD<Eigen::Matrix3d> svd(C, Eigen::ComputeFullU | Eigen::ComputeFullV);
+#else
+    Eigen::SVD<Eigen::Matrix3d> svd(C);
+#endif
+    Eigen::Matrix3d T = Eigen::Matrix3d::Identity();
+    T(2,2) = (C.determinant() > 0) ? 1. : -1.;
+    Eigen::Matrix3d rot = svd.matrixV() * T * svd.matrixU().transpose();
+    return sqrt((rot.transpose() * target - ref).squaredNorm() / ref.cols());
+  }
+
   void OBAlign::TheobaldAlign(const Eigen::MatrixXd &mtarget)
   {
     // M = B(t) times A (where A, B are N x 3 matrices)
     Eigen::Matrix3d M = mtarget * _mref.transpose();
 
-    // Maximum value for lambda is (Ga + Gb) / 2
     double innerprod = mtarget.squaredNorm() + _mref.squaredNorm();
 
-    vector<double> coeffs = CalcQuarticCoeffs(M);
-    double lambdamax = QCProot(coeffs, 0.5 * innerprod, 1e-6);
-    if (lambdamax > (0.5 * innerprod))
+    if (!QCPRMSD(M, innerprod, mtarget.cols(), _rmsd))
       _fail = true;
-    else {
-      double sqrdev = innerprod - (2.0 * lambdamax);
-      _rmsd = sqrt(sqrdev / mtarget.cols());
-    }
   }
 
   void OBAlign::SimpleAlign(const Eigen::MatrixXd &mtarget)
@@ -361,6 +387,99 @@ namespace OpenBabel
     return true;
   }
 
+  vector<double> OBAlign::GetRMSDMatrix(const OBMol &mol) const
+  {
+    vector<double> result;
+    // the conformer accessors of OBMol are not const, but only read here
+    OBMol &cmol = const_cast<OBMol&>(mol);
+    const int nconfs = cmol.NumConformers();
+    if (nconfs < 2)
+      return result;
+
+    // Sets up the fragment atoms and the automorphisms, once for all pairs,
+    // without touching the reference of this instance
+    OBAlign ensemble(_includeH, _symmetry);
+    ensemble.SetRefMol(mol);
+    const OBBitVec &frag_atoms = ensemble._frag_atoms;
+    const Automorphisms &aut = ensemble._aut;
+    const vector<unsigned int> &newidx = ensemble._newidx;
+    const int N = ensemble._refmol_coords.size();
+    const unsigned int natoms = mol.NumAtoms();
+
+    // Centred coordinates and squared norms of every conformer
+    vector<Eigen::Matrix3Xd> confs(nconfs);
+    vector<double> norms(nconfs);
+    for (int c = 0; c < nconfs; ++c) {
+      const double *xyz = cmol.GetConformer(c);
+      Eigen::Matrix3Xd &m = confs[c];
+      m.resize(3, N);
+      int col = 0;
+      for (unsigned int i = 1; i <= natoms; ++i)
+        if (frag_atoms.BitIsSet(i))
+          m.col(col++) = Eigen::Vector3d(xyz + 3 * (i - 1));
+      Eigen::Vector3d centroid = m.rowwise().sum() / N;
+      m.colwise() -= centroid;
+      norms[c] = m.squaredNorm();
+    }
+
+    // Column permutation of the target for each automorphism
+    vector<vector<int> > perms;
+    if (_symmetry && aut.size() > 1) {
+      perms.resize(aut.size());
+      for (unsigned int k = 0; k < aut.size(); ++k) {
+        perms[k].resize(N);
+        unsigned int i = 0;
+        for (unsigned int j = 1; j <= natoms; ++j) {
+          if (frag_atoms.BitIsSet(j)) {
+            for (std::size_t l = 0; l < aut[k].size(); ++l)
+              if (aut[k][l].first == j - 1) {
+                perms[k][i] = newidx[aut[k][l].second];
+                break;
+              }
+            i++;
+          }
+        }
+      }
+    }
+    else {
+      perms.resize(1, vector<int>(N));
+      for (int i = 0; i < N; ++i)
+        perms[0][i] = i;
+    }
+
+    result.resize(nconfs * (nconfs - 1) / 2);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int a = 0; a < nconfs - 1; ++a) {
+      const Eigen::Matrix3Xd &ref = confs[a];
+      std::size_t idx = (std::size_t)a * nconfs - (std::size_t)a * (a + 1) / 2;
+      for (int b = a + 1; b < nconfs; ++b, ++idx) {
+        const Eigen::Matrix3Xd &target = confs[b];
+        const double innerprod = norms[a] + norms[b];
+        double best = DBL_MAX;
+        for (std::size_t k = 0; k < perms.size(); ++k) {
+          const vector<int> &perm = perms[k];
+          Eigen::Matrix3d M = Eigen::Matrix3d::Zero();
+          for (int i = 0; i < N; ++i)
+            M.noalias() += target.col(perm[i]) * ref.col(i).transpose();
+          double rmsd;
+          if (!QCPRMSD(M, innerprod, N, rmsd)) {
+            Eigen::Matrix3Xd permuted(3, N);
+            for (int i = 0; i < N; ++i)
+              permuted.col(i) = target.col(perm[i]);
+            rmsd = KabschRMSD(ref, permuted);
+          }
+          if (rmsd < best)
+            best = rmsd;
+        }
+        result[idx] = best;
+      }
+    }
+
+    return result;
+  }
+
   matrix3x3 OBAlign::GetRotMatrix()
   {
     if (!_ready) {
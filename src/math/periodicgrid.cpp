@@ -0,0 +1,144 @@
+/**********************************************************************
+periodicgrid.cpp - Neighbor search over points in a periodic cell
+
+This file is part of the Open Babel project.
+For more information, see <http://openbabel.org/>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+***********************************************************************/
+
+#include <openbabel/babelconfig.h>
+#include <openbabel/math/periodicgrid.h>
+
+#include <cmath>
+
+using namespace std;
+
+namespace OpenBabel
+{
+  static const int MaxBins = 1 << 20; // per axis, so a bin key fits in 63 bits
+  static const unsigned int NoPoint = ~0u;
+
+  OBPeriodicGrid::OBPeriodicGrid(const matrix3x3 &fracToCart, double cutoff)
+    : _fracToCart(fracToCart), _cutoffSq(cutoff * cutoff)
+  {
+    // Size the bins by the distance between opposite faces of the cell, so
+    // that points within the cutoff are at most _reach bins apart
+    double volume = fabs(fracToCart.determinant());
+    for (int i = 0; i < 3; ++i) {
+      vector3 face = cross(fracToCart.GetColumn((i + 1) % 3),
+                           fracToCart.GetColumn((i + 2) % 3));
+      double width = face.length() > 0.0 ? volume / face.length() : 0.0;
+      if (!(width > 0.0) || !(cutoff > 0.0)) {
+        _bins[i] = 1;
+        _reach[i] = 1;
+        continue;
+      }
+      double bins = floor(width / cutoff);
+      _bins[i] = bins < 1.0 ? 1 : (bins > MaxBins ? MaxBins : static_cast<int>(bins));
+      _reach[i] = static_cast<int>(ceil(cutoff * _bins[i] / width));
+      if (_reach[i] < 1)
+        _reach[i] = 1;
+    }
+  }
+
+  unsigned int OBPeriodicGrid::Add(const vector3 &frac)
+  {
+    vector3 wrapped;
+    int bin[3];
+    Locate(frac, wrapped, bin);
+
+    unsigned int index = static_cast<unsigned int>(_points.size());
+    _points.push_back(wrapped);
+    _next.push_back(NoPoint);
+    pair<unordered_map<unsigned long long, unsigned int>::iterator, bool> ins =
+      _heads.insert(make_pair(BinKey(bin), index));
+    if (!ins.second) { // prepend to the bin's chain
+      _next[index] = ins.first->second;
+      ins.first->second = index;
+    }
+    return index;
+  }
+
+  void OBPeriodicGrid::Clear()
+  {
+    _points.clear();
+    _next.clear();
+    _heads.clear();
+  }
+
+  void OBPeriodicGrid::GetNeighbors(const vector3 &frac, vector<Neighbor> &result) const
+  {
+    result.clear();
+    if (_points.empty())
+      return;
+
+    vector3 wrapped;
+    int home[3];
+    Locate(frac, wrapped, home);
+
+    // Each (bin, lattice translation) pair is visited once, also when the
+    // search reaches further than the cell and wraps onto the same bins
+    int bin[3], shift[3];
+    for (int dx = -_reach[0]; dx <= _reach[0]; ++dx) {
+      int bx = home[0] + dx;
+      shift[0] = bx >= 0 ? bx / _bins[0] : -((_bins[0] - 1 - bx) / _bins[0]);
+      bin[0] = bx - shift[0] * _bins[0];
+      for (int dy = -_reach[1]; dy <= _reach[1]; ++dy) {
+        int by = home[1] + dy;
+        shift[1] = by >= 0 ? by / _bins[1] : -((_bins[1] - 1 - by) / _bins[1]);
+        bin[1] = by - shift[1] * _bins[1];
+        for (int dz = -_reach[2]; dz <= _reach[2]; ++dz) {
+          int bz = home[2] + dz;
+          shift[2] = bz >= 0 ? bz / _bins[2] : -((_bins[2] - 1 - bz) / _bins[2]);
+          bin[2] = bz - shift[2] * _bins[2];
+
+          unordered_map<unsigned long long, unsigned int>::const_iterator head =
+            _heads.find(BinKey(bin));
+          if (head == _heads.end())
+            continue;
+          vector3 offset(shift[0] - wrapped.x(), shift[1] - wrapped.y(), shift[2] - wrapped.z());
+          for (unsigned int i = head->second; i != NoPoint; i = _next[i]) {
+            vector3 delta = _fracToCart * (_points[i] + offset);
+            if (delta.length_2() <= _cutoffSq) {
+              Neighbor n = { i, delta };
+              result.push_back(n);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  unsigned long long OBPeriodicGrid::BinKey(const int bin[3]) const
+  {
+    return (static_cast<unsigned long long>(bin[0]) << 42) |
+           (static_cast<unsigned long long>(bin[1]) << 21) |
+            static_cast<unsigned long long>(bin[2]);
+  }
+
+  void OBPeriodicGrid::Locate(const vector3 &frac, vector3 &wrapped, int bin[3]) const
+  {
+    double f[3];
+    for (int i = 0; i < 3; ++i) {
+      f[i] = frac[i] - floor(frac[i]);
+      if (!(f[i] < 1.0)) // rounding of tiny negative values, or NaN
+        f[i] = 0.0;
+      bin[i] = static_cast<int>(f[i] * _bins[i]);
+      if (bin[i] >= _bins[i])
+        bin[i] = _bins[i] - 1;
+    }
+    wrapped.Set(f);
+  }
+
+} // namespace OpenBabel
+
+//! \file periodicgrid.cpp
+//! \brief Neighbor search over points in a periodic cell
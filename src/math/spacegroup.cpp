@@ -352,6 +352,31 @@ namespace OpenBabel
     return res;
   }
 
+  void SpaceGroup::Transform(const vector<vector3> &coords, vector<vector3> &result) const
+  {
+    const size_t n = coords.size();
+    result.resize(n * m_transforms.size());
+    vector3 *out = n ? &result[0] : NULL;
+    transform3dIterator i, iend = m_transforms.end();
+    for (i = m_transforms.begin(); i != iend; ++i, out += n)
+      {
+        // Take the matrix and translation out of the transform once, then
+        // apply them to all the coordinates in one plain loop
+        const transform3d &t = **i;
+        vector3 shift = t * vector3(0., 0., 0.);
+        vector3 cx = t * vector3(1., 0., 0.) - shift;
+        vector3 cy = t * vector3(0., 1., 0.) - shift;
+        vector3 cz = t * vector3(0., 0., 1.) - shift;
+        for (size_t j = 0; j < n; ++j)
+          {
+            const vector3 &v = coords[j];
+            out[j].Set(cx.x() * v.x() + cy.x() * v.y() + cz.x() * v.z() + shift.x(),
+                       cx.y() * v.x() + cy.y() * v.y() + cz.y() * v.z() + shift.y(),
+                       cx.z() * v.x() + cy.z() * v.y() + cz.z() * v.z() + shift.z());
+          }
+      }
+  }
+
   /*!
    */
   transform3d const * SpaceGroup::BeginTransform(transform3dIterator &i) const
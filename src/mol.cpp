@@ -913,7 +913,8 @@ namespace OpenBabel
     }
 
     rd = (OBRingData *) GetData("SSSR");
-    rd->SetOrigin(perceived);
+    if (rd->GetOrigin() != perceived) // only written once, for concurrent queries
+      rd->SetOrigin(perceived);
     return(rd->GetData());
   }
 
@@ -930,7 +931,8 @@ namespace OpenBabel
     }
 
     rd = (OBRingData *) GetData("LSSR");
-    rd->SetOrigin(perceived);
+    if (rd->GetOrigin() != perceived) // only written once, for concurrent queries
+      rd->SetOrigin(perceived);
     return(rd->GetData());
   }
 
@@ -1310,8 +1312,8 @@ namespace OpenBabel
     //Copy all the OBGenericData, providing the new molecule, this,
     //for those classes like OBRotameterList which contain Atom pointers
     //OBGenericData classes can choose not to be cloned by returning NULL
-    vector<OBGenericData*>::iterator itr;
-    for(itr=src.BeginData();itr!=src.EndData();++itr)
+    vector<OBGenericData*>::const_iterator itr;
+    for(itr=source.GetData().begin();itr!=source.GetData().end();++itr)
       {
         OBGenericData* pCopiedData = (*itr)->Clone(this);
         SetData(pCopiedData);
@@ -2564,8 +2566,9 @@ namespace OpenBabel
                    bond.GetFlags()))
       return false;
     //copy the bond's generic data
-    OBDataIterator diter;
-    for(diter=bond.BeginData(); diter!=bond.EndData();++diter)
+    const vector<OBGenericData*> &vdata = static_cast<const OBBond&>(bond).GetData();
+    vector<OBGenericData*>::const_iterator diter;
+    for(diter=vdata.begin(); diter!=vdata.end();++diter)
       GetBond(NumBonds()-1)->CloneData(*diter);
     return true;
   }
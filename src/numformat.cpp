@@ -0,0 +1,117 @@
+/**********************************************************************
+numformat.cpp - Locale-independent fixed-width number formatting
+
+This file is part of the Open Babel project.
+For more information, see <http://openbabel.org/>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+***********************************************************************/
+
+#include <openbabel/babelconfig.h>
+#include <openbabel/numformat.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <clocale>
+
+using namespace std;
+namespace OpenBabel
+{
+  static const double powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+  };
+
+  static inline void AppendRightAligned(string& s, const char* begin, const char* end, int width)
+  {
+    int len = static_cast<int>(end - begin);
+    if (width > len)
+      s.append(width - len, ' ');
+    s.append(begin, end);
+  }
+
+  void AppendFixed(string& s, double value, int width, int precision, bool showSign)
+  {
+    if (precision >= 0 && precision <= 9 && fabs(value) < 1e9) { // also false for NaN
+      // Scaling is exact apart from one rounding of the product, so the
+      // digits are those printf would give unless the scaled value is within
+      // that rounding of a tie. The C library decides those.
+      double x = fabs(value) * powersOfTen[precision];
+      double whole = floor(x);
+      double frac = x - whole;
+      if (fabs(frac - 0.5) > x * 2.3e-16) {
+        unsigned long long digits = static_cast<unsigned long long>(whole) + (frac > 0.5 ? 1 : 0);
+        char buf[32];
+        char* end = buf + sizeof(buf);
+        char* p = end;
+        for (int i = 0; i < precision; ++i) {
+          *--p = static_cast<char>('0' + digits % 10);
+          digits /= 10;
+        }
+        if (precision > 0)
+          *--p = '.';
+        do {
+          *--p = static_cast<char>('0' + digits % 10);
+          digits /= 10;
+        } while (digits);
+        if (signbit(value))
+          *--p = '-';
+        else if (showSign)
+          *--p = '+';
+        AppendRightAligned(s, p, end, width);
+        return;
+      }
+    }
+
+    char buf[352]; // enough for the largest double in %f
+    int len = snprintf(buf, sizeof(buf), showSign ? "%+*.*f" : "%*.*f", width, precision, value);
+    if (len < 0)
+      return;
+    if (len >= static_cast<int>(sizeof(buf)))
+      len = sizeof(buf) - 1;
+    const char* point = localeconv()->decimal_point;
+    if (point && point[0] != '.' && point[0] != '\0') {
+      char* c = strchr(buf, point[0]);
+      if (c)
+        *c = '.';
+    }
+    s.append(buf, len);
+  }
+
+  void AppendInt(string& s, long value, int width)
+  {
+    char buf[24];
+    char* end = buf + sizeof(buf);
+    char* p = end;
+    unsigned long u = value < 0 ? 0UL - static_cast<unsigned long>(value)
+                                : static_cast<unsigned long>(value);
+    do {
+      *--p = static_cast<char>('0' + u % 10);
+      u /= 10;
+    } while (u);
+    if (value < 0)
+      *--p = '-';
+    AppendRightAligned(s, p, end, width);
+  }
+
+  void AppendPadded(string& s, const char* text, int width, bool left)
+  {
+    int len = static_cast<int>(strlen(text));
+    if (!left && width > len)
+      s.append(width - len, ' ');
+    s.append(text, len);
+    if (left && width > len)
+      s.append(width - len, ' ');
+  }
+
+} // namespace OpenBabel
+
+//! \file numformat.cpp
+//! \brief Locale-independent fixed-width number formatting
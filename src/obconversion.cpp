@@ -333,6 +333,84 @@ namespace OpenBabel {
     return pFormat->RegisterFormat(ID, MIME);
   }
 
+  /// Set up while a format writes one object. With BGZF output it holds back
+  /// the syncs from the std::endl that formats end lines with, as each would
+  /// end a member, and notes where the object starts for the record index
+  /// read by RecordIndex().
+  class RecordWriter
+  {
+  public:
+    explicit RecordWriter(ostream* os)
+#ifdef HAVE_LIBZ
+      : _out(dynamic_cast<zlib_stream::bgzf_ostream*>(os)), _start(0)
+    {
+      if (_out) {
+        _start = _out->tell();
+        _out->hold_sync(true);
+      }
+    }
+    ~RecordWriter()
+    {
+      if (_out)
+        _out->hold_sync(false);
+    }
+    //! Call when the object has been written
+    void Written()
+    {
+      if (_out && _out->tell() > _start) // not if held back until the end
+        _out->add_record(_start);
+    }
+  private:
+    zlib_stream::bgzf_ostream *_out;
+    streamoff _start;
+#else
+    {}
+    void Written() {}
+#endif
+  };
+
+  static bool WriteAndIndex(OBFormat* pFormat, OBConversion* pConv)
+  {
+    RecordWriter record(pConv->GetOutStream());
+    if (!pFormat->WriteChemObject(pConv))
+      return false;
+    record.Written();
+    return true;
+  }
+
+  /// The start of each object in the gzipped input file, from the record
+  /// index written with it by --zindex. \return false if there is no index
+  /// for this file, or its offsets are not all within the uncompressed data.
+  static bool RecordIndex(OBConversion* pConv, vector<streamoff>& records)
+  {
+#ifdef HAVE_LIBZ
+    string path = pConv->GetInFilename();
+    if (!pConv->GetInGzipped() || path.empty() || path[0] == '-')
+      return false;
+    ifstream ifs(path.c_str(), ios_base::in | ios_base::binary | ios_base::ate);
+    streamoff size = ifs ? static_cast<streamoff>(ifs.tellg()) : -1;
+    if (size <= 0 || !zlib_stream::read_record_index(path + ".obi", size, records)
+        || records.empty() || records[0] < 0)
+      return false;
+
+    // The offsets are increasing, so the last one must be before the end
+    istream& in = *pConv->GetInStream();
+    in.clear();
+    streampos pos = in.tellg();
+    in.seekg(0, ios_base::end);
+    streamoff end = in ? static_cast<streamoff>(in.tellg()) : -1;
+    in.clear();
+    in.seekg(pos);
+    if (records.back() >= end) {
+      records.clear();
+      return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
   /// Set input stream, removing/deallocating previous stream if necessary.
   /// If takeOwnership is true, takes responsibility for freeing pIn
   void OBConversion::SetInStream(std::istream* pIn, bool takeOwnership)
@@ -395,7 +473,13 @@ namespace OpenBabel {
 
       if (IsOption("z", GENOPTIONS) || outFormatGzip)
       {
-        zlib_stream::zip_ostream *zOut = new zlib_stream::zip_ostream(*pOutput, true);
+        // BGZF: gzip members compressed in parallel, still read by gunzip
+        zlib_stream::bgzf_ostream *zOut = new zlib_stream::bgzf_ostream(*pOutput);
+        // With --zindex, a file named by OutFilename also gets an index of
+        // its objects, so that -f can go straight to one when it is read back
+        if (IsOption("zindex", GENOPTIONS) && dynamic_cast<ofstream*>(pOut) &&
+            !OutFilename.empty() && OutFilename.find('*') == string::npos)
+          zOut->set_record_index(OutFilename + ".obi");
         //we need to delete the zstream _before_ the underlying stream so it can add the footer
         ownedOutStreams.insert(ownedOutStreams.begin(),zOut);
         pOutput = zOut;
@@ -604,7 +688,7 @@ namespace OpenBabel {
     //Output is always occurs at the end with the --OutputAtEnd option
     bool oae = IsOption("OutputAtEnd",GENOPTIONS)!=NULL;
     if(pOutFormat && (!oae || m_IsLast))
-      if((oae || pOb1) && !pOutFormat->WriteChemObject(this))
+      if((oae || pOb1) && !WriteAndIndex(pOutFormat, this))
         Index--;
 
     //Put AddChemObject() into non-queue mode
@@ -626,8 +710,25 @@ namespace OpenBabel {
         if(StartNumber>1)
           {
             TempStartNumber=StartNumber;
-            //Try to skip objects now
-            int ret = pInFormat->SkipObjects(StartNumber-1,this);
+            //Go straight to the object if the gzipped input has an index,
+            //otherwise try to skip objects now
+            int ret = 0;
+            vector<streamoff> records;
+            if(static_cast<int>(StartNumber) > 0 && RecordIndex(this, records) &&
+               static_cast<size_t>(StartNumber) <= records.size())
+              {
+                pInput->clear();
+                pInput->seekg(records[StartNumber-1]);
+                if(pInput->good() && pInput->tellg() == streampos(records[StartNumber-1]))
+                  ret = 1;
+                else
+                  {
+                    pInput->clear();
+                    pInput->seekg(0);
+                  }
+              }
+            if(ret==0)
+              ret = pInFormat->SkipObjects(StartNumber-1,this);
             if(ret==-1) //error
               return false;
             if(ret==1) //success:objects skipped
@@ -691,7 +792,7 @@ namespace OpenBabel {
             if(pOb1 && pOutFormat) //see if there is an object ready to be output
               {
                 //Output object
-                if (!pOutFormat->WriteChemObject(this))
+                if (!WriteAndIndex(pOutFormat, this))
                   {
                     //faultly write, so finish
                     --Index;
@@ -909,7 +1010,10 @@ namespace OpenBabel {
     pOutput->imbue(cNumericLocale);
 
     // The actual work is done here
+    RecordWriter record(pOutput);
     bool success = pOutFormat->WriteMolecule(pOb,this);
+    if (success)
+      record.Written();
 
     // return the C locale to the original one
     obLocale.RestoreLocale();
@@ -1117,8 +1221,8 @@ namespace OpenBabel {
       obErrorLog.ThrowError(__FUNCTION__,"Cannot write to " + outfilepath, obError);
       return false;
     }
+    OutFilename = outfilepath; //before SetOutStream(), which uses it for -z
     SetOutStream(ofs, true);
-    OutFilename = outfilepath;
 
     return true;
   }
@@ -1133,6 +1237,7 @@ namespace OpenBabel {
       "-e Continue with next object after error, if possible\n"
       #ifdef HAVE_LIBZ
       "-z Compress the output with gzip\n"
+      "--zindex With compressed output, also index the objects in <file>.obi\n"
       "-zin Decompress the input with gzip\n"
       #endif
       "-k Attempt to translate keywords\n";
@@ -1651,8 +1756,8 @@ Additional options :
                                   "The number of parameters needed by option \"" + name + "\" in "
                                   + description.substr(0,description.find('\n'))
                                   + " differs from an earlier registration.", obError);
-            return;
           }
+        return; // nothing to write, so conversions can be constructed on several threads
       }
     OptionParamArray(typ)[name] = numberParams;
   }
@@ -1740,12 +1845,19 @@ Additional options :
     if( (p=IsOption("l", GENOPTIONS)) ) // extra parens to indicate truth value
       nlast=atoi(p);
 
+    int count=0;
+    vector<streamoff> records;
+    if(RecordIndex(this, records))
+    {
+      count = records.size() < static_cast<size_t>(nlast) ? static_cast<int>(records.size()) : nlast;
+      return count - (nfirst-1);
+    }
+
     ifs.seekg(0); //rewind
     //Compressed files currently show an error here.***TAKE CHANCE: RESET ifs****
     ifs.clear();
 
     OBFormat* pFormat = GetInFormat();
-    int count=0;
     //skip each object but stop after nlast objects
     while(ifs && pFormat->SkipObjects(1, this)>0  && count<nlast)
       ++count;
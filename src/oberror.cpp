@@ -165,17 +165,24 @@ namespace OpenBabel
     if (!_logging)
       return;
 
-    //Output error message if level sufficiently high and, if onceOnly set, it has not been logged before
-    if (err.GetLevel() <= _outputLevel &&
-      (qualifier!=onceOnly || find(_messageList.begin(), _messageList.end(), err)==_messageList.end()))
+    //Messages can come from descriptors, fingerprints etc. run in parallel,
+    //so every method that uses the log is a critical section
+#ifdef _OPENMP
+    #pragma omp critical (OBMessageHandler)
+#endif
     {
-      *_outputStream << err;
-    }
+      //Output error message if level sufficiently high and, if onceOnly set, it has not been logged before
+      if (err.GetLevel() <= _outputLevel &&
+        (qualifier!=onceOnly || find(_messageList.begin(), _messageList.end(), err)==_messageList.end()))
+      {
+        *_outputStream << err;
+      }
 
-    _messageList.push_back(err);
-    _messageCount[err.GetLevel()]++;
-    if (_maxEntries != 0 && _messageList.size() > _maxEntries)
-      _messageList.pop_front();
+      _messageList.push_back(err);
+      _messageCount[err.GetLevel()]++;
+      if (_maxEntries != 0 && _messageList.size() > _maxEntries)
+        _messageList.pop_front();
+    }
   }
 
   void OBMessageHandler::ThrowError(const std::string &method,
@@ -195,6 +202,9 @@ namespace OpenBabel
     deque<OBError>::iterator i;
     OBError error;
 
+#ifdef _OPENMP
+    #pragma omp critical (OBMessageHandler)
+#endif
     for (i = _messageList.begin(); i != _messageList.end(); ++i)
       {
         error = (*i);
@@ -205,6 +215,14 @@ namespace OpenBabel
     return results;
   }
 
+  void OBMessageHandler::ClearLog()
+  {
+#ifdef _OPENMP
+    #pragma omp critical (OBMessageHandler)
+#endif
+    _messageList.clear();
+  }
+
   bool OBMessageHandler::StartErrorWrap()
   {
     if (_inWrapStreamBuf != NULL)
@@ -238,16 +256,21 @@ namespace OpenBabel
   string OBMessageHandler::GetMessageSummary()
   {
     stringstream summary;
-    if (_messageCount[obError] > 0)
-      summary << _messageCount[obError] << " errors ";
-    if (_messageCount[obWarning] > 0)
-      summary << _messageCount[obWarning] << " warnings ";
-    if (_messageCount[obInfo] > 0)
-      summary << _messageCount[obInfo] << " info messages ";
-    if (_messageCount[obAuditMsg] > 0)
-      summary << _messageCount[obAuditMsg] << " audit log messages ";
-    if (_messageCount[obDebug] > 0)
-      summary << _messageCount[obDebug] << " debugging messages ";
+    unsigned int count[5];
+#ifdef _OPENMP
+    #pragma omp critical (OBMessageHandler)
+#endif
+    std::copy(_messageCount, _messageCount + 5, count);
+    if (count[obError] > 0)
+      summary << count[obError] << " errors ";
+    if (count[obWarning] > 0)
+      summary << count[obWarning] << " warnings ";
+    if (count[obInfo] > 0)
+      summary << count[obInfo] << " info messages ";
+    if (count[obAuditMsg] > 0)
+      summary << count[obAuditMsg] << " audit log messages ";
+    if (count[obDebug] > 0)
+      summary << count[obDebug] << " debugging messages ";
 
     return summary.str();
   }
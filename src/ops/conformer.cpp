@@ -70,6 +70,7 @@ namespace OpenBabel
           " --mutability #   mutation frequency (default = 5)\n"
           " --convergence #  number of identical generations before convergence is reached\n"
           " --score #        scoring function [rmsd|energy|minrmsd|minenergy] (default = rmsd)\n"
+          " --seed #         seed for the random number generator (default = current time)\n"
           " customize the filter used to sort out wrong conformers\n"
           " --csfilter #     the filtering algorithm [steric] (default=steric)\n"
           " --cutoff #       absolute distance in Anstroms below which atoms are considered to clash\n"
@@ -223,6 +224,13 @@ namespace OpenBabel
       else if (score == "minr" || score == "minrmsd")
         cs.SetScore(new OBMinimizingRMSDConformerScore);
 
+      iter = pmap->find("seed");
+      if(iter!=pmap->end()) {
+        int seed;
+        if (getValue<int>(iter->second, seed))
+          cs.SetSeed(seed);
+      }
+
       iter = pmap->find("csfilter");
       if(iter!=pmap->end())
         filter = iter->second;
@@ -22,6 +22,7 @@ GNU General Public License for more details.
 #include <openbabel/atom.h>
 #include <openbabel/obiter.h>
 #include <openbabel/math/spacegroup.h>
+#include <openbabel/math/periodicgrid.h>
 #include <openbabel/generic.h>
 #include <openbabel/obconversion.h>
 #include <map>
@@ -164,18 +165,19 @@ bool OpFillUC::Do(OBBase* pOb, const char* OptionText, OpMap* pOptions, OBConver
   FOR_ATOMS_OF_MOL(atom, *pmol)
       vatoms[&(*atom)]=std::vector<vector3>();
 
+  // Apply all symmetry operators to all atoms in one pass
+  std::vector<vector3> orig, transformed;
   for(std::map<OBAtom*,std::vector<vector3> >:: iterator atom=vatoms.begin();
-      atom!=vatoms.end();++atom){
-    vector3 orig = atom->first->GetVector();
-    orig = pUC->CartesianToFractional(orig);// To fractional coordinates
-
-    // Loop over symmetry operators
-    transform3dIterator ti;
-    const transform3d *t = pSG->BeginTransform(ti);
-    while(t){
-      atom->second.push_back ( (transform3d)(*t) * orig);
-      t = pSG->NextTransform(ti);
-    }
+      atom!=vatoms.end();++atom)
+    orig.push_back(pUC->CartesianToFractional(atom->first->GetVector()));// To fractional coordinates
+  pSG->Transform(orig, transformed);
+  const size_t natoms = orig.size();
+  const size_t nops = natoms ? transformed.size() / natoms : 0;
+  size_t n = 0;
+  for(std::map<OBAtom*,std::vector<vector3> >:: iterator atom=vatoms.begin();
+      atom!=vatoms.end();++atom, ++n){
+    for(size_t op=0;op<nops;++op)
+      atom->second.push_back(transformed[op * natoms + n]);
   }
 
   if(0==strncasecmp(OptionText, "keepconnect", 11)){
@@ -193,39 +195,7 @@ bool OpFillUC::Do(OBBase* pOb, const char* OptionText, OpMap* pOptions, OBConver
         atom->second[i]+=ccoord;
       }
     }
-    // Now add atoms that are not duplicates
-    for(std::map<OBAtom*,std::vector<vector3> >:: iterator atom=vatoms.begin();
-        atom!=vatoms.end();++atom){
-      for(unsigned int i=1;i<atom->second.size();++i){
-        bool foundDuplicate = false;
-        for(unsigned int j=0;j<i;++j){
-          if(areDuplicateAtoms2(atom->second[i],atom->second[j])){
-            foundDuplicate=true;
-            break;
-          }
-        }
-        if(!foundDuplicate){
-          vector3 transformed = pUC->FractionalToCartesian(atom->second[i]);
-          // let's make sure there isn't some *other* atom that's in this spot
-          bool foundCartesianDuplicate = false;
-          FOR_ATOMS_OF_MOL(a, *pmol) {
-            vector3 diff = a->GetVector() - transformed;
-            if (diff.length_2() < 1.0e-4) {
-              foundCartesianDuplicate = true;
-              break;
-            }
-          }
-
-          if (!foundCartesianDuplicate) {
-            OBAtom *newAtom = pmol->NewAtom();
-            newAtom->Duplicate(atom->first);
-            newAtom->SetVector( transformed );
-          }
-        }
-      }
-    }
   }
-
   else{
     if(0!=strncasecmp(OptionText, "strict", 6))
       obErrorLog.ThrowError(__FUNCTION__, "fillUC: lacking \"strict\n or \"keepconnect\" option, using strict" , obWarning);
@@ -235,31 +205,49 @@ bool OpFillUC::Do(OBBase* pOb, const char* OptionText, OpMap* pOptions, OBConver
       for(unsigned int i=0;i<atom->second.size();++i){
         atom->second[i]=fuzzyWrapFractionalCoordinate(atom->second[i]);
       }
-      for(unsigned int i=1;i<atom->second.size();++i){
-        bool foundDuplicate = false;
-        for(unsigned int j=0;j<i;++j){
-          if(areDuplicateAtoms2(atom->second[i],atom->second[j])){
-            foundDuplicate=true;
+    }
+  }
+
+  // Now add atoms that are not duplicates. Symmetrics of the same atom are
+  // compared as in areDuplicateAtoms2(), across the cell boundaries, and
+  // new atoms are checked against all atoms placed so far in Cartesian
+  // space, using grids so that neither check is quadratic.
+  OBPeriodicGrid symmetrics(matrix3x3(1.0), sqrt(1e-3));
+  OBPeriodicGrid placed(pUC->GetCellMatrix().transpose(), 1e-2);
+  std::vector<vector3> placedCoords;
+  std::vector<OBPeriodicGrid::Neighbor> found;
+  FOR_ATOMS_OF_MOL(a, *pmol) {
+    placed.Add(pUC->CartesianToFractional(a->GetVector()));
+    placedCoords.push_back(a->GetVector());
+  }
+  for(std::map<OBAtom*,std::vector<vector3> >:: iterator atom=vatoms.begin();
+      atom!=vatoms.end();++atom){
+    symmetrics.Clear();
+    if (!atom->second.empty())
+      symmetrics.Add(atom->second[0]);
+    for(unsigned int i=1;i<atom->second.size();++i){
+      symmetrics.GetNeighbors(atom->second[i], found);
+      bool foundDuplicate = !found.empty();
+      symmetrics.Add(atom->second[i]);
+      if(!foundDuplicate){
+        vector3 transformed = pUC->FractionalToCartesian(atom->second[i]);
+        // let's make sure there isn't some *other* atom that's in this spot
+        bool foundCartesianDuplicate = false;
+        placed.GetNeighbors(atom->second[i], found);
+        for (size_t j = 0; j < found.size(); ++j) {
+          vector3 diff = placedCoords[found[j].index] - transformed;
+          if (diff.length_2() < 1.0e-4) {
+            foundCartesianDuplicate = true;
             break;
           }
         }
-        if(!foundDuplicate){
-          vector3 transformed = pUC->FractionalToCartesian(atom->second[i]);
-          // let's make sure there isn't some *other* atom that's in this spot
-          bool foundCartesianDuplicate = false;
-          FOR_ATOMS_OF_MOL(a, *pmol) {
-            vector3 diff = a->GetVector() - transformed;
-            if (diff.length_2() < 1.0e-4) {
-              foundCartesianDuplicate = true;
-              break;
-            }
-          }
 
-          if (!foundCartesianDuplicate) {
-            OBAtom *newAtom = pmol->NewAtom();
-            newAtom->Duplicate(atom->first);
-            newAtom->SetVector( transformed );
-          }
+        if (!foundCartesianDuplicate) {
+          OBAtom *newAtom = pmol->NewAtom();
+          newAtom->Duplicate(atom->first);
+          newAtom->SetVector( transformed );
+          placed.Add(atom->second[i]);
+          placedCoords.push_back(transformed);
         }
       }
     }
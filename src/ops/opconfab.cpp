@@ -61,6 +61,7 @@ namespace OpenBabel
           "    --rcutoff #  RMSD cutoff (default 0.5 Angstrom)\n"
           "    --ecutoff #  Energy cutoff (default 50.0 kcal/mol)\n"
           "    --original   Include the input conformation as the first conformer\n"
+          "    --tree       Depth-first torsion driving with incremental energies\n"
           "    --verbose    Verbose output\n"
           ;
       }
@@ -78,6 +79,7 @@ namespace OpenBabel
       unsigned int conf_cutoff;
       bool verbose;
       bool include_original;
+      bool use_tree;
       unsigned int N;
       OBForceField *pff;
   };
@@ -102,6 +104,7 @@ namespace OpenBabel
       conf_cutoff = 1000000; // 1 Million
       verbose = false;
       include_original = false;
+      use_tree = false;
 
       OpMap::const_iterator iter;
       iter = pmap->find("rcutoff");
@@ -119,6 +122,9 @@ namespace OpenBabel
       iter = pmap->find("original");
       if(iter!=pmap->end())
         include_original = true;
+      iter = pmap->find("tree");
+      if(iter!=pmap->end())
+        use_tree = true;
 
       cout << "**Starting Confab " << CONFAB_VER << "\n";
       cout << "**To support, cite Journal of Cheminformatics, 2011, 3, 8.\n";
@@ -149,7 +155,10 @@ namespace OpenBabel
            << "!!Skipping\n" << endl;
       return;
     }
-    pff->DiverseConfGen(rmsd_cutoff, conf_cutoff, energy_cutoff, verbose);
+    if (use_tree)
+      pff->DiverseConfGenTree(rmsd_cutoff, conf_cutoff, energy_cutoff, verbose);
+    else
+      pff->DiverseConfGen(rmsd_cutoff, conf_cutoff, energy_cutoff, verbose);
 
     pff->GetConformers(mol);
     int nconfs = include_original ? mol.NumConformers() : mol.NumConformers() - 1;
@@ -181,6 +190,7 @@ namespace OpenBabel
     cout << "..Energy cutoff = " << energy_cutoff << endl;
     cout << "..Conformer cutoff = " << conf_cutoff << endl;
     cout << "..Write input conformation? " << (include_original ? "True" : "False") << endl;
+    cout << "..Depth-first torsion tree? " << (use_tree ? "True" : "False") << endl;
     cout << "..Verbose? " << (verbose ? "True" : "False") << endl;
     cout << endl;
   }
@@ -0,0 +1,81 @@
+/**********************************************************************
+supercell.cpp - The option --supercell: replicate the unit cell
+
+This file is part of the Open Babel project.
+For more information, see <http://openbabel.org/>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+***********************************************************************/
+#include <openbabel/babelconfig.h>
+#include <openbabel/op.h>
+#include <openbabel/mol.h>
+#include <openbabel/oberror.h>
+#include <openbabel/generic.h>
+#include <openbabel/obconversion.h>
+#include <cstdlib>
+
+namespace OpenBabel
+{
+
+class OpSupercell : public OBOp
+{
+public:
+  OpSupercell(const char* ID) : OBOp(ID, false){
+    OBConversion::RegisterOptionParam("supercell", NULL, 1, OBConversion::GENOPTIONS);
+  }
+  const char* Description(){ return "<AxBxC> Replicate the unit cell A, B and C times\n"
+    "Copies the atoms and bonds and enlarges the cell. Bonds through the\n"
+    "cell faces join the matching copies. Use e.g. \"--supercell 2x2x1\",\n"
+    "or \"--supercell 3\" for 3x3x3. The unit cell must be filled already;\n"
+    "use --fillUC first if only the unique atoms are given."; }
+
+  virtual bool WorksWith(OBBase* pOb)const{ return dynamic_cast<OBMol*>(pOb)!=NULL; }
+  virtual bool Do(OBBase* pOb, const char* OptionText=NULL, OpMap* pOptions=NULL, OBConversion* pConv=NULL);
+};
+
+/////////////////////////////////////////////////////////////////
+OpSupercell theOpSupercell("supercell"); //Global instance
+
+/////////////////////////////////////////////////////////////////
+bool OpSupercell::Do(OBBase* pOb, const char* OptionText, OpMap*, OBConversion*)
+{
+  OBMol* pmol = dynamic_cast<OBMol*>(pOb);
+  if(!pmol)
+    return false;
+
+  if (!pmol->HasData(OBGenericDataType::UnitCell))
+  {
+    obErrorLog.ThrowError(__FUNCTION__, "Cannot make a supercell without a unit cell !" , obWarning);
+    return false;
+  }
+
+  std::vector<std::string> vs;
+  tokenize(vs, OptionText ? OptionText : "", "xX*, ");
+  if (vs.size() == 1)
+  {
+    vs.push_back(vs[0]);
+    vs.push_back(vs[0]);
+  }
+  int counts[3] = { 0, 0, 0 };
+  if (vs.size() == 3)
+    for (int i = 0; i < 3; ++i)
+      counts[i] = atoi(vs[i].c_str());
+  if (counts[0] < 1 || counts[1] < 1 || counts[2] < 1)
+  {
+    obErrorLog.ThrowError(__FUNCTION__, "supercell: expected sizes such as \"3x3x3\", not \"" +
+                          std::string(OptionText ? OptionText : "") + "\"", obWarning);
+    return false;
+  }
+
+  OBUnitCell *pUC = (OBUnitCell*)pmol->GetData(OBGenericDataType::UnitCell);
+  return pUC->MakeSupercell(pmol, counts[0], counts[1], counts[2]);
+}
+
+}//namespace
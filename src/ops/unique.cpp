@@ -61,6 +61,10 @@ public:
     "The duplicates can be output instead by making the first character\n"
     "in the parameter ~  e.g. --unique ~cansmi   --unique ~\n\n"
 
+    "When the input contains many repeats, setting the environment variable\n"
+    "BABEL_STRINGCACHE to a number of entries caches the InChI and canonical\n"
+    "SMILES of recently seen structures instead of regenerating them.\n\n"
+
     "/formula  formula only\n"
     "/connect  formula and connectivity only\n"
     "/nostereo ignore E/Z and sp3 stereochemistry\n"
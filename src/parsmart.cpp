@@ -1767,6 +1767,25 @@ namespace OpenBabel
 	  return Match(mol, dummy, Single);
   }
 
+  bool OBSmartsPattern::MatchesAt(OBAtom *atom) const
+  {
+    if (_pat == NULL || atom == NULL)
+      return false;
+    OBMol &mol = *((OBMol*) atom->GetParent());
+    if (_pat->hasExplicitH || _pat->ischiral || _pat->parts > 1)
+      {
+        // these need the whole-molecule machinery
+        std::vector<std::vector<int> > mlist;
+        Match(mol, mlist);
+        for (std::vector<std::vector<int> >::iterator m = mlist.begin(); m != mlist.end(); ++m)
+          if ((*m)[0] == (int)atom->GetIdx())
+            return true;
+        return false;
+      }
+    OBSmartsMatcher matcher;
+    return matcher.matchAt(mol, _pat, atom);
+  }
+
   bool OBSmartsPattern::Match(OBMol &mol, std::vector<std::vector<int> > & mlist,
 		  MatchType mtype /*=All*/) const
   {
@@ -1992,6 +2011,110 @@ namespace OpenBabel
   }
 
 
+  bool OBSmartsMatcher::matchAt(OBMol &mol, const Pattern *pat, OBAtom *root)
+  {
+    if (!pat || pat->acount == 0 || !root)
+      return false;
+    Rooted = true;
+    return RootedMatch(mol, pat, root);
+  }
+
+  //! Depth-first search as in FastSingleMatch() with the first pattern atom
+  //! fixed. The atoms mapped so far are found by scanning the (short) map,
+  //! so no per-molecule storage is needed.
+  bool OBSmartsMatcher::RootedMatch(OBMol &mol, const Pattern *pat, OBAtom *root)
+  {
+    if (!EvalAtomExpr(pat->atom[0].expr, root))
+      return false;
+    if (pat->bcount == 0)
+      return true;
+
+    const int SMALL = 16;
+    int smap[SMALL];
+    char svif[SMALL];
+    std::vector<OBBond*>::iterator svi[SMALL];
+    std::vector<int> vmap;
+    std::vector<char> vvif;
+    std::vector<std::vector<OBBond*>::iterator> vvi;
+    int *map = smap;
+    char *vif = svif;
+    std::vector<OBBond*>::iterator *vi = svi;
+    if (pat->acount > SMALL)
+      {
+        vmap.resize(pat->acount);
+        map = &vmap[0];
+      }
+    if (pat->bcount > SMALL)
+      {
+        vvif.resize(pat->bcount);
+        vvi.resize(pat->bcount);
+        vif = &vvif[0];
+        vi = &vvi[0];
+      }
+    for (int k = 0; k < pat->acount; ++k)
+      map[k] = 0;
+    map[0] = root->GetIdx();
+    vif[0] = false;
+
+    OBAtom *a1, *nbr;
+    for (int bcount = 0; bcount >= 0;)
+      {
+        if (bcount == pat->bcount) //entire pattern matched
+          return true;
+
+        const BondSpec &bs = pat->bond[bcount];
+        if (!bs.grow) //just check bond here
+          {
+            if (!vif[bcount])
+              {
+                OBBond *bond = mol.GetBond(map[bs.src], map[bs.dst]);
+                if (bond && EvalBondExpr(bs.expr, bond))
+                  {
+                    vif[bcount++] = true;
+                    if (bcount < pat->bcount)
+                      vif[bcount] = false;
+                  }
+                else
+                  bcount--;
+              }
+            else //bond must have already been visited - backtrack
+              bcount--;
+            continue;
+          }
+
+        //need to map atom and check bond
+        a1 = mol.GetAtom(map[bs.src]);
+        if (!vif[bcount])
+          nbr = a1->BeginNbrAtom(vi[bcount]);
+        else
+          {
+            map[bs.dst] = 0;
+            nbr = a1->NextNbrAtom(vi[bcount]);
+          }
+
+        for (; nbr; nbr = a1->NextNbrAtom(vi[bcount]))
+          {
+            int idx = nbr->GetIdx();
+            int k = 0;
+            while (k < pat->acount && map[k] != idx)
+              ++k;
+            if (k == pat->acount && EvalAtomExpr(pat->atom[bs.dst].expr, nbr)
+                && EvalBondExpr(bs.expr, *vi[bcount]))
+              {
+                map[bs.dst] = idx;
+                vif[bcount++] = true;
+                if (bcount < pat->bcount)
+                  vif[bcount] = false;
+                break;
+              }
+          }
+
+        if (!nbr) //no match - time to backtrack
+          bcount--;
+      }
+    return false;
+  }
+
   bool OBSmartsMatcher::match(OBMol &mol, const Pattern *pat,
                     std::vector<std::vector<int> > &mlist,bool single)
   {
@@ -2172,6 +2295,10 @@ namespace OpenBabel
 
         case AE_RECUR:
           {
+            const Pattern *recur = (const Pattern*)expr->recur.recur;
+            if (Rooted && !recur->ischiral && recur->parts == 1)
+              return RootedMatch(*((OBMol *) atom->GetParent()), recur, atom);
+
             //see if pattern has been matched
             std::vector<std::pair<const Pattern*,std::vector<bool> > >::iterator i;
             for (i = RSCACHE.begin();i != RSCACHE.end();++i)
@@ -2486,6 +2613,47 @@ namespace OpenBabel
     return 0;
   }
 
+  // Atomic numbers that can satisfy expr, conservatively
+  static void GetExprElements(AtomExpr *expr, std::vector<bool> &elements)
+  {
+    std::vector<bool> rgt;
+    switch (expr->type)
+      {
+      case AE_ELEM:
+      case AE_AROMELEM:
+      case AE_ALIPHELEM:
+        elements.assign(elements.size(), false);
+        if (expr->leaf.value >= 0 && expr->leaf.value < (int)elements.size())
+          elements[expr->leaf.value] = true;
+        return;
+      case AE_FALSE:
+        elements.assign(elements.size(), false);
+        return;
+      case AE_ANDHI:
+      case AE_ANDLO:
+      case AE_OR:
+        rgt.resize(elements.size());
+        GetExprElements(expr->bin.lft, elements);
+        GetExprElements(expr->bin.rgt, rgt);
+        for (unsigned int n = 0; n < elements.size(); ++n)
+          elements[n] = expr->type == AE_OR ? elements[n] || rgt[n]
+                                            : elements[n] && rgt[n];
+        return;
+      case AE_RECUR:
+        GetExprElements(((Pattern*)expr->recur.recur)->atom[0].expr, elements);
+        return;
+      default:
+        elements.assign(elements.size(), true);
+      }
+  }
+
+  void OBSmartsPattern::GetFirstAtomElements(std::vector<bool> &elements) const
+  {
+    elements.assign(119, false);
+    if (_pat && _pat->acount)
+      GetExprElements(_pat->atom[0].expr, elements);
+  }
+
   int OBSmartsPattern::GetAtomicNum(int idx)
   {
     return GetExprAtomicNum(_pat->atom[idx].expr);
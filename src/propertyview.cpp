@@ -0,0 +1,106 @@
+/**********************************************************************
+propertyview.cpp - Structure-of-arrays snapshot of atom properties
+
+This file is part of the Open Babel project.
+For more information, see <http://openbabel.org/>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+***********************************************************************/
+
+#include <openbabel/babelconfig.h>
+#include <openbabel/propertyview.h>
+#include <openbabel/mol.h>
+#include <openbabel/atom.h>
+#include <openbabel/bond.h>
+#include <openbabel/obiter.h>
+#include <openbabel/elements.h>
+#include <openbabel/typer.h>
+
+using namespace std;
+namespace OpenBabel
+{
+  void OBMolPropertyView::Update(OBMol &mol, bool hybridization)
+  {
+    const unsigned int n = mol.NumAtoms();
+    _atomicNum.resize(n);
+    _isotope.resize(n);
+    _charge.resize(n);
+    _implicitH.resize(n);
+    _explicitH.assign(n, 0);
+    _degree.assign(n, 0);
+    _heavyDegree.assign(n, 0);
+    _valence.assign(n, 0);
+    _hyb.clear();
+    _flags.resize(n);
+    _mol = &mol;
+    // Aromaticity is left to the first query unless it is already known
+    _hasAromatic = false;
+
+    if (!mol.HasRingAtomsAndBondsPerceived())
+      mol.FindRingAtomsAndBonds();
+
+    FOR_ATOMS_OF_MOL (atom, mol) {
+      unsigned int i = atom->GetIdx() - 1;
+      _atomicNum[i] = static_cast<unsigned char>(atom->GetAtomicNum());
+      _isotope[i] = static_cast<unsigned short>(atom->GetIsotope());
+      _charge[i] = static_cast<signed char>(atom->GetFormalCharge());
+      _implicitH[i] = static_cast<unsigned char>(atom->GetImplicitHCount());
+      _flags[i] = atom->IsInRing() ? InRing : 0;
+    }
+
+    // Degrees, valences and hydrogen counts in one pass over the bonds
+    FOR_BONDS_OF_MOL (bond, mol) {
+      unsigned int b = bond->GetBeginAtomIdx() - 1;
+      unsigned int e = bond->GetEndAtomIdx() - 1;
+      unsigned int order = bond->GetBondOrder();
+      ++_degree[b];
+      ++_degree[e];
+      _valence[b] += order;
+      _valence[e] += order;
+      if (_atomicNum[e] == OBElements::Hydrogen)
+        ++_explicitH[b];
+      else
+        ++_heavyDegree[b];
+      if (_atomicNum[b] == OBElements::Hydrogen)
+        ++_explicitH[e];
+      else
+        ++_heavyDegree[e];
+    }
+
+    if (mol.HasAromaticPerceived())
+      FillAromatic();
+
+    if (hybridization) {
+      _hyb.resize(n);
+      FOR_ATOMS_OF_MOL (atom, mol)
+        _hyb[atom->GetIdx() - 1] = static_cast<unsigned char>(atom->GetHyb());
+    }
+  }
+
+  void OBMolPropertyView::FillAromatic() const
+  {
+    _hasAromatic = true;
+    if (!_mol)
+      return;
+    if (!_mol->HasAromaticPerceived())
+      aromtyper.AssignAromaticFlags(*_mol);
+    FOR_ATOMS_OF_MOL (atom, *_mol) {
+      unsigned int i = atom->GetIdx() - 1;
+      if (atom->IsAromatic())
+        _flags[i] |= Aromatic;
+      else
+        _flags[i] &= ~Aromatic;
+    }
+  }
+
+} // namespace OpenBabel
+
+//! \file propertyview.cpp
+//! \brief Structure-of-arrays snapshot of atom properties
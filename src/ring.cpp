@@ -84,7 +84,6 @@ namespace OpenBabel
   */
 
   static int DetermineFRJ(OBMol &);
-  static void BuildOBRTreeVector(OBAtom*,OBRTree*,vector<OBRTree*>&,OBBitVec&);
 
   void OBMol::FindSSSR()
   {
@@ -146,92 +145,61 @@ namespace OpenBabel
         rd->SetOrigin(perceived); // to separate from user or file input
         rd->SetAttribute("SSSR");
         rd->SetData(vr);
+        rd->BuildIndex(*this);
         SetData(rd);
       }
   }
 
-  std::vector<unsigned int> atomRingToBondRing(OBMol *mol, const std::vector<int> &atoms)
+  //! Ring atom and bond sets packed 64 to a word, used by
+  //! OBRingSearch::RemoveRedundant()
+  typedef unsigned long long RingWord;
+
+  static inline void SetRingBit(vector<RingWord> &bits, unsigned int i)
   {
-    std::vector<unsigned int> bonds;
-    for (unsigned int i = 0; i < atoms.size() - 1; ++i) {
-      unsigned int beginIndex = atoms[i];
-      unsigned int endIndex = atoms[i+1];
-      unsigned int index = mol->GetBond(beginIndex, endIndex)->GetIdx();
-      bonds.push_back(index);
-    }
-    bonds.push_back(mol->GetBond(atoms[0], atoms[atoms.size()-1])->GetIdx());
-    return bonds;
-  }
-
-  /**
-   * This function finds the LSSR containing all relevant cycles. A cycle is
-   * relevant if it belongs to at least one minimum cycle basis. Another
-   * description is more useful though:
-   *
-   * A cycle (C) is relevant if:
-   * - no smaller cycles C_i, ..., C_k exist such that C = C_1 + ... + C_k
-   * - both bonds & atoms are checked
-   *
-   * This is based on lemma 1 from:
-   *
-   * P. Vismara, Union of all the minimum cycle bases of a graph, The electronic
-   * journal of combinatorics, Vol. 4, 1997
-   * http://www.emis.de/journals/EJC/Volume_4/PostScriptfiles/v4i1r9.ps
-   */
-  void visitRing(OBMol *mol, OBRing *ring, std::vector<OBRing*> &rlist, std::vector<OBRing*> &rignored)
-  {
-    OBBitVec mask;
-    // Make sure mask is the same size as the maximum ring atom/bond index.
-    mask.SetBitOn(mol->NumAtoms());
-    mask.SetBitOn(mol->NumBonds());
-
-    //
-    // Remove larger rings that cover the same atoms as smaller rings.
-    //
-    mask.Clear();
-    for (unsigned int j = 0; j < rlist.size(); ++j)
-      // Here we select only smaller rings.
-      if (rlist[j]->_path.size() < ring->_path.size())
-        mask |= rlist[j]->_pathset;
-
-    mask = mask & ring->_pathset;
-
-    bool containsSmallerAtomRing = (mask == ring->_pathset) ? true : false;
-
-    // Translate ring atom indexes to ring bond indexes.
-    std::vector<unsigned int> bonds = atomRingToBondRing(mol, ring->_path);
-    OBBitVec bondset;
-    for (unsigned int i = 0; i < bonds.size(); ++i)
-      bondset.SetBitOn(bonds[i]);
-
-    //
-    // Remove larger rings that cover the same bonds as smaller rings.
-    //
-    mask.Clear();
-    for (unsigned int j = 0; j < rlist.size(); ++j) {
-      std::vector<unsigned int> otherBonds = atomRingToBondRing(mol, rlist[j]->_path);
-      OBBitVec bs;
-      for (unsigned int i = 0; i < otherBonds.size(); ++i)
-        bs.SetBitOn(otherBonds[i]);
-
-      // Here we select only smaller rings.
-      if (otherBonds.size() < bonds.size())
-        mask |= bs;
-    }
+    bits[i / 64] |= 1ULL << (i % 64);
+  }
 
-    mask = mask & bondset;
+  static inline bool RingBitIsSet(const vector<RingWord> &bits, unsigned int i)
+  {
+    return (bits[i / 64] >> (i % 64)) & 1ULL;
+  }
 
-    bool containsSmallerBondRing = (mask == bondset) ? true : false;
+  //! \return Whether every bit of @p b is also set in @p a
+  static inline bool RingBitsCover(const vector<RingWord> &a, const vector<RingWord> &b)
+  {
+    for (unsigned int i = 0; i < b.size(); ++i)
+      if (b[i] & ~a[i])
+        return false;
+    return true;
+  }
 
-    // The ring is part of the LSSR if all it's atoms and bonds are not
-    // found in smaller rings.
-    if (!containsSmallerAtomRing || !containsSmallerBondRing) {
-      rlist.push_back(ring);
-    } else {
-      rignored.push_back(ring);
-    }
+  static inline void RingBitsOr(vector<RingWord> &a, const vector<RingWord> &b)
+  {
+    for (unsigned int i = 0; i < b.size(); ++i)
+      a[i] |= b[i];
   }
 
+  static void RingAtomBits(const OBRing *ring, vector<RingWord> &bits)
+  {
+    std::fill(bits.begin(), bits.end(), 0ULL);
+    for (unsigned int i = 0; i < ring->_path.size(); ++i)
+      SetRingBit(bits, ring->_path[i]);
+  }
+
+  //! Set the bits of the bonds between consecutive atoms of @p ring
+  //! \return false if two consecutive atoms are not bonded
+  static bool RingBondBits(OBMol *mol, const OBRing *ring, vector<RingWord> &bits)
+  {
+    std::fill(bits.begin(), bits.end(), 0ULL);
+    const vector<int> &path = ring->_path;
+    for (unsigned int i = 0; i < path.size(); ++i) {
+      OBBond *bond = mol->GetBond(path[i], path[(i + 1) % path.size()]);
+      if (!bond)
+        return false;
+      SetRingBit(bits, bond->GetIdx());
+    }
+    return true;
+  }
 
   void OBMol::FindLSSR()
   {
@@ -294,6 +262,7 @@ namespace OpenBabel
         rd->SetOrigin(perceived); // to separate from user or file input
         rd->SetAttribute("LSSR");
         rd->SetData(vr);
+        rd->BuildIndex(*this);
         SetData(rd);
       }
   }
@@ -316,31 +285,75 @@ namespace OpenBabel
 
   void OBRingSearch::RemoveRedundant(int frj)
   {
-    int i,j;
-
-    //remove identical rings
-    for (i = _rlist.size()-1;i > 0;i--)
-      for (j = i-1;j >= 0;j--)
-        if ((_rlist[i])->_pathset == (_rlist[j])->_pathset)
-          {
-            delete _rlist[i];
-            _rlist.erase(_rlist.begin()+i);
-            break;
-          }
+    //remove identical rings, keeping the first of each
+    std::set<vector<int> > unique;
+    vector<OBRing*> rlist;
+    vector<OBRing*>::iterator i;
+    for (i = _rlist.begin();i != _rlist.end();++i)
+      {
+        vector<int> key((*i)->_path);
+        std::sort(key.begin(), key.end());
+        key.erase(std::unique(key.begin(), key.end()), key.end());
+        if (unique.insert(key).second)
+          rlist.push_back(*i);
+        else
+          delete *i;
+      }
+    _rlist.swap(rlist);
+    rlist.clear();
 
     if (_rlist.size() == 0)
       return; // nothing to do
 
+    OBMol *mol = _rlist[0]->GetParent();
+    const unsigned int natomwords = mol->NumAtoms() / 64 + 1;
+    const unsigned int nbondwords = mol->NumBonds() / 64 + 1;
+    vector<RingWord> atoms(natomwords), bonds(nbondwords);
+
     // handle LSSR
+    /*
+     * The LSSR contains all relevant cycles. A cycle is relevant if it
+     * belongs to at least one minimum cycle basis. Another description is
+     * more useful though:
+     *
+     * A cycle (C) is relevant if:
+     * - no smaller cycles C_i, ..., C_k exist such that C = C_1 + ... + C_k
+     * - both bonds & atoms are checked
+     *
+     * This is based on lemma 1 from:
+     *
+     * P. Vismara, Union of all the minimum cycle bases of a graph, The electronic
+     * journal of combinatorics, Vol. 4, 1997
+     * http://www.emis.de/journals/EJC/Volume_4/PostScriptfiles/v4i1r9.ps
+     *
+     * A ring is kept unless all its atoms and all its bonds are found in
+     * smaller rings already kept. As the rings are sorted by size, those
+     * are accumulated one size at a time.
+     */
     if (frj < 0) {
-      OBMol *mol = _rlist[0]->GetParent();
-      std::vector<OBRing*> rlist, rignored;
-      for (unsigned int i = 0; i < _rlist.size(); ++i) {
-        visitRing(mol, _rlist[i], rlist, rignored);
-      }
-      for (unsigned int i = 0; i < rignored.size(); ++i)
-        delete rignored[i];
-      _rlist = rlist;
+      vector<RingWord> smallerAtoms(natomwords, 0ULL), smallerBonds(nbondwords, 0ULL);
+      vector<RingWord> sameAtoms(natomwords, 0ULL), sameBonds(nbondwords, 0ULL);
+      size_t size = 0;
+      for (i = _rlist.begin();i != _rlist.end();++i)
+        {
+          if ((*i)->Size() != size) {
+            RingBitsOr(smallerAtoms, sameAtoms);
+            RingBitsOr(smallerBonds, sameBonds);
+            std::fill(sameAtoms.begin(), sameAtoms.end(), 0ULL);
+            std::fill(sameBonds.begin(), sameBonds.end(), 0ULL);
+            size = (*i)->Size();
+          }
+          RingAtomBits(*i, atoms);
+          RingBondBits(mol, *i, bonds);
+          if (!RingBitsCover(smallerAtoms, atoms) || !RingBitsCover(smallerBonds, bonds)) {
+            RingBitsOr(sameAtoms, atoms);
+            RingBitsOr(sameBonds, bonds);
+            rlist.push_back(*i);
+          }
+          else
+            delete *i;
+        }
+      _rlist.swap(rlist);
       return;
     }
 
@@ -348,126 +361,153 @@ namespace OpenBabel
     if (_rlist.size() == (unsigned)frj)
       return;
 
-    //make sure tmp is the same size as the rings
-    OBBitVec tmp;
-    for (j = 0;j < (signed)_rlist.size();++j)
-      tmp = (_rlist[j])->_pathset;
-
-    //remove larger rings that cover the same atoms as smaller rings
-    for (i = _rlist.size()-1;i >= 0;i--)
+    //keep the smallest rings whose bond sets are linearly independent over
+    //GF(2), reducing each against the rings kept so far (a ring bond basis
+    //in row echelon form, one pivot bond per row). The earlier atom/bond
+    //union test could keep a ring that was the sum of others, so for some
+    //cages and metal complexes the SSSR differs from older versions
+    vector<RingWord> basis;
+    vector<unsigned int> pivots;
+    for (i = _rlist.begin();i != _rlist.end();++i)
       {
-        tmp.Clear();
-        for (j = 0;j < (signed)_rlist.size();++j)
-          if ((_rlist[j])->_path.size() <= (_rlist[i])->_path.size() && i != j)
-            tmp |= (_rlist[j])->_pathset;
+        if (rlist.size() == (unsigned)frj || !RingBondBits(mol, *i, bonds)) {
+          delete *i;
+          continue;
+        }
+
+        for (unsigned int k = 0; k < pivots.size(); ++k)
+          if (RingBitIsSet(bonds, pivots[k]))
+            for (unsigned int w = 0; w < nbondwords; ++w)
+              bonds[w] ^= basis[k * nbondwords + w];
+
+        unsigned int w = 0;
+        while (w < nbondwords && !bonds[w])
+          ++w;
+        if (w == nbondwords) { // a sum of smaller rings
+          delete *i;
+          continue;
+        }
 
-        tmp = tmp & (_rlist[i])->_pathset;
+        unsigned int pivot = w * 64;
+        while (!RingBitIsSet(bonds, pivot))
+          ++pivot;
+        pivots.push_back(pivot);
+        basis.insert(basis.end(), bonds.begin(), bonds.end());
+        rlist.push_back(*i);
+      }
+    _rlist.swap(rlist);
+  }
+
+  //! Build a breadth-first tree of the atoms within 21 bonds of @p root,
+  //! not passing through atom @p excluded. Each level is visited in order
+  //! of atom index.
+  void OBRingSearch::BuildTree(OBMol &mol, OBAtom *root, int excluded, vector<int> &tree)
+  {
+    tree.assign(mol.NumAtoms() + 1, -1);
+    tree[root->GetIdx()] = 0;
+    tree[excluded] = 0;
+    _curr.assign(1, root->GetIdx());
+
+#define OB_RTREE_CUTOFF 20
 
-        if (tmp == (_rlist[i])->_pathset)
+    OBAtom *atom, *nbr;
+    vector<OBBond*>::iterator j;
+    int level = 0;
+    for (;;)
+      {
+        _next.clear();
+        for (unsigned int i = 0; i < _curr.size(); ++i)
           {
-            delete _rlist[i];
-            _rlist.erase(_rlist.begin()+i);
+            atom = mol.GetAtom(_curr[i]);
+            for (nbr = atom->BeginNbrAtom(j);nbr;nbr = atom->NextNbrAtom(j))
+              if (tree[nbr->GetIdx()] < 0)
+                {
+                  tree[nbr->GetIdx()] = atom->GetIdx();
+                  _next.push_back(nbr->GetIdx());
+                }
           }
 
-        if (_rlist.size() == (unsigned)frj)
+        if (_next.empty())
+          break;
+        std::sort(_next.begin(), _next.end());
+        _curr.swap(_next);
+        level++;
+        if (level > OB_RTREE_CUTOFF)
           break;
       }
+#undef OB_RTREE_CUTOFF
+
+    tree[excluded] = -1;
   }
 
+  //! Fill @p path with the atoms from @p idx up to the root of @p tree
+  static void PathToRoot(const vector<int> &tree, int idx, vector<int> &path)
+  {
+    path.clear();
+    for (; idx > 0; idx = tree[idx])
+      path.push_back(idx);
+  }
 
   void OBRingSearch::AddRingFromClosure(OBMol &mol,OBBond *cbond)
   {
-    vector<OBRTree*> t1(mol.NumAtoms()+1,(OBRTree*)NULL);
-    vector<OBRTree*> t2(mol.NumAtoms()+1,(OBRTree*)NULL);
-    OBBitVec bv1,bv2;
+    BuildTree(mol, cbond->GetBeginAtom(), cbond->GetEndAtomIdx(), _tree1);
+    BuildTree(mol, cbond->GetEndAtom(), cbond->GetBeginAtomIdx(), _tree2);
 
-    bv1.SetBitOn(cbond->GetEndAtomIdx());
-    bv2.SetBitOn(cbond->GetBeginAtomIdx());
-    BuildOBRTreeVector(cbond->GetBeginAtom(),NULL,t1,bv1);
-    BuildOBRTreeVector(cbond->GetEndAtom(),NULL,t2,bv2);
-
-    bool pathok;
-    deque<int> p1,p2;
-    vector<OBAtom*> path1,path2;
-    vector<OBAtom*>::iterator m,n;
-    vector<OBRTree*>::iterator i;
-
-    for (i = t1.begin();i != t1.end();++i)
-      if (*i)
-        {
-          path1.clear();
-          (*i)->PathToRoot(path1);
-
-          if (t2[(*i)->GetAtomIdx()])
-            {
-              pathok = true;
-              path2.clear();
-              t2[(*i)->GetAtomIdx()]->PathToRoot(path2);
-
-              p1.clear();
-              m = path1.begin();
-              if (m != path1.end())
-                p1.push_back((*m)->GetIdx());
-              for (m = path1.begin(),++m;m != path1.end();++m)
-                {
-                  p1.push_back((*m)->GetIdx());
-                  p2.clear();
-                  for (n = path2.begin(),++n;n != path2.end();++n)
-                    {
-                      p2.push_front((*n)->GetIdx());
-                      if (*n == *m)//don't traverse across identical atoms
-                        {
-                          p2.pop_front();
-                          if (p1.size()+p2.size() > 2)
-                            SaveUniqueRing(p1,p2);
-                          pathok = false;
-                          break;
-                        }
-                      if ((*n)->IsConnected(*m) && p1.size()+p2.size() > 2)
-                        SaveUniqueRing(p1,p2);
-                    }
-                  if (!pathok)
+    //join the paths to the two ends of the closure bond
+    for (unsigned int i = 1; i < _tree1.size(); ++i)
+      {
+        if (_tree1[i] < 0 || _tree2[i] < 0)
+          continue;
+        PathToRoot(_tree1, i, _path1);
+        PathToRoot(_tree2, i, _path2);
+
+        _p1.assign(1, _path1[0]);
+        bool pathok = true;
+        for (unsigned int m = 1; m < _path1.size(); ++m)
+          {
+            _p1.push_back(_path1[m]);
+            _p2.clear();
+            OBAtom *matom = mol.GetAtom(_path1[m]);
+            for (unsigned int n = 1; n < _path2.size(); ++n)
+              {
+                if (_path2[n] == _path1[m]) //don't traverse across identical atoms
+                  {
+                    if (_p1.size()+_p2.size() > 2)
+                      SaveRing(_p1,_p2);
+                    pathok = false;
                     break;
-                }
-            }
-        }
-
-    //clean up OBRTree vectors
-    for (i = t1.begin();i != t1.end();++i)
-      if (*i)
-        delete *i;
-
-    for (i = t2.begin();i != t2.end();++i)
-      if (*i)
-        delete *i;
+                  }
+                _p2.push_back(_path2[n]);
+                if (mol.GetAtom(_path2[n])->IsConnected(matom) && _p1.size()+_p2.size() > 2)
+                  SaveRing(_p1,_p2);
+              }
+            if (!pathok)
+              break;
+          }
+      }
 
     // set parent for all rings
     for (unsigned int j = 0; j < _rlist.size(); ++j)
       _rlist[j]->SetParent(&mol);
   }
 
-  bool OBRingSearch::SaveUniqueRing(deque<int> &d1,deque<int> &d2)
+  //! Save the ring made of @p p1 followed by @p p2 in reverse order,
+  //! unless a ring with the same atoms has already been saved
+  bool OBRingSearch::SaveRing(const vector<int> &p1, const vector<int> &p2)
   {
-    vector<int> path;
-    OBBitVec bv;
-    deque<int>::iterator i;
+    vector<int> path(p1);
+    path.insert(path.end(), p2.rbegin(), p2.rend());
 
-    for (i = d1.begin();i != d1.end();++i)
-      {
-        bv.SetBitOn(*i);
-        path.push_back(*i);
-      }
+    vector<int> key(path);
+    std::sort(key.begin(), key.end());
+    key.erase(std::unique(key.begin(), key.end()), key.end());
+    if (!_seen.insert(key).second)
+      return(false);
 
-    for (i = d2.begin();i != d2.end();++i)
-      {
-        bv.SetBitOn(*i);
-        path.push_back(*i);
-      }
-
-    vector<OBRing*>::iterator j;
-    for (j = _rlist.begin();j != _rlist.end();++j)
-      if (bv == (*j)->_pathset)
-        return(false);
+    OBBitVec bv;
+    vector<int>::iterator i;
+    for (i = path.begin();i != path.end();++i)
+      bv.SetBitOn(*i);
 
     OBRing *ring = new OBRing(path, bv);
     _rlist.push_back(ring);
@@ -475,6 +515,13 @@ namespace OpenBabel
     return(true);
   }
 
+  bool OBRingSearch::SaveUniqueRing(deque<int> &d1,deque<int> &d2)
+  {
+    vector<int> p1(d1.begin(), d1.end());
+    vector<int> p2(d2.rbegin(), d2.rend());
+    return SaveRing(p1, p2);
+  }
+
   //! Destructor -- free all rings created from this search
   OBRingSearch::~OBRingSearch()
   {
@@ -696,46 +743,6 @@ namespace OpenBabel
     return(*this);
   }
 
-  void BuildOBRTreeVector(OBAtom *atom,OBRTree *prv,vector<OBRTree*> &vt,OBBitVec &bv)
-  {
-    vt[atom->GetIdx()] = new OBRTree (atom,prv);
-
-    int i;
-    OBAtom *nbr;
-    OBMol *mol = (OBMol*)atom->GetParent();
-    OBBitVec curr,used,next;
-    vector<OBBond*>::iterator j;
-    curr |= atom->GetIdx();
-    used = bv|curr;
-
-#define OB_RTREE_CUTOFF 20
-
-    int level=0;
-    for (;;)
-      {
-        next.Clear();
-        for (i = curr.NextBit(0);i != bv.EndBit();i = curr.NextBit(i))
-          {
-            atom = mol->GetAtom(i);
-            for (nbr = atom->BeginNbrAtom(j);nbr;nbr = atom->NextNbrAtom(j))
-              if (!used[nbr->GetIdx()])
-                {
-                  next |= nbr->GetIdx();
-                  used |= nbr->GetIdx();
-                  vt[nbr->GetIdx()] = new OBRTree (nbr,vt[atom->GetIdx()]);
-                }
-          }
-
-        if (next.IsEmpty())
-          break;
-        curr = next;
-        level++;
-        if (level > OB_RTREE_CUTOFF)
-          break;
-      }
-#undef OB_RTREE_CUTOFF
-  }
-
   OBRTree::OBRTree(OBAtom *atom,OBRTree *prv)
   {
     _atom = atom;
@@ -395,6 +395,7 @@ namespace OpenBabel
       for (unsigned int j = 0; j < _vrings.size(); ++j) {
         vector<int> path = _vrings[j];
         double torsionSum = 0.0;
+        bool unassigned = false;
 
         // go around the loop and add up the torsions
         for (unsigned int i = 0; i < path.size(); ++i) {
@@ -403,6 +404,11 @@ namespace OpenBabel
             torsionSum += _vringTors[j][i];
             continue;
           }
+          if (arr[ path[i]+1 ] == -1) {
+            // a rotor that is skipped, so the ring cannot be checked yet
+            unassigned = true;
+            break;
+          }
 
           // what angle are we trying to use with this key?
           angle = _vres[ path[i] ][arr[ path[i]+1 ]]*res;
@@ -417,7 +423,7 @@ namespace OpenBabel
         }
 
         // if the sum of the ring torsions is not ~0, bad move
-        if (fabs(torsionSum) > 45.0) {
+        if (!unassigned && fabs(torsionSum) > 45.0) {
           //          cerr << " Bad move! " << fabs(torsionSum) << endl;
           return; // don't make the move
         }
@@ -528,6 +534,7 @@ namespace OpenBabel
       for (unsigned int j = 0; j < _vrings.size(); ++j) {
         vector<int> path = _vrings[j];
         double torsionSum = 0.0;
+        bool unassigned = false;
 
         // go around the loop and add up the torsions
         for (unsigned int i = 0; i < path.size(); ++i) {
@@ -536,6 +543,11 @@ namespace OpenBabel
             torsionSum += _vringTors[j][i];
             continue;
           }
+          if (arr[ path[i]+1 ] == -1) {
+            // a rotor that is skipped, so the ring cannot be checked yet
+            unassigned = true;
+            break;
+          }
 
           // what angle are we trying to use with this key?
           angle = _vres[ path[i] ][arr[ path[i]+1 ]];
@@ -550,7 +562,7 @@ namespace OpenBabel
         }
 
         // if the sum of the ring torsions is not ~0, bad move
-        if (fabs(torsionSum) > 45.0) {
+        if (!unassigned && fabs(torsionSum) > 45.0) {
           //          cerr << " Bad move!" << endl;
           return false; // don't make the move
         }
@@ -0,0 +1,620 @@
+/**********************************************************************
+stringcache.cpp - Memoisation of strings computed from molecular graphs
+
+This file is part of the Open Babel project.
+For more information, see <http://openbabel.org/>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+***********************************************************************/
+
+#include <openbabel/babelconfig.h>
+#include <openbabel/stringcache.h>
+#include <openbabel/mol.h>
+#include <openbabel/atom.h>
+#include <openbabel/bond.h>
+#include <openbabel/generic.h>
+#include <openbabel/obiter.h>
+#include <openbabel/stereo/stereo.h>
+#include <openbabel/stereo/tetrahedral.h>
+#include <openbabel/stereo/cistrans.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+namespace OpenBabel
+{
+  OBMolStringCache::OBMolStringCache(size_t maxSize) : _maxSize(maxSize)
+  {
+    memset(&_stats, 0, sizeof(_stats));
+  }
+
+  OBMolStringCache& OBMolStringCache::Default()
+  {
+    static OBMolStringCache cache(getenv("BABEL_STRINGCACHE") ?
+        strtoul(getenv("BABEL_STRINGCACHE"), NULL, 10) : 0);
+    return cache;
+  }
+
+  void OBMolStringCache::SetMaxSize(size_t maxSize)
+  {
+    lock_guard<mutex> lock(_mutex);
+    _maxSize = maxSize;
+    Trim();
+  }
+
+  size_t OBMolStringCache::GetMaxSize() const
+  {
+    lock_guard<mutex> lock(_mutex);
+    return _maxSize;
+  }
+
+  // Combine @p value into the hash @p h (the splitmix64 finalizer on top of
+  // boost::hash_combine)
+  static inline unsigned long long Mix(unsigned long long h, unsigned long long value)
+  {
+    h ^= value + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+  }
+
+  static size_t CountDistinct(vector<unsigned long long> values)
+  {
+    sort(values.begin(), values.end());
+    return unique(values.begin(), values.end()) - values.begin();
+  }
+
+  // The index of the atom with id @p ref, or -1 for an implicit hydrogen
+  static bool RefIndex(OBMol& mol, unsigned long ref, int& index)
+  {
+    if (ref == OBStereo::ImplicitRef) {
+      index = -1;
+      return true;
+    }
+    OBAtom* atom = mol.GetAtomById(ref);
+    if (!atom)
+      return false;
+    index = atom->GetIndex();
+    return true;
+  }
+
+  // The parity of the permutation that sorts @p values, or 2 if two are equal
+  template<int N>
+  static int SortParity(const unsigned long long (&values)[N])
+  {
+    int inversions = 0;
+    for (int i = 0; i < N; ++i)
+      for (int j = i + 1; j < N; ++j) {
+        if (values[i] == values[j])
+          return 2;
+        if (values[i] > values[j])
+          ++inversions;
+      }
+    return inversions % 2;
+  }
+
+  // Refs @p i and @p j in the U shape are cis
+  static inline bool IsCis(int i, int j)
+  {
+    return (i == 0 && j == 3) || (i == 3 && j == 0) || (i == 1 && j == 2) || (i == 2 && j == 1);
+  }
+
+  bool OBMolStringCache::GraphKey(OBMol& mol, const string& kind, Key& key)
+  {
+    // The writers use these instead of (or as well as) the graph, or
+    // (for reactions) per-atom data that is not part of the key
+    if (mol.IsReaction() || mol.HasData("inchi") || mol.HasData("SMILES_Fragment")
+        || mol.HasData(OBGenericDataType::ExternalBondData) || mol.NumAtoms() == 0)
+      return false;
+
+    // Stereo is perceived from the coordinates or wedges here, as the
+    // writers do, so that the key needs neither
+    PerceiveStereo(&mol);
+
+    const unsigned int numAtoms = mol.NumAtoms();
+    key._kind = kind;
+    key._dim = mol.GetDimension();
+    key._labels.assign(numAtoms, 0);
+    key._nbrs.assign(numAtoms, Key::Neighbors());
+    key._tetrahedral.clear();
+    key._cistrans.clear();
+
+    FOR_ATOMS_OF_MOL (atom, mol) {
+      key._labels[atom->GetIndex()] = static_cast<unsigned long long>(atom->GetAtomicNum())
+        | static_cast<unsigned long long>(static_cast<unsigned char>(atom->GetFormalCharge())) << 8
+        | static_cast<unsigned long long>(atom->GetIsotope() & 0xffff) << 16
+        | static_cast<unsigned long long>(atom->GetImplicitHCount() & 0xff) << 32
+        | static_cast<unsigned long long>(atom->GetSpinMultiplicity() & 0x7f) << 40
+        | static_cast<unsigned long long>(atom->IsAromatic()) << 47
+        | static_cast<unsigned long long>(atom->GetExplicitDegree() & 0xffff) << 48;
+    }
+    FOR_BONDS_OF_MOL (bond, mol) {
+      unsigned int begin = bond->GetBeginAtom()->GetIndex();
+      unsigned int end = bond->GetEndAtom()->GetIndex();
+      unsigned int code = bond->GetBondOrder() | (bond->IsAromatic() ? 0x100 : 0);
+      key._nbrs[begin].push_back(make_pair(end, code));
+      key._nbrs[end].push_back(make_pair(begin, code));
+    }
+
+    // Refine the atom labels by those of the neighbors until no more classes split
+    vector<unsigned long long>& classes = key._classes;
+    classes.resize(numAtoms);
+    for (unsigned int i = 0; i < numAtoms; ++i)
+      classes[i] = Mix(0, key._labels[i]);
+    size_t numClasses = CountDistinct(classes);
+    vector<unsigned long long> next(numAtoms), env;
+    for (unsigned int iter = 0; iter < numAtoms; ++iter) {
+      for (unsigned int i = 0; i < numAtoms; ++i) {
+        env.clear();
+        for (Key::Neighbors::const_iterator n = key._nbrs[i].begin(); n != key._nbrs[i].end(); ++n)
+          env.push_back(Mix(n->second, classes[n->first]));
+        sort(env.begin(), env.end());
+        unsigned long long h = classes[i];
+        for (vector<unsigned long long>::const_iterator e = env.begin(); e != env.end(); ++e)
+          h = Mix(h, *e);
+        next[i] = h;
+      }
+      classes.swap(next);
+      size_t count = CountDistinct(classes);
+      if (count == numClasses)
+        break;
+      numClasses = count;
+    }
+
+    // The stereo descriptors in terms of atom indices. The hash takes the
+    // parity with respect to the classes of the ligands where they differ.
+    vector<unsigned long long> stereo;
+    std::vector<OBGenericData*> data = mol.GetAllData(OBGenericDataType::StereoData);
+    for (std::vector<OBGenericData*>::iterator i = data.begin(); i != data.end(); ++i) {
+      OBStereo::Type type = static_cast<OBStereoBase*>(*i)->GetType();
+      if (type == OBStereo::Tetrahedral) {
+        OBTetrahedralStereo* ts = static_cast<OBTetrahedralStereo*>(*i);
+        if (!ts->IsValid())
+          return false;
+        OBTetrahedralStereo::Config cfg = ts->GetConfig();
+        Key::Tetrahedral t;
+        t.specified = cfg.specified;
+        if (!RefIndex(mol, cfg.center, t.center) || t.center < 0
+            || !RefIndex(mol, cfg.from, t.ligands[0]) || cfg.refs.size() != 3)
+          return false;
+        for (int j = 0; j < 3; ++j)
+          if (!RefIndex(mol, cfg.refs[j], t.ligands[j + 1]))
+            return false;
+        key._tetrahedral.push_back(t);
+
+        unsigned long long ligands[4];
+        for (int j = 0; j < 4; ++j)
+          ligands[j] = t.ligands[j] < 0 ? 0 : classes[t.ligands[j]];
+        stereo.push_back(Mix(Mix(OBStereo::Tetrahedral, classes[t.center]),
+                             t.specified ? SortParity(ligands) : 3));
+      }
+      else if (type == OBStereo::CisTrans) {
+        OBCisTransStereo* ct = static_cast<OBCisTransStereo*>(*i);
+        if (!ct->IsValid())
+          return false;
+        OBCisTransStereo::Config cfg = ct->GetConfig(OBStereo::ShapeU);
+        Key::CisTrans c;
+        c.specified = cfg.specified;
+        if (!RefIndex(mol, cfg.begin, c.begin) || !RefIndex(mol, cfg.end, c.end)
+            || c.begin < 0 || c.end < 0 || cfg.refs.size() != 4)
+          return false;
+        for (int j = 0; j < 4; ++j)
+          if (!RefIndex(mol, cfg.refs[j], c.refs[j]))
+            return false;
+        key._cistrans.push_back(c);
+
+        // Whether the ligands of higher class on either side are cis
+        unsigned long long refs[4];
+        for (int j = 0; j < 4; ++j)
+          refs[j] = c.refs[j] < 0 ? 0 : classes[c.refs[j]];
+        int flag = 3;
+        if (c.specified)
+          flag = refs[0] == refs[1] || refs[2] == refs[3] ? 2
+            : IsCis(refs[0] > refs[1] ? 0 : 1, refs[2] > refs[3] ? 2 : 3);
+        stereo.push_back(Mix(Mix(Mix(OBStereo::CisTrans, min(classes[c.begin], classes[c.end])),
+                                 max(classes[c.begin], classes[c.end])), flag));
+      }
+      else
+        return false; // a kind of stereo we do not know how to key
+    }
+
+    unsigned long long h = Mix(0, key._dim);
+    for (string::const_iterator i = kind.begin(); i != kind.end(); ++i)
+      h = Mix(h, static_cast<unsigned char>(*i));
+    vector<unsigned long long> sorted(classes);
+    sort(sorted.begin(), sorted.end());
+    for (vector<unsigned long long>::const_iterator i = sorted.begin(); i != sorted.end(); ++i)
+      h = Mix(h, *i);
+    sort(stereo.begin(), stereo.end());
+    for (vector<unsigned long long>::const_iterator i = stereo.begin(); i != stereo.end(); ++i)
+      h = Mix(h, *i);
+    key._hash = h;
+    return true;
+  }
+
+  namespace {
+    // Search for a mapping of the atoms of one key onto those of another
+    // that keeps the labels, classes, bonds and stereo
+    class KeyMapper
+    {
+    public:
+      KeyMapper(const vector<unsigned long long>& qlabels, const vector<unsigned long long>& qclasses,
+                const vector<vector<pair<unsigned int, unsigned int> > >& qnbrs,
+                const vector<unsigned long long>& slabels, const vector<unsigned long long>& sclasses,
+                const vector<vector<pair<unsigned int, unsigned int> > >& snbrs)
+        : ql(qlabels), qc(qclasses), qn(qnbrs), sl(slabels), sc(sclasses), sn(snbrs),
+          map(qlabels.size(), -1), used(slabels.size(), false)
+      {
+      }
+
+      const vector<unsigned long long> &ql, &qc;
+      const vector<vector<pair<unsigned int, unsigned int> > >& qn;
+      const vector<unsigned long long> &sl, &sc;
+      const vector<vector<pair<unsigned int, unsigned int> > >& sn;
+      vector<int> map;
+      vector<bool> used;
+
+      // Query atom @p a can be mapped onto @p c given the atoms mapped so far
+      bool Feasible(unsigned int a, unsigned int c) const
+      {
+        if (used[c] || qc[a] != sc[c] || ql[a] != sl[c])
+          return false;
+        unsigned int mapped = 0;
+        for (vector<pair<unsigned int, unsigned int> >::const_iterator n = qn[a].begin(); n != qn[a].end(); ++n) {
+          if (map[n->first] < 0)
+            continue;
+          ++mapped;
+          bool found = false;
+          for (vector<pair<unsigned int, unsigned int> >::const_iterator m = sn[c].begin(); m != sn[c].end(); ++m)
+            if (static_cast<int>(m->first) == map[n->first] && m->second == n->second) {
+              found = true;
+              break;
+            }
+          if (!found)
+            return false;
+        }
+        for (vector<pair<unsigned int, unsigned int> >::const_iterator m = sn[c].begin(); m != sn[c].end(); ++m)
+          if (used[m->first])
+            --mapped;
+        return mapped == 0;
+      }
+    };
+  }
+
+  // The position of @p value in @p values, or -1
+  static inline int Position(const int* values, int size, int value)
+  {
+    for (int i = 0; i < size; ++i)
+      if (values[i] == value)
+        return i;
+    return -1;
+  }
+
+  bool OBMolStringCache::Key::Matches(const Key& other) const
+  {
+    vector<int> tetrahedral, cistrans;
+    return Map(other, tetrahedral, cistrans);
+  }
+
+  bool OBMolStringCache::Key::Map(const Key& other, vector<int>& tetrahedral,
+                                  vector<int>& cistrans) const
+  {
+    const unsigned int n = _labels.size();
+    if (_hash != other._hash || _kind != other._kind || _dim != other._dim
+        || n != other._labels.size() || _tetrahedral.size() != other._tetrahedral.size()
+        || _cistrans.size() != other._cistrans.size())
+      return false;
+
+    KeyMapper mapper(_labels, _classes, _nbrs, other._labels, other._classes, other._nbrs);
+    vector<int>& map = mapper.map;
+
+    // Visit the atoms breadth first, starting each fragment from an atom of
+    // the rarest class, so that all but the first have a mapped neighbor
+    vector<unsigned int> order;
+    vector<int> parent;
+    order.reserve(n);
+    parent.reserve(n);
+    vector<bool> visited(n, false);
+    std::map<unsigned long long, unsigned int> frequency;
+    for (unsigned int i = 0; i < n; ++i)
+      frequency[_classes[i]]++;
+    while (order.size() < n) {
+      int root = -1;
+      for (unsigned int i = 0; i < n; ++i)
+        if (!visited[i] && (root < 0 || frequency[_classes[i]] < frequency[_classes[root]]))
+          root = i;
+      visited[root] = true;
+      order.push_back(root);
+      parent.push_back(-1);
+      for (size_t k = order.size() - 1; k < order.size(); ++k)
+        for (Neighbors::const_iterator nbr = _nbrs[order[k]].begin(); nbr != _nbrs[order[k]].end(); ++nbr)
+          if (!visited[nbr->first]) {
+            visited[nbr->first] = true;
+            order.push_back(nbr->first);
+            parent.push_back(order[k]);
+          }
+    }
+
+    // Where the other key has stereo, by center
+    vector<int> otherTetrahedral(n, -1);
+    for (size_t i = 0; i < other._tetrahedral.size(); ++i)
+      otherTetrahedral[other._tetrahedral[i].center] = i;
+
+    // Backtrack over the candidates for each atom in turn. Highly symmetric
+    // molecules with stereo can have very many mappings to try, so give up
+    // (and treat it as a miss) after a while.
+    const unsigned long maxSteps = 10000 + 100UL * n;
+    unsigned long steps = 0;
+    vector<size_t> next(n + 1, 0);
+    size_t depth = 0;
+    for (;;) {
+      if (depth == n) {
+        if (StereoMatches(other, map, otherTetrahedral, tetrahedral, cistrans))
+          return true;
+      }
+      else {
+        const unsigned int a = order[depth];
+        const Neighbors* candidates = parent[depth] < 0 ? NULL : &other._nbrs[map[parent[depth]]];
+        const size_t numCandidates = candidates ? candidates->size() : n;
+        bool assigned = false;
+        while (next[depth] < numCandidates) {
+          unsigned int c = candidates ? (*candidates)[next[depth]].first : next[depth];
+          ++next[depth];
+          if (++steps > maxSteps)
+            return false;
+          if (mapper.Feasible(a, c)) {
+            map[a] = c;
+            mapper.used[c] = true;
+            assigned = true;
+            break;
+          }
+        }
+        if (assigned) {
+          ++depth;
+          next[depth] = 0;
+          continue;
+        }
+      }
+      // backtrack
+      if (depth == 0)
+        return false;
+      --depth;
+      mapper.used[map[order[depth]]] = false;
+      map[order[depth]] = -1;
+    }
+  }
+
+  bool OBMolStringCache::Key::StereoMatches(const Key& other, const vector<int>& map,
+                                            const vector<int>& otherTetrahedral,
+                                            vector<int>& tetrahedral, vector<int>& cistrans) const
+  {
+    tetrahedral.clear();
+    cistrans.clear();
+    for (vector<Tetrahedral>::const_iterator t = _tetrahedral.begin(); t != _tetrahedral.end(); ++t) {
+      int i = otherTetrahedral[map[t->center]];
+      if (i < 0)
+        return false;
+      const Tetrahedral& o = other._tetrahedral[i];
+      if (t->specified != o.specified)
+        return false;
+      tetrahedral.push_back(i);
+      if (!t->specified)
+        continue;
+      // The mapped ligands must be an even permutation of the other's
+      int perm[4];
+      for (int j = 0; j < 4; ++j) {
+        perm[j] = Position(o.ligands, 4, t->ligands[j] < 0 ? -1 : map[t->ligands[j]]);
+        if (perm[j] < 0 || Position(perm, j, perm[j]) >= 0)
+          return false;
+      }
+      int inversions = 0;
+      for (int j = 0; j < 4; ++j)
+        for (int k = j + 1; k < 4; ++k)
+          if (perm[j] > perm[k])
+            ++inversions;
+      if (inversions % 2)
+        return false;
+    }
+
+    for (vector<CisTrans>::const_iterator c = _cistrans.begin(); c != _cistrans.end(); ++c) {
+      const int begin = map[c->begin], end = map[c->end];
+      vector<CisTrans>::const_iterator o = other._cistrans.begin();
+      for (; o != other._cistrans.end(); ++o)
+        if ((o->begin == begin && o->end == end) || (o->begin == end && o->end == begin))
+          break;
+      if (o == other._cistrans.end() || c->specified != o->specified)
+        return false;
+      cistrans.push_back(o - other._cistrans.begin());
+      if (!c->specified)
+        continue;
+      // Compare the relation of an explicit ligand on either side
+      int x = c->refs[0] >= 0 ? 0 : 1;
+      int y = c->refs[2] >= 0 ? 2 : 3;
+      if (c->refs[x] < 0 || c->refs[y] < 0)
+        return false;
+      int ox = Position(o->refs, 4, map[c->refs[x]]);
+      int oy = Position(o->refs, 4, map[c->refs[y]]);
+      if (ox < 0 || oy < 0 || IsCis(x, y) != IsCis(ox, oy))
+        return false;
+    }
+    return true;
+  }
+
+  // Whether each tetrahedral and cis/trans stereo descriptor of @p mol is
+  // specified, in the order of GraphKey()
+  static void SpecifiedStereo(OBMol& mol, vector<bool>& tetrahedral, vector<bool>& cistrans)
+  {
+    tetrahedral.clear();
+    cistrans.clear();
+    std::vector<OBGenericData*> data = mol.GetAllData(OBGenericDataType::StereoData);
+    for (std::vector<OBGenericData*>::iterator i = data.begin(); i != data.end(); ++i) {
+      OBStereo::Type type = static_cast<OBStereoBase*>(*i)->GetType();
+      if (type == OBStereo::Tetrahedral)
+        tetrahedral.push_back(static_cast<OBTetrahedralStereo*>(*i)->GetConfig().specified);
+      else if (type == OBStereo::CisTrans)
+        cistrans.push_back(static_cast<OBCisTransStereo*>(*i)->GetConfig().specified);
+    }
+  }
+
+  bool OBMolStringCache::Find(const Key& key, string& value)
+  {
+    vector<int> tetrahedral, cistrans;
+    return Find(key, value, tetrahedral, cistrans);
+  }
+
+  bool OBMolStringCache::Find(OBMol& mol, const Key& key, string& value)
+  {
+    // The stereo descriptors to mark as unspecified
+    vector<int> tetrahedral, cistrans;
+    if (!Find(key, value, tetrahedral, cistrans))
+      return false;
+    if (tetrahedral.empty() && cistrans.empty())
+      return true;
+
+    int t = 0, c = 0;
+    std::vector<OBGenericData*> data = mol.GetAllData(OBGenericDataType::StereoData);
+    for (std::vector<OBGenericData*>::iterator i = data.begin(); i != data.end(); ++i) {
+      OBStereo::Type type = static_cast<OBStereoBase*>(*i)->GetType();
+      if (type == OBStereo::Tetrahedral) {
+        if (find(tetrahedral.begin(), tetrahedral.end(), t++) != tetrahedral.end()) {
+          OBTetrahedralStereo* ts = static_cast<OBTetrahedralStereo*>(*i);
+          OBTetrahedralStereo::Config cfg = ts->GetConfig();
+          cfg.specified = false;
+          ts->SetConfig(cfg);
+        }
+      }
+      else if (type == OBStereo::CisTrans) {
+        if (find(cistrans.begin(), cistrans.end(), c++) != cistrans.end()) {
+          OBCisTransStereo* ct = static_cast<OBCisTransStereo*>(*i);
+          OBCisTransStereo::Config cfg = ct->GetConfig();
+          cfg.specified = false;
+          ct->SetConfig(cfg);
+        }
+      }
+    }
+    return true;
+  }
+
+  bool OBMolStringCache::Find(const Key& key, string& value,
+                              vector<int>& tetrahedral, vector<int>& cistrans)
+  {
+    vector<int> mappedTetrahedral, mappedCisTrans;
+    lock_guard<mutex> lock(_mutex);
+    map<unsigned long long, EntryList::iterator>::iterator it = _index.find(key.GetHash());
+    if (it == _index.end()) {
+      ++_stats.misses;
+      return false;
+    }
+    const Entry& entry = *it->second;
+    if (!key.Map(entry.key, mappedTetrahedral, mappedCisTrans)) {
+      ++_stats.misses;
+      ++_stats.collisions;
+      return false;
+    }
+    tetrahedral.clear();
+    for (size_t i = 0; i < mappedTetrahedral.size(); ++i)
+      if (entry.unspecified.first[mappedTetrahedral[i]])
+        tetrahedral.push_back(i);
+    cistrans.clear();
+    for (size_t i = 0; i < mappedCisTrans.size(); ++i)
+      if (entry.unspecified.second[mappedCisTrans[i]])
+        cistrans.push_back(i);
+    _entries.splice(_entries.begin(), _entries, it->second);
+    value = it->second->value;
+    ++_stats.hits;
+    return true;
+  }
+
+  void OBMolStringCache::Insert(const Key& key, const string& value)
+  {
+    Entry entry;
+    entry.key = key;
+    entry.value = value;
+    entry.unspecified.first.assign(key._tetrahedral.size(), false);
+    entry.unspecified.second.assign(key._cistrans.size(), false);
+    Insert(entry);
+  }
+
+  void OBMolStringCache::Insert(OBMol& mol, const Key& key, const string& value)
+  {
+    // Record the stereo that was marked as unspecified after the key was built
+    vector<bool> tetrahedral, cistrans;
+    SpecifiedStereo(mol, tetrahedral, cistrans);
+    if (tetrahedral.size() != key._tetrahedral.size() || cistrans.size() != key._cistrans.size())
+      return; // stereo was added or removed, which a hit cannot repeat
+    Entry entry;
+    entry.key = key;
+    entry.value = value;
+    entry.unspecified.first.resize(tetrahedral.size());
+    for (size_t i = 0; i < tetrahedral.size(); ++i)
+      entry.unspecified.first[i] = key._tetrahedral[i].specified && !tetrahedral[i];
+    entry.unspecified.second.resize(cistrans.size());
+    for (size_t i = 0; i < cistrans.size(); ++i)
+      entry.unspecified.second[i] = key._cistrans[i].specified && !cistrans[i];
+    Insert(entry);
+  }
+
+  void OBMolStringCache::Insert(const Entry& entry)
+  {
+    lock_guard<mutex> lock(_mutex);
+    if (_maxSize == 0)
+      return;
+    map<unsigned long long, EntryList::iterator>::iterator it = _index.find(entry.key.GetHash());
+    if (it != _index.end()) {
+      // Same key computed concurrently, or a colliding key: the newer one wins
+      *it->second = entry;
+      _entries.splice(_entries.begin(), _entries, it->second);
+      return;
+    }
+    _entries.push_front(entry);
+    _index[entry.key.GetHash()] = _entries.begin();
+    Trim();
+  }
+
+  void OBMolStringCache::Trim()
+  {
+    while (_entries.size() > _maxSize) {
+      _index.erase(_entries.back().key.GetHash());
+      _entries.pop_back();
+      ++_stats.evictions;
+    }
+  }
+
+  void OBMolStringCache::Clear()
+  {
+    lock_guard<mutex> lock(_mutex);
+    _entries.clear();
+    _index.clear();
+  }
+
+  OBMolStringCache::Statistics OBMolStringCache::GetStatistics() const
+  {
+    lock_guard<mutex> lock(_mutex);
+    Statistics stats = _stats;
+    stats.size = _index.size();
+    return stats;
+  }
+
+  void OBMolStringCache::ResetStatistics()
+  {
+    lock_guard<mutex> lock(_mutex);
+    memset(&_stats, 0, sizeof(_stats));
+  }
+
+} // namespace OpenBabel
+
+//! \file stringcache.cpp
+//! \brief Memoisation of canonical strings computed from molecules
@@ -67,6 +67,45 @@ namespace OpenBabel
     _dataptr = AtomTypeData;
   }
 
+  // Index rule idx under each atomic number its first atom could match.
+  // The key is the element only: MatchesAt() tests the first atom's
+  // expression (degree, charge, ring membership...) before anything else,
+  // so a finer key would only save that one test per rule, and each element
+  // has a handful of rules.
+  static void IndexRule(const OBSmartsPattern *sp, unsigned int idx,
+                        vector<vector<unsigned int> > &index)
+  {
+    vector<bool> elements;
+    sp->GetFirstAtomElements(elements);
+    if (index.empty())
+      index.resize(elements.size());
+    for (unsigned int n = 0; n < elements.size(); ++n)
+      if (elements[n])
+        index[n].push_back(idx);
+  }
+
+  // \return the last of the rules that matches at atom, or -1. Later rules
+  // override earlier ones, so this is the rule that decides the atom's value.
+  template<typename T>
+  static int LastMatchingRule(OBAtom *atom,
+                              const vector<pair<OBSmartsPattern*,T> > &rules,
+                              const vector<vector<unsigned int> > &index)
+  {
+    unsigned int n = atom->GetAtomicNum();
+    if (n < index.size()) {
+      const vector<unsigned int> &candidates = index[n];
+      for (vector<unsigned int>::const_reverse_iterator i = candidates.rbegin();
+           i != candidates.rend(); ++i)
+        if (rules[*i].first->MatchesAt(atom))
+          return *i;
+      return -1;
+    }
+    for (int i = rules.size() - 1; i >= 0; --i)
+      if (rules[i].first->MatchesAt(atom))
+        return i;
+    return -1;
+  }
+
   void OBAtomTyper::ParseLine(const char *buffer)
   {
     vector<string> vs;
@@ -83,7 +122,10 @@ namespace OpenBabel
 
         sp = new OBSmartsPattern;
         if (sp->Init(vs[1]))
-          _vinthyb.push_back(pair<OBSmartsPattern*,int> (sp,atoi((char*)vs[2].c_str())));
+          {
+            IndexRule(sp, _vinthyb.size(), _inthybIndex);
+            _vinthyb.push_back(pair<OBSmartsPattern*,int> (sp,atoi((char*)vs[2].c_str())));
+          }
         else
           {
             delete sp;
@@ -102,7 +144,10 @@ namespace OpenBabel
           }
         sp = new OBSmartsPattern;
         if (sp->Init(vs[1]))
-          _vexttyp.push_back(pair<OBSmartsPattern*,string> (sp,vs[2]));
+          {
+            IndexRule(sp, _vexttyp.size(), _exttypIndex);
+            _vexttyp.push_back(pair<OBSmartsPattern*,string> (sp,vs[2]));
+          }
         else
           {
             delete sp;
@@ -141,21 +186,17 @@ namespace OpenBabel
 
     mol.SetAtomTypesPerceived();
 
-    vector<vector<int> >::iterator j;
-    vector<pair<OBSmartsPattern*,string> >::iterator i;
-
-    for (i = _vexttyp.begin(); i != _vexttyp.end(); ++i) {
-      std::vector<std::vector<int> > mlist;
-      if (i->first->Match(mol, mlist))
-      {
-        for (j = mlist.begin(); j != mlist.end(); ++j)
-          mol.GetAtom((*j)[0])->SetType(i->second);
-      }
+    // Only the rules that could apply to an element are tried, and only
+    // at the atom itself; an atom no rule matches keeps its type
+    vector<OBAtom*>::iterator a;
+    OBAtom* atom;
+    for (atom = mol.BeginAtom(a); atom; atom = mol.NextAtom(a)) {
+      int rule = LastMatchingRule(atom, _vexttyp, _exttypIndex);
+      if (rule >= 0)
+        atom->SetType(_vexttyp[rule].second);
     }
 
     // Special cases
-    vector<OBAtom*>::iterator a;
-    OBAtom* atom;
     for (atom = mol.BeginAtom(a); atom; atom = mol.NextAtom(a)) {
       // guanidinium. Fixes PR#1800964
       if (strncasecmp(atom->GetType(),"C2", 2) == 0) {
@@ -192,16 +233,10 @@ namespace OpenBabel
     for (atom = mol.BeginAtom(k);atom;atom = mol.NextAtom(k))
       atom->SetHyb(0);
 
-    vector<vector<int> >::iterator j;
-    vector<pair<OBSmartsPattern*,int> >::iterator i;
-
-    for (i = _vinthyb.begin(); i != _vinthyb.end(); ++i) {
-      std::vector<std::vector<int> > mlist;
-      if (i->first->Match(mol, mlist))
-      {
-        for (j = mlist.begin(); j != mlist.end(); ++j)
-          mol.GetAtom((*j)[0])->SetHyb(i->second);
-      }
+    for (atom = mol.BeginAtom(k);atom;atom = mol.NextAtom(k)) {
+      int rule = LastMatchingRule(atom, _vinthyb, _inthybIndex);
+      if (rule >= 0)
+        atom->SetHyb(_vinthyb[rule].second);
     }
 
     // check all atoms to make sure *some* hybridization is assigned
@@ -262,8 +297,11 @@ namespace OpenBabel
         return;
       }
       sp = new OBSmartsPattern;
-      if (sp->Init(vs[2]))
+      if (sp->Init(vs[2])) {
         _ringtyp.push_back(pair<OBSmartsPattern*,string> (sp,vs[1]));
+        _ringElements.push_back(vector<bool>());
+        sp->GetFirstAtomElements(_ringElements.back());
+      }
       else {
         delete sp;
         sp = NULL;
@@ -299,8 +337,27 @@ namespace OpenBabel
     vector<int>::iterator j;
     vector<OBRing*> rlist = mol.GetSSSR();
 
+    if (rlist.empty())
+      return;
+
+    // A rule can only match if some atom is a possible first atom
+    vector<bool> molElements;
+    FOR_ATOMS_OF_MOL(atom, mol) {
+      unsigned int n = atom->GetAtomicNum();
+      if (n >= molElements.size())
+        molElements.resize(n + 1);
+      molElements[n] = true;
+    }
+
     unsigned int member_count;
     for (i2 = _ringtyp.begin();i2 != _ringtyp.end();++i2) { // for each ring type
+      const vector<bool> &first = _ringElements[i2 - _ringtyp.begin()];
+      bool possible = molElements.size() > first.size();
+      for (unsigned int n = 0; n < molElements.size() && !possible; ++n)
+        possible = molElements[n] && first[n];
+      if (!possible)
+        continue;
+
       std::vector<std::vector<int> > mlist;
       if (i2->first->Match(mol, mlist)) {
         for (j2 = mlist.begin();j2 != mlist.end();++j2) { // for each found match
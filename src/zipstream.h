@@ -29,20 +29,36 @@ Altered by: Andreas Zieringer 2003 for OpenSG project
 
 Altered by: Geoffrey Hutchison 2005 for Open Babel project
             minor namespace modifications, VC++ compatibility
+
+Altered for Open Babel 3.1: BGZF block output and block-parallel input,
+            larger default buffers
 */
 
 #ifndef _ZIPSTREAM_H_
 #define _ZIPSTREAM_H_
 
 #include <vector>
+#include <deque>
 #include <string>
 #include <streambuf>
 #include <sstream>
 #include <iosfwd>
 #include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
 
 #include <zlib.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #ifdef WIN32 /* Window 95 & Windows NT */
 #  define OS_CODE  0x0b
 #endif
@@ -66,11 +82,99 @@ namespace detail
     const int gz_orig_name  =  0x08; /* bit 3 set: original file name present */
     const int gz_comment    =  0x10; /* bit 4 set: file comment present */
     const int gz_reserved   =  0xE0; /* bits 5..7: reserved */
+
+    /// Largest BGZF member, header and footer included
+    const size_t bgzf_max_block_size = 0x10000;
+    /// BGZF member header: gzip header with a 6 byte "BC" extra field
+    const size_t bgzf_header_size = 18;
+
+    /// A unit of work for the block compressor/decompressor: one BGZF member
+    struct bgzf_block
+    {
+        std::vector<char> in;           ///< input: text (writing) or member payload (reading)
+        std::vector<char> out;          ///< output: member (writing) or text (reading)
+        std::streamoff    coffset;      ///< offset of the member in the compressed stream
+        std::streamoff    uoffset;      ///< offset of its text in the uncompressed stream
+        bool              ready;
+        bool              ok;
+
+        bgzf_block() : coffset(0), uoffset(0), ready(false), ok(false) {}
+    };
+
+    /// Compress \p len bytes of text into one BGZF member in \p out
+    inline void bgzf_compress(const char* text, size_t len, int level,
+                              std::vector<char>& out);
+    /// Inflate the payload of a BGZF member (everything after the header)
+    /// into \p out, leaving \p putback bytes free at the front
+    inline bool bgzf_decompress(const std::vector<char>& payload,
+                                std::vector<char>& out, size_t putback);
+
+    /// Number of threads in the shared pool: the OpenMP thread count
+    /// (OMP_NUM_THREADS) when built with OpenMP, otherwise one per core
+    inline unsigned int default_thread_count();
+
+    /** \brief A fixed set of threads that run compression jobs.
+
+    Jobs finish in any order; each sets its ready flag under the pool's lock
+    and the owner waits for the flags in the order it needs the results.
+    With no worker threads jobs run at once in add().
+    */
+    class block_worker_pool
+    {
+    public:
+        explicit block_worker_pool(unsigned int threads);
+        ~block_worker_pool(void);
+
+        inline size_t size(void) const { return _workers.size(); }
+        inline void   add (const std::function<void()>& job, bool* ready);
+        inline void   wait(const bool* ready);
+
+    private:
+        block_worker_pool(const block_worker_pool&);
+        block_worker_pool& operator=(const block_worker_pool&);
+
+        void run(void);
+
+        std::vector<std::thread>  _workers;
+        std::deque<std::pair<std::function<void()>, bool*> > _jobs;
+        std::mutex                _mutex;
+        std::condition_variable   _wake;
+        std::condition_variable   _done;
+        bool                      _stop;
+    };
+
+    /// The pool shared by all streams if \p threads is 0, otherwise a pool
+    /// of its own with \p threads threads
+    inline std::shared_ptr<block_worker_pool> worker_pool(unsigned int threads);
+
+    /// Position of one BGZF member, for seeking
+    struct bgzf_index_entry
+    {
+        std::streamoff coffset;
+        std::streamoff uoffset;
+    };
 }
 
+/** \brief Record index of a BGZF file
+
+The uncompressed offset at which each record (e.g. molecule) starts, saved
+next to a BGZF file so that a reader can go to record N through the member
+index instead of reading the records before it. The index also holds the
+size of the compressed file, so one left over from an earlier file is not
+used.
+*/
+inline bool write_record_index(const std::string& path, std::streamoff compressed_size,
+                               const std::vector<std::streamoff>& records);
+/// Read the index at \p path, if it belongs to a file of \p compressed_size bytes
+inline bool read_record_index(const std::string& path, std::streamoff compressed_size,
+                              std::vector<std::streamoff>& records);
+
 /// default gzip buffer size,
 /// change this to suite your needs
-const size_t zstream_default_buffer_size = 4096;
+const size_t zstream_default_buffer_size = 65536;
+
+/// Text bytes per BGZF member; keeps every compressed member under 64 KB
+const size_t bgzf_block_text_size = 0xff00;
 
 /// Compression strategy, see zlib doc.
 enum EStrategy
@@ -166,7 +270,8 @@ public:
     basic_unzip_streambuf(istream_reference istream,
                           int window_size,
                           size_t read_buffer_size,
-                          size_t input_buffer_size);
+                          size_t input_buffer_size,
+                          unsigned int threads = 0);
 
     ~basic_unzip_streambuf(void);
 
@@ -204,6 +309,14 @@ private:
     size_t            fill_input_buffer        (void);
     std::streampos    currentpos               (void);
 
+    // BGZF input: members are read here and inflated ahead on worker threads
+    int_type          bgzf_underflow           (void);
+    void              bgzf_fill_ahead          (void);
+    void              bgzf_add_to_index        (std::streamoff coffset, std::streamoff uoffset,
+                                                std::streamoff csize, std::streamoff usize);
+    std::streampos    bgzf_seek                (std::streamoff target);
+    bool              bgzf_begin               (void);
+
     istream_reference   _istream;
     z_stream            _zip_stream;
     int                 _err;
@@ -211,6 +324,25 @@ private:
     char_vector_type    _buffer;
     unsigned long       _crc;
     unsigned long       _unzipped_component_bytes; //keep track of bytes that were in separately zipped sections for seeking purposes
+
+    size_t              _header_size;   // bytes in the last header read by check_header
+    size_t              _bgzf_bsize;    // size of that member from its BC field, or 0
+    bool                _is_bgzf;       // reading whole members rather than streaming
+    bool                _bgzf_header_read; // header of the next member already consumed
+    bool                _bgzf_input_done;
+    bool                _bgzf_fallback; // next member is plain gzip; continue by streaming
+    unsigned int        _threads;
+    std::shared_ptr<detail::block_worker_pool> _pool;
+    std::deque<std::shared_ptr<detail::bgzf_block> > _bgzf_ahead;
+    char_vector_type    _bgzf_text;     // text of the current member, putback area first
+    char_type*          _bgzf_data;     // start of that text in the get area
+    std::streamoff      _bgzf_uoffset;  // uncompressed offset of _bgzf_data
+    std::streamoff      _bgzf_base;     // stream position of the first member, or -1
+    std::streamoff      _bgzf_coffset;  // offset of the next member to read
+    std::streamoff      _bgzf_next_uoffset;
+    std::vector<detail::bgzf_index_entry> _bgzf_index;
+    std::streamoff      _bgzf_index_cend; // members before these offsets are indexed
+    std::streamoff      _bgzf_index_uend;
 };
 
 //*****************************************************************************
@@ -275,7 +407,8 @@ public:
     explicit basic_zip_istream(istream_reference istream,
                                int window_size = -15 /*windowBits is passed < 0 to suppress zlib header */,
                                size_t read_buffer_size = zstream_default_buffer_size,
-                               size_t input_buffer_size = zstream_default_buffer_size);
+                               size_t input_buffer_size = zstream_default_buffer_size,
+                               unsigned int threads = 0 /* 0: the shared pool */);
 
     inline
     bool     is_gzip           (void) const;
@@ -295,8 +428,97 @@ protected:
     long _gzip_data_size;
 };
 
+//*****************************************************************************
+//  template class basic_bgzf_streambuf
+//*****************************************************************************
+
+/** \brief A stream decorator that writes BGZF to an ostream.
+
+BGZF (from SAMtools) is a series of gzip members holding at most 64 KB each,
+so it is still read by gunzip. The members are independent, so they are
+compressed on worker threads, and a reader can find any of them from the
+sizes in their headers without inflating the rest.
+*/
+template <class charT,
+          class traits = std::char_traits<charT> >
+class basic_bgzf_streambuf : public std::basic_streambuf<charT, traits>
+{
+public:
+    typedef std::basic_ostream<charT, traits>& ostream_reference;
+    typedef char char_type;
+    typedef int int_type;
+
+    basic_bgzf_streambuf(ostream_reference ostream,
+                         int level,
+                         unsigned int threads);
+
+    ~basic_bgzf_streambuf(void);
+
+    int               sync        (void);
+    int_type          overflow    (int_type c);
+    std::streampos    seekoff     (std::streamoff off, std::ios_base::seekdir way,
+                                   std::ios_base::openmode which);
+    void              finish      (void);
+    inline
+    ostream_reference get_ostream (void) const;
+
+    /// Uncompressed position, which is what tellp() returns
+    inline
+    std::streamoff    tell        (void) const;
+    /// Note that a record starts at uncompressed offset \p offset
+    void              add_record  (std::streamoff offset);
+    /// Write the record offsets to \p path in finish(), see write_record_index()
+    void              set_record_index(const std::string& path);
+    /// While \p hold is true sync() does nothing. For writers that flush
+    /// every line (std::endl), where a member per line would make the output
+    /// several times larger.
+    void              hold_sync   (bool hold) { _hold_sync = hold; }
+
+private:
+
+    void              submit_block(void);
+    void              write_blocks(size_t keep);
+
+    ostream_reference   _ostream;
+    int                 _level;
+    std::vector<char_type> _buffer;
+    std::deque<std::shared_ptr<detail::bgzf_block> > _pending;
+    bool                _finished;
+    bool                _hold_sync;
+    std::shared_ptr<detail::block_worker_pool> _pool;
+    std::streamoff      _uoffset;       // text bytes submitted as members
+    std::streamoff      _base;          // position of the first member in the ostream
+    std::vector<std::streamoff> _records;
+    std::string         _index_path;
+};
+
+//*****************************************************************************
+//  template class basic_bgzf_ostream
+//*****************************************************************************
+
+template <class charT,
+          class traits = std::char_traits<charT> >
+class basic_bgzf_ostream :
+    public basic_bgzf_streambuf<charT, traits>,
+    public std::basic_ostream<charT, traits>
+{
+public:
+    typedef std::basic_ostream<charT, traits>& ostream_reference;
+
+    explicit basic_bgzf_ostream(ostream_reference ostream,
+                                int level = Z_DEFAULT_COMPRESSION,
+                                unsigned int threads = 0 /* 0: the shared pool */);
+
+    ~basic_bgzf_ostream(void);
+
+    /// Write everything buffered and the end-of-file marker
+    void finished(void);
+};
+
 /// A typedef for basic_zip_ostream<char>
 typedef basic_zip_ostream<char> zip_ostream;
+/// A typedef for basic_bgzf_ostream<char>
+typedef basic_bgzf_ostream<char> bgzf_ostream;
 /// A typedef for basic_zip_istream<char>
 typedef basic_zip_istream<char> zip_istream;
 
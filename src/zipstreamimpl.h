@@ -33,6 +33,254 @@ Altered by: Geoffrey Hutchison 2005 for Open Babel project
 
 #include <cstring>
 
+//*****************************************************************************
+//  BGZF members and the worker pool
+//*****************************************************************************
+
+namespace detail
+{
+
+inline void bgzf_compress(const char* text, size_t len, int level,
+                          std::vector<char>& out)
+{
+    out.resize(bgzf_max_block_size);
+    unsigned char* member = reinterpret_cast<unsigned char*>(&out[0]);
+
+    // If the data does not shrink, store it (level 0); that always fits
+    size_t clen = 0;
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        if (deflateInit2(&zs, attempt ? 0 : level, Z_DEFLATED, -15, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK)
+            continue;
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(text));
+        zs.avail_in = static_cast<uInt>(len);
+        zs.next_out = member + bgzf_header_size;
+        zs.avail_out = static_cast<uInt>(bgzf_max_block_size - bgzf_header_size - 8);
+        int err = deflate(&zs, Z_FINISH);
+        clen = zs.total_out;
+        deflateEnd(&zs);
+        if (err == Z_STREAM_END)
+            break;
+    }
+
+    size_t bsize = bgzf_header_size + clen + 8;
+    const unsigned char header[bgzf_header_size] = {
+        static_cast<unsigned char>(gz_magic[0]), static_cast<unsigned char>(gz_magic[1]),
+        Z_DEFLATED, gz_extra_field,
+        0, 0, 0, 0,   // time
+        0, 0xff,      // xflags, OS unknown
+        6, 0,         // extra field length
+        'B', 'C', 2, 0,
+        static_cast<unsigned char>((bsize - 1) & 0xff),
+        static_cast<unsigned char>((bsize - 1) >> 8)
+    };
+    memcpy(member, header, bgzf_header_size);
+
+    unsigned long crc = crc32(crc32(0L, Z_NULL, 0),
+                              reinterpret_cast<const Bytef*>(text), static_cast<uInt>(len));
+    unsigned char* footer = member + bgzf_header_size + clen;
+    for (int n = 0; n < 4; ++n)
+        footer[n] = static_cast<unsigned char>((crc >> (8 * n)) & 0xff);
+    for (int n = 0; n < 4; ++n)
+        footer[4 + n] = static_cast<unsigned char>((len >> (8 * n)) & 0xff);
+
+    out.resize(bsize);
+}
+
+inline bool bgzf_decompress(const std::vector<char>& payload,
+                            std::vector<char>& out, size_t putback)
+{
+    if (payload.size() < 8)
+        return false;
+    const unsigned char* footer =
+        reinterpret_cast<const unsigned char*>(&payload[0]) + payload.size() - 8;
+    unsigned long crc = 0, isize = 0;
+    for (int n = 0; n < 4; ++n)
+    {
+        crc |= static_cast<unsigned long>(footer[n]) << (8 * n);
+        isize |= static_cast<unsigned long>(footer[4 + n]) << (8 * n);
+    }
+    if (isize > bgzf_max_block_size)
+        return false;
+
+    out.resize(putback + isize);
+    if (isize == 0)
+        return true;
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, -15) != Z_OK)
+        return false;
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(&payload[0]));
+    zs.avail_in = static_cast<uInt>(payload.size() - 8);
+    zs.next_out = reinterpret_cast<Bytef*>(&out[putback]);
+    zs.avail_out = static_cast<uInt>(isize);
+    int err = inflate(&zs, Z_FINISH);
+    inflateEnd(&zs);
+
+    return err == Z_STREAM_END && zs.avail_out == 0 &&
+        crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(&out[putback]),
+              static_cast<uInt>(isize)) == crc;
+}
+
+inline unsigned int default_thread_count()
+{
+#ifdef _OPENMP
+    int n = omp_get_max_threads();
+    return n < 1 ? 1 : static_cast<unsigned int>(n);
+#else
+    unsigned int n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+#endif
+}
+
+inline std::shared_ptr<block_worker_pool> worker_pool(unsigned int threads)
+{
+    if (threads)
+        return std::make_shared<block_worker_pool>(threads);
+    // Created on first use and kept alive by the streams using it, so the
+    // process has one set of threads however many streams are open
+    static std::shared_ptr<block_worker_pool> shared(
+        std::make_shared<block_worker_pool>(default_thread_count()));
+    return shared;
+}
+
+inline block_worker_pool::block_worker_pool(unsigned int threads)
+    : _stop(false)
+{
+    if (threads > 1)
+        for (unsigned int i = 0; i < threads; ++i)
+            _workers.push_back(std::thread(&block_worker_pool::run, this));
+}
+
+inline block_worker_pool::~block_worker_pool(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (size_t i = 0; i < _workers.size(); ++i)
+        _workers[i].join();
+}
+
+inline void block_worker_pool::add(const std::function<void()>& job, bool* ready)
+{
+    if (_workers.empty())
+    {
+        job();
+        *ready = true;
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(std::make_pair(job, ready));
+    }
+    _wake.notify_one();
+}
+
+inline void block_worker_pool::wait(const bool* ready)
+{
+    if (_workers.empty())
+        return;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!*ready)
+        _done.wait(lock);
+}
+
+inline void block_worker_pool::run(void)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;)
+    {
+        while (!_stop && _jobs.empty())
+            _wake.wait(lock);
+        if (_stop) // jobs nobody waits for any more are dropped
+            return;
+        std::pair<std::function<void()>, bool*> job = _jobs.front();
+        _jobs.pop_front();
+        lock.unlock();
+        job.first();
+        lock.lock();
+        *job.second = true;
+        _done.notify_all();
+    }
+}
+
+} // namespace detail
+
+//*****************************************************************************
+//  Record index
+//*****************************************************************************
+
+namespace detail
+{
+    const char record_index_magic[4] = { 'O', 'B', 'R', 'I' };
+    const unsigned int record_index_version = 1;
+
+    inline void put_le(std::string& buf, unsigned long long x, int nbytes)
+    {
+        for (int i = 0; i < nbytes; ++i)
+            buf += static_cast<char>((x >> (8 * i)) & 0xff);
+    }
+
+    inline bool get_le(std::istream& is, unsigned long long& x, int nbytes)
+    {
+        unsigned char bytes[8];
+        if (!is.read(reinterpret_cast<char*>(bytes), nbytes))
+            return false;
+        x = 0;
+        for (int i = 0; i < nbytes; ++i)
+            x |= static_cast<unsigned long long>(bytes[i]) << (8 * i);
+        return true;
+    }
+}
+
+/** The file is the magic string "OBRI", the version, the size of the
+ *  compressed file and the number of records (unsigned 32, 64 and 64-bit
+ *  little endian), then the offset of each record as a 64-bit integer.
+ */
+inline bool write_record_index(const std::string& path, std::streamoff compressed_size,
+                               const std::vector<std::streamoff>& records)
+{
+    std::string buf(detail::record_index_magic, 4);
+    detail::put_le(buf, detail::record_index_version, 4);
+    detail::put_le(buf, compressed_size, 8);
+    detail::put_le(buf, records.size(), 8);
+    for (size_t i = 0; i < records.size(); ++i)
+        detail::put_le(buf, records[i], 8);
+    std::ofstream ofs(path.c_str(), std::ios_base::out | std::ios_base::binary);
+    return ofs.write(buf.data(), static_cast<std::streamsize>(buf.size())).good();
+}
+
+inline bool read_record_index(const std::string& path, std::streamoff compressed_size,
+                              std::vector<std::streamoff>& records)
+{
+    records.clear();
+    std::ifstream ifs(path.c_str(), std::ios_base::in | std::ios_base::binary);
+    char magic[4];
+    unsigned long long version, size, count;
+    if (!ifs.read(magic, 4) || memcmp(magic, detail::record_index_magic, 4) != 0 ||
+        !detail::get_le(ifs, version, 4) || version != detail::record_index_version ||
+        !detail::get_le(ifs, size, 8) || size != static_cast<unsigned long long>(compressed_size) ||
+        !detail::get_le(ifs, count, 8) || count > static_cast<unsigned long long>(compressed_size))
+        return false;
+    records.reserve(static_cast<size_t>(count));
+    unsigned long long offset;
+    for (unsigned long long i = 0; i < count; ++i) {
+        if (!detail::get_le(ifs, offset, 8) || (!records.empty() &&
+            static_cast<std::streamoff>(offset) <= records.back())) {
+            records.clear();
+            return false;
+        }
+        records.push_back(static_cast<std::streamoff>(offset));
+    }
+    return true;
+}
+
 //*****************************************************************************
 //  template class basic_zip_streambuf
 //*****************************************************************************
@@ -303,13 +551,28 @@ template <class charT, class traits>
 basic_unzip_streambuf<charT, traits>::basic_unzip_streambuf(istream_reference istream,
                                                             int window_size,
                                                             size_t read_buffer_size,
-                                                            size_t input_buffer_size)
+                                                            size_t input_buffer_size,
+                                                            unsigned int threads)
     : _is_gzip(false),
       _istream(istream),
       _input_buffer(input_buffer_size),
       _buffer(read_buffer_size),
       _crc(0),
-      _unzipped_component_bytes(0)
+      _unzipped_component_bytes(0),
+      _header_size(0),
+      _bgzf_bsize(0),
+      _is_bgzf(false),
+      _bgzf_header_read(false),
+      _bgzf_input_done(false),
+      _bgzf_fallback(false),
+      _threads(threads),
+      _bgzf_data(0),
+      _bgzf_uoffset(0),
+      _bgzf_base(-1),
+      _bgzf_coffset(0),
+      _bgzf_next_uoffset(0),
+      _bgzf_index_cend(0),
+      _bgzf_index_uend(0)
 {
   initialize(window_size);
 }
@@ -354,6 +617,9 @@ basic_unzip_streambuf<charT, traits>::underflow(void)
     if(this->gptr() && ( this->gptr() < this->egptr()))
         return * reinterpret_cast<unsigned char *>(this->gptr());
 
+    if(_is_bgzf || bgzf_begin())
+        return bgzf_underflow();
+
     int n_putback = static_cast<int>(this->gptr() - this->eback());
     if(n_putback > 4)
         n_putback = 4;
@@ -383,6 +649,8 @@ template <class charT, class traits>
 std::streampos
   basic_unzip_streambuf<charT, traits>::currentpos()
 {
+  if (_is_bgzf)
+    return _bgzf_uoffset + std::streamoff(this->gptr() - _bgzf_data);
   return _unzipped_component_bytes + _zip_stream.total_out - std::streamoff(this->egptr() - this->gptr());
 }
 
@@ -395,6 +663,18 @@ std::streampos
     return this->currentpos();
   }
 
+  if (_is_bgzf || bgzf_begin()) {
+    if (way == std::ios_base::cur)
+      off += this->currentpos();
+    else if (way == std::ios_base::end) {
+      std::streampos end = bgzf_seek(std::numeric_limits<std::streamoff>::max());
+      if (end == std::streampos(std::streamoff(-1)))
+        return end;
+      off += end;
+    }
+    return bgzf_seek(off);
+  }
+
   // We can't really randomly skip around, so we go to the beginning and read until we hit the right spot
   // So the first step is to calculate the final positioning
   std::streampos finalpos;
@@ -442,6 +722,9 @@ template <class charT, class traits>
 std::streampos
   basic_unzip_streambuf<charT, traits>::seekpos(std::streampos sp, std::ios_base::openmode)
 {
+  if (_is_bgzf || bgzf_begin())
+    return bgzf_seek(sp);
+
   // re-roll to the beginning of the file
   inflateEnd(&_zip_stream);
 
@@ -460,6 +743,220 @@ std::streampos
 }
 
 
+/** Switches to reading whole members if a BGZF header was read and nothing
+ *  has been inflated yet. \return whether the input is now read as BGZF
+ */
+template <class charT, class traits>
+bool
+  basic_unzip_streambuf<charT, traits>::bgzf_begin(void)
+{
+  if (_is_bgzf)
+    return true;
+  if (!_bgzf_bsize || _zip_stream.total_out != 0 ||
+      _unzipped_component_bytes != 0 || _err != Z_OK ||
+      this->gptr() != this->egptr())
+    return false;
+  _is_bgzf = true;
+  _bgzf_header_read = true;
+  _bgzf_input_done = false;
+  _bgzf_fallback = false;
+  _bgzf_ahead.clear();
+  _bgzf_coffset = 0;
+  _bgzf_next_uoffset = 0;
+  _bgzf_uoffset = 0;
+  _bgzf_data = this->gptr();
+  std::streamoff pos = _istream.tellg();
+  _bgzf_base = pos < 0 ? -1 : pos - static_cast<std::streamoff>(_header_size);
+  if (!_pool)
+    _pool = detail::worker_pool(_threads);
+  return true;
+}
+
+/** Reads BGZF members ahead of the reader and queues them for inflating
+ */
+template <class charT, class traits>
+void
+  basic_unzip_streambuf<charT, traits>::bgzf_fill_ahead(void)
+{
+  const size_t ahead = 2 * std::max<size_t>(1, _pool->size());
+  while (!_bgzf_input_done && _bgzf_ahead.size() < ahead) {
+    if (!_bgzf_header_read) {
+      if (check_header() != Z_OK || !_is_gzip) {
+        _bgzf_input_done = true;
+        break;
+      }
+      if (!_bgzf_bsize) { // header consumed; the streaming code carries on
+        _bgzf_input_done = true;
+        _bgzf_fallback = true;
+        break;
+      }
+    }
+    _bgzf_header_read = false;
+
+    std::shared_ptr<detail::bgzf_block> block(new detail::bgzf_block);
+    block->in.resize(_bgzf_bsize - _header_size);
+    _istream.read(&block->in[0], static_cast<std::streamsize>(block->in.size()));
+    if (_istream.gcount() != static_cast<std::streamsize>(block->in.size())) {
+      _err = Z_DATA_ERROR;
+      _bgzf_input_done = true;
+      break;
+    }
+    const unsigned char* footer =
+      reinterpret_cast<const unsigned char*>(&block->in[0]) + block->in.size() - 4;
+    std::streamoff isize = footer[0] | (footer[1] << 8) | (footer[2] << 16) |
+      (static_cast<std::streamoff>(footer[3]) << 24);
+
+    block->coffset = _bgzf_coffset;
+    block->uoffset = _bgzf_next_uoffset;
+    bgzf_add_to_index(_bgzf_coffset, _bgzf_next_uoffset, _bgzf_bsize, isize);
+    _bgzf_coffset += _bgzf_bsize;
+    _bgzf_next_uoffset += isize;
+
+    _pool->add([block]() { block->ok = detail::bgzf_decompress(block->in, block->out, 4); },
+               &block->ready);
+    _bgzf_ahead.push_back(block);
+  }
+}
+
+/** underflow() for BGZF input: hands out the text of the next inflated member
+ */
+template <class charT, class traits>
+typename basic_unzip_streambuf<charT, traits>::int_type
+  basic_unzip_streambuf<charT, traits>::bgzf_underflow(void)
+{
+  int n_putback = static_cast<int>(this->gptr() - this->eback());
+  if (n_putback > 4)
+    n_putback = 4;
+
+  for (;;) {
+    bgzf_fill_ahead();
+    if (_bgzf_ahead.empty()) {
+      if (!_bgzf_fallback)
+        return EOF;
+      // A plain gzip member follows: stream it as if the BGZF text were an
+      // earlier member
+      _is_bgzf = false;
+      _bgzf_fallback = false;
+      _unzipped_component_bytes = static_cast<unsigned long>(_bgzf_next_uoffset);
+      inflateReset(&_zip_stream);
+      _zip_stream.avail_in = 0;
+      return underflow();
+    }
+
+    std::shared_ptr<detail::bgzf_block> block = _bgzf_ahead.front();
+    _bgzf_ahead.pop_front();
+    _pool->wait(&block->ready);
+    if (!block->ok) {
+      _err = Z_DATA_ERROR;
+      _bgzf_ahead.clear();
+      _bgzf_input_done = true;
+      return EOF;
+    }
+    if (block->out.size() == 4) // empty member, e.g. the end-of-file marker
+      continue;
+
+    memcpy(&block->out[4 - n_putback], this->gptr() - n_putback,
+           n_putback * sizeof(char_type));
+    _bgzf_text.swap(block->out);
+    _bgzf_uoffset = block->uoffset;
+    _bgzf_data = &_bgzf_text[0] + 4;
+    this->setg(_bgzf_data - n_putback, _bgzf_data, &_bgzf_text[0] + _bgzf_text.size());
+    return * reinterpret_cast<unsigned char *>(this->gptr());
+  }
+}
+
+template <class charT, class traits>
+void
+  basic_unzip_streambuf<charT, traits>::bgzf_add_to_index(std::streamoff coffset,
+                                                          std::streamoff uoffset,
+                                                          std::streamoff csize,
+                                                          std::streamoff usize)
+{
+  if (coffset != _bgzf_index_cend)
+    return; // already indexed
+  detail::bgzf_index_entry entry;
+  entry.coffset = coffset;
+  entry.uoffset = uoffset;
+  _bgzf_index.push_back(entry);
+  _bgzf_index_cend += csize;
+  _bgzf_index_uend += usize;
+}
+
+/** Seeks in BGZF input by jumping to the member holding \p target.
+ *
+ *  Members not yet seen are indexed from their headers and footers, which
+ *  needs a seekable input stream but no inflating.
+ */
+template <class charT, class traits>
+std::streampos
+  basic_unzip_streambuf<charT, traits>::bgzf_seek(std::streamoff target)
+{
+  const std::streampos failed(std::streamoff(-1));
+  if (target < 0 || _bgzf_base < 0)
+    return failed;
+
+  _bgzf_ahead.clear(); // members being inflated are dropped when done
+  _bgzf_fallback = false;
+
+  if (target >= _bgzf_index_uend) {
+    _istream.clear();
+    _istream.seekg(_bgzf_base + _bgzf_index_cend);
+    while (_istream && target >= _bgzf_index_uend) {
+      if (check_header() != Z_OK || !_is_gzip || !_bgzf_bsize)
+        break; // end of input, or of its BGZF part
+      unsigned char isize[4];
+      _istream.ignore(static_cast<std::streamsize>(_bgzf_bsize - _header_size - 4));
+      if (!_istream.read(reinterpret_cast<char*>(isize), 4))
+        break;
+      bgzf_add_to_index(_bgzf_index_cend, _bgzf_index_uend, _bgzf_bsize,
+                        isize[0] | (isize[1] << 8) | (isize[2] << 16) |
+                        (static_cast<std::streamoff>(isize[3]) << 24));
+    }
+  }
+
+  // Restart reading at that member, or after the last one
+  std::streamoff coffset = _bgzf_index_cend, uoffset = _bgzf_index_uend;
+  if (target < _bgzf_index_uend) {
+    std::vector<detail::bgzf_index_entry>::const_iterator i = _bgzf_index.begin();
+    size_t count = _bgzf_index.size();
+    while (count > 0) { // upper bound on uoffset
+      size_t step = count / 2;
+      if (i[step].uoffset <= target) {
+        i += step + 1;
+        count -= step + 1;
+      }
+      else
+        count = step;
+    }
+    --i;
+    coffset = i->coffset;
+    uoffset = i->uoffset;
+  }
+  _istream.clear();
+  if (!_istream.seekg(_bgzf_base + coffset))
+    return failed;
+  _err = Z_OK;
+  _is_bgzf = true; // may have gone on to a plain gzip tail
+  _bgzf_header_read = false;
+  _bgzf_input_done = false;
+  _bgzf_coffset = coffset;
+  _bgzf_next_uoffset = uoffset;
+  _bgzf_uoffset = uoffset;
+  _bgzf_data = &_buffer[0] + 4;
+  this->setg(_bgzf_data, _bgzf_data, _bgzf_data);
+
+  // Move up to target within the member (or through a plain gzip tail)
+  std::streamoff pos;
+  while ((pos = this->currentpos()) < target) {
+    std::streamoff n = std::min<std::streamoff>(target - pos, this->egptr() - this->gptr());
+    if (n > 0)
+      this->gbump(static_cast<int>(n));
+    else if (this->sgetc() == EOF)
+      break;
+  }
+  return this->currentpos();
+}
+
 /** returns the compressed input istream
  */
 template <class charT, class traits> inline
@@ -731,6 +1228,204 @@ basic_zip_ostream<charT,traits>& basic_zip_ostream<charT, traits>::add_footer(vo
 
 
 
+//*****************************************************************************
+//  template class basic_bgzf_streambuf
+//*****************************************************************************
+
+//-----------------------------------------------------------------------------
+// PUBLIC
+//-----------------------------------------------------------------------------
+
+/** Construct a BGZF output stream buffer. \p threads is the number of
+ *  compressing threads; 0 uses the pool shared by all streams.
+ */
+template <class charT, class traits>
+basic_bgzf_streambuf<charT, traits>::basic_bgzf_streambuf(ostream_reference ostream,
+                                                          int level,
+                                                          unsigned int threads)
+    : _ostream(ostream),
+      _level(level > 9 ? 9 : level),
+      _buffer(bgzf_block_text_size + 1),
+      _finished(false),
+      _hold_sync(false),
+      _pool(detail::worker_pool(threads)),
+      _uoffset(0),
+      _base(ostream.tellp())
+{
+    this->setp(&_buffer[0], &_buffer[0] + bgzf_block_text_size);
+}
+
+/** Destructor
+ */
+template <class charT, class traits>
+basic_bgzf_streambuf<charT, traits>::~basic_bgzf_streambuf(void)
+{
+    finish();
+}
+
+/** Compresses the buffered text as a member of its own and writes all
+ *  members, so that what has been written so far can be read back.
+ *  Each sync ends a member, so frequent syncs make the output larger.
+ */
+template <class charT, class traits>
+int basic_bgzf_streambuf<charT, traits>::sync(void)
+{
+    if (_finished)
+        return -1;
+    if (_hold_sync)
+        return 0;
+    if (this->pptr() > this->pbase())
+        submit_block();
+    write_blocks(0);
+    _ostream.flush();
+    return _ostream.good() ? 0 : -1;
+}
+
+/** Only reports the position, as in tellp(): the uncompressed offset
+ */
+template <class charT, class traits>
+std::streampos basic_bgzf_streambuf<charT, traits>::seekoff(std::streamoff off,
+                                                            std::ios_base::seekdir way,
+                                                            std::ios_base::openmode which)
+{
+    if (off == 0 && way == std::ios_base::cur && (which & std::ios_base::out))
+        return tell();
+    return std::streampos(std::streamoff(-1));
+}
+
+template <class charT, class traits> inline
+std::streamoff basic_bgzf_streambuf<charT, traits>::tell(void) const
+{
+    return _uoffset + (this->pptr() - this->pbase());
+}
+
+template <class charT, class traits>
+void basic_bgzf_streambuf<charT, traits>::add_record(std::streamoff offset)
+{
+    if (_records.empty() || offset > _records.back())
+        _records.push_back(offset);
+}
+
+template <class charT, class traits>
+void basic_bgzf_streambuf<charT, traits>::set_record_index(const std::string& path)
+{
+    _index_path = path;
+}
+
+template <class charT, class traits>
+typename basic_bgzf_streambuf<charT, traits>::int_type
+basic_bgzf_streambuf<charT, traits>::overflow(int_type c)
+{
+    if (_finished)
+        return EOF;
+    if (c != EOF)
+    {
+        *this->pptr() = static_cast<char_type>(c); // the put area leaves room for one
+        this->pbump(1);
+    }
+    if (this->pptr() > this->pbase())
+        submit_block();
+    return c == EOF ? 0 : c;
+}
+
+/** Compresses what is left, writes the BGZF end-of-file marker (an empty
+ *  member) and flushes the underlying stream. Nothing can be written after.
+ */
+template <class charT, class traits>
+void basic_bgzf_streambuf<charT, traits>::finish(void)
+{
+    if (_finished)
+        return;
+    if (this->pptr() > this->pbase())
+        submit_block();
+    write_blocks(0);
+    std::vector<char> marker;
+    detail::bgzf_compress(NULL, 0, _level, marker);
+    _ostream.write(&marker[0], static_cast<std::streamsize>(marker.size()));
+    _ostream.flush();
+    _finished = true;
+
+    // The offsets only help a reader that starts at the first member
+    std::streamoff end = _ostream.tellp();
+    if (!_index_path.empty() && !_records.empty() && _base == 0 && end > 0)
+        write_record_index(_index_path, end, _records);
+}
+
+/** returns a reference to the output stream
+ */
+template <class charT, class traits> inline
+typename basic_bgzf_streambuf<charT, traits>::ostream_reference
+basic_bgzf_streambuf<charT, traits>::get_ostream(void) const
+{
+    return _ostream;
+}
+
+//-----------------------------------------------------------------------------
+// PRIVATE
+//-----------------------------------------------------------------------------
+
+/** Queues the put area as one member, then writes the members that are done
+ */
+template <class charT, class traits>
+void basic_bgzf_streambuf<charT, traits>::submit_block(void)
+{
+    std::shared_ptr<detail::bgzf_block> block(new detail::bgzf_block);
+    block->in.assign(this->pbase(), this->pptr());
+    _uoffset += static_cast<std::streamoff>(block->in.size());
+    this->setp(&_buffer[0], &_buffer[0] + bgzf_block_text_size);
+
+    const int level = _level;
+    _pool->add([block, level]() {
+        detail::bgzf_compress(block->in.data(), block->in.size(), level, block->out);
+        block->ok = true;
+      }, &block->ready);
+    _pending.push_back(block);
+
+    // Keep every thread busy but bound the memory held by waiting members
+    write_blocks(2 * std::max<size_t>(1, _pool->size()));
+}
+
+/** Writes finished members in order until no more than \p keep are pending
+ */
+template <class charT, class traits>
+void basic_bgzf_streambuf<charT, traits>::write_blocks(size_t keep)
+{
+    while (_pending.size() > keep)
+    {
+        std::shared_ptr<detail::bgzf_block> block = _pending.front();
+        _pending.pop_front();
+        _pool->wait(&block->ready);
+        _ostream.write(&block->out[0], static_cast<std::streamsize>(block->out.size()));
+    }
+}
+
+//*****************************************************************************
+//  template class basic_bgzf_ostream
+//*****************************************************************************
+
+template <class charT, class traits>
+basic_bgzf_ostream<charT, traits>::basic_bgzf_ostream(ostream_reference ostream,
+                                                      int level,
+                                                      unsigned int threads) :
+    basic_bgzf_streambuf<charT, traits>(ostream, level, threads),
+    std::basic_ostream<charT, traits>(this)
+{
+}
+
+/** Destructor: completes the file
+ */
+template <class charT, class traits>
+basic_bgzf_ostream<charT, traits>::~basic_bgzf_ostream(void)
+{
+    finished();
+}
+
+template <class charT, class traits>
+void basic_bgzf_ostream<charT, traits>::finished(void)
+{
+    this->finish();
+}
+
 //*****************************************************************************
 //  template class basic_zip_istream
 //*****************************************************************************
@@ -745,9 +1440,11 @@ template <class charT, class traits>
 basic_zip_istream<charT, traits>::basic_zip_istream(istream_reference istream,
                                                     int window_size,
                                                     size_t read_buffer_size,
-                                                    size_t input_buffer_size)
+                                                    size_t input_buffer_size,
+                                                    unsigned int threads)
     : basic_unzip_streambuf<charT, traits>(istream, window_size,
-                                           read_buffer_size, input_buffer_size),
+                                           read_buffer_size, input_buffer_size,
+                                           threads),
       std::basic_istream<charT, traits>(this),
       _gzip_crc(0),
       _gzip_data_size(0)
@@ -825,6 +1522,9 @@ basic_unzip_streambuf<charT, traits>::check_header(void)
     int err=0;
     z_stream &zip_stream = this->get_zip_stream();
 
+    _header_size = 0;
+    _bgzf_bsize = 0;
+
     /* Check the gzip magic header */
     for(len = 0; len < 2; len++)
     {
@@ -856,31 +1556,49 @@ basic_unzip_streambuf<charT, traits>::check_header(void)
     /* Discard time, xflags and OS code: */
     for (len = 0; len < 6; len++)
         this->get_istream().get();
+    _header_size = 10;
 
     if ((flags & detail::gz_extra_field) != 0)
     {
-        /* skip the extra field */
+        /* skip the extra field, noting a BGZF block size (subfield "BC") */
         len  =  (uInt)this->get_istream().get();
         len += ((uInt)this->get_istream().get())<<8;
-        /* len is garbage if EOF but the loop below will quit anyway */
-        while (len-- != 0 && this->get_istream().get() != EOF) ;
+        _header_size += 2 + len;
+        std::string extra(len, '\0');
+        /* len is garbage if EOF but the read will quit anyway */
+        if (len != 0)
+            this->get_istream().read(&extra[0], len);
+        for (size_t i = 0; i + 4 <= extra.size(); )
+        {
+            size_t slen = (unsigned char)extra[i + 2] | ((unsigned char)extra[i + 3] << 8);
+            if (extra[i] == 'B' && extra[i + 1] == 'C' && slen == 2 && i + 6 <= extra.size())
+                _bgzf_bsize = 1 + ((unsigned char)extra[i + 4] | ((unsigned char)extra[i + 5] << 8));
+            i += 4 + slen;
+        }
     }
     if ((flags & detail::gz_orig_name) != 0)
     {
         /* skip the original file name */
-        while ((c = this->get_istream().get()) != 0 && c != EOF) ;
+        while ((c = this->get_istream().get()) != 0 && c != EOF)
+            ++_header_size;
+        ++_header_size;
     }
     if ((flags & detail::gz_comment) != 0)
     {
         /* skip the .gz file comment */
-        while ((c = this->get_istream().get()) != 0 && c != EOF) ;
+        while ((c = this->get_istream().get()) != 0 && c != EOF)
+            ++_header_size;
+        ++_header_size;
     }
     if ((flags & detail::gz_head_crc) != 0)
     {  /* skip the header crc */
         for (len = 0; len < 2; len++)
             this->get_istream().get();
+        _header_size += 2;
     }
     err = this->get_istream().eof() ? Z_DATA_ERROR : Z_OK;
+    if (_bgzf_bsize < _header_size + 8)
+        _bgzf_bsize = 0;
 
     return err;
 }
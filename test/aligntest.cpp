@@ -387,6 +387,64 @@ void test_QCP()
 
 }
 
+void test_RMSDMatrix()
+{
+  OBConversion conv;
+  OB_REQUIRE( conv.SetInFormat("xyz") );
+
+  OBMol mol;
+  OB_REQUIRE( conv.ReadFile(&mol, TESTDATADIR + string("test3d.xyz")) );
+
+  // A rotated copy and two distorted ones
+  vector<OBMol> confs(4, mol);
+  matrix3x3 rot;
+  rot.RotAboutAxisByAngle(vector3(1.0, -0.3, 0.23), 67);
+  double rot_array[9];
+  rot.GetArray(rot_array);
+  confs[1].Rotate(rot_array);
+  OBAtom *patom = confs[2].GetAtom(1);
+  patom->SetVector( patom->GetVector() + vector3(.3, -.2, .1) );
+  patom = confs[3].GetAtom(2);
+  patom->SetVector( patom->GetVector() + vector3(-.1, .4, .2) );
+
+  vector<double*> coords;
+  for (unsigned int c = 0; c < confs.size(); ++c) {
+    double *xyz = new double[3 * mol.NumAtoms()];
+    for (unsigned int i = 0; i < 3 * mol.NumAtoms(); ++i)
+      xyz[i] = confs[c].GetCoordinates()[i];
+    coords.push_back(xyz);
+  }
+  OBMol ensemble = mol;
+  ensemble.SetConformers(coords);
+
+  // The reference of the instance is kept
+  OBAlign align(false, true);
+  align.SetRefMol(confs[0]);
+  align.SetTargetMol(confs[2]);
+  align.Align();
+  double rmsd = align.GetRMSD();
+
+  vector<double> matrix = align.GetRMSDMatrix(ensemble);
+  OB_COMPARE( matrix.size(), 6 );
+
+  align.Align();
+  OB_ASSERT( fabs(align.GetRMSD() - rmsd) < 1.0E-8 );
+
+  // Each entry matches a pairwise alignment, in scipy's condensed order
+  unsigned int n = confs.size(), idx = 0;
+  for (unsigned int i = 0; i < n; ++i)
+    for (unsigned int j = i + 1; j < n; ++j, ++idx) {
+      OBAlign pair(confs[i], confs[j], false, true);
+      pair.Align();
+      OB_ASSERT( fabs(matrix[idx] - pair.GetRMSD()) < 1.0E-6 );
+    }
+  OB_ASSERT( matrix[0] < 1.0E-6 );
+  OB_ASSERT( matrix[1] > 1.0E-2 );
+
+  // Too few conformers
+  OB_ASSERT( align.GetRMSDMatrix(mol).empty() );
+}
+
 int aligntest(int argc, char* argv[])
 {
   int defaultchoice = 1;
@@ -425,6 +483,9 @@ int aligntest(int argc, char* argv[])
     test_alignWithoutHydrogens();
     test_alignWithSymWithoutHydrogens();
     break;
+  case 6:
+    test_RMSDMatrix();
+    break;
   default:
     cout << "Test number " << choice << " does not exist!\n";
     return -1;
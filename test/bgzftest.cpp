@@ -0,0 +1,183 @@
+#include "obtest.h"
+#include <openbabel/mol.h>
+#include <openbabel/obconversion.h>
+
+#include "../src/zipstream.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace OpenBabel;
+
+static string Inflate(const string &compressed)
+{
+  stringstream in(compressed);
+  zlib_stream::zip_istream zin(in);
+  stringstream text;
+  text << zin.rdbuf();
+  return text.str();
+}
+
+static string ReadAll(const string &path)
+{
+  ifstream ifs(path.c_str(), ios_base::in | ios_base::binary);
+  stringstream text;
+  text << ifs.rdbuf();
+  return text.str();
+}
+
+static streamoff FileSize(const string &path)
+{
+  ifstream ifs(path.c_str(), ios_base::in | ios_base::binary | ios_base::ate);
+  return ifs.tellg();
+}
+
+// Converts @p in to SMILES in @p out with the options -f @p first and -l @p last
+static string Convert(const string &in, const string &out, int first, int last)
+{
+  OBConversion conv; // the formats, and gzip for the input, from the extensions
+  ostringstream f, l;
+  f << first;
+  l << last;
+  conv.AddOption("f", OBConversion::GENOPTIONS, f.str().c_str());
+  conv.AddOption("l", OBConversion::GENOPTIONS, l.str().c_str());
+  OB_REQUIRE(conv.OpenInAndOutFiles(in, out));
+  conv.Convert();
+  conv.SetOutStream(NULL);
+  return ReadAll(out);
+}
+
+static int NumInputObjects(const string &in)
+{
+  OBConversion conv;
+  OB_REQUIRE(conv.OpenInAndOutFiles(in, ""));
+  return conv.NumInputObjects();
+}
+
+// flush() ends a member, so that the text so far can be read back, unless
+// the syncs are held back
+void testSync()
+{
+  cout << "testSync" << endl;
+  stringstream out;
+  zlib_stream::bgzf_ostream zout(out);
+  zout << "line one" << endl;
+  size_t size = out.str().size();
+  OB_ASSERT(size > 0);
+  OB_COMPARE(Inflate(out.str()), "line one\n");
+
+  zout.hold_sync(true);
+  zout << "line two" << endl;
+  OB_COMPARE(out.str().size(), size);
+  zout.hold_sync(false);
+  zout.flush();
+  OB_ASSERT(out.str().size() > size);
+  OB_COMPARE(Inflate(out.str()), "line one\nline two\n");
+  OB_COMPARE(static_cast<streamoff>(zout.tellp()), static_cast<streamoff>(18));
+
+  zout << "line three";
+  zout.finished();
+  OB_COMPARE(Inflate(out.str()), "line one\nline two\nline three");
+}
+
+static void Compress(const string &in, const string &out, bool index)
+{
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInAndOutFormats("sdf", "sdf"));
+  conv.AddOption("z", OBConversion::GENOPTIONS);
+  if (index)
+    conv.AddOption("zindex", OBConversion::GENOPTIONS);
+  OB_REQUIRE(conv.OpenInAndOutFiles(in, out));
+  OB_COMPARE(conv.Convert(), 20);
+  conv.SetOutStream(NULL);
+}
+
+// Compressed output written with --zindex gets a record index, which -f and
+// -l use to go to the first object. An index that does not belong to the
+// file, or has offsets beyond its end, is not used.
+void testRecordIndex()
+{
+  cout << "testRecordIndex" << endl;
+  const string infile = OBTestUtil::GetFilename("cantest.sdf");
+  const string gzfile = "bgzftest.sdf.gz", index = gzfile + ".obi";
+  const string outfile = "bgzftest_out.smi";
+  remove(index.c_str());
+
+  // Only on request
+  Compress(infile, gzfile, false);
+  OB_ASSERT(!ifstream(index.c_str()).good());
+  Compress(infile, gzfile, true);
+
+  vector<streamoff> records;
+  OB_REQUIRE(zlib_stream::read_record_index(index, FileSize(gzfile), records));
+  OB_COMPARE(records.size(), 20U);
+  OB_COMPARE(records[0], static_cast<streamoff>(0));
+
+  OB_COMPARE(NumInputObjects(gzfile), 20);
+  const int ranges[][2] = { { 1, 20 }, { 1, 1 }, { 2, 4 }, { 15, 17 }, { 20, 20 }, { 18, 30 } };
+  for (size_t i = 0; i < sizeof(ranges) / sizeof(ranges[0]); ++i) {
+    string expected = Convert(infile, outfile, ranges[i][0], ranges[i][1]);
+    OB_ASSERT(!expected.empty());
+    OB_COMPARE(Convert(gzfile, outfile, ranges[i][0], ranges[i][1]), expected);
+  }
+
+  // Counting objects uses the index: without the first five it has 15
+  vector<streamoff> fewer(records.begin() + 5, records.end());
+  OB_REQUIRE(zlib_stream::write_record_index(index, FileSize(gzfile), fewer));
+  OB_COMPARE(NumInputObjects(gzfile), 15);
+
+  // One written for a file of another size is not
+  OB_REQUIRE(zlib_stream::write_record_index(index, FileSize(gzfile) + 1, fewer));
+  OB_COMPARE(NumInputObjects(gzfile), 20);
+  OB_COMPARE(Convert(gzfile, outfile, 15, 17), Convert(infile, outfile, 15, 17));
+
+  // Nor is one with an offset beyond the uncompressed data
+  vector<streamoff> beyond(records);
+  beyond.back() += static_cast<streamoff>(1) << 30;
+  OB_REQUIRE(zlib_stream::write_record_index(index, FileSize(gzfile), beyond));
+  OB_COMPARE(NumInputObjects(gzfile), 20);
+  OB_COMPARE(Convert(gzfile, outfile, 20, 20), Convert(infile, outfile, 20, 20));
+
+  remove(gzfile.c_str());
+  remove(index.c_str());
+  remove(outfile.c_str());
+}
+
+int bgzftest(int argc, char* argv[])
+{
+  int defaultchoice = 1;
+
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+  // Define location of file formats for testing
+  #ifdef FORMATDIR
+    char env[BUFF_SIZE];
+    snprintf(env, BUFF_SIZE, "BABEL_LIBDIR=%s", FORMATDIR);
+    putenv(env);
+  #endif
+
+  switch(choice) {
+  case 1:
+    testSync();
+    break;
+  case 2:
+    testRecordIndex();
+    break;
+  default:
+    cout << "Test number " << choice << " does not exist!\n";
+    return -1;
+  }
+
+  return 0;
+}
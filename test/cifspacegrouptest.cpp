@@ -22,6 +22,9 @@ GNU General Public License for more details.
 #include <openbabel/mol.h>
 #include <openbabel/obconversion.h>
 #include <openbabel/generic.h>
+#include <openbabel/obiter.h>
+#include <openbabel/atom.h>
+#include <openbabel/bond.h>
 
 #include <string>
 #include <algorithm>
@@ -318,6 +321,52 @@ void testCIFMolecules()
   OB_ASSERT(smi.find(".") == string::npos);
 }
 
+void testSupercell()
+{
+  OBConversion conv;
+  OBMol mol;
+  conv.SetInFormat("cif");
+  conv.ReadFile(&mol, GetFilename("1519159.cif"));
+  OBUnitCell* pUC = (OBUnitCell*)mol.GetData(OBGenericDataType::UnitCell);
+  OB_REQUIRE(pUC != NULL);
+  unsigned int numAtoms = mol.NumAtoms(), numBonds = mol.NumBonds();
+  OB_REQUIRE(numAtoms == 26 && numBonds == 28);
+  vector<vector3> cell = pUC->GetCellVectors();
+
+  // Wrap the atoms into the cell, keeping the bonds, so that some bonds go
+  // through the cell faces
+  FOR_ATOMS_OF_MOL(atom, mol)
+    atom->SetVector(pUC->WrapCartesianCoordinate(atom->GetVector()));
+  bool crossing = false;
+  FOR_BONDS_OF_MOL(bond, mol)
+    if (bond->GetLength() > 2.0)
+      crossing = true;
+  OB_REQUIRE(crossing);
+
+  OB_ASSERT(!pUC->MakeSupercell(&mol, 2, 0, 2));
+  OB_REQUIRE(pUC->MakeSupercell(&mol, 2, 2, 2));
+  OB_COMPARE(mol.NumAtoms(), 8 * numAtoms);
+  OB_COMPARE(mol.NumBonds(), 8 * numBonds);
+
+  pUC = (OBUnitCell*)mol.GetData(OBGenericDataType::UnitCell);
+  vector<vector3> supercell = pUC->GetCellVectors();
+  OB_REQUIRE(supercell.size() == 3);
+  for (int i = 0; i < 3; ++i)
+    OB_ASSERT(supercell[i].IsApprox(2.0 * cell[i], 1.0e-6));
+  OB_COMPARE(pUC->GetSpaceGroup()->GetId(), 1U);
+
+  // Each bond joins the nearest images, and each molecule is whole
+  FOR_BONDS_OF_MOL(bond, mol)
+    OB_ASSERT(pUC->MinimumImageDistance(bond->GetBeginAtom()->GetVector(),
+                                        bond->GetEndAtom()->GetVector()) < 2.0);
+  vector<OBMol> parts = mol.Separate();
+  OB_COMPARE(parts.size(), 8U);
+  for (size_t i = 0; i < parts.size(); ++i) {
+    OB_COMPARE(parts[i].NumAtoms(), numAtoms);
+    OB_COMPARE(parts[i].NumBonds(), numBonds);
+  }
+}
+
 int cifspacegrouptest(int argc, char* argv[])
 {
   int defaultchoice = 1;
@@ -375,6 +424,9 @@ int cifspacegrouptest(int argc, char* argv[])
   case 12:
     testCIFMolecules();
   break;
+  case 13:
+    testSupercell();
+  break;
   default:
     cout << "Test number " << choice << " does not exist!\n";
     return -1;
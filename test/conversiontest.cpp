@@ -4,7 +4,9 @@
 #include <openbabel/phmodel.h>
 #include <openbabel/elements.h>
 
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <algorithm>
@@ -29,6 +31,45 @@ void testMolToCdxmlConversion()
   OB_COMPARE(cdxmlFromMol, cdxmlTarget);
 }
 
+// Converts filterset.sdf to SMILES with --filter @p filter and -f/-l
+static string FilterRange(const string &filter, int first, int last, int &count)
+{
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInAndOutFormats("sdf", "smi"));
+  ostringstream f, l;
+  f << first;
+  l << last;
+  conv.AddOption("filter", OBConversion::GENOPTIONS, filter.c_str());
+  conv.AddOption("f", OBConversion::GENOPTIONS, f.str().c_str());
+  conv.AddOption("l", OBConversion::GENOPTIONS, l.str().c_str());
+  ifstream ifs(OBTestUtil::GetFilename("filterset.sdf").c_str());
+  OB_REQUIRE(ifs.good());
+  ostringstream out;
+  count = conv.Convert(&ifs, &out);
+  return out.str();
+}
+
+// A filter on data fields alone is tested before the connection table is
+// parsed. The records selected with -f/-l, and the output, must be those of
+// the same filter with a descriptor added, which parses every record.
+void testFilterOnDataFields()
+{
+  const int ranges[][2] = { { 1, 10 }, { 1, 1 }, { 2, 5 }, { 3, 3 }, { 6, 9 }, { 8, 20 } };
+  int passed = 0;
+  for (size_t i = 0; i < sizeof(ranges) / sizeof(ranges[0]); ++i) {
+    int first = ranges[i][0], last = ranges[i][1];
+    int lazyCount, eagerCount;
+    string lazy = FilterRange("ROTATABLE_BOND>3", first, last, lazyCount);
+    string eager = FilterRange("ROTATABLE_BOND>3 & atoms>0", first, last, eagerCount);
+    OB_COMPARE(lazyCount, eagerCount);
+    OB_COMPARE(lazy, eager);
+    if (first == 1 && last == 10)
+      passed = lazyCount;
+  }
+  // some records pass and some fail
+  OB_COMPARE(passed, 5);
+}
+
 int conversiontest(int argc, char* argv[])
 {
   int defaultchoice = 1;
@@ -52,6 +93,9 @@ int conversiontest(int argc, char* argv[])
   case 1:
     testMolToCdxmlConversion();
     break;
+  case 2:
+    testFilterOnDataFields();
+    break;
   //case N:
   //  YOUR_TEST_HERE();
   //  Remember to update CMakeLists.txt with the number of your test
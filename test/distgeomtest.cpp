@@ -0,0 +1,108 @@
+#include "obtest.h"
+#include <openbabel/mol.h>
+#include <openbabel/atom.h>
+#include <openbabel/bond.h>
+#include <openbabel/obiter.h>
+#include <openbabel/obconversion.h>
+#include <openbabel/distgeom.h>
+#include <openbabel/stereo/stereo.h>
+#include <openbabel/stereo/tetrahedral.h>
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace OpenBabel;
+
+static OBMolPtr ReadSmiles(const string &smiles)
+{
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInFormat("smi"));
+  OBMolPtr mol(new OBMol);
+  OB_REQUIRE(conv.ReadString(mol.get(), smiles));
+  return mol;
+}
+
+// The configuration of the stereocentre with id @p center, perceived from the
+// current coordinates of @p mol
+static OBTetrahedralStereo::Config ConfigFrom3D(const OBMol &mol, unsigned long center)
+{
+  OBMol copy(mol);
+  StereoFrom3D(&copy, true);
+  OBStereoFacade facade(&copy);
+  OB_REQUIRE(facade.HasTetrahedralStereo(center));
+  return facade.GetTetrahedralStereo(center)->GetConfig();
+}
+
+// AddConformers() embeds each conformer independently, and each must have
+// sensible bond lengths and keep the stereochemistry of the input
+void testAddConformers()
+{
+  cout << "testAddConformers" << endl;
+  OBMolPtr mol = ReadSmiles("N[C@@H](CCO)C(=O)O");
+  mol->AddHydrogens();
+
+  OBStereoFacade facade(mol.get());
+  OBAtom *center = mol->GetAtom(2);
+  OB_REQUIRE(facade.HasTetrahedralStereo(center->GetId()));
+  OBTetrahedralStereo::Config ref = facade.GetTetrahedralStereo(center->GetId())->GetConfig();
+
+  // The embeddings are added after the conformers of the input
+  int first = mol->NumConformers();
+  OBDistanceGeometry dg;
+  OB_REQUIRE(dg.Setup(*mol));
+  dg.AddConformers(4);
+  dg.GetConformers(*mol);
+  OB_COMPARE(mol->NumConformers(), first + 4);
+
+  for (int c = first; c < mol->NumConformers(); ++c) {
+    mol->SetConformer(c);
+    FOR_BONDS_OF_MOL(bond, *mol) {
+      double length = bond->GetLength();
+      OB_ASSERT(length > 0.8 && length < 2.0);
+    }
+    OB_ASSERT(ConfigFrom3D(*mol, center->GetId()) == ref);
+  }
+
+  // Each embedding has its own random start
+  mol->SetConformer(first);
+  double dist = mol->GetAtom(1)->GetDistance(mol->GetAtom(5));
+  bool differ = false;
+  for (int c = first + 1; c < mol->NumConformers(); ++c) {
+    mol->SetConformer(c);
+    if (fabs(mol->GetAtom(1)->GetDistance(mol->GetAtom(5)) - dist) > 1e-3)
+      differ = true;
+  }
+  OB_ASSERT(differ);
+}
+
+int distgeomtest(int argc, char* argv[])
+{
+  int defaultchoice = 1;
+
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+  // Define location of file formats for testing
+  #ifdef FORMATDIR
+    char env[BUFF_SIZE];
+    snprintf(env, BUFF_SIZE, "BABEL_LIBDIR=%s", FORMATDIR);
+    putenv(env);
+  #endif
+
+  switch(choice) {
+  case 1:
+    testAddConformers();
+    break;
+  default:
+    cout << "Test number " << choice << " does not exist!\n";
+    return -1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,276 @@
+#include "obtest.h"
+#include <openbabel/mol.h>
+#include <openbabel/obconversion.h>
+#include <openbabel/descriptor.h>
+#include <openbabel/obutil.h>
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace OpenBabel;
+
+// The number of atoms, or the text "small" for fewer than three
+class TextOrNumber : public OBDescriptor
+{
+public:
+  TextOrNumber() : OBDescriptor("") {}
+  const char* Description() { return "test"; }
+  double Predict(OBBase* pOb, string* = NULL)
+  {
+    unsigned int n = static_cast<OBMol*>(pOb)->NumAtoms();
+    return n < 3 ? numeric_limits<double>::quiet_NaN() : n;
+  }
+  double GetStringValue(OBBase* pOb, string& svalue, string* param = NULL)
+  {
+    double val = Predict(pOb, param);
+    if (IsNan(val))
+      svalue = "small";
+    else {
+      stringstream ss;
+      ss << val;
+      svalue = ss.str();
+    }
+    return val;
+  }
+};
+
+// The number of atoms, which cannot be calculated for fewer than three
+class NumberOrFailure : public OBDescriptor
+{
+public:
+  NumberOrFailure() : OBDescriptor("") {}
+  const char* Description() { return "test"; }
+  double Predict(OBBase* pOb, string* = NULL)
+  {
+    unsigned int n = static_cast<OBMol*>(pOb)->NumAtoms();
+    return n < 3 ? numeric_limits<double>::quiet_NaN() : n;
+  }
+};
+
+static string Convert(const string &format, const string &descriptors, const string &smiles)
+{
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInAndOutFormats("smi", format.c_str()));
+  conv.AddOption("d", OBConversion::OUTOPTIONS, descriptors.c_str());
+  stringstream in(smiles), out;
+  OB_REQUIRE(conv.Convert(&in, &out) > 0);
+  return out.str();
+}
+
+static double MW(const string &smiles)
+{
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInFormat("smi"));
+  OBMol mol;
+  OB_REQUIRE(conv.ReadString(&mol, smiles));
+  return OBDescriptor::FindType("MW")->Predict(&mol);
+}
+
+// Reads little-endian values from a dtab file
+class Reader
+{
+public:
+  explicit Reader(const string &data) : _data(data), _pos(0) {}
+  unsigned int U32()
+  {
+    OB_REQUIRE(_pos + 4 <= _data.size());
+    unsigned int x = 0;
+    for (int i = 0; i < 4; ++i)
+      x |= static_cast<unsigned int>(static_cast<unsigned char>(_data[_pos + i])) << (8 * i);
+    _pos += 4;
+    return x;
+  }
+  double Double()
+  {
+    OB_REQUIRE(_pos + 8 <= _data.size());
+    unsigned long long bits = 0;
+    for (int i = 0; i < 8; ++i)
+      bits |= static_cast<unsigned long long>(static_cast<unsigned char>(_data[_pos + i])) << (8 * i);
+    _pos += 8;
+    double x;
+    memcpy(&x, &bits, 8);
+    return x;
+  }
+  string Text(size_t n)
+  {
+    OB_REQUIRE(_pos + n <= _data.size());
+    string s = _data.substr(_pos, n);
+    _pos += n;
+    return s;
+  }
+  void Align()
+  {
+    _pos = (_pos + 7) / 8 * 8;
+  }
+  bool AtEnd() const { return _pos == _data.size(); }
+private:
+  const string &_data;
+  size_t _pos;
+};
+
+// Strings, as their offsets and then the text
+static vector<string> ReadStrings(Reader &r, unsigned int nrows)
+{
+  vector<unsigned int> offsets;
+  for (unsigned int i = 0; i <= nrows; ++i)
+    offsets.push_back(r.U32());
+  string text = r.Text(offsets[nrows]);
+  r.Align();
+  vector<string> rows;
+  for (unsigned int i = 0; i < nrows; ++i)
+    rows.push_back(text.substr(offsets[i], offsets[i + 1] - offsets[i]));
+  return rows;
+}
+
+// The type of a column is decided by all the objects, not just the first
+void testColumnTypes()
+{
+  cout << "testColumnTypes" << endl;
+  const char *smiles[] = { "C nan", "CCCCC pentane", "CCC propane" };
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInFormat("smi"));
+  vector<OBBase*> objects;
+  for (int i = 0; i < 3; ++i) {
+    OBMol *mol = new OBMol;
+    OB_REQUIRE(conv.ReadString(mol, smiles[i]));
+    objects.push_back(mol);
+  }
+
+  TextOrNumber textOrNumber;
+  NumberOrFailure numberOrFailure;
+  vector<pair<OBDescriptor*, string> > descrs;
+  descrs.push_back(make_pair(OBDescriptor::FindType("title"), string()));
+  descrs.push_back(make_pair((OBDescriptor*)&textOrNumber, string()));
+  descrs.push_back(make_pair((OBDescriptor*)&numberOrFailure, string()));
+  vector<bool> isString;
+  vector<double> values;
+  vector<string> svalues;
+  OBDescriptor::PredictValues(objects, descrs, isString, values, svalues);
+
+  OB_REQUIRE(isString.size() == 3);
+  OB_ASSERT(isString[0]);
+  OB_ASSERT(isString[1]);
+  OB_ASSERT(!isString[2]);
+  OB_REQUIRE(values.size() == 9 && svalues.size() == 9);
+  OB_COMPARE(svalues[0], "nan");
+  OB_COMPARE(svalues[3], "pentane");
+  OB_COMPARE(svalues[1], "small");
+  OB_COMPARE(svalues[4], "5");
+  OB_COMPARE(svalues[7], "3");
+  OB_ASSERT(IsNan(values[2]));
+  OB_ASSERT(svalues[2].empty());
+  OB_COMPARE(values[5], 5.0);
+  OB_COMPARE(values[8], 3.0);
+
+  // With the types given, text in a numeric column is NaN
+  vector<bool> given(3, false);
+  given[0] = true;
+  OBDescriptor::PredictValues(objects, descrs, given, values, svalues);
+  OB_COMPARE(svalues[3], "pentane");
+  OB_ASSERT(IsNan(values[1]));
+  OB_COMPARE(values[4], 5.0);
+
+  for (size_t i = 0; i < objects.size(); ++i)
+    delete objects[i];
+}
+
+// A header line, then a line per molecule with the text quoted where needed
+void testCSV()
+{
+  cout << "testCSV" << endl;
+  string csv = Convert("csv", "title formula MW", "CCO ethanol\nc1ccccc1 benzene, \"aromatic\"\n");
+  vector<string> lines;
+  tokenize(lines, csv, "\n");
+  OB_REQUIRE(lines.size() == 3);
+  OB_COMPARE(lines[0], "title,formula,MW");
+
+  char mw[32];
+  snprintf(mw, sizeof(mw), "%.15g", MW("CCO"));
+  OB_COMPARE(lines[1], string("ethanol,C2H6O,") + mw);
+  snprintf(mw, sizeof(mw), "%.15g", MW("c1ccccc1"));
+  OB_COMPARE(lines[2], string("\"benzene, \"\"aromatic\"\"\",C6H6,") + mw);
+}
+
+// The header, then blocks of 1024 rows stored column by column
+void testDtab()
+{
+  cout << "testDtab" << endl;
+  const unsigned int n = 1030;
+  stringstream smiles;
+  for (unsigned int i = 0; i < n; ++i)
+    smiles << (i % 2 ? "CCO" : "C") << " mol" << i << "\n";
+  string dtab = Convert("dtab", "title MW", smiles.str());
+  OB_COMPARE(dtab.size() % 8, 0U);
+
+  Reader r(dtab);
+  OB_COMPARE(r.Text(8), "OBDTAB01");
+  OB_REQUIRE(r.U32() == 2);
+  OB_COMPARE(r.U32(), 0U);
+  const char *names[] = { "title", "MW" };
+  const char types[] = { 's', 'd' };
+  for (int j = 0; j < 2; ++j) {
+    OB_COMPARE(r.Text(4), string(1, types[j]) + string(3, '\0'));
+    unsigned int length = r.U32();
+    OB_COMPARE(r.Text(length), names[j]);
+    r.Align();
+  }
+
+  double methane = MW("C"), ethanol = MW("CCO");
+  unsigned int row = 0;
+  const unsigned int blocks[] = { 1024, 6 };
+  for (int b = 0; b < 2; ++b) {
+    unsigned int nrows = r.U32();
+    OB_REQUIRE(nrows == blocks[b]);
+    OB_COMPARE(r.U32(), 0U);
+    vector<string> titles = ReadStrings(r, nrows);
+    for (unsigned int i = 0; i < nrows; ++i) {
+      stringstream title;
+      title << "mol" << row + i;
+      OB_COMPARE(titles[i], title.str());
+      OB_COMPARE(r.Double(), (row + i) % 2 ? ethanol : methane);
+    }
+    row += nrows;
+  }
+  OB_ASSERT(r.AtEnd());
+}
+
+int dtabtest(int argc, char* argv[])
+{
+  int defaultchoice = 1;
+
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+  // Define location of file formats for testing
+  #ifdef FORMATDIR
+    char env[BUFF_SIZE];
+    snprintf(env, BUFF_SIZE, "BABEL_LIBDIR=%s", FORMATDIR);
+    putenv(env);
+  #endif
+
+  switch(choice) {
+  case 1:
+    testColumnTypes();
+    break;
+  case 2:
+    testCSV();
+    break;
+  case 3:
+    testDtab();
+    break;
+  default:
+    cout << "Test number " << choice << " does not exist!\n";
+    return -1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,231 @@
+#include "obtest.h"
+#include <openbabel/mol.h>
+#include <openbabel/obconversion.h>
+#include <openbabel/fingerprint.h>
+
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace OpenBabel;
+
+static OBMolPtr ReadSmiles(const string &smiles)
+{
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInFormat("smi"));
+  OBMolPtr mol(new OBMol);
+  OB_REQUIRE(conv.ReadString(mol.get(), smiles));
+  return mol;
+}
+
+// The fragment description of FP2 belongs to the last molecule fingerprinted,
+// and there is none when FPT_NOINFO is set
+void testFP2Description()
+{
+  OBFingerprint *fp2 = OBFingerprint::FindFingerprint("FP2");
+  OB_REQUIRE(fp2);
+  unsigned int flags = fp2->Flags();
+  OBMolPtr mol = ReadSmiles("c1ccccc1CCO");
+  vector<unsigned int> fp;
+
+  fp2->SetFlags(flags & ~OBFingerprint::FPT_NOINFO);
+  OB_REQUIRE(fp2->GetFingerprint(mol.get(), fp));
+  OB_ASSERT(!fp2->DescribeBits(fp).empty());
+  OB_ASSERT(!fp2->IsThreadSafe());
+
+  fp2->SetFlags(flags | OBFingerprint::FPT_NOINFO);
+  OB_REQUIRE(fp2->GetFingerprint(mol.get(), fp));
+  OB_ASSERT(fp2->DescribeBits(fp).empty());
+  OB_ASSERT(fp2->IsThreadSafe());
+
+  fp2->SetFlags(flags);
+}
+
+static unsigned int ReadLE32(const string &data, size_t pos)
+{
+  unsigned int x = 0;
+  for (int i = 0; i < 4; ++i)
+    x |= static_cast<unsigned int>(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+  return x;
+}
+
+// Write molecules in fpm format and read the matrix back, checking each row
+// against the fingerprint of the molecule
+void testFPMRoundTrip(int nbits)
+{
+  cout << "testFPMRoundTrip(" << nbits << ")" << endl;
+  const char *smiles[] = {"c1ccccc1CCO", "CC(=O)Nc1ccc(O)cc1", "C1CCCCC1Br", "OCC(O)CO"};
+  const unsigned int nmols = sizeof(smiles) / sizeof(smiles[0]);
+  stringstream input;
+  for (unsigned int m = 0; m < nmols; ++m)
+    input << smiles[m] << "\n";
+
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInAndOutFormats("smi", "fpm"));
+  conv.AddOption("f", OBConversion::OUTOPTIONS, "FP2");
+  stringstream nbitsopt;
+  nbitsopt << nbits;
+  if (nbits)
+    conv.AddOption("N", OBConversion::OUTOPTIONS, nbitsopt.str().c_str());
+  stringstream output;
+  OB_COMPARE(conv.Convert(&input, &output), nmols);
+  string data = output.str();
+
+  OB_REQUIRE(data.size() >= 32);
+  OB_ASSERT(data.compare(0, 8, "OBFPMAT1") == 0);
+  unsigned int fpbits = ReadLE32(data, 8);
+  unsigned int nwords = ReadLE32(data, 12);
+  OB_COMPARE(fpbits, nbits ? nbits : 1024);
+  OB_COMPARE(nwords, (fpbits + 63) / 64);
+  OB_ASSERT(string(data.c_str() + 16) == "FP2");
+  OB_REQUIRE(data.size() == 32 + nmols * 8 * nwords);
+
+  OBFingerprint *fp2 = OBFingerprint::FindFingerprint("FP2");
+  OB_REQUIRE(fp2);
+  const unsigned int perint = OBFingerprint::Getbitsperint();
+  for (unsigned int m = 0; m < nmols; ++m) {
+    OBMolPtr mol = ReadSmiles(smiles[m]);
+    vector<unsigned int> fp;
+    OB_REQUIRE(fp2->GetFingerprint(mol.get(), fp, nbits));
+    // The bits beyond the number of bits are folded onto bit n % fpbits
+    vector<bool> expected(64 * nwords, false);
+    for (unsigned int n = 0; n < fp.size() * perint; ++n)
+      if (fp2->GetBit(fp, n))
+        expected[n % fpbits] = true;
+    const string row = data.substr(32 + m * 8 * nwords, 8 * nwords);
+    for (unsigned int n = 0; n < 64 * nwords; ++n) {
+      bool bit = (static_cast<unsigned char>(row[n / 8]) >> (n % 8)) & 1;
+      OB_ASSERT(bit == expected[n]);
+    }
+  }
+}
+
+static unsigned int TotalCount(const map<unsigned int, unsigned int> &counts)
+{
+  unsigned int total = 0;
+  map<unsigned int, unsigned int>::const_iterator it;
+  for (it = counts.begin(); it != counts.end(); ++it)
+    total += it->second;
+  return total;
+}
+
+// Each heavy atom gives one ECFP feature per pass, and the folded fingerprint
+// has the bits of the identifiers
+void testECFPCounts()
+{
+  cout << "testECFPCounts" << endl;
+  OBFingerprint *ecfp4 = OBFingerprint::FindFingerprint("ECFP4");
+  OB_REQUIRE(ecfp4);
+  OBMolPtr mol = ReadSmiles("CC(C)C");
+  map<unsigned int, unsigned int> counts;
+  OB_REQUIRE(ecfp4->GetFeatureCounts(mol.get(), counts));
+  OB_COMPARE(TotalCount(counts), 4 * 3);
+  // the methyl groups are alike up to radius 2
+  unsigned int maxcount = 0;
+  map<unsigned int, unsigned int>::const_iterator it;
+  for (it = counts.begin(); it != counts.end(); ++it)
+    maxcount = max(maxcount, it->second);
+  OB_COMPARE(maxcount, 3);
+
+  const unsigned int nbits = 1024;
+  vector<unsigned int> fp, expected(nbits / OBFingerprint::Getbitsperint());
+  OB_REQUIRE(ecfp4->GetFingerprint(mol.get(), fp, nbits));
+  for (it = counts.begin(); it != counts.end(); ++it)
+    ecfp4->SetBit(expected, (it->first % nbits) & 0x7fffffff);
+  OB_ASSERT(fp == expected);
+
+  // The fpt format writes the counts with -xc
+  OBConversion conv;
+  OB_REQUIRE(conv.SetOutFormat("fpt"));
+  conv.AddOption("f", OBConversion::OUTOPTIONS, "ECFP4");
+  conv.AddOption("c", OBConversion::OUTOPTIONS);
+  mol->SetTitle("isobutane");
+  stringstream expectedOut;
+  expectedOut << ">isobutane\n";
+  for (it = counts.begin(); it != counts.end(); ++it)
+    expectedOut << (it == counts.begin() ? "" : " ") << it->first << ':' << it->second;
+  expectedOut << "\n";
+  OB_COMPARE(conv.WriteString(mol.get()), expectedOut.str());
+}
+
+// An ECFP instance made as from plugindefines.txt with "nodups" drops the
+// features whose environment, the set of bonds it covers, was already seen
+void testECFPNoDups()
+{
+  cout << "testECFPNoDups" << endl;
+  OBFingerprint *ecfp4 = OBFingerprint::FindFingerprint("ECFP4");
+  OB_REQUIRE(ecfp4);
+  vector<string> lines;
+  lines.push_back("fingerprintECFP");
+  lines.push_back("ECFP4nodupstest");
+  lines.push_back("2");
+  lines.push_back("nodups");
+  // registered under its ID, so it is not deleted
+  OBFingerprint *nodups = static_cast<OBFingerprint*>(ecfp4->MakeInstance(lines));
+  OB_REQUIRE(nodups);
+
+  map<unsigned int, unsigned int> counts, allcounts;
+
+  // Butane: all four first pass environments differ, but only the one of a
+  // central atom is new in the second pass
+  OBMolPtr mol = ReadSmiles("CCCC");
+  OB_REQUIRE(ecfp4->GetFeatureCounts(mol.get(), allcounts));
+  OB_REQUIRE(nodups->GetFeatureCounts(mol.get(), counts));
+  OB_COMPARE(TotalCount(allcounts), 4 * 3);
+  OB_COMPARE(TotalCount(counts), 4 + 4 + 1);
+  map<unsigned int, unsigned int>::const_iterator it;
+  for (it = counts.begin(); it != counts.end(); ++it)
+    OB_ASSERT(allcounts.count(it->first) == 1);
+
+  // Atoms without heavy neighbours do not grow beyond the first pass
+  mol = ReadSmiles("[Na+].[Cl-]");
+  OB_REQUIRE(nodups->GetFeatureCounts(mol.get(), counts));
+  OB_COMPARE(TotalCount(counts), 2);
+  mol = ReadSmiles("C");
+  OB_REQUIRE(nodups->GetFeatureCounts(mol.get(), counts));
+  OB_COMPARE(TotalCount(counts), 1);
+}
+
+int fingerprinttest(int argc, char* argv[])
+{
+  int defaultchoice = 1;
+
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+  // Define location of file formats for testing
+  #ifdef FORMATDIR
+    char env[BUFF_SIZE];
+    snprintf(env, BUFF_SIZE, "BABEL_LIBDIR=%s", FORMATDIR);
+    putenv(env);
+  #endif
+
+  switch(choice) {
+  case 1:
+    testFP2Description();
+    break;
+  case 2:
+    testFPMRoundTrip(0);
+    testFPMRoundTrip(100);
+    break;
+  case 3:
+    testECFPCounts();
+    break;
+  case 4:
+    testECFPNoDups();
+    break;
+  default:
+    cout << "Test number " << choice << " does not exist!\n";
+    return -1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,190 @@
+#include "obtest.h"
+
+#include <openbabel/mol.h>
+#include <openbabel/atom.h>
+#include <openbabel/obiter.h>
+#include <openbabel/forcefield.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace OpenBabel;
+
+static double NonBondedEnergy(OBForceField *pFF)
+{
+  return pFF->E_VDW(false) + pFF->E_Electrostatic(false);
+}
+
+static bool IsClose(double a, double b)
+{
+  return fabs(a - b) < 1e-6 * std::max(1.0, fabs(b));
+}
+
+// A rigid move of some of the atoms only changes the energy of the pairs
+// between a moved and a static atom, which E_NonBonded() must pick out.
+// Ignoring an atom leaves out its pairs, so that the terms of the force
+// field are no longer one for each pair.
+void testMovedPairs(const string &ffname, bool ignoreAtom)
+{
+  cout << "testMovedPairs(" << ffname << ", " << ignoreAtom << ")" << endl;
+  OBMolPtr mol = OBTestUtil::ReadFile("forcefield.sdf");
+  OBForceField *pFF = OBForceField::FindForceField(ffname);
+  OB_REQUIRE(pFF);
+  OBFFConstraints constraints;
+  if (ignoreAtom)
+    constraints.AddIgnore(2);
+  OB_REQUIRE(pFF->Setup(*mol, constraints));
+
+  OBBitVec moved(mol->NumAtoms() + 1);
+  for (unsigned int i = 1; i <= mol->NumAtoms() / 2; ++i)
+    moved.SetBitOn(i);
+  OBBitVec cross, rest;
+  pFF->GetMovedPairs(moved, cross, rest);
+
+  double full0 = NonBondedEnergy(pFF);
+  double cross0 = pFF->E_NonBonded(cross);
+  double rest0 = pFF->E_NonBonded(rest);
+  OB_ASSERT(IsClose(cross0 + rest0, full0));
+
+  vector3 shift(0.4, -0.3, 0.5);
+  FOR_ATOMS_OF_MOL(a, *mol)
+    if (moved.BitIsSet(a->GetIdx()))
+      a->SetVector(a->GetVector() + shift);
+  OB_REQUIRE(pFF->SetCoordinates(*mol));
+
+  double full1 = NonBondedEnergy(pFF);
+  double cross1 = pFF->E_NonBonded(cross);
+  double rest1 = pFF->E_NonBonded(rest);
+  OB_ASSERT(!IsClose(full1, full0));
+  OB_ASSERT(IsClose(rest1, rest0));
+  OB_ASSERT(IsClose(cross1 + rest1, full1));
+
+  // The subsets are further restricted by the cut-off
+  pFF->EnableCutOff(true);
+  pFF->SetVDWCutOff(4.0);
+  pFF->SetElectrostaticCutOff(6.0);
+  pFF->UpdatePairsSimple();
+  double cutoff = NonBondedEnergy(pFF);
+  OB_ASSERT(!IsClose(cutoff, full1));
+  OB_ASSERT(IsClose(pFF->E_NonBonded(cross) + pFF->E_NonBonded(rest), cutoff));
+  pFF->EnableCutOff(false);
+}
+
+#ifdef HAVE_EIGEN
+// A conformer, as its energy and coordinates
+typedef pair<double, vector<double> > Conformer;
+
+static vector<Conformer> Conformers(const OBMol &mol, const string &ffname, bool tree)
+{
+  OBMol copy(mol);
+  // A new instance, so that neither search sees state left by the other
+  OBForceField *pFF = OBForceField::FindForceField(ffname)->MakeNewInstance();
+  pFF->SetLogFile(&cout);
+  pFF->SetLogLevel(OBFF_LOGLVL_NONE);
+  OB_REQUIRE(pFF->Setup(copy));
+  // No RMSD filter and an energy window that takes every pose, as otherwise
+  // which poses are kept depends on the order in which they are found
+  if (tree)
+    pFF->DiverseConfGenTree(0.0, 0, 1.0e9);
+  else
+    pFF->DiverseConfGen(0.0, 0, 1.0e9);
+  pFF->GetConformers(copy);
+  delete pFF;
+
+  vector<double> energies = copy.GetEnergies();
+  OB_REQUIRE(energies.size() == static_cast<size_t>(copy.NumConformers()));
+  vector<Conformer> confs;
+  for (int i = 0; i < copy.NumConformers(); ++i) {
+    const double *c = copy.GetConformer(i);
+    confs.push_back(Conformer(energies[i], vector<double>(c, c + 3 * copy.NumAtoms())));
+  }
+  sort(confs.begin(), confs.end());
+  return confs;
+}
+
+static bool SameCoordinates(const vector<double> &a, const vector<double> &b)
+{
+  for (size_t i = 0; i < a.size(); ++i)
+    if (fabs(a[i] - b[i]) > 1e-6)
+      return false;
+  return true;
+}
+
+// The tree search evaluates the non-bonded pairs level by level with
+// E_NonBonded(), and must find every conformer of the exhaustive search with
+// the same energy
+void testDiverseConfGenTree(const string &ffname)
+{
+  cout << "testDiverseConfGenTree(" << ffname << ")" << endl;
+  OBMolPtr mol = OBTestUtil::ReadFile("forcefield.sdf");
+  OB_REQUIRE(mol->NumRotors() > 0);
+  vector<Conformer> full = Conformers(*mol, ffname, false);
+  vector<Conformer> tree = Conformers(*mol, ffname, true);
+  OB_REQUIRE(full.size() > 2);
+  OB_REQUIRE(tree.size() == full.size());
+  for (size_t i = 0; i < tree.size(); ++i) {
+    OB_COMPARE(IsClose(tree[i].first, full[i].first), true);
+    // Poses of the same energy may come in either order
+    bool found = false;
+    for (size_t j = i; !found && j < full.size() && IsClose(full[j].first, tree[i].first); ++j)
+      found = SameCoordinates(tree[i].second, full[j].second);
+    for (size_t j = i; !found && j-- > 0 && IsClose(full[j].first, tree[i].first); )
+      found = SameCoordinates(tree[i].second, full[j].second);
+    OB_ASSERT(found);
+  }
+}
+#endif
+
+int forcefieldtest(int argc, char* argv[])
+{
+  int defaultchoice = 1;
+
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+  // Define location of file formats for testing
+  #ifdef FORMATDIR
+    char env[BUFF_SIZE];
+    snprintf(env, BUFF_SIZE, "BABEL_LIBDIR=%s", FORMATDIR);
+    putenv(env);
+  #endif
+
+  switch(choice) {
+  case 1:
+    testMovedPairs("UFF", false);
+    testMovedPairs("UFF", true);
+    break;
+  case 2:
+    testMovedPairs("GAFF", false);
+    testMovedPairs("GAFF", true);
+    break;
+  case 3:
+    testMovedPairs("Ghemical", false);
+    testMovedPairs("Ghemical", true);
+    break;
+  case 4:
+    testMovedPairs("MMFF94", false);
+    testMovedPairs("MMFF94", true);
+    break;
+#ifdef HAVE_EIGEN
+  case 5:
+    testDiverseConfGenTree("UFF");
+    testDiverseConfGenTree("GAFF");
+    break;
+#endif
+  default:
+    cout << "Test number " << choice << " does not exist!\n";
+    return -1;
+  }
+
+  return 0;
+}
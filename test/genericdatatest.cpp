@@ -0,0 +1,343 @@
+#include "obtest.h"
+#include <openbabel/mol.h>
+#include <openbabel/generic.h>
+#include <openbabel/atom.h>
+#include <openbabel/bond.h>
+#include <openbabel/ring.h>
+#include <openbabel/obconversion.h>
+#include <openbabel/obiter.h>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace OpenBabel;
+
+static string Tag(int i)
+{
+  ostringstream ss;
+  ss << "tag" << i;
+  return ss.str();
+}
+
+static OBPairData *AddPair(OBBase &ob, const string &attr)
+{
+  OBPairData *dp = new OBPairData;
+  dp->SetAttribute(attr);
+  dp->SetValue(attr + " value");
+  ob.SetData(dp);
+  return dp;
+}
+
+// The lookups must agree with a linear search of GetData()
+static void CheckLookups(OBBase &ob, const vector<string> &attrs)
+{
+  for (size_t i = 0; i < attrs.size(); ++i) {
+    OBGenericData *expected = NULL;
+    for (size_t j = 0; j < ob.GetData().size(); ++j)
+      if (ob.GetData()[j]->GetAttribute() == attrs[i]) {
+        expected = ob.GetData()[j];
+        break;
+      }
+    OB_COMPARE(ob.HasData(attrs[i]), expected != NULL);
+    OB_ASSERT(ob.GetData(attrs[i]) == expected);
+    OB_ASSERT(ob.GetData(attrs[i].c_str()) == expected);
+  }
+}
+
+// Deleting an item and adding another, which may be allocated at the same
+// address, must not leave the lookups on the old item. Each size is either
+// side of the number of items from which lookups use an index.
+void testDeleteAndAdd()
+{
+  cout << "testDeleteAndAdd" << endl;
+  for (int n = 7; n <= 16; ++n) {
+    vector<string> attrs;
+    OBMol mol;
+    for (int i = 0; i < n; ++i) {
+      attrs.push_back(Tag(i));
+      AddPair(mol, Tag(i));
+    }
+    attrs.push_back("renamed");
+    OB_ASSERT(mol.HasData(Tag(0)));
+    CheckLookups(mol, attrs);
+
+    mol.DeleteData(mol.GetData(Tag(n - 1)));
+    OB_ASSERT(!mol.HasData(Tag(n - 1)));
+    OBPairData *dp = AddPair(mol, "renamed");
+    OB_ASSERT(mol.GetData("renamed") == dp);
+    CheckLookups(mol, attrs);
+
+    OB_ASSERT(mol.DeleteData(string("renamed")));
+    OB_ASSERT(!mol.HasData("renamed"));
+    dp = AddPair(mol, "renamed");
+    OB_ASSERT(mol.GetData("renamed") == dp);
+    CheckLookups(mol, attrs);
+
+    vector<OBGenericData*> some;
+    some.push_back(mol.GetData(Tag(0)));
+    some.push_back(mol.GetData("renamed"));
+    mol.DeleteData(some);
+    OB_ASSERT(!mol.HasData(Tag(0)));
+    OB_ASSERT(!mol.HasData("renamed"));
+    dp = AddPair(mol, "renamed");
+    OB_ASSERT(mol.GetData("renamed") == dp);
+    CheckLookups(mol, attrs);
+
+    mol.DeleteData(OBGenericDataType::PairData);
+    OB_COMPARE(mol.DataSize(), 0U);
+    CheckLookups(mol, attrs);
+    dp = AddPair(mol, "renamed");
+    OB_ASSERT(mol.GetData("renamed") == dp);
+
+    for (int i = 0; i < n; ++i)
+      AddPair(mol, Tag(i));
+    mol.Clear();
+    OB_ASSERT(!mol.HasData("renamed"));
+    dp = AddPair(mol, "renamed");
+    OB_ASSERT(mol.GetData("renamed") == dp);
+    CheckLookups(mol, attrs);
+  }
+}
+
+// Renaming an item after it was added
+void testRename()
+{
+  cout << "testRename" << endl;
+  OBMol mol;
+  vector<string> attrs;
+  for (int i = 0; i < 12; ++i) {
+    attrs.push_back(Tag(i));
+    AddPair(mol, Tag(i));
+  }
+  attrs.push_back("renamed");
+  CheckLookups(mol, attrs);
+
+  mol.GetData(Tag(5))->SetAttribute("renamed");
+  OB_ASSERT(!mol.HasData(Tag(5)));
+  OB_ASSERT(mol.HasData("renamed"));
+  CheckLookups(mol, attrs);
+
+  // and again after the next change
+  AddPair(mol, Tag(12));
+  attrs.push_back(Tag(12));
+  CheckLookups(mol, attrs);
+  OB_ASSERT(mol.GetData("renamed") == mol.GetData()[5]);
+}
+
+// Changes made through the reference from GetData() that keep the number of
+// items, including through one kept from before the index was last updated
+void testDirectEdits()
+{
+  cout << "testDirectEdits" << endl;
+  OBMol mol;
+  vector<string> attrs;
+  for (int i = 0; i < 12; ++i) {
+    attrs.push_back(Tag(i));
+    AddPair(mol, Tag(i));
+  }
+  attrs.push_back("replaced");
+  OB_ASSERT(mol.HasData(Tag(3)));
+
+  // Replacing an item
+  OBPairData *dp = new OBPairData;
+  dp->SetAttribute("replaced");
+  delete mol.GetData()[3];
+  mol.GetData()[3] = dp;
+  OB_ASSERT(!mol.HasData(Tag(3)));
+  OB_ASSERT(mol.GetData("replaced") == dp);
+  CheckLookups(mol, attrs);
+
+  // Swapping two items through a reference kept over a change
+  vector<OBGenericData*> &vdata = mol.GetData();
+  AddPair(mol, Tag(12));
+  OBGenericData *first = mol.GetData(Tag(0)), *second = mol.GetData(Tag(1));
+  swap(vdata[0], vdata[1]);
+  OB_ASSERT(mol.GetData(Tag(0)) == first);
+  OB_ASSERT(mol.GetData(Tag(1)) == second);
+  OB_ASSERT(mol.GetData(OBGenericDataType::PairData) == second);
+  OB_ASSERT(mol.GetAllData(OBGenericDataType::PairData)[0] == second);
+  attrs.push_back(Tag(12));
+  CheckLookups(mol, attrs);
+}
+
+// Lookups by type return the first item, and GetAllData() all of them in order
+void testTypes()
+{
+  cout << "testTypes" << endl;
+  OBMol mol;
+  vector<OBGenericData*> pairs, comments;
+  for (int i = 0; i < 20; ++i) {
+    if (i % 3 == 0) {
+      OBCommentData *cd = new OBCommentData;
+      cd->SetData(Tag(i));
+      mol.SetData(cd);
+      comments.push_back(cd);
+    }
+    else
+      pairs.push_back(AddPair(mol, Tag(i)));
+  }
+  OB_ASSERT(mol.GetData(OBGenericDataType::PairData) == pairs[0]);
+  OB_ASSERT(mol.GetData(OBGenericDataType::CommentData) == comments[0]);
+  OB_ASSERT(!mol.HasData(OBGenericDataType::UnitCell));
+  OB_ASSERT(mol.GetAllData(OBGenericDataType::PairData) == pairs);
+  OB_ASSERT(mol.GetAllData(OBGenericDataType::CommentData) == comments);
+
+  mol.DeleteData(comments[0]);
+  comments.erase(comments.begin());
+  OB_ASSERT(mol.GetData(OBGenericDataType::CommentData) == comments[0]);
+  OB_ASSERT(mol.GetAllData(OBGenericDataType::CommentData) == comments);
+  mol.DeleteData(OBGenericDataType::CommentData);
+  OB_ASSERT(!mol.HasData(OBGenericDataType::CommentData));
+  OB_ASSERT(mol.GetAllData(OBGenericDataType::PairData) == pairs);
+
+  // A copy looks up the same items
+  OBMol copy(mol);
+  OB_ASSERT(copy.GetAllData(OBGenericDataType::PairData).size() == pairs.size());
+  OB_ASSERT(copy.HasData(Tag(19)));
+}
+
+// Lookups do not change the object, so several threads can make them at once
+void testConcurrentLookups()
+{
+  cout << "testConcurrentLookups" << endl;
+  OBMol mol;
+  vector<OBPairData*> pairs;
+  for (int i = 0; i < 32; ++i)
+    pairs.push_back(AddPair(mol, Tag(i)));
+
+  const int numThreads = 4;
+  vector<int> wrong(numThreads, 0);
+  vector<thread> threads;
+  for (int t = 0; t < numThreads; ++t)
+    threads.push_back(thread([&, t]() {
+      for (int j = 0; j < 5000; ++j) {
+        int i = (j * 7 + t) % 33;
+        OBGenericData *expected = i < 32 ? pairs[i] : NULL;
+        if (mol.GetData(Tag(i)) != expected || mol.HasData(Tag(i)) != (expected != NULL))
+          wrong[t]++;
+      }
+    }));
+  for (size_t t = 0; t < threads.size(); ++t)
+    threads[t].join();
+  for (int t = 0; t < numThreads; ++t)
+    OB_COMPARE(wrong[t], 0);
+}
+
+// The ring membership index follows changes to the rings made through
+// GetData() that keep their number, and bonds added since the perception
+void testRingMembership()
+{
+  cout << "testRingMembership" << endl;
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInFormat("smi"));
+  OBMol mol;
+  OB_REQUIRE(conv.ReadString(&mol, "C1CC1C1CCCC1")); // atoms 1-3 and 4-8
+  vector<OBRing*> &rings = mol.GetSSSR();
+  OB_REQUIRE(rings.size() == 2);
+  OBAtom *three = mol.GetAtom(1), *five = mol.GetAtom(5);
+  OB_ASSERT(three->IsInRingSize(3));
+  OB_COMPARE(three->MemberOfRingCount(), 1U);
+  OB_COMPARE(five->MemberOfRingSize(), 5U);
+
+  // Replace the three-membered ring with a copy of the five-membered one
+  OBRing *small = rings[0]->Size() == 3 ? rings[0] : rings[1];
+  OBRing *large = small == rings[0] ? rings[1] : rings[0];
+  *find(rings.begin(), rings.end(), small) = new OBRing(large->_path, mol.NumAtoms() + 1);
+  delete small;
+  OB_ASSERT(!three->IsInRingSize(3));
+  OB_COMPARE(three->MemberOfRingCount(), 0U);
+  OB_COMPARE(five->MemberOfRingCount(), 2U);
+  OB_ASSERT(mol.GetBond(1, 2)->FindSmallestRing() == NULL);
+
+  // A bond added without modifying the rings
+  OB_REQUIRE(mol.AddBond(4, 6, 1));
+  OB_ASSERT(mol.GetBond(4, 6)->FindSmallestRing() != NULL);
+}
+
+// Ring queries do not change the molecule once the rings are perceived
+void testConcurrentRingQueries()
+{
+  cout << "testConcurrentRingQueries" << endl;
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInFormat("smi"));
+  OBMol mol;
+  OB_REQUIRE(conv.ReadString(&mol, "c1ccc2c(c1)C1CC1C1CCCC21"));
+  vector<unsigned int> counts;
+  vector<int> sizes;
+  FOR_ATOMS_OF_MOL (atom, mol) {
+    counts.push_back(atom->MemberOfRingCount());
+    sizes.push_back(atom->IsInRingSize(3) ? 3 : atom->MemberOfRingSize());
+  }
+
+  const int numThreads = 4;
+  vector<int> wrong(numThreads, 0);
+  vector<thread> threads;
+  for (int t = 0; t < numThreads; ++t)
+    threads.push_back(thread([&, t]() {
+      for (int j = 0; j < 2000; ++j) {
+        OBAtom *atom = mol.GetAtom(1 + (j * 7 + t) % mol.NumAtoms());
+        unsigned int i = atom->GetIdx() - 1;
+        int size = atom->IsInRingSize(3) ? 3 : atom->MemberOfRingSize();
+        if (atom->MemberOfRingCount() != counts[i] || size != sizes[i])
+          wrong[t]++;
+      }
+    }));
+  for (size_t t = 0; t < threads.size(); ++t)
+    threads[t].join();
+  for (int t = 0; t < numThreads; ++t)
+    OB_COMPARE(wrong[t], 0);
+}
+
+int genericdatatest(int argc, char* argv[])
+{
+  int defaultchoice = 1;
+
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+  // Define location of file formats for testing
+  #ifdef FORMATDIR
+    char env[BUFF_SIZE];
+    snprintf(env, BUFF_SIZE, "BABEL_LIBDIR=%s", FORMATDIR);
+    putenv(env);
+  #endif
+
+  switch(choice) {
+  case 1:
+    testDeleteAndAdd();
+    break;
+  case 2:
+    testRename();
+    break;
+  case 3:
+    testTypes();
+    break;
+  case 4:
+    testConcurrentLookups();
+    break;
+  case 5:
+    testDirectEdits();
+    break;
+  case 6:
+    testRingMembership();
+    break;
+  case 7:
+    testConcurrentRingQueries();
+    break;
+  default:
+    cout << "Test number " << choice << " does not exist!\n";
+    return -1;
+  }
+
+  return 0;
+}
@@ -4,8 +4,11 @@
 #include <openbabel/ring.h>
 #include <openbabel/atom.h>
 #include <openbabel/obiter.h>
+#include <openbabel/bitvec.h>
+#include <openbabel/bond.h>
 
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <algorithm>
@@ -179,6 +182,89 @@ bool verifyLSSR(const std::string &filename, const LSSR &ref)
   return true;
 }
 
+// The SSSR atoms of each ring, sorted, with " | " between the rings
+static std::string SSSRAtoms(OBMol &mol)
+{
+  std::vector<std::vector<int> > rings;
+  std::vector<OBRing*> sssr = mol.GetSSSR();
+  for (unsigned int i = 0; i < sssr.size(); ++i) {
+    std::vector<int> path(sssr[i]->_path);
+    std::sort(path.begin(), path.end());
+    rings.push_back(path);
+  }
+  std::sort(rings.begin(), rings.end());
+  std::stringstream ss;
+  for (unsigned int i = 0; i < rings.size(); ++i) {
+    if (i)
+      ss << " | ";
+    for (unsigned int j = 0; j < rings[i].size(); ++j)
+      ss << (j ? " " : "") << rings[i][j];
+  }
+  return ss.str();
+}
+
+// The number of SSSR rings whose bond sets are linearly independent (mod 2)
+static unsigned int SSSRRank(OBMol &mol)
+{
+  std::vector<OBBitVec> rows;
+  std::vector<OBRing*> sssr = mol.GetSSSR();
+  for (unsigned int i = 0; i < sssr.size(); ++i) {
+    OBBitVec bonds;
+    const std::vector<int> &path = sssr[i]->_path;
+    for (unsigned int j = 0; j < path.size(); ++j)
+      bonds.SetBitOn(mol.GetBond(path[j], path[(j + 1) % path.size()])->GetIdx());
+    // reduce against the rows so far, each of which has a distinct lowest bit
+    for (unsigned int k = 0; k < rows.size(); ++k)
+      if (bonds.BitIsSet(rows[k].FirstBit()))
+        bonds ^= rows[k];
+    if (!bonds.IsEmpty()) {
+      for (unsigned int k = 0; k < rows.size(); ++k)
+        if (rows[k].BitIsSet(bonds.FirstBit()))
+          rows[k] ^= bonds;
+      rows.push_back(bonds);
+    }
+  }
+  return rows.size();
+}
+
+// Metal complexes, cages and bridged polycycles for which the SSSR used to
+// contain a ring that was the sum of others. Each SSSR must be a cycle basis,
+// and these are the rings found.
+void verifySSSRBasis()
+{
+  cout << "Verify SSSR basis" << endl;
+  const char *data[][2] = {
+    { "C1O[Cu+2]234[OH+]CC[N@+]4(C1)CC[O-]3[Cu+2]134OCC[N@+]4(CC[OH+]1)CC[O-]3[Cu+2]134OCC[N@+]4(CC[OH+]1)CC[O-]3[Cu+2]134OCC[N@+]4(CC[OH+]1)CC[O-]23",
+      "1 2 3 7 8 | 3 4 5 6 7 | 3 7 9 10 11 | 3 11 12 22 23 33 34 44 | 12 13 14 15 16 | 12 16 17 18 19 | 12 16 20 21 22 | 23 24 25 26 27 | 23 27 28 29 30 | 23 27 31 32 33 | 34 35 36 37 38 | 34 38 39 40 41 | 34 38 42 43 44" },
+    { "C1O[Cu+2]234[OH+]CC[N@@+]4(C1)CC[O-]2[Cu+2]124OCC[N@@+]4(CC[OH+]1)CC[O-]2[Cu+2]124OCC[N@+]4(CC[OH+]1)CC[O-]2[Cu+2]124OCC[N@+]2(CC[OH+]1)CC[O-]34",
+      "1 2 3 7 8 | 3 4 5 6 7 | 3 7 9 10 11 | 3 11 12 22 23 33 34 44 | 12 13 14 15 16 | 12 16 17 18 19 | 12 16 20 21 22 | 23 24 25 26 27 | 23 27 28 29 30 | 23 27 31 32 33 | 34 35 36 37 38 | 34 38 39 40 41 | 34 38 42 43 44" },
+    { "CN(C(=O)[C@]12[C@@H]3[C@@H]4[C@H]1[C@H]1[C@@]4([C@@H]3[C@@]21C)C(=O)[C@]12[C@@H]3[C@@H]4[C@H]1[C@@H]1[C@H]2[C@H]3[C@]41C)C(C)(C)C",
+      "5 6 7 8 | 5 6 11 12 | 5 8 9 12 | 6 7 10 11 | 7 8 9 10 | 16 17 18 19 | 16 17 21 22 | 16 19 20 21 | 17 18 22 23 | 18 19 20 23" },
+    { "CN(C(=O)[C@]12[C@@H]3[C@H]4[C@@H]5[C@H]([C@@H]14)[C@]2([C@H]35)C(=O)[C@@]12[C@H]3[C@@H]4[C@@H]5[C@H]3[C@H]2[C@@H]5[C@H]14)C(C)(C)C",
+      "5 6 7 10 | 5 6 11 12 | 5 9 10 11 | 7 8 9 10 | 8 9 11 12 | 15 16 17 22 | 15 16 19 20 | 15 20 21 22 | 16 17 18 19 | 17 18 21 22" },
+    { "C[Si](C)(C)C12#C3([Si](C)(C)C)[Ni]45671([C@H]1C6=C5C4=C71)[Ni]145623[C@H]2C5=C4C1=C62",
+      "5 6 11 | 5 6 17 | 5 11 17 | 11 12 13 | 11 12 16 | 11 13 14 | 11 14 15 | 11 15 16 | 17 18 19 | 17 18 22 | 17 19 20 | 17 20 21 | 17 21 22" },
+    { "N1=C[NH+]2[Cu+2]3456N7CCN3CN(CN5CCN4CN(C7)C2=N1)C1=NN=C[NH+]61",
+      "1 2 3 19 20 | 3 4 5 17 18 19 | 3 4 15 16 17 19 | 4 5 6 7 8 | 4 8 9 10 11 12 | 4 8 9 10 21 25 | 4 12 13 14 15 | 21 22 23 24 25" },
+    { "O=C(N[C@@H]1C[C@@H]2c3ccccc3[C@H]1c1ccccc21)N[C@@H]1C[C@H]2c3ccccc3[C@@H]1c1ccccc21",
+      "4 5 6 7 12 13 | 6 7 12 13 14 19 | 7 8 9 10 11 12 | 14 15 16 17 18 19 | 21 22 23 24 29 30 | 23 24 29 30 31 36 | 24 25 26 27 28 29 | 31 32 33 34 35 36" },
+    { "O=C1C=CC(=O)[C@H]2[C@H]1[C@@H]1C=C[C@H]2[C@H]2[C@@H]1[C@]1(Cl)C(=C(Cl)[C@@]2(Cl)[C@]1(Cl)Cl)Cl",
+      "2 3 4 5 7 8 | 7 8 9 10 11 12 | 7 8 9 12 13 14 | 13 14 15 20 22 | 15 17 18 20 22" },
+    { "O=C1C=CC(=O)c2c3c([C@H]4c5ccccc5[C@@H]3c3ccccc43)c3[C@@H]4c5ccccc5[C@@H](c5ccccc45)c3c12",
+      "2 3 4 5 7 40 | 7 8 9 24 39 40 | 8 9 10 11 16 17 | 8 9 10 17 18 23 | 11 12 13 14 15 16 | 18 19 20 21 22 23 | 24 25 26 31 32 39 | 25 26 31 32 33 38 | 26 27 28 29 30 31 | 33 34 35 36 37 38" },
+    { "O=[N+]1[C@@H]2[C@H]3CC[C@H](C3)[C@H]2[N+](=O)[Co]23451[C@H]1C4=C3C2=C51",
+      "2 3 9 10 12 | 3 4 7 8 9 | 4 5 6 7 8 | 12 13 14 | 12 13 17 | 12 14 15 | 12 15 16 | 12 16 17" },
+  };
+  OBConversion conv;
+  OB_REQUIRE( conv.SetInFormat("smi") );
+  for (unsigned int i = 0; i < sizeof(data) / sizeof(data[0]); ++i) {
+    OBMol mol;
+    OB_REQUIRE( conv.ReadString(&mol, data[i][0]) );
+    OB_COMPARE( SSSRRank(mol), mol.GetSSSR().size() );
+    OB_COMPARE( SSSRAtoms(mol), data[i][1] );
+  }
+}
+
 int lssrtest(int argc, char* argv[])
 {
   int defaultchoice = 1;
@@ -232,6 +318,9 @@ int lssrtest(int argc, char* argv[])
     // 12x 5-ring, 20x 6-ring
     OB_ASSERT( verifyLSSR("rings/fullerene60.mdl", LSSR(LSSR::Size_Count(5, 12), LSSR::Size_Count(6, 20))) );
     break;
+  case 6:
+    verifySSSRBasis();
+    break;
   default:
     cout << "Test number " << choice << " does not exist!\n";
     return -1;
@@ -0,0 +1,216 @@
+#include "obtest.h"
+#include <openbabel/mol.h>
+#include <openbabel/atom.h>
+#include <openbabel/bond.h>
+#include <openbabel/residue.h>
+#include <openbabel/generic.h>
+#include <openbabel/obiter.h>
+#include <openbabel/obconversion.h>
+#include <openbabel/stereo/stereo.h>
+#include <openbabel/stereo/tetrahedral.h>
+#include <openbabel/stereo/cistrans.h>
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace OpenBabel;
+
+static OBMolPtr RoundTrip(OBMol &mol)
+{
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInAndOutFormats("obbin", "obbin"));
+  string record = conv.WriteString(&mol);
+  OB_REQUIRE(!record.empty());
+  OBMolPtr copy(new OBMol);
+  OB_REQUIRE(conv.ReadString(copy.get(), record));
+  return copy;
+}
+
+static void AddPair(OBMol &mol, const string &attr, const string &value)
+{
+  OBPairData *dp = new OBPairData;
+  dp->SetAttribute(attr);
+  dp->SetValue(value);
+  mol.SetData(dp);
+}
+
+// Atoms and bonds come back in the same order with the same ids
+static void CompareAtomsAndBonds(OBMol &mol, OBMol &copy)
+{
+  OB_REQUIRE(copy.NumAtoms() == mol.NumAtoms());
+  OB_REQUIRE(copy.NumBonds() == mol.NumBonds());
+  FOR_ATOMS_OF_MOL (atom, mol) {
+    OBAtom *other = copy.GetAtom(atom->GetIdx());
+    OB_COMPARE(other->GetId(), atom->GetId());
+    OB_COMPARE(other->GetAtomicNum(), atom->GetAtomicNum());
+    OB_COMPARE(other->GetImplicitHCount(), atom->GetImplicitHCount());
+    OB_ASSERT(other->GetVector().IsApprox(atom->GetVector(), 1e-12));
+  }
+  FOR_BONDS_OF_MOL (bond, mol) {
+    OBBond *other = copy.GetBond(bond->GetIdx());
+    OB_COMPARE(other->GetId(), bond->GetId());
+    OB_ASSERT(copy.GetBondById(bond->GetId()) == other);
+    OB_COMPARE(other->GetBeginAtom()->GetId(), bond->GetBeginAtom()->GetId());
+    OB_COMPARE(other->GetEndAtom()->GetId(), bond->GetEndAtom()->GetId());
+    OB_COMPARE(other->GetBondOrder(), bond->GetBondOrder());
+    OB_COMPARE(other->GetFlags(), bond->GetFlags());
+    // The end atoms know the bond as well
+    OB_ASSERT(other->GetBeginAtom()->GetBond(other->GetEndAtom()) == other);
+  }
+}
+
+static void ComparePairs(OBMol &mol, OBMol &copy)
+{
+  vector<OBGenericData*> pairs = mol.GetAllData(OBGenericDataType::PairData);
+  OB_REQUIRE(!pairs.empty());
+  for (vector<OBGenericData*>::iterator i = pairs.begin(); i != pairs.end(); ++i) {
+    OBGenericData *other = copy.GetData((*i)->GetAttribute());
+    OB_REQUIRE(other);
+    OB_COMPARE(other->GetValue(), (*i)->GetValue());
+  }
+}
+
+// Stereo refers to atom ids, which stay valid after atoms and bonds have
+// been deleted; the bond ids are kept as well
+void testStereo()
+{
+  cout << "testStereo" << endl;
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInFormat("smi"));
+  OBMol mol;
+  OB_REQUIRE(conv.ReadString(&mol, "C[C@@H](N)C(=O)O/C=C/F.[Cl-]"));
+  mol.AddHydrogens();
+  // Leave gaps in the atom and bond ids
+  mol.DeleteAtom(mol.GetAtom(10));
+  mol.DeleteHydrogen(mol.GetAtom(10));
+  OB_REQUIRE(mol.GetAtom(10)->GetId() != 9);
+  OB_REQUIRE(mol.GetBond(mol.NumBonds() - 1)->GetId() != mol.NumBonds() - 1);
+  AddPair(mol, "name", "test molecule");
+  AddPair(mol, "empty", "");
+
+  OBMolPtr copy = RoundTrip(mol);
+  CompareAtomsAndBonds(mol, *copy);
+  ComparePairs(mol, *copy);
+
+  OBStereoFacade facade(&mol), copyFacade(copy.get());
+  OB_REQUIRE(facade.NumTetrahedralStereo() == 1);
+  OB_REQUIRE(facade.NumCisTransStereo() == 1);
+  OB_COMPARE(copyFacade.NumTetrahedralStereo(), 1U);
+  OB_COMPARE(copyFacade.NumCisTransStereo(), 1U);
+  FOR_ATOMS_OF_MOL (atom, mol)
+    if (facade.HasTetrahedralStereo(atom->GetId())) {
+      OBTetrahedralStereo *ts = copyFacade.GetTetrahedralStereo(atom->GetId());
+      OB_REQUIRE(ts);
+      OB_ASSERT(ts->GetConfig() == facade.GetTetrahedralStereo(atom->GetId())->GetConfig());
+    }
+  FOR_BONDS_OF_MOL (bond, mol)
+    if (facade.HasCisTransStereo(bond->GetId())) {
+      OBCisTransStereo *ct = copyFacade.GetCisTransStereo(bond->GetId());
+      OB_REQUIRE(ct);
+      OB_ASSERT(ct->GetConfig() == facade.GetCisTransStereo(bond->GetId())->GetConfig());
+    }
+
+  OB_REQUIRE(conv.SetOutFormat("can"));
+  OB_COMPARE(conv.WriteString(copy.get(), true), conv.WriteString(&mol, true));
+}
+
+// Residues keep their atoms, atom names, HETATM flags and serial numbers
+void testResidues()
+{
+  cout << "testResidues" << endl;
+  OBMolPtr mol = OBTestUtil::ReadFile("00T_ideal_het.pdb");
+  AddPair(*mol, "source", "00T_ideal_het.pdb");
+
+  OBMolPtr copy = RoundTrip(*mol);
+  CompareAtomsAndBonds(*mol, *copy);
+  ComparePairs(*mol, *copy);
+
+  OB_REQUIRE(mol->NumResidues() > 0);
+  OB_REQUIRE(copy->NumResidues() == mol->NumResidues());
+  FOR_RESIDUES_OF_MOL (res, *mol) {
+    OBResidue *other = copy->GetResidue(res->GetIdx());
+    OB_COMPARE(other->GetName(), res->GetName());
+    OB_COMPARE(other->GetNumString(), res->GetNumString());
+    OB_COMPARE(other->GetChain(), res->GetChain());
+    vector<OBAtom*> atoms = res->GetAtoms(), otherAtoms = other->GetAtoms();
+    OB_REQUIRE(otherAtoms.size() == atoms.size());
+    for (size_t i = 0; i < atoms.size(); ++i) {
+      OB_COMPARE(otherAtoms[i]->GetIdx(), atoms[i]->GetIdx());
+      OB_COMPARE(other->GetAtomID(otherAtoms[i]), res->GetAtomID(atoms[i]));
+      OB_COMPARE(other->IsHetAtom(otherAtoms[i]), res->IsHetAtom(atoms[i]));
+      OB_COMPARE(other->GetSerialNum(otherAtoms[i]), res->GetSerialNum(atoms[i]));
+    }
+  }
+}
+
+// Records with a length or a current conformer that cannot be right are
+// rejected, without allocating for the length first
+void testCorrupt()
+{
+  cout << "testCorrupt" << endl;
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInAndOutFormats("obbin", "obbin"));
+  OBMol mol;
+  OBAtom *atom = mol.NewAtom();
+  atom->SetAtomicNum(6);
+  atom->SetVector(1234.5, 0.0, 0.0);
+  string record = conv.WriteString(&mol);
+  OBMol copy;
+  OB_REQUIRE(conv.ReadString(&copy, record));
+
+  // The length is the last 8 bytes of the header
+  string huge = record;
+  huge[15] = 0x40;
+  OB_ASSERT(!conv.ReadString(&copy, huge));
+  string longer = record;
+  longer[8] = static_cast<char>(longer[8] + 1);
+  OB_ASSERT(!conv.ReadString(&copy, longer));
+
+  // The index of the current conformer is just before the coordinates
+  double x = 1234.5;
+  string bits(reinterpret_cast<const char*>(&x), sizeof(x));
+  size_t pos = record.find(bits, 16);
+  OB_REQUIRE(pos != string::npos && pos >= 20);
+  string current = record;
+  current[pos - 4] = 1;
+  OB_ASSERT(!conv.ReadString(&copy, current));
+  OB_COMPARE(copy.NumAtoms(), 0U);
+}
+
+int obbintest(int argc, char* argv[])
+{
+  int defaultchoice = 1;
+
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+  // Define location of file formats for testing
+  #ifdef FORMATDIR
+    char env[BUFF_SIZE];
+    snprintf(env, BUFF_SIZE, "BABEL_LIBDIR=%s", FORMATDIR);
+    putenv(env);
+  #endif
+
+  switch(choice) {
+  case 1:
+    testStereo();
+    break;
+  case 2:
+    testResidues();
+    break;
+  case 3:
+    testCorrupt();
+    break;
+  default:
+    cout << "Test number " << choice << " does not exist!\n";
+    return -1;
+  }
+
+  return 0;
+}
@@ -2,6 +2,13 @@
 
 #include <openbabel/mol.h>
 #include <openbabel/obconversion.h>
+#include <openbabel/bond.h>
+#include <openbabel/obiter.h>
+#include <openbabel/kekulize.h>
+#include <openbabel/chains.h>
+#include <openbabel/descriptor.h>
+
+#include <fstream>
 
 std::string GetFilename(const std::string &filename)
 {
@@ -40,9 +47,130 @@ void benchmarkOBMol3()
   }
 }
 
+void benchmarkRings()
+{
+  // Fused, bridged and cage ring systems
+  const char *smiles[] = {
+    "C12=C3C4=C5C6=C1C7=C8C9=C1C%10=C%11C(=C29)C3=C2C3=C4C4=C5C5=C9C6=C7C6=C7C8=C1C1=C8C%10=C%10C%11=C2C2=C3C3=C4C4=C5C5=C%11C%12=C(C6=C95)C7=C1C1=C%12C5=C%11C4=C3C3=C5C(=C81)C%10=C23", // C60
+    "C12C3C4C1C5C2C3C45", // cubane
+    "C1CC2CC3CC4CC5CC6CC7CC8CC9CC%10CCCCC%10CC9CC8CC7CC6CC5CC4CC3CC2CC1",
+    "C1CC2(CCC3(CCC4(CCC5(CCC6(CC1)CC6)CC5)CC4)CC3)CC2",
+    "CC12CCC3C(CCC4=CC(=O)CCC34C)C1CCC2O", // testosterone
+    "C1CN2CCOCCOCCN(CCO1)CCOCCOCC2" // cryptand
+  };
+  std::vector<OBMol> mols(sizeof(smiles) / sizeof(smiles[0]));
+  OBConversion conv;
+  OB_REQUIRE( conv.SetInFormat("smi") );
+  for (unsigned int i = 0; i < mols.size(); ++i)
+    OB_REQUIRE( conv.ReadString(&mols[i], smiles[i]) );
+
+  OB_NAMED_BENCHMARK("Rings: SSSR and LSSR of ring-heavy molecules") {
+    for (unsigned int i = 0; i < mols.size(); ++i) {
+      mols[i].SetSSSRPerceived(false);
+      mols[i].SetLSSRPerceived(false);
+      mols[i].GetSSSR();
+      mols[i].GetLSSR();
+    }
+  }
+}
+
+void benchmarkKekulize()
+{
+  // Fused aromatic systems, including ones the greedy match cannot complete
+  const char *smiles[] = {
+    "c1cc2ccc3ccc4ccc5ccc6ccc1c1c2c3c4c5c61", // coronene
+    "c1cc2cc3cc4cc5cc6cc7cc8cc9cc%10ccccc%10cc9cc8cc7cc6cc5cc4cc3cc2cc1", // decacene
+    "c1ccc2c(c1)ccc1ccc3ccc4ccc5ccc6ccc7ccc8ccccc8c7c6c5c4c3c21", // octahelicene
+    "c1cc2ccc3cc4ccc5ccc6cc7ccc1c1c2c3c(c4c5c6c7)c1",
+    "c1ccc2cc3ccc4cccc5ccc(c2c1)c3c45", // benzo[a]pyrene
+    "Cn1cnc2c1c(=O)n(C)c(=O)n2C", // caffeine
+    "c1ccc2c(c1)[nH]c1ccccc12" // carbazole
+  };
+  std::vector<OBMol> mols(sizeof(smiles) / sizeof(smiles[0]));
+  OBConversion conv;
+  OB_REQUIRE( conv.SetInFormat("smi") );
+  for (unsigned int i = 0; i < mols.size(); ++i)
+    OB_REQUIRE( conv.ReadString(&mols[i], smiles[i]) );
+
+  OB_NAMED_BENCHMARK("Kekulize: 100 x fused aromatic systems") {
+    for (unsigned int n = 0; n < 100; ++n)
+      for (unsigned int i = 0; i < mols.size(); ++i) {
+        FOR_BONDS_OF_MOL(bond, mols[i])
+          if (bond->IsAromatic())
+            bond->SetBondOrder(1);
+        OBKekulize(&mols[i]);
+      }
+  }
+}
+
+void benchmarkWriters()
+{
+  OBConversion conv;
+  OB_REQUIRE( conv.SetInFormat("pdb") );
+  OBMol mol;
+  OB_REQUIRE( conv.ReadFile(&mol, GetFilename("1DRF.pdb")) );
+
+  const char *formats[] = { "sdf", "pdb", "mol2", "xyz" };
+  for (unsigned int i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i)
+    OB_REQUIRE( conv.SetOutFormat(formats[i]) );
+
+  OB_NAMED_BENCHMARK("Writers: 1788 atoms to sdf, pdb, mol2 and xyz") {
+    for (unsigned int i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i) {
+      conv.SetOutFormat(formats[i]);
+      conv.WriteString(&mol);
+    }
+  }
+}
+
+void benchmarkChains()
+{
+  OBConversion conv;
+  OB_REQUIRE( conv.SetInFormat("pdb") );
+  OBMol mol;
+  OB_REQUIRE( conv.ReadFile(&mol, GetFilename("3G61.pdb")) );
+  OBMol big;
+  for (unsigned int i = 0; i < 5; ++i)
+    big += mol;
+
+  OB_NAMED_BENCHMARK("Chains: perceive residues of 92240 atoms (5 x 3G61)") {
+    chainsparser.PerceiveChains(big);
+  }
+}
+
+void benchmarkDescriptors()
+{
+  OBConversion conv;
+  OB_REQUIRE( conv.SetInFormat("smi") );
+  std::ifstream ifs(GetFilename("nci.smi").c_str());
+  OB_REQUIRE( ifs );
+  std::vector<OBMol> mols;
+  OBMol mol;
+  while (conv.Read(&mol, &ifs))
+    mols.push_back(mol);
+
+  std::vector<std::pair<OBDescriptor*, std::string> > descrs;
+  OB_REQUIRE( OBDescriptor::FindDescriptors("MW logP TPSA MR HBD HBA1 HBA2 rotors", descrs) );
+  std::vector<bool> isString;
+  std::vector<double> values;
+  std::vector<std::string> svalues;
+
+  OB_NAMED_BENCHMARK("Descriptors: MW logP TPSA MR HBD HBA1 HBA2 rotors of 1005 molecules") {
+    std::vector<OBMol> copies(mols); // without the perception done last time
+    std::vector<OBBase*> objects;
+    for (unsigned int i = 0; i < copies.size(); ++i)
+      objects.push_back(&copies[i]);
+    OBDescriptor::PredictValues(objects, descrs, isString, values, svalues);
+  }
+}
+
 int main()
 {
   benchmarkOBMol1();
   benchmarkOBMol2();
   benchmarkOBMol3();
+  benchmarkRings();
+  benchmarkKekulize();
+  benchmarkWriters();
+  benchmarkChains();
+  benchmarkDescriptors();
 }
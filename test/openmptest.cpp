@@ -0,0 +1,297 @@
+#include "obtest.h"
+#include <openbabel/mol.h>
+#include <openbabel/obconversion.h>
+#include <openbabel/builder.h>
+#include <openbabel/conformersearch.h>
+#include <openbabel/descriptor.h>
+#include <openbabel/fingerprint.h>
+#include <openbabel/forcefield.h>
+#include <openbabel/oberror.h>
+#include <openbabel/obutil.h>
+#ifdef HAVE_EIGEN
+#include <openbabel/distgeom.h>
+#include <openbabel/math/align.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace OpenBabel;
+
+// The code run in parallel must give the same results on one thread as on
+// several. Without OpenMP both runs are serial.
+static const int numThreads = 4;
+
+static void SetThreads(int n)
+{
+#ifdef _OPENMP
+  omp_set_num_threads(n);
+#else
+  (void)n;
+#endif
+}
+
+static void Build3D(OBMol &mol, const string &smiles)
+{
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInFormat("smi"));
+  OB_REQUIRE(conv.ReadString(&mol, smiles));
+  OBBuilder builder;
+  OB_REQUIRE(builder.Build(mol));
+  mol.AddHydrogens(false, true);
+}
+
+// The first @p n molecules of nci.smi
+static void ReadMolecules(vector<OBMol> &mols, unsigned int n)
+{
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInFormat("smi"));
+  ifstream ifs(OBTestUtil::GetFilename("nci.smi").c_str());
+  OB_REQUIRE(ifs.good());
+  string line;
+  while (mols.size() < n && getline(ifs, line)) {
+    OBMol mol;
+    if (conv.ReadString(&mol, line))
+      mols.push_back(mol);
+  }
+  OB_REQUIRE(mols.size() == n);
+}
+
+static vector<double> AllCoordinates(OBMol &mol)
+{
+  vector<double> coords;
+  for (int c = 0; c < mol.NumConformers(); ++c) {
+    double *conf = mol.GetConformer(c);
+    coords.insert(coords.end(), conf, conf + 3 * mol.NumAtoms());
+  }
+  return coords;
+}
+
+static vector<double> ConformerSearch(const OBMol &start, int threads)
+{
+  SetThreads(threads);
+  OBConformerSearch cs;
+  cs.SetSeed(42);
+  OB_REQUIRE(cs.Setup(start, 20, 5, 5, 5));
+  cs.Search();
+  OBMol mol(start);
+  cs.GetConformers(mol);
+  return AllCoordinates(mol);
+}
+
+// A seeded genetic search gives the same conformers
+void testConformerSearch()
+{
+  cout << "testConformerSearch" << endl;
+  OBMol mol;
+  Build3D(mol, "CCCCOc1ccccc1CCNC(=O)CC");
+  vector<double> serial = ConformerSearch(mol, 1);
+  OB_ASSERT(!serial.empty());
+  OB_ASSERT(ConformerSearch(mol, numThreads) == serial);
+  SetThreads(1);
+}
+
+static vector<double> FastRotorSearch(const OBMol &start, int threads)
+{
+  SetThreads(threads);
+  OBMol mol(start);
+  OBForceField *pFF = OBForceField::FindForceField("MMFF94");
+  OB_REQUIRE(pFF && pFF->Setup(mol));
+  pFF->FastRotorSearch(false);
+  pFF->GetCoordinates(mol);
+  return AllCoordinates(mol);
+}
+
+// The rotor positions scored on per-thread force field copies
+void testFastRotorSearch()
+{
+  cout << "testFastRotorSearch" << endl;
+  OBMol mol;
+  Build3D(mol, "CCCCCOc1ccccc1OCCCN(C)C");
+  vector<double> serial = FastRotorSearch(mol, 1);
+  OB_ASSERT(FastRotorSearch(mol, numThreads) == serial);
+  SetThreads(1);
+}
+
+// Warns about every molecule it is given, from whichever thread
+class Warner : public OBDescriptor
+{
+public:
+  Warner() : OBDescriptor("") {}
+  const char* Description() { return "test"; }
+  virtual bool IsThreadSafe() { return true; }
+  double Predict(OBBase* pOb, string* = NULL)
+  {
+    OBMol *mol = static_cast<OBMol*>(pOb);
+    obErrorLog.ThrowError(__FUNCTION__, string("warning for ") + mol->GetTitle(), obWarning);
+    return mol->NumAtoms();
+  }
+};
+
+// Descriptor columns, and the messages thrown while they are computed
+void testDescriptors()
+{
+  cout << "testDescriptors" << endl;
+  vector<OBMol> mols;
+  ReadMolecules(mols, 200);
+  vector<OBBase*> objects;
+  for (size_t i = 0; i < mols.size(); ++i)
+    objects.push_back(&mols[i]);
+
+  Warner warner;
+  vector<pair<OBDescriptor*, string> > descrs;
+  const char *ids[] = { "title", "formula", "MW", "HBD", "HBA1", "rotors" };
+  for (size_t j = 0; j < sizeof(ids) / sizeof(ids[0]); ++j) {
+    OBDescriptor *pDesc = OBDescriptor::FindType(ids[j]);
+    OB_REQUIRE(pDesc && pDesc->IsThreadSafe());
+    descrs.push_back(make_pair(pDesc, string()));
+  }
+  descrs.push_back(make_pair((OBDescriptor*)&warner, string()));
+
+  vector<bool> isString[2];
+  vector<double> values[2];
+  vector<string> svalues[2];
+  for (int run = 0; run < 2; ++run) {
+    SetThreads(run == 0 ? 1 : numThreads);
+    obErrorLog.ClearLog();
+    obErrorLog.SetOutputLevel(obError);
+    obErrorLog.SetMaxLogEntries(0);
+    unsigned int before = obErrorLog.GetWarningMessageCount();
+    OBDescriptor::PredictValues(objects, descrs, isString[run], values[run], svalues[run]);
+
+    OB_COMPARE(obErrorLog.GetWarningMessageCount() - before, 200U);
+    vector<string> warnings = obErrorLog.GetMessagesOfLevel(obWarning);
+    OB_COMPARE(warnings.size(), 200U);
+    for (size_t i = 0; i < mols.size(); ++i) {
+      string expected = string("warning for ") + mols[i].GetTitle();
+      size_t found = 0;
+      for (size_t k = 0; k < warnings.size(); ++k)
+        if (warnings[k].find(expected) != string::npos)
+          ++found;
+      OB_ASSERT(found >= 1);
+    }
+  }
+  obErrorLog.ClearLog();
+  obErrorLog.SetOutputLevel(obWarning);
+  obErrorLog.SetMaxLogEntries(100);
+  SetThreads(1);
+
+  OB_ASSERT(isString[1] == isString[0]);
+  OB_ASSERT(svalues[1] == svalues[0]);
+  OB_REQUIRE(values[1].size() == values[0].size());
+  for (size_t k = 0; k < values[0].size(); ++k)
+    OB_ASSERT(values[1][k] == values[0][k] || (IsNan(values[1][k]) && IsNan(values[0][k])));
+}
+
+// ECFP fingerprints of many molecules
+void testFingerprints()
+{
+  cout << "testFingerprints" << endl;
+  vector<OBMol> mols;
+  ReadMolecules(mols, 200);
+  vector<OBBase*> objects;
+  for (size_t i = 0; i < mols.size(); ++i)
+    objects.push_back(&mols[i]);
+
+  OBFingerprint *pFP = OBFingerprint::FindFingerprint("ECFP4");
+  OB_REQUIRE(pFP && pFP->IsThreadSafe());
+  vector<vector<unsigned int> > fps[2];
+  for (int run = 0; run < 2; ++run) {
+    SetThreads(run == 0 ? 1 : numThreads);
+    OB_ASSERT(pFP->GetFingerprints(objects, fps[run], 1024));
+  }
+  SetThreads(1);
+  OB_COMPARE(fps[0].size(), mols.size());
+  OB_ASSERT(fps[1] == fps[0]);
+}
+
+#ifdef HAVE_EIGEN
+// Distance geometry embeddings are time-seeded, so only the number of
+// conformers and their coordinates being numbers are checked. The RMSD
+// matrix of the result is exact.
+void testConformersAndRMSD()
+{
+  cout << "testConformersAndRMSD" << endl;
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInFormat("smi"));
+  OBMol mol;
+  OB_REQUIRE(conv.ReadString(&mol, "C[C@H](O)CC(=O)OC"));
+  mol.AddHydrogens();
+
+  OBMol confs[2];
+  for (int run = 0; run < 2; ++run) {
+    SetThreads(run == 0 ? 1 : numThreads);
+    OBDistanceGeometry dg;
+    OB_REQUIRE(dg.Setup(mol));
+    dg.AddConformers(4);
+    confs[run] = mol;
+    dg.GetConformers(confs[run]);
+    OB_COMPARE(confs[run].NumConformers(), 5);
+    vector<double> coords = AllCoordinates(confs[run]);
+    for (size_t i = 0; i < coords.size(); ++i)
+      OB_ASSERT(!IsNan(coords[i]));
+  }
+
+  OBAlign align(false, true);
+  vector<double> rmsd[2];
+  for (int run = 0; run < 2; ++run) {
+    SetThreads(run == 0 ? 1 : numThreads);
+    rmsd[run] = align.GetRMSDMatrix(confs[1]);
+  }
+  SetThreads(1);
+  OB_COMPARE(rmsd[0].size(), 10U);
+  OB_ASSERT(rmsd[1] == rmsd[0]);
+}
+#endif
+
+int openmptest(int argc, char* argv[])
+{
+  int defaultchoice = 1;
+
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+  // Define location of file formats for testing
+  #ifdef FORMATDIR
+    char env[BUFF_SIZE];
+    snprintf(env, BUFF_SIZE, "BABEL_LIBDIR=%s", FORMATDIR);
+    putenv(env);
+  #endif
+
+  switch(choice) {
+  case 1:
+    testConformerSearch();
+    break;
+  case 2:
+    testFastRotorSearch();
+    break;
+  case 3:
+    testDescriptors();
+    break;
+  case 4:
+    testFingerprints();
+    break;
+#ifdef HAVE_EIGEN
+  case 5:
+    testConformersAndRMSD();
+    break;
+#endif
+  default:
+    cout << "Test number " << choice << " does not exist!\n";
+    return -1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,100 @@
+#include "obtest.h"
+#include <openbabel/mol.h>
+#include <openbabel/atom.h>
+#include <openbabel/obiter.h>
+#include <openbabel/obconversion.h>
+#include <openbabel/propertyview.h>
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace OpenBabel;
+
+static OBMolPtr ReadSmiles(const string &smiles)
+{
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInFormat("smi"));
+  OBMolPtr mol(new OBMol);
+  OB_REQUIRE(conv.ReadString(mol.get(), smiles));
+  return mol;
+}
+
+// Each array agrees with the OBAtom getter it replaces
+void testAgreesWithAtoms()
+{
+  cout << "testAgreesWithAtoms" << endl;
+  const char *smiles[] = { "c1ccccc1O", "[13CH3]C(=O)[O-]", "C1CC1C#N",
+                           "[NH4+].[Cl-]", "c1cc[nH]c1[2H]", "O=S(=O)(O)c1ccncc1" };
+  for (size_t s = 0; s < sizeof(smiles) / sizeof(smiles[0]); ++s) {
+    OBMolPtr mol = ReadSmiles(smiles[s]);
+    if (s % 2)
+      mol->AddHydrogens();
+    OBMolPropertyView view(*mol, true);
+    OB_REQUIRE(view.NumAtoms() == mol->NumAtoms());
+    FOR_ATOMS_OF_MOL (atom, *mol) {
+      unsigned int i = atom->GetIdx() - 1;
+      OB_COMPARE(view.GetAtomicNums()[i], atom->GetAtomicNum());
+      OB_COMPARE(view.GetIsotopes()[i], atom->GetIsotope());
+      OB_COMPARE(view.GetFormalCharges()[i], atom->GetFormalCharge());
+      OB_COMPARE(view.GetImplicitHCounts()[i], atom->GetImplicitHCount());
+      OB_COMPARE(view.GetExplicitHCounts()[i], atom->ExplicitHydrogenCount());
+      OB_COMPARE(view.GetDegrees()[i], atom->GetExplicitDegree());
+      OB_COMPARE(view.GetHeavyDegrees()[i], atom->GetHvyDegree());
+      OB_COMPARE(view.GetValences()[i], atom->GetExplicitValence());
+      OB_COMPARE(view.GetHybs()[i], atom->GetHyb());
+      OB_COMPARE(view.IsInRing(i), atom->IsInRing());
+      OB_COMPARE(view.IsAromatic(i), atom->IsAromatic());
+    }
+  }
+}
+
+// Aromaticity is only perceived when it is asked for
+void testLazyAromaticity()
+{
+  cout << "testLazyAromaticity" << endl;
+  OBMolPtr mol = ReadSmiles("C1=CC=CC=C1C");
+  mol->SetAromaticPerceived(false);
+  OBMolPropertyView view(*mol);
+  OB_ASSERT(!mol->HasAromaticPerceived());
+  OB_ASSERT(view.IsInRing(0));
+  OB_ASSERT(!mol->HasAromaticPerceived());
+  OB_ASSERT(view.IsAromatic(0));
+  OB_ASSERT(!view.IsAromatic(6));
+  OB_ASSERT(mol->HasAromaticPerceived());
+  OB_COMPARE(view.GetFlags()[0], OBMolPropertyView::Aromatic | OBMolPropertyView::InRing);
+}
+
+int propertyviewtest(int argc, char* argv[])
+{
+  int defaultchoice = 1;
+
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+  // Define location of file formats for testing
+  #ifdef FORMATDIR
+    char env[BUFF_SIZE];
+    snprintf(env, BUFF_SIZE, "BABEL_LIBDIR=%s", FORMATDIR);
+    putenv(env);
+  #endif
+
+  switch(choice) {
+  case 1:
+    testAgreesWithAtoms();
+    break;
+  case 2:
+    testLazyAromaticity();
+    break;
+  default:
+    cout << "Test number " << choice << " does not exist!\n";
+    return -1;
+  }
+
+  return 0;
+}
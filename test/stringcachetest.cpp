@@ -0,0 +1,285 @@
+#include "obtest.h"
+#include <openbabel/mol.h>
+#include <openbabel/atom.h>
+#include <openbabel/obiter.h>
+#include <openbabel/obconversion.h>
+#include <openbabel/descriptor.h>
+#include <openbabel/builder.h>
+#include <openbabel/generic.h>
+#include <openbabel/stringcache.h>
+#include <openbabel/stereo/tetrahedral.h>
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace OpenBabel;
+
+static OBMolPtr ReadString(const string &format, const string &input)
+{
+  OBConversion conv;
+  OB_REQUIRE(conv.SetInFormat(format.c_str()));
+  OBMolPtr mol(new OBMol);
+  OB_REQUIRE(conv.ReadString(mol.get(), input));
+  return mol;
+}
+
+static OBMolStringCache::Key Key(const string &smiles)
+{
+  OBMolPtr mol = ReadString("smi", smiles);
+  OBMolStringCache::Key key;
+  OB_REQUIRE(OBMolStringCache::GraphKey(*mol, "test", key));
+  return key;
+}
+
+static string CanSmiles(OBMol &mol)
+{
+  OBDescriptor *desc = OBDescriptor::FindType("cansmi");
+  OB_REQUIRE(desc);
+  string value;
+  desc->GetStringValue(&mol, value);
+  return value;
+}
+
+// The key depends on the graph and stereo but not on the atom order, and
+// two molecules match only if they are the same
+void testGraphKey()
+{
+  cout << "testGraphKey" << endl;
+  const char *same[][2] = {
+    { "N[C@@H](C)C(=O)O", "OC(=O)[C@@H](N)C" },
+    { "F/C=C/F", "F\\C=C\\F" },
+    { "F/C=C\\Cl", "Cl/C=C\\F" },
+    { "c1ccccc1O", "Oc1ccccc1" },
+    { "[13CH3]C(=O)[O-]", "[O-]C([13CH3])=O" },
+    { "C[C@H]1CC[C@@H](C)CC1", "C[C@@H]1CC[C@H](C)CC1" },
+  };
+  for (size_t i = 0; i < sizeof(same) / sizeof(same[0]); ++i) {
+    OBMolStringCache::Key a = Key(same[i][0]), b = Key(same[i][1]);
+    OB_ASSERT(a.GetHash() == b.GetHash());
+    OB_ASSERT(a.Matches(b));
+  }
+
+  const char *different[][2] = {
+    { "N[C@@H](C)C(=O)O", "N[C@H](C)C(=O)O" },
+    { "N[C@@H](C)C(=O)O", "NC(C)C(=O)O" },
+    { "F/C=C/F", "F/C=C\\F" },
+    { "CC(=O)O", "[13CH3]C(=O)O" },
+    { "CC(=O)O", "CC(=O)[O-]" },
+    { "C[C@H]1CC[C@@H](C)CC1", "C[C@H]1CC[C@H](C)CC1" },
+  };
+  for (size_t i = 0; i < sizeof(different) / sizeof(different[0]); ++i)
+    OB_ASSERT(!Key(different[i][0]).Matches(Key(different[i][1])));
+
+  // Refining the atom invariants cannot tell these apart, so they have the
+  // same hash, but they do not match
+  const char *collisions[][2] = {
+    { "C1CCCCC1", "C1CC1.C1CC1" },
+    { "C1CCC2CCCCC2C1", "C1CCC(C1)C1CCCC1" },
+  };
+  for (size_t i = 0; i < sizeof(collisions) / sizeof(collisions[0]); ++i) {
+    OBMolStringCache::Key a = Key(collisions[i][0]), b = Key(collisions[i][1]);
+    OB_ASSERT(a.GetHash() == b.GetHash());
+    OB_ASSERT(!a.Matches(b));
+  }
+
+  OBMolStringCache cache(10);
+  cache.Insert(Key("C1CCCCC1"), "cyclohexane");
+  string value;
+  OB_ASSERT(!cache.Find(Key("C1CC1.C1CC1"), value));
+  OB_ASSERT(cache.Find(Key("C1CCCCC1"), value));
+  OB_COMPARE(value, "cyclohexane");
+  OBMolStringCache::Statistics stats = cache.GetStatistics();
+  OB_COMPARE(stats.collisions, 1UL);
+  OB_COMPARE(stats.misses, 1UL);
+  OB_COMPARE(stats.hits, 1UL);
+}
+
+// 3D input is keyed on the stereo perceived from the coordinates, so moving
+// or renumbering the atoms keeps the key and mirroring them changes it
+void testGraphKey3D()
+{
+  cout << "testGraphKey3D" << endl;
+  OBMolPtr built = ReadString("smi", "N[C@@H](C)C(=O)O");
+  built->AddHydrogens();
+  OBBuilder builder;
+  OB_REQUIRE(builder.Build(*built));
+  OBConversion conv;
+  OB_REQUIRE(conv.SetOutFormat("sdf"));
+  string sdf = conv.WriteString(built.get());
+
+  OBMolPtr mol = ReadString("sdf", sdf);
+  OBMolStringCache::Key key;
+  OB_REQUIRE(OBMolStringCache::GraphKey(*mol, "test", key));
+
+  OBMolPtr moved = ReadString("sdf", sdf);
+  vector<OBAtom*> order;
+  FOR_ATOMS_OF_MOL (atom, *moved) {
+    atom->SetVector(atom->GetVector() + vector3(1.5, -2.0, 0.5));
+    order.insert(order.begin(), &*atom);
+  }
+  moved->RenumberAtoms(order);
+  OBMolStringCache::Key movedKey;
+  OB_REQUIRE(OBMolStringCache::GraphKey(*moved, "test", movedKey));
+  OB_ASSERT(movedKey.GetHash() == key.GetHash());
+  OB_ASSERT(movedKey.Matches(key));
+
+  FOR_ATOMS_OF_MOL (atom, *built)
+    atom->SetVector(-atom->x(), atom->y(), atom->z());
+  OBMolPtr mirrored = ReadString("sdf", conv.WriteString(built.get()));
+  OBMolStringCache::Key mirroredKey;
+  OB_REQUIRE(OBMolStringCache::GraphKey(*mirrored, "test", mirroredKey));
+  OB_ASSERT(!mirroredKey.Matches(key));
+}
+
+static void CompareState(OBMol &a, OBMol &b)
+{
+  OB_COMPARE(a.GetFlags(), b.GetFlags());
+  vector<OBGenericData*> da = a.GetData(), db = b.GetData();
+  OB_REQUIRE(da.size() == db.size());
+  for (size_t i = 0; i < da.size(); ++i) {
+    OB_COMPARE(da[i]->GetAttribute(), db[i]->GetAttribute());
+    OB_COMPARE(da[i]->GetValue(), db[i]->GetValue());
+    OBTetrahedralStereo *ta = dynamic_cast<OBTetrahedralStereo*>(da[i]);
+    OBTetrahedralStereo *tb = dynamic_cast<OBTetrahedralStereo*>(db[i]);
+    OB_REQUIRE(!ta == !tb);
+    if (ta)
+      OB_COMPARE(ta->GetConfig().specified, tb->GetConfig().specified);
+  }
+}
+
+// The descriptor counts hits and misses, returns the uncached string and
+// leaves the molecule in the same state either way
+void testHitCounts()
+{
+  cout << "testHitCounts" << endl;
+  OBMolStringCache &cache = OBMolStringCache::Default();
+  cache.SetMaxSize(0);
+  OBMolPtr ref = ReadString("smi", "OC(=O)[C@@H](N)C");
+  string expected = CanSmiles(*ref);
+
+  cache.SetMaxSize(2);
+  cache.ResetStatistics();
+  OBMolPtr first = ReadString("smi", "N[C@@H](C)C(=O)O");
+  OBMolPtr second = ReadString("smi", "OC(=O)[C@@H](N)C");
+  OBMolPtr third = ReadString("smi", "N[C@@H](C)C(=O)O");
+  OB_COMPARE(CanSmiles(*first), expected);
+  OB_COMPARE(CanSmiles(*second), expected);
+  OB_COMPARE(CanSmiles(*third), expected);
+  OBMolStringCache::Statistics stats = cache.GetStatistics();
+  OB_COMPARE(stats.misses, 1UL);
+  OB_COMPARE(stats.hits, 2UL);
+  OB_COMPARE(stats.size, 1U);
+
+  // The same input leaves the same data and flags after a miss (first) and
+  // a hit (third)
+  CompareState(*first, *third);
+
+  // The least recently used entry is evicted
+  OBMolPtr ethanol = ReadString("smi", "CCO");
+  OBMolPtr benzene = ReadString("smi", "c1ccccc1");
+  CanSmiles(*ethanol);
+  CanSmiles(*benzene);
+  stats = cache.GetStatistics();
+  OB_COMPARE(stats.misses, 3UL);
+  OB_COMPARE(stats.evictions, 1UL);
+  OB_COMPARE(stats.size, 2U);
+  OBMolPtr again = ReadString("smi", "N[C@@H](C)C(=O)O");
+  OB_COMPARE(CanSmiles(*again), expected);
+  stats = cache.GetStatistics();
+  OB_COMPARE(stats.misses, 4UL);
+  OB_COMPARE(stats.hits, 2UL);
+
+  // The writer marks the stereo of a center that is not stereogenic as
+  // unspecified, and leaves ring and symmetry data
+  cache.Clear();
+  OBMolPtr miss = ReadString("smi", "C[C@H](C)C1CCCCC1");
+  OBMolPtr hit = ReadString("smi", "C[C@H](C)C1CCCCC1");
+  OB_COMPARE(CanSmiles(*miss), CanSmiles(*hit));
+  CompareState(*miss, *hit);
+
+  cache.SetMaxSize(0);
+  OB_COMPARE(cache.GetStatistics().size, 0U);
+}
+
+// Concurrent lookups and inserts on a cache smaller than the working set
+void testThreads()
+{
+  cout << "testThreads" << endl;
+  const char *smiles[] = { "C", "CC", "CCC", "CCO", "CC=O", "CC(=O)O", "c1ccccc1",
+                           "c1ccncc1", "C1CCCCC1", "N[C@@H](C)C(=O)O", "N[C@H](C)C(=O)O",
+                           "F/C=C/F", "F/C=C\\F", "OCCO", "CN", "CCN" };
+  const size_t n = sizeof(smiles) / sizeof(smiles[0]);
+  vector<OBMolStringCache::Key> keys(n);
+  for (size_t i = 0; i < n; ++i)
+    keys[i] = Key(smiles[i]);
+
+  OBMolStringCache cache(5);
+  const int numThreads = 4, numLookups = 2000;
+  vector<int> wrong(numThreads, 0);
+  vector<thread> threads;
+  for (int t = 0; t < numThreads; ++t)
+    threads.push_back(thread([&, t]() {
+      for (int j = 0; j < numLookups; ++j) {
+        size_t i = (j * 7 + t * 3) % n;
+        string value;
+        if (cache.Find(keys[i], value)) {
+          if (value != smiles[i])
+            wrong[t]++;
+        }
+        else
+          cache.Insert(keys[i], smiles[i]);
+      }
+    }));
+  for (size_t t = 0; t < threads.size(); ++t)
+    threads[t].join();
+
+  OBMolStringCache::Statistics stats = cache.GetStatistics();
+  OB_COMPARE(stats.hits + stats.misses, (unsigned long)(numThreads * numLookups));
+  OB_ASSERT(stats.size <= 5);
+  OB_COMPARE(stats.collisions, 0UL);
+  for (int t = 0; t < numThreads; ++t)
+    OB_COMPARE(wrong[t], 0);
+}
+
+int stringcachetest(int argc, char* argv[])
+{
+  int defaultchoice = 1;
+
+  int choice = defaultchoice;
+
+  if (argc > 1) {
+    if(sscanf(argv[1], "%d", &choice) != 1) {
+      printf("Couldn't parse that input as a number\n");
+      return -1;
+    }
+  }
+  // Define location of file formats for testing
+  #ifdef FORMATDIR
+    char env[BUFF_SIZE];
+    snprintf(env, BUFF_SIZE, "BABEL_LIBDIR=%s", FORMATDIR);
+    putenv(env);
+  #endif
+
+  switch(choice) {
+  case 1:
+    testGraphKey();
+    break;
+  case 2:
+    testGraphKey3D();
+    break;
+  case 3:
+    testHitCounts();
+    break;
+  case 4:
+    testThreads();
+    break;
+  default:
+    cout << "Test number " << choice << " does not exist!\n";
+    return -1;
+  }
+
+  return 0;
+}
@@ -413,5 +413,28 @@ TORSDOF 5
             for outline, cofline in zip(outdata, cofdata):
                 self.assertEqual(outline.rstrip('\r\n'), cofline.rstrip('\r\n'))
 
+class TestOBRms(BaseTest):
+    """A series of tests relating to the obrms executable"""
+
+    def testMatrix(self):
+        """The -M matrix only includes structures with the same atoms and
+        bonds as the first one"""
+        self.canFindExecutable("obrms")
+        xyzfile = self.getTestFile("rmsmatrix.xyz")
+        output, error = run_exec("obrms -M %s" % xyzfile)
+
+        self.assertTrue("Skipping conf4" in error)
+        self.assertTrue("Skipping conf5" in error)
+        rows = [line.split(", ") for line in output.splitlines()]
+        self.assertEqual([row[0] for row in rows], ["conf1", "conf2", "conf3"])
+        rmsd = [[float(x) for x in row[1:]] for row in rows]
+        for i in range(3):
+            self.assertEqual(rmsd[i][i], 0.0)
+            for j in range(3):
+                self.assertAlmostEqual(rmsd[i][j], rmsd[j][i])
+        # conf2 is a rigid move of conf1
+        self.assertAlmostEqual(rmsd[0][1], 0.0, places=5)
+        self.assertTrue(rmsd[0][2] > 0.1)
+
 if __name__ == "__main__":
     unittest.main()
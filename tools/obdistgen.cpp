@@ -30,6 +30,8 @@ GNU General Public License for more details.
 #include <openbabel/forcefield.h>
 #include <openbabel/distgeom.h>
 
+#include <cstdlib>
+
 using namespace std;
 using namespace OpenBabel;
 
@@ -42,10 +44,11 @@ int main(int argc,char **argv)
 {
   char *program_name= argv[0];
   int c;
+  unsigned int nconfs = 1;
   string basename, filename = "";
 
   if (argc < 2) {
-    cout << "Usage: obdistgen <filename>" << endl;
+    cout << "Usage: obdistgen <filename> [number of conformers to try]" << endl;
     cout << endl;
     exit(-1);
   } else {
@@ -55,6 +58,14 @@ int main(int argc,char **argv)
     if (extPos!= string::npos) {
       basename = filename.substr(0, extPos);
     }
+    if (argc > 2) {
+      int n = atoi(argv[2]);
+      if (n < 1) {
+        cerr << program_name << ": the number of conformers must be positive" << endl;
+        exit (-1);
+      }
+      nconfs = n;
+    }
   }
 
   // Find Input filetype
@@ -94,10 +105,8 @@ int main(int argc,char **argv)
       OBDistanceGeometry dg;
       dg.Setup(mol);
 
-      for (unsigned int i = 1; i < 2; ++i) {
-        //        cout << i << endl;
-        dg.AddConformer();
-      }
+      // embed independently, and keep the one of lowest energy
+      dg.AddConformers(nconfs);
       dg.GetConformers(mol);
       //      cout << " Conformers: " << mol.NumConformers() << endl;
       // Check the energies
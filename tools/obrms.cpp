@@ -35,9 +35,12 @@
 #include <openbabel/isomorphism.h>
 #include <openbabel/shared_ptr.h>
 #include <openbabel/obutil.h>
+#include <openbabel/math/align.h>
 
 #include "getopt.h"
 
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 
 using namespace std;
@@ -209,6 +212,26 @@ static void processMol(OBMol& mol)
 	mol.SetRingAtomsAndBondsPerceived();
 	mol.SetAromaticPerceived();
 }
+
+//true if the two molecules have the same atoms in the same order, connected
+//in the same way, so that one can be treated as a conformer of the other
+static bool sameTopology(OBMol& a, OBMol& b)
+{
+	if (a.NumAtoms() != b.NumAtoms() || a.NumBonds() != b.NumBonds())
+		return false;
+	for (unsigned i = 1; i <= a.NumAtoms(); i++)
+	{
+		if (a.GetAtom(i)->GetAtomicNum() != b.GetAtom(i)->GetAtomicNum())
+			return false;
+	}
+	for (OBBondIterator bitr = a.BeginBonds(); bitr != a.EndBonds(); bitr++)
+	{
+		OBBond *bond = *bitr;
+		if (!b.GetBond(bond->GetBeginAtomIdx(), bond->GetEndAtomIdx()))
+			return false;
+	}
+	return true;
+}
 ///////////////////////////////////////////////////////////////////////////////
 //! \brief compute rms between chemically identical molecules
 int main(int argc, char **argv)
@@ -218,6 +241,7 @@ int main(int argc, char **argv)
 	bool separate = false;
 	bool help = false;
 	bool docross = false;
+	bool domatrix = false;
 	string fileRef;
 	string fileTest;
 	string fileOut;
@@ -230,19 +254,22 @@ int main(int argc, char **argv)
 	  "\t -f, --firstonly  use only the first structure in the reference file\n"
 	  "\t -m, --minimize   compute minimum RMSD\n"
 	  "\t -x, --cross      compute all n^2 RMSDs between molecules of reference file\n"
+	  "\t -M, --matrix     compute all n^2 minimized RMSDs between conformers of reference file\n"
+	  "\t                  (all structures must share the topology of the first one)\n"
 	  "\t -s, --separate   separate reference file into constituent molecules and report best RMSD\n"
 	  "\t -h, --help       help message\n";
 	struct option long_options[] = {
 	    {"firstonly", no_argument, 0, 'f'},
 	    {"minimize", no_argument, 0, 'm'},
 	    {"cross", no_argument, 0, 'x'},
+	    {"matrix", no_argument, 0, 'M'},
 	    {"separate", no_argument, 0, 's'},
 	    {"out", required_argument, 0, 'o'},
 	    {"help", no_argument, 0, 'h'}
 	};
 	int option_index = 0;
 	int c = 0;
-	while ((c = getopt_long(argc, argv, "hfmxso:", long_options, &option_index) ) > 0) {
+	while ((c = getopt_long(argc, argv, "hfmxMso:", long_options, &option_index) ) > 0) {
 	  switch(c) {
 	    case 'o':
 	      fileOut = optarg;
@@ -256,6 +283,9 @@ int main(int argc, char **argv)
 	    case 'x':
 	      docross = true;
 	      break;
+	    case 'M':
+	      domatrix = true;
+	      break;
 	    case 's':
 	      separate = true;
 	      break;
@@ -283,7 +313,7 @@ int main(int argc, char **argv)
 	  exit(-1);
 	}
 
-	if(!docross && fileTest.size() == 0) {
+	if(!docross && !domatrix && fileTest.size() == 0) {
     cerr << helpmsg;
 	  cerr << "Command line parse error: test file is required but missing\n";
 	  exit(-1);
@@ -313,7 +343,45 @@ int main(int argc, char **argv)
   //read reference
   OBMol molref;
 
-	if(docross) {
+	if(domatrix) {
+	  //load the reference file as conformers of the first structure
+	  OBMol mol;
+	  vector<string> titles;
+	  while (refconv.Read(&molref))
+	  {
+	    if (titles.empty()) {
+	      mol = molref;
+	    } else {
+	      if (!sameTopology(molref, mol)) {
+	        cerr << "Skipping " << molref.GetTitle() << ": different atoms or bonds from the first structure\n";
+	        continue;
+	      }
+	      double *xyz = new double[3 * molref.NumAtoms()];
+	      memcpy(xyz, molref.GetCoordinates(), sizeof(double) * 3 * molref.NumAtoms());
+	      mol.AddConformer(xyz);
+	    }
+	    titles.push_back(molref.GetTitle());
+	  }
+
+	  //symmetry-aware heavy-atom RMSDs, automorphisms computed only once
+	  OBAlign align(false, true);
+	  vector<double> rmsds = align.GetRMSDMatrix(mol);
+
+	  unsigned n = titles.size();
+	  for(unsigned i = 0; i < n; i++) {
+	    cout << titles[i];
+	    for(unsigned j = 0; j < n; j++) {
+	      double rmsd = 0.0;
+	      if(i != j) {
+	        unsigned a = min(i, j), b = max(i, j);
+	        rmsd = rmsds[a * n - a * (a + 1) / 2 + (b - a - 1)];
+	      }
+	      cout << ", " << rmsd;
+	    }
+	    cout << "\n";
+	  }
+
+	} else if(docross) {
 	  //load in the entire reference file
     vector<OBMol> refmols;
     while (refconv.Read(&molref))